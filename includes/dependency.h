@@ -4,7 +4,9 @@
 // +===----- External libraries -----===+ //
 
 # include <sys/inotify.h>
+# include <sys/mman.h>
 # include <sys/types.h>
+# include <sys/uio.h>
 # include <sys/stat.h>
 # include <fcntl.h>
 # include <errno.h>
@@ -11,6 +11,12 @@
 /* The seed API manager */
 typedef struct s_Manager	t_Manager;
 
+/* An immutable copy of the lines of a buffer */
+typedef struct s_Snapshot	t_Snapshot;
+
+/* A compiled regular expression */
+typedef struct s_Regex		t_Regex;
+
 /* Error codes for API manager */
 typedef enum	e_ErrorCode
 {
@@ -32,6 +38,9 @@ typedef enum	e_ErrorCode
 	/* +==-- Writing system errors --==+ */
 	ERR_BUFFER_NOT_FOUND,	/* Buffer not found */
 	ERR_LINE_NOT_FOUND,	/* Line not found */
+	ERR_INVALID_ENCODING,	/* Data is not valid UTF-8 */
+	ERR_HISTORY_EMPTY,	/* Nothing to undo or redo */
+	ERR_INVALID_PATTERN,	/* Invalid regular expression */
 
 	/* +==-- Filesystem errors --==+ */
 	ERR_DIR_NOT_FOUND,	/* Directory not found */
@@ -48,13 +57,35 @@ typedef enum	e_CommandId
 	/* +==-- Writing system commands ID --==+ */
 	CMD_WRITING_CREATE_BUFFER,	/* Create a buffer */
 	CMD_WRITING_DELETE_BUFFER,	/* Delete a buffer */
+	CMD_WRITING_LOAD_FILE,	/* Load a file in a new buffer */
+	CMD_WRITING_SAVE_BUFFER,	/* Save a buffer in a file */
 	CMD_WRITING_INSERT_LINE,	/* Insert a line */
 	CMD_WRITING_DELETE_LINE,	/* Delete a line */
 	CMD_WRITING_SPLIT_LINE,	/* Split a line */
 	CMD_WRITING_JOIN_LINE,	/* Join a line */
 	CMD_WRITING_GET_LINE,	/* Get a line content */
+	CMD_WRITING_GET_LINES,	/* Get the content of consecutive lines */
+	CMD_WRITING_FIND,	/* Find a text in a buffer */
+	CMD_WRITING_REGEX_FIND,	/* Find a regular expression in a buffer */
+	CMD_WRITING_FIND_ALL,	/* Find a text in all buffers */
+	CMD_WRITING_SET_INDEX,	/* Keep or drop the trigram index of a buffer */
+	CMD_WRITING_REPLACE_ALL,	/* Replace every match in a buffer */
+	CMD_WRITING_OFFSET_TO_POS,	/* Get the position of a byte offset */
+	CMD_WRITING_POS_TO_OFFSET,	/* Get the byte offset of a position */
+	CMD_WRITING_CONVERT_UTF16,	/* Convert positions between UTF-16 and bytes */
+	CMD_WRITING_CONVERT_COLUMNS,	/* Convert positions between indexes and display columns */
+	CMD_WRITING_SET_WRAP,	/* Wrap the lines of a buffer at a width */
+	CMD_WRITING_ROW_TO_POS,	/* Get the position of a wrapped row */
+	CMD_WRITING_POS_TO_ROW,	/* Get the wrapped row of a position */
 	CMD_WRITING_INSERT_TEXT,	/* Insert text inside a line */
 	CMD_WRITING_DELETE_TEXT,	/* Delete text inside a line */
+	CMD_WRITING_INSERT_RANGE,	/* Insert text over several lines */
+	CMD_WRITING_DELETE_RANGE,	/* Delete text over several lines */
+	CMD_WRITING_MULTI_EDIT,	/* Apply a batch of edits at once */
+	CMD_WRITING_APPLY_CHANGES,	/* Apply a batch of range replacements in order */
+	CMD_WRITING_UNDO,	/* Undo the last edit */
+	CMD_WRITING_REDO,	/* Redo the last undone edit */
+	CMD_WRITING_SNAPSHOT,	/* Take a snapshot of a buffer */
 
 	/* +==-- Filesystem commands ID --==+ */
 	CMD_FS_OPEN_ROOT,	/* Open a root directory */
@@ -92,6 +123,21 @@ typedef struct	s_CmdDestroyBuffer
 	size_t	buffer_id;	/* The buffer ID */
 }	t_CmdDestroyBuffer;
 
+typedef struct	s_CmdLoadFile
+{
+	char	*path;	/* The relative path of the file */
+	size_t	out_buffer_id;	/* The buffer ID that was be created */
+	size_t	out_lines;	/* The count of lines */
+	bool	out_crlf;	/* The file uses CRLF line endings */
+}	t_CmdLoadFile;
+
+typedef struct	s_CmdSaveBuffer
+{
+	size_t	buffer_id;	/* The buffer ID */
+	char	*path;	/* The relative path of the file */
+	size_t	out_size;	/* The count of bytes written */
+}	t_CmdSaveBuffer;
+
 typedef struct	s_CmdInsertLine
 {
 	size_t	buffer_id;	/* The buffer ID */
@@ -126,6 +172,178 @@ typedef struct	s_CmdGetLine
 	size_t		out_size;	/* The data size */
 }	t_CmdGetLine;
 
+/* The content of a line, valid until the next edit of its buffer */
+typedef struct	s_LineView
+{
+	const char	*data;	/* The data content */
+	size_t		size;	/* The data size */
+}	t_LineView;
+
+typedef struct	s_CmdGetLines
+{
+	size_t		buffer_id;	/* The buffer ID */
+	ssize_t		line;	/* The first line */
+	size_t		count;	/* The count of views */
+	t_LineView	*views;	/* The views filled with the lines */
+	size_t		out_count;	/* The count of filled views */
+}	t_CmdGetLines;
+
+/* A match of a search */
+typedef struct	s_Match
+{
+	size_t	line;	/* The line */
+	size_t	index;	/* The index of the first character */
+	size_t	size;	/* The count of characters */
+}	t_Match;
+
+typedef struct	s_CmdFind
+{
+	size_t		buffer_id;	/* The buffer ID */
+	const char	*data;	/* The searched text, without line endings */
+	size_t		size;	/* The size of the searched text */
+	ssize_t		line;	/* The line where the search starts */
+	ssize_t		index;	/* The index where the search starts */
+	bool		backward;	/* Search before the position instead of after */
+	bool		ignore_case;	/* Ignore the case of ASCII letters */
+	size_t		count;	/* The maximum count of matches */
+	t_Match		*matches;	/* The matches, in the order of the search */
+	size_t		out_count;	/* The count of matches */
+}	t_CmdFind;
+
+typedef struct	s_CmdRegexFind
+{
+	size_t		buffer_id;	/* The buffer ID */
+	const char	*pattern;	/* The regular expression */
+	size_t		size;	/* The size of the regular expression */
+	bool		ignore_case;	/* Ignore the case of ASCII letters */
+	t_Regex		*regex;	/* The expression compiled by a previous chunk, or NULL */
+	ssize_t		line;	/* The line where the search starts */
+	ssize_t		index;	/* The index where the search starts */
+	size_t		count;	/* The maximum count of matches */
+	t_Match		*matches;	/* The matches, in the order of the buffer */
+	size_t		out_count;	/* The count of matches */
+	size_t		out_line;	/* The line where the next chunk starts */
+	size_t		out_index;	/* The index where the next chunk starts */
+	bool		out_done;	/* The end of the buffer was reached */
+}	t_CmdRegexFind;
+
+/* A match of a search in all buffers */
+typedef struct	s_BufferMatch
+{
+	size_t	buffer_id;	/* The buffer ID */
+	t_Match	match;	/* The match in the buffer */
+}	t_BufferMatch;
+
+typedef struct	s_CmdFindAll
+{
+	const char		*data;	/* The searched text, without line endings */
+	size_t			size;	/* The size of the searched text */
+	bool			ignore_case;	/* Ignore the case of ASCII letters */
+	size_t			buffer_id;	/* The buffer where the search starts */
+	size_t			line;	/* The line where the search starts */
+	size_t			index;	/* The index where the search starts */
+	size_t			count;	/* The maximum count of matches */
+	t_BufferMatch	*matches;	/* The matches, by buffer then position */
+	size_t			out_count;	/* The count of matches */
+	size_t			out_buffer_id;	/* The buffer where the next chunk starts */
+	size_t			out_line;	/* The line where the next chunk starts */
+	size_t			out_index;	/* The index where the next chunk starts */
+	bool			out_done;	/* Every buffer was searched */
+}	t_CmdFindAll;
+
+typedef struct	s_CmdSetIndex
+{
+	size_t	buffer_id;	/* The buffer ID */
+	bool	enable;	/* Keep the index, or release it */
+}	t_CmdSetIndex;
+
+typedef struct	s_CmdReplaceAll
+{
+	size_t		buffer_id;	/* The buffer ID */
+	const char	*data;	/* The searched text or regular expression */
+	size_t		size;	/* The size of the searched text */
+	bool		is_regex;	/* The searched text is a regular expression */
+	bool		ignore_case;	/* Ignore the case of ASCII letters */
+	const char	*replacement;	/* The replacement, without line endings */
+	size_t		replacement_size;	/* The size of the replacement */
+	size_t		out_count;	/* The count of replacements */
+	size_t		out_lines;	/* The count of lines changed */
+}	t_CmdReplaceAll;
+
+typedef struct	s_CmdOffsetToPos
+{
+	size_t	buffer_id;	/* The buffer ID */
+	size_t	offset;	/* The byte offset in the text of the buffer */
+	size_t	out_line;	/* The line of the offset */
+	size_t	out_index;	/* The index of the character at the offset */
+}	t_CmdOffsetToPos;
+
+typedef struct	s_CmdPosToOffset
+{
+	size_t	buffer_id;	/* The buffer ID */
+	ssize_t	line;	/* The line */
+	ssize_t	index;	/* The index, or -1 for the end of the line */
+	size_t	out_offset;	/* The byte offset in the text of the buffer */
+}	t_CmdPosToOffset;
+
+/* A position in a line, as a UTF-16 column and as a byte */
+typedef struct	s_Utf16Position
+{
+	ssize_t	line;	/* The line */
+	size_t	column;	/* The count of UTF-16 code units before the position */
+	size_t	byte;	/* The count of bytes before the position */
+}	t_Utf16Position;
+
+typedef struct	s_CmdConvertUtf16
+{
+	size_t			buffer_id;	/* The buffer ID */
+	bool			to_utf16;	/* Convert the bytes, or the columns */
+	size_t			count;	/* The count of positions */
+	t_Utf16Position	*positions;	/* The positions, converted in place */
+	size_t			out_count;	/* The count of positions converted */
+}	t_CmdConvertUtf16;
+
+typedef struct	s_ColumnPosition
+{
+	ssize_t	line;	/* The line */
+	size_t	index;	/* The index of the character */
+	size_t	column;	/* The display column */
+}	t_ColumnPosition;
+
+typedef struct	s_CmdConvertColumns
+{
+	size_t				buffer_id;	/* The buffer ID */
+	bool				to_columns;	/* Convert the indexes, or the columns */
+	size_t				tab_size;	/* The count of columns between two tab stops */
+	size_t				count;	/* The count of positions */
+	t_ColumnPosition	*positions;	/* The positions, converted in place */
+	size_t				out_count;	/* The count of positions converted */
+}	t_CmdConvertColumns;
+
+typedef struct	s_CmdSetWrap
+{
+	size_t	buffer_id;	/* The buffer ID */
+	size_t	width;	/* The count of columns of a row, or 0 to unwrap */
+	size_t	tab_size;	/* The count of columns between two tab stops */
+	size_t	out_rows;	/* The count of rows of the buffer */
+}	t_CmdSetWrap;
+
+typedef struct	s_CmdRowToPos
+{
+	size_t	buffer_id;	/* The buffer ID */
+	size_t	row;	/* The wrapped row */
+	size_t	out_line;	/* The line of the row */
+	size_t	out_index;	/* The index of the first character of the row */
+}	t_CmdRowToPos;
+
+typedef struct	s_CmdPosToRow
+{
+	size_t	buffer_id;	/* The buffer ID */
+	ssize_t	line;	/* The line */
+	ssize_t	index;	/* The index, or -1 for the end of the line */
+	size_t	out_row;	/* The wrapped row of the position */
+}	t_CmdPosToRow;
+
 typedef struct	s_CmdInsertData
 {
 	size_t	buffer_id;	/* The buffer ID */
@@ -143,6 +361,78 @@ typedef struct	s_CmdDeleteData
 	size_t	size;	/* The length of data that will be deleted */
 }	t_CmdDeleteData;
 
+typedef struct	s_CmdInsertRange
+{
+	size_t	buffer_id;	/* The buffer ID */
+	ssize_t	line;	/* The line */
+	ssize_t	index;	/* The index */
+	size_t	size;	/* The data size */
+	char	*data;	/* The data content, with line endings */
+	size_t	out_line;	/* The line where the data ends */
+	size_t	out_index;	/* The index after the data */
+}	t_CmdInsertRange;
+
+typedef struct	s_CmdDeleteRange
+{
+	size_t	buffer_id;	/* The buffer ID */
+	ssize_t	line;	/* The first line */
+	size_t	index;	/* The index in the first line */
+	ssize_t	end_line;	/* The last line */
+	size_t	end_index;	/* The index after the data in the last line */
+}	t_CmdDeleteRange;
+
+/* One edit of a batch, such as the edit of a cursor */
+typedef struct	s_Edit
+{
+	ssize_t		line;	/* The line */
+	size_t		index;	/* The index of the first character */
+	size_t		delete_size;	/* The count of characters deleted */
+	size_t		size;	/* The data size */
+	const char	*data;	/* The data inserted, without line endings */
+	size_t		out_line;	/* The line of the edit */
+	size_t		out_index;	/* The index after the data once the batch is applied */
+}	t_Edit;
+
+typedef struct	s_CmdMultiEdit
+{
+	size_t	buffer_id;	/* The buffer ID */
+	size_t	count;	/* The count of edits */
+	t_Edit	*edits;	/* The edits, in any order */
+}	t_CmdMultiEdit;
+
+typedef struct	s_Change
+{
+	size_t		line;	/* The line of the start */
+	size_t		index;	/* The column of the start */
+	size_t		end_line;	/* The line of the end */
+	size_t		end_index;	/* The column of the end, past the line is its end */
+	size_t		size;	/* The data size */
+	const char	*data;	/* The data inserted, it may contain line endings */
+}	t_Change;
+
+typedef struct	s_CmdApplyChanges
+{
+	size_t			buffer_id;	/* The buffer ID */
+	bool			utf16;	/* Columns are UTF-16 code units instead of characters */
+	size_t			count;	/* The count of changes */
+	const t_Change	*changes;	/* The changes, each one applied to the result of the previous ones */
+	size_t			out_count;	/* The count of changes applied, or the failed one */
+	size_t			out_version;	/* The version of the buffer */
+}	t_CmdApplyChanges;
+
+typedef struct	s_CmdHistory
+{
+	size_t	buffer_id;	/* The buffer ID */
+	size_t	out_line;	/* The line of the edit */
+	size_t	out_index;	/* The index of the edit */
+}	t_CmdHistory;
+
+typedef struct	s_CmdSnapshot
+{
+	size_t		buffer_id;	/* The buffer ID */
+	t_Snapshot	*out_snapshot;	/* The snapshot, released by the caller */
+}	t_CmdSnapshot;
+
 /* +==-- Filesystem payload --==+ */
 // Payloads for the entire filesystem
 
@@ -218,4 +508,55 @@ void		manager_clean(t_Manager *manager);
 */
 t_ErrorCode	manager_exec(t_Manager *manager, t_Command *cmd);
 
+/* +==-- Snapshots --==+ */
+// A snapshot does not depend on its buffer or the manager, it can be read and
+// released from any thread while the buffer is edited or destroyed.
+
+/**
+ * @brief Get the count of lines of the snapshot.
+ * @param snapshot The snapshot.
+ * @return The count of lines.
+*/
+size_t		snapshot_size(const t_Snapshot *snapshot);
+
+/**
+ * @brief Get the content of consecutive lines of the snapshot.
+ * @param snapshot The snapshot.
+ * @param line The first line.
+ * @param count The count of views.
+ * @param views The views filled with the lines, valid until the release.
+ * @return The count of filled views.
+*/
+size_t		snapshot_get_lines(const t_Snapshot *snapshot, size_t line,
+	size_t count, t_LineView *views);
+
+/**
+ * @brief Check if the line of the snapshot ends with CRLF.
+ * @param snapshot The snapshot.
+ * @param line The line.
+ * @return TRUE if the line ends with CRLF or FALSE otherwise.
+*/
+bool		snapshot_is_crlf(const t_Snapshot *snapshot, size_t line);
+
+/**
+ * @brief Adds an owner to the snapshot.
+ * @param snapshot The snapshot.
+ * @return The snapshot.
+*/
+t_Snapshot	*snapshot_retain(t_Snapshot *snapshot);
+
+/**
+ * @brief Removes an owner of the snapshot, the last one releases it.
+ * @param snapshot The snapshot, or NULL.
+*/
+void		snapshot_release(t_Snapshot *snapshot);
+
+/* +==-- Regular expressions --==+ */
+
+/**
+ * @brief Releases an expression compiled by CMD_WRITING_REGEX_FIND.
+ * @param regex The expression, or NULL.
+*/
+void		regex_destroy(t_Regex *regex);
+
 #endif
\ No newline at end of file
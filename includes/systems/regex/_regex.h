@@ -0,0 +1,224 @@
+#ifndef SEED_REGEX_H
+# define SEED_REGEX_H
+
+# include "dependency.h"
+# include "seed.h"
+# include <stdint.h>
+
+# define REGEX_NONE ((uint32_t)-1)	/* No NFA state */
+# define REGEX_NPOS ((size_t)-1)	/* No match */
+# define REGEX_MAX_STATES 16384	/* The maximum count of NFA states */
+# define REGEX_MAX_REPEAT 1000	/* The maximum bound of a counted repetition */
+# define REGEX_MAX_DEPTH 64	/* The maximum depth of groups */
+# define REGEX_CLASS_CHARS 32	/* The maximum count of non-ASCII characters of a class */
+# define REGEX_SCAN_RATIO 2	/* The forward bytes read by byte of a line */
+# define REGEX_SCAN_MIN 256	/* The forward bytes read on any line */
+
+# define DFA_MAX_STATES 4096	/* The count of cached states before a reset */
+# define DFA_MAX_POOL (1 << 20)	/* The count of cached NFA states before a reset */
+# define DFA_UNKNOWN -1	/* A transition not built yet */
+# define DFA_DEAD 0	/* The state without NFA states */
+# define DFA_MATCH 1	/* The state matches */
+# define DFA_MATCH_EOL 2	/* The state matches at the end of the line */
+# define DFA_MATCH_LINE 4	/* The state matches at the end of an empty line */
+
+// The patterns are compiled twice to Thompson NFAs, one for the pattern and
+// one for the pattern read backward. Each NFA is run by a DFA built while it
+// is used: a state is the set of NFA states reached so far, and its
+// transitions are filled on the first use. Bytes that no NFA state tells
+// apart share a class, so a state only has one transition by class.
+// The cache is cleared when it grows too large, so the memory is bounded and
+// each byte still costs at most one NFA step.
+// A forward read of a match may go far past its end, so the reads of a line
+// are bounded: past REGEX_SCAN_RATIO times its size, the end of every match
+// is found in one more backward pass. The search of a line is linear.
+
+// +===----- Types -----===+ //
+
+/* The kind of an NFA state */
+typedef enum	e_NfaKind
+{
+	NFA_BYTES,	/* Reads a byte of a set */
+	NFA_EMPTY,	/* Goes to the next state */
+	NFA_SPLIT,	/* Goes to both next states */
+	NFA_BOL,	/* Goes to the next state at the start of the line */
+	NFA_EOL,	/* Goes to the next state at the end of the line */
+	NFA_MATCH	/* Ends a match */
+}	t_NfaKind;
+
+/* A set of bytes */
+typedef struct	s_ByteSet
+{
+	uint64_t	bits[4];	/* One bit by byte */
+}	t_ByteSet;
+
+/* A state of an NFA */
+typedef struct	s_NfaState
+{
+	uint32_t	kind;	/* The kind of state */
+	uint32_t	out;	/* The next state */
+	uint32_t	out1;	/* The other next state of a split */
+	uint32_t	set;	/* The byte set of a byte state */
+}	t_NfaState;
+
+/* A Thompson NFA */
+typedef struct	s_Nfa
+{
+	t_NfaState	*states;	/* The states */
+	size_t		count;	/* The count of states */
+	size_t		capacity;	/* The capacity of states */
+	t_ByteSet	*sets;	/* The byte sets */
+	size_t		set_count;	/* The count of byte sets */
+	size_t		set_capacity;	/* The capacity of byte sets */
+	uint32_t	start;	/* The first state */
+}	t_Nfa;
+
+/* A DFA built from an NFA while it runs */
+// The NFA states of each DFA state are sorted and stored in the pool, they
+// identify the state in the hash table. Only byte, EOL and match states are
+// kept, the others are followed when the set is built.
+typedef struct	s_Dfa
+{
+	t_Nfa		nfa;	/* The NFA */
+	bool		unanchored;	/* The NFA restarts at each byte */
+	uint8_t		classes[256];	/* The class of each byte */
+	size_t		class_count;	/* The count of classes */
+	int32_t		*next;	/* The transitions of each state by class */
+	uint8_t		*flags;	/* The flags of each state */
+	uint32_t	*offsets;	/* The position of each state in the pool */
+	size_t		count;	/* The count of states */
+	size_t		capacity;	/* The capacity of states */
+	uint32_t	*pool;	/* The NFA states of the DFA states */
+	size_t		pool_size;	/* The size of the pool */
+	size_t		pool_capacity;	/* The capacity of the pool */
+	int32_t		*table;	/* The hash table of states */
+	size_t		table_size;	/* The size of the table, a power of 2 */
+	int32_t		starts[2];	/* The start states, without and with BOL */
+	uint32_t	*marks;	/* The generation of each NFA state */
+	uint32_t	generation;	/* The current generation */
+	uint32_t	*stack;	/* The NFA states to follow */
+	uint32_t	*list;	/* The NFA states of the state being built */
+	size_t		resets;	/* The count of cache resets */
+}	t_Dfa;
+
+/* A compiled regular expression */
+// A line is first read backward with the reversed DFA, which tells where the
+// matches start. The leftmost start is then read forward with the anchored
+// DFA until it dies, the last match state gives the longest match. When the
+// forward reads of the line grow too long, the ends of the matches are all
+// found at once from the reversed NFA, and read from there.
+struct	s_Regex
+{
+	t_Dfa		forward;	/* The anchored DFA of the pattern */
+	t_Dfa		reverse;	/* The unanchored DFA of the reversed pattern */
+	const char	*data;	/* The data of the prepared line */
+	size_t		size;	/* The size of the prepared line */
+	uint8_t		*starts;	/* The positions where a match starts */
+	size_t		capacity;	/* The capacity of starts */
+	size_t		*ends;	/* The end of the longest match from each position */
+	size_t		ends_capacity;	/* The capacity of ends */
+	size_t		scanned;	/* The bytes read forward on the line */
+	size_t		version;	/* The buffer version of the line, kept by the search */
+	bool		longest;	/* The ends are filled for the line */
+};
+
+// +===----- NFA -----===+ //
+
+/**
+ * @brief Compiles a pattern to an NFA.
+ * @param nfa The empty NFA.
+ * @param pattern The pattern.
+ * @param size The size of the pattern.
+ * @param fold TRUE to ignore the case of ASCII letters.
+ * @param reverse TRUE to compile the pattern read backward.
+ * @return ERR_INVALID_PATTERN, ERR_INTERNAL_MEMORY or SUCCESS (=0).
+*/
+t_ErrorCode	nfa_compile(t_Nfa *nfa, const char *pattern, size_t size,
+	bool fold, bool reverse);
+
+/**
+ * @brief Releases the states of the NFA.
+ * @param nfa The NFA.
+*/
+void		nfa_clean(t_Nfa *nfa);
+
+// +===----- DFA -----===+ //
+
+/**
+ * @brief Prepares the DFA of a compiled NFA.
+ * @param dfa The DFA, its NFA compiled.
+ * @param unanchored TRUE to restart the NFA at each byte.
+ * @return TRUE for success or FALSE if an error occured.
+*/
+bool		dfa_init(t_Dfa *dfa, bool unanchored);
+
+/**
+ * @brief Releases the DFA and its NFA.
+ * @param dfa The DFA.
+*/
+void		dfa_clean(t_Dfa *dfa);
+
+/**
+ * @brief Get the start state.
+ * @param dfa The DFA.
+ * @param bol TRUE at the start of the line.
+ * @return The state.
+*/
+int32_t		dfa_start(t_Dfa *dfa, bool bol);
+
+/**
+ * @brief Builds the transition of a state, it may reset the cache.
+ * @param dfa The DFA.
+ * @param state The state.
+ * @param byte The byte read.
+ * @return The next state.
+*/
+int32_t		dfa_build(t_Dfa *dfa, int32_t state, uint8_t byte);
+
+/**
+ * @brief Finds the end of the longest match from each position of a line, in
+ * one backward pass of the reversed NFA. Each NFA state keeps the farthest
+ * end it was reached from, so a pass costs O(size * NFA states).
+ * @param dfa The DFA of the reversed pattern.
+ * @param data The line data.
+ * @param size The line size.
+ * @param ends The ends, size + 1 positions, REGEX_NPOS where no match starts.
+ * @return TRUE for success or FALSE if an error occured.
+*/
+bool		dfa_longest(t_Dfa *dfa, const char *data, size_t size, size_t *ends);
+
+// +===----- Regex -----===+ //
+
+/**
+ * @brief Compiles a regular expression.
+ * Supported: literals, ., [...], [^...], \d \w \s \D \W \S, ^, $, (...),
+ * (?:...), |, *, +, ? and {m,n}. Matches are leftmost-longest.
+ * @param pattern The pattern.
+ * @param size The size of the pattern.
+ * @param fold TRUE to ignore the case of ASCII letters.
+ * @param regex The compiled expression, owned by the caller.
+ * @return ERR_INVALID_PATTERN, ERR_INTERNAL_MEMORY or SUCCESS (=0).
+*/
+t_ErrorCode	regex_compile(const char *pattern, size_t size, bool fold,
+	t_Regex **regex);
+
+/**
+ * @brief Finds where the matches of a line start, in one backward pass.
+ * @param regex The expression.
+ * @param data The line data, without the line ending.
+ * @param size The line size.
+ * @return TRUE for success or FALSE if an error occured.
+*/
+bool		regex_line(t_Regex *regex, const char *data, size_t size);
+
+/**
+ * @brief Get the leftmost-longest match of the prepared line from a position.
+ * @param regex The expression.
+ * @param from The byte position where the match can start (<= size).
+ * @param start The byte position of the start of the match.
+ * @param end The byte position after the match.
+ * @return TRUE if a match was found or FALSE otherwise.
+*/
+bool		regex_next(t_Regex *regex, size_t from, size_t *start, size_t *end);
+
+#endif
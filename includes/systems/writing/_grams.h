@@ -0,0 +1,101 @@
+#ifndef SEED_WRITING_GRAMS_H
+# define SEED_WRITING_GRAMS_H
+
+# include "dependency.h"
+
+# define GRAM_WORDS 6	/* The count of words of a line signature, one pool class */
+# define GRAM_BITS (GRAM_WORDS * 64)	/* The count of bits of a line signature */
+# define GRAM_BLOOM_BITS 65536	/* The count of bits of a buffer filter */
+# define GRAM_KEYS 64	/* The maximum count of trigrams checked in a filter */
+
+// +===----- Types -----===+ //
+
+typedef struct s_Line	t_Line;
+typedef struct s_Buffer	t_Buffer;
+
+/* The trigram index of a buffer */
+// Each trigram sets one bit of the buffer filter and one bit of the signature
+// of its line, ASCII letters are lowercased so that both also serve searches
+// that ignore the case. A buffer or a line can only contain a text if it has
+// every bit of the text: the others are skipped without reading their data.
+// The filter is updated by the edits, the bits of removed text are only
+// dropped when the filter is built again. A signature is computed again on
+// the first search after an edit of its line.
+typedef struct	s_GramIndex
+{
+	uint64_t	*bloom;	/* The buffer filter, or NULL without index */
+	size_t		size;	/* The count of bytes in the filter */
+	size_t		removed;	/* The count of bytes removed since the build */
+}	t_GramIndex;
+
+/* The trigrams of a searched text */
+typedef struct	s_GramMask
+{
+	uint64_t	bits[GRAM_WORDS];	/* The bits of a line signature */
+	uint32_t	keys[GRAM_KEYS];	/* The bits of a buffer filter */
+	size_t		key_count;	/* The count of keys, 0 if the text is too short */
+}	t_GramMask;
+
+// +===----- Index -----===+ //
+
+/**
+ * @brief Builds the trigram index of the buffer.
+ * @param buffer The buffer.
+ * @return TRUE for success or FALSE if an error occured.
+*/
+bool	grams_enable(t_Buffer *buffer);
+
+/**
+ * @brief Releases the trigram index of the buffer.
+ * @param buffer The buffer.
+*/
+void	grams_disable(t_Buffer *buffer);
+
+/**
+ * @brief Adds the trigrams around an edit of a line to the buffer filter.
+ * @param buffer The buffer that contains the line.
+ * @param line The line.
+ * @param start The byte position of the edit.
+ * @param end The byte position after the inserted data (== start on delete).
+ * @param removed The count of bytes deleted.
+*/
+void	grams_note(t_Buffer *buffer, t_Line *line, size_t start, size_t end,
+	size_t removed);
+
+/**
+ * @brief Releases the signature of a line.
+ * @param buffer The buffer that contains the line.
+ * @param line The line.
+*/
+void	grams_clean(t_Buffer *buffer, t_Line *line);
+
+// +===----- Queries -----===+ //
+
+/**
+ * @brief Get the trigrams of a searched text.
+ * @param data The text.
+ * @param size The size of the text.
+ * @param mask The trigrams.
+*/
+void	grams_mask(const char *data, size_t size, t_GramMask *mask);
+
+/**
+ * @brief Check if the buffer may contain the text, the filter is built again
+ * when half of it comes from removed text.
+ * @param buffer The buffer.
+ * @param mask The trigrams of the text.
+ * @return FALSE if the buffer cannot contain the text or TRUE otherwise.
+*/
+bool	grams_match_buffer(t_Buffer *buffer, const t_GramMask *mask);
+
+/**
+ * @brief Check if the line may contain the text, its signature is computed
+ * if it is stale.
+ * @param buffer The buffer that contains the line.
+ * @param line The line.
+ * @param mask The trigrams of the text.
+ * @return FALSE if the line cannot contain the text or TRUE otherwise.
+*/
+bool	grams_match(t_Buffer *buffer, t_Line *line, const t_GramMask *mask);
+
+#endif
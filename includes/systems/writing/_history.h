@@ -0,0 +1,171 @@
+#ifndef SEED_WRITING_HISTORY_H
+# define SEED_WRITING_HISTORY_H
+
+# include "dependency.h"
+
+# define HISTORY_BUDGET (16 << 20)	/* The maximum size of the records */
+
+// +===----- Types -----===+ //
+
+typedef struct s_Line	t_Line;
+typedef struct s_Buffer	t_Buffer;
+
+/* The kinds of edit records */
+typedef enum	e_RecordKind
+{
+	RECORD_INSERT,	/* Text inserted, it may contain line endings */
+	RECORD_DELETE,	/* Text deleted, it may contain line endings */
+	RECORD_LINE_INSERT,	/* Empty line inserted */
+	RECORD_LINE_DELETE	/* Line deleted with its content */
+}	t_RecordKind;
+
+/* The header of an edit record, followed by its text */
+// Positions are line indexes and byte positions, so that a record does not
+// depend on the lines that exist when it is replayed. A line ending of the
+// text is "\r\n" for a CRLF line and "\n" otherwise.
+typedef struct	s_Record
+{
+	size_t			line;	/* The line of the edit */
+	size_t			byte;	/* The byte position in the line */
+	size_t			size;	/* The text size */
+	size_t			back;	/* The distance to the previous record, or 0 */
+	unsigned char	kind;	/* The record kind */
+	unsigned char	flags;	/* The flags of the line of a line record */
+	bool			lines;	/* The text contains line endings */
+	bool			chain;	/* The record is undone with the previous one */
+}	t_Record;
+
+/* The undo history of a buffer */
+// Records are appended to one arena, the ones before the cursor are undone
+// from the last one and the ones after it are redone. A new edit drops the
+// records after the cursor. When the arena grows past the budget, the
+// oldest records are dropped. The records of a group are kept until the
+// group ends, so that a failed batch can always be reverted.
+typedef struct	s_History
+{
+	char	*data;	/* The records */
+	size_t	size;	/* The size of the records */
+	size_t	capacity;	/* The capacity of the arena */
+	size_t	cursor;	/* The end of the applied records */
+	size_t	last;	/* The start of the last applied record */
+	size_t	floor;	/* The start of the records of the group */
+	bool	merge;	/* The last record can be extended by the next edit */
+	bool	group;	/* The next records are chained to the first one */
+	bool	chain;	/* The next record is chained to the previous one */
+}	t_History;
+
+// +===----- History -----===+ //
+
+/**
+ * @brief Initializes an empty history.
+ * @param history The history.
+*/
+void	history_init(t_History *history);
+
+/**
+ * @brief Releases every record of the history.
+ * @param history The history.
+*/
+void	history_clean(t_History *history);
+
+/**
+ * @brief Starts or ends a group of records, which are undone and redone at
+ * once. The budget is checked when the group ends: a group larger than half
+ * of the budget cleans the history, as a record would.
+ * @param history The history.
+ * @param group TRUE to start a group or FALSE to end it.
+*/
+void	history_group(t_History *history, bool group);
+
+/**
+ * @brief Drops the applied records after the given cursor, without reverting
+ * them. It is used when an edit fails after it was recorded.
+ * @param history The history, in a group.
+ * @param cursor A cursor of the history, from the current group.
+*/
+void	history_drop(t_History *history, size_t cursor);
+
+/**
+ * @brief Reverts and drops the records of the current group, so that a failed
+ * batch leaves the buffer and the older records as they were.
+ * @param buffer The buffer.
+ * @return TRUE for success or FALSE if an error occured (the history is then
+ * cleaned).
+*/
+bool	history_rollback(t_Buffer *buffer);
+
+// +===----- Records -----===+ //
+
+// An edit is recorded after it is done when its text is known, and before
+// it is done when the text is deleted. If a record cannot be allocated, the
+// history is cleaned so that it never goes out of sync with the buffer.
+// In a group, records are never merged nor cleaned: the edits are recorded
+// before they are done, and a record that cannot be allocated stops the
+// batch, which is rolled back.
+// Each record, undo and redo also bumps the version of the buffer.
+
+/**
+ * @brief Records text inserted in the buffer, consecutive typing in a line
+ * extends the last record.
+ * @param buffer The buffer.
+ * @param line The line where the text starts.
+ * @param byte The byte position of the text.
+ * @param size The text size.
+ * @param data The text.
+ * @return TRUE for success or FALSE if the record could not be allocated.
+*/
+bool	history_insert(t_Buffer *buffer, t_Line *line, size_t byte, size_t size,
+	const char *data);
+
+/**
+ * @brief Records text that will be deleted from the buffer, consecutive
+ * deletions in a line extend the last record.
+ * @param buffer The buffer.
+ * @param first The line where the text starts.
+ * @param start The byte position of the start in the first line.
+ * @param last The line where the text ends.
+ * @param end The byte position of the end in the last line.
+ * @return TRUE for success or FALSE if the record could not be allocated.
+*/
+bool	history_delete(t_Buffer *buffer, t_Line *first, size_t start,
+	t_Line *last, size_t end);
+
+/**
+ * @brief Records an empty line inserted in the buffer.
+ * @param buffer The buffer.
+ * @param line The line.
+*/
+void	history_line_insert(t_Buffer *buffer, t_Line *line);
+
+/**
+ * @brief Records a line that will be deleted from the buffer.
+ * @param buffer The buffer.
+ * @param line The line.
+*/
+void	history_line_delete(t_Buffer *buffer, t_Line *line);
+
+// +===----- Replay -----===+ //
+
+// Undo needs at least one record before the cursor and redo one after it.
+
+/**
+ * @brief Reverts the last applied record.
+ * @param buffer The buffer.
+ * @param line The line of the edit.
+ * @param byte The byte position of the edit.
+ * @return TRUE for success or FALSE if an error occured (the history is then
+ * cleaned).
+*/
+bool	history_undo(t_Buffer *buffer, size_t *line, size_t *byte);
+
+/**
+ * @brief Applies again the next reverted record.
+ * @param buffer The buffer.
+ * @param line The line of the edit.
+ * @param byte The byte position after the edit.
+ * @return TRUE for success or FALSE if an error occured (the history is then
+ * cleaned).
+*/
+bool	history_redo(t_Buffer *buffer, size_t *line, size_t *byte);
+
+#endif
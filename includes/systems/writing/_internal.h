@@ -2,26 +2,135 @@
 # define SEED_WRITING_INTERNAL_H
 
 # include "dependency.h"
+# include "seed.h"
+# include "systems/writing/_pool.h"
+# include "systems/writing/_history.h"
+# include "systems/writing/_snapshot.h"
+# include "systems/writing/_grams.h"
+
+// +===----- Flags -----===+ //
+
+# define LINE_FREE 0x01	/* The line is released in the pool */
+# define LINE_ASCII 0x02	/* The line only contains ASCII */
+# define LINE_CRLF 0x04	/* The line ends with CRLF instead of LF */
+# define LINE_GRAMS 0x08	/* The trigram signature is up to date */
+# define LINE_UTF16 0x10	/* LINE_ASTRAL is up to date */
+# define LINE_ASTRAL 0x20	/* The line has characters above U+FFFF */
+# define LINE_CELLS 0x40	/* LINE_WIDE is up to date */
+# define LINE_WIDE 0x80	/* The line has tabs, wide, zero-width or joined characters */
+
+# define UTF_NPOS ((size_t)-1)	/* Invalid position */
+
+# define LINE_INLINE 32	/* The size of the data stored in the line itself */
+
+# define UTF_STEP 64	/* The count of characters between two checkpoints */
+# define UTF_MARKS_MIN 256	/* The line size from which checkpoints are kept */
 
 // +===----- Types -----===+ //
 
+/* The data of a line that is only kept on demand */
+// The checkpoint k is the byte position of the character k * UTF_STEP. Only
+// the first `count` checkpoints are valid, an edit drops the ones after it
+// and they are scanned again on demand.
+// The block is allocated with the first checkpoint, trigram signature or
+// wrapped row after the first one, the nodes of the other lines stay small.
+typedef struct	s_LineExtra
+{
+	uint64_t	*grams;	/* The trigram signature, or NULL */
+	size_t		height;	/* The count of wrapped rows of the line */
+	size_t		count;	/* The count of valid checkpoints */
+	size_t		capacity;	/* The checkpoints capacity */
+	size_t		bytes[];	/* The byte positions */
+}	t_LineExtra;
+
 /* A line in writing system */
+// A line with data but no capacity borrows its data from the origin of its
+// buffer, it is copied on the first write.
+// A short line stores its data in the line itself, it moves to the pool
+// when it grows past LINE_INLINE bytes.
+// Long lines are edited as a gap buffer: the bytes after the gap are stored
+// at the end of the capacity (minus one byte for the terminator).
+// The data of a line stamped before the last snapshot may be read by a
+// snapshot, the first edit after it copies the data before changing it.
 typedef struct	s_Line
 {
 	char			*data;	/* The data content */
 	size_t			size;	/* The data size content */
 	size_t			capacity;	/* The data capacity */
+	size_t			gap;	/* The gap position (== size if contiguous) */
 	struct s_Line	*prev;	/* The previous line */
 	struct s_Line	*next; 	/* The next line */
+	struct s_Line	*parent;	/* The parent node in the line tree */
+	struct s_Line	*left;	/* The left child in the line tree */
+	struct s_Line	*right;	/* The right child in the line tree */
+	size_t			count;	/* The count of lines in this subtree */
+	size_t			bytes;	/* The count of bytes in this subtree, line endings included */
+	size_t			rows;	/* The count of wrapped rows in this subtree */
+	t_LineExtra		*extra;	/* The checkpoints, signature and height, or NULL */
+	unsigned int	priority;	/* The heap priority in the line tree */
+	unsigned int	stamp;	/* The count of snapshots when its data was last owned */
+	unsigned int	loan;	/* The stamp when its inline data was left to snapshots, or 0 */
+	unsigned char	flags;	/* The line flags */
+	char			inline_data[LINE_INLINE];	/* The data of a short line */
 }	t_Line;
 
+/* The soft wrap layout of a buffer */
+// Each line keeps its count of rows at the wrap width and the line tree sums
+// them, so that a row is found from the root like a line. A line is cut
+// before the grapheme cluster that does not fit, and its rows are counted
+// again when it is edited. Without wrap, each line is one row.
+typedef struct	s_Wrap
+{
+	size_t	width;	/* The count of columns of a row, or 0 without wrap */
+	size_t	tab;	/* The count of columns between two tab stops */
+}	t_Wrap;
+
 /* A buffer in writing system */
 typedef struct	s_Buffer
 {
-	t_Line	*line;	/* The  first line */
-	size_t	size;	/* The count of lines */
+	t_Line			*line;	/* The first line */
+	t_Line			*last;	/* The last line */
+	t_Line			*root;	/* The root of the line tree */
+	size_t			size;	/* The count of lines */
+	size_t			version;	/* The count of edits, undos and redos */
+	unsigned int	seed;	/* The priority generator state */
+	bool			crlf;	/* New lines end with CRLF */
+	t_GramIndex		grams;	/* The trigram index */
+	t_Wrap			wrap;	/* The soft wrap layout */
+	const char		*origin;	/* The immutable mapped file content */
+	size_t			origin_size;	/* The size of the mapped file */
+	t_Mapping		*mapping;	/* The mapping of the origin, or NULL */
+	t_Pool			pool;	/* The allocator of lines and data */
+	t_History		history;	/* The undo history */
+	t_Views			views;	/* The views of the lines shared with snapshots */
 }	t_Buffer;
 
+/* A search in a buffer */
+typedef struct	s_Find
+{
+	const char	*needle;	/* The searched text, without line endings */
+	size_t		size;	/* The size of the searched text */
+	bool		fold;	/* Ignore the case of ASCII letters */
+	t_Match		*matches;	/* The matches */
+	size_t		capacity;	/* The maximum count of matches */
+	size_t		count;	/* The count of matches */
+}	t_Find;
+
+/* A range of bytes of a line */
+typedef struct	s_Range
+{
+	size_t	start;	/* The byte position of the start */
+	size_t	end;	/* The byte position after the range */
+}	t_Range;
+
+/* An edit of a batch resolved in its line */
+typedef struct	s_EditSlot
+{
+	t_Edit	*edit;	/* The edit */
+	size_t	start;	/* The byte position of the start */
+	size_t	end;	/* The byte position after the deleted data */
+}	t_EditSlot;
+
 // +===----- Buffer -----===+ //
 
 /**
@@ -36,13 +145,51 @@ t_Buffer	*buffer_create(void);
 */
 void		buffer_destroy(t_Buffer *buffer);
 
+/**
+ * @brief Loads a file in an empty buffer without copying it.
+ * The file is mapped read-only and each line borrows its data from the
+ * mapping until it is edited. A CR before a LF is not part of the line, the
+ * line is flagged instead, and the first line gives the style of new lines.
+ * @param buffer The empty buffer.
+ * @param path The absolute path of the file.
+ * @return TRUE for success or FALSE if an error occured.
+*/
+bool		buffer_map_file(t_Buffer *buffer, const char *path);
+
+/**
+ * @brief Writes the lines of the buffer to the file descriptor.
+ * Lines are written in place with batches of iovecs, each line is followed
+ * by its line ending except the last one. Unedited lines of a mapped file
+ * are written as one range of the mapping.
+ * @param buffer The buffer.
+ * @param fd The file descriptor.
+ * @param size The count of bytes written.
+ * @return TRUE for success or FALSE if an error occured.
+*/
+bool		buffer_write(t_Buffer *buffer, int fd, size_t *size);
+
 // +===----- Lines -----===+ //
 
 /**
  * @brief Creates a new empty line.
+ * @param buffer The buffer that will contain the line.
  * @return The line that has just been created.
 */
-t_Line		*line_create(void);
+t_Line		*line_create(t_Buffer *buffer);
+
+/**
+ * @brief Destroys a line that is not linked in the buffer.
+ * @param buffer The buffer that has created the line.
+ * @param line The line that will be destroyed.
+*/
+void		line_destroy(t_Buffer *buffer, t_Line *line);
+
+/**
+ * @brief Get the extra data of the line, it is allocated on the first use.
+ * @param line The line.
+ * @return The extra data, or NULL if an error occured.
+*/
+t_LineExtra	*line_extra(t_Line *line);
 
 /**
  * @brief Destroys the given line.
@@ -69,7 +216,8 @@ bool		buffer_line_insert(t_Buffer *buffer, t_Line *line, ssize_t index);
 t_Line		*buffer_line_split(t_Buffer *buffer, t_Line *line, size_t index);
 
 /**
- * @brief Joins the givens line in one line.
+ * @brief Joins the givens line in one line, which takes the line ending of
+ * the source line.
  * @param buffer The buffer that contains lines.
  * @param dst The line that will be contains the lines joined.
  * @param src The line that will be destroyed.
@@ -77,6 +225,47 @@ t_Line		*buffer_line_split(t_Buffer *buffer, t_Line *line, size_t index);
 */
 t_Line		*buffer_line_join(t_Buffer *buffer, t_Line *dst, t_Line *src);
 
+/**
+ * @brief Inserts text that may contain line endings in one pass.
+ * The line is split at the position, the first pasted line is appended to it,
+ * the next ones are added after it and the last one is prepended to the
+ * rest of the line. A CR before a LF gives the line ending of its line.
+ * @param buffer The buffer that contains lines.
+ * @param line The line.
+ * @param index The byte position where the text is inserted.
+ * @param size The size of the text.
+ * @param data The text.
+ * @param end_line The index of the line where the text ends.
+ * @return The line where the text ends, or NULL if an error occured.
+*/
+t_Line		*buffer_insert_text(t_Buffer *buffer, t_Line *line, size_t index,
+	size_t size, const char *data, size_t *end_line);
+
+/**
+ * @brief Deletes text that may span several lines in one pass.
+ * The end of the last line is appended to the first line and the lines
+ * after the first one are unlinked at once, then released.
+ * @param buffer The buffer that contains lines.
+ * @param first The line where the text starts.
+ * @param start The byte position of the start in the first line.
+ * @param last The line where the text ends, not before the first line.
+ * @param end The byte position of the end in the last line.
+ * @return TRUE for success or FALSE if an error occured.
+*/
+bool		buffer_delete_text(t_Buffer *buffer, t_Line *first, size_t start,
+	t_Line *last, size_t end);
+
+/**
+ * @brief Wraps the lines of the buffer at the given width, the rows of each
+ * line are counted.
+ * @param buffer The buffer.
+ * @param width The count of columns of a row, or 0 to unwrap the lines.
+ * @param tab The count of columns between two tab stops (> 0).
+ * @return TRUE for success or FALSE if an error occured, the lines that
+ * could not be counted keep one row.
+*/
+bool		buffer_wrap(t_Buffer *buffer, size_t width, size_t tab);
+
 /**
  * @brief Get the line of the given index.
  * @param buffer The buffer that contains lines.
@@ -85,25 +274,189 @@ t_Line		*buffer_line_join(t_Buffer *buffer, t_Line *dst, t_Line *src);
 */
 t_Line		*buffer_get_line(t_Buffer *buffer, ssize_t index);
 
+// +===----- Search -----===+ //
+
+/**
+ * @brief Finds the matches that start at or after the given position, a
+ * match is searched again after the end of the previous one.
+ * Unedited lines of a mapped file that follow each other in the mapping are
+ * searched as one block.
+ * @param line The line where the search starts.
+ * @param byte The byte position where the search starts.
+ * @param find The search, its matches are appended until it is full.
+*/
+void		find_forward(t_Line *line, size_t byte, t_Find *find);
+
+/**
+ * @brief Finds the matches that start before the given position, from the
+ * closest one.
+ * @param line The line where the search starts.
+ * @param byte The byte position where the search starts.
+ * @param find The search, its matches are appended until it is full.
+*/
+void		find_backward(t_Line *line, size_t byte, t_Find *find);
+
+/**
+ * @brief Finds the matches of a regular expression from the given position.
+ * Each line is read once backward, then forward from each match. A line
+ * prepared by the previous chunk at the same version is not read again.
+ * @param line The line where the search starts.
+ * @param byte The byte position where the search starts.
+ * @param regex The expression.
+ * @param version The version of the buffer.
+ * @param find The search, its matches are appended until it is full.
+ * @param next The match that did not fit, or the line after the last one.
+ * @return TRUE for success or FALSE if an error occured.
+*/
+bool		find_regex(t_Line *line, size_t byte, t_Regex *regex, size_t version,
+	t_Find *find, t_Match *next);
+
+/**
+ * @brief Finds the matches from the given position line by line. With a
+ * trigram index, the buffer or the lines that lack a trigram of the text are
+ * skipped.
+ * @param buffer The buffer that contains the lines.
+ * @param line The line where the search starts.
+ * @param byte The byte position where the search starts.
+ * @param find The search, its matches are appended until it is full.
+ * @param next The match that did not fit, or the line after the last one.
+*/
+void		find_indexed(t_Buffer *buffer, t_Line *line, size_t byte,
+	t_Find *find, t_Match *next);
+
+/**
+ * @brief Get the byte ranges of the matches of one line, a match is searched
+ * again after the end of the previous one.
+ * @param line The line.
+ * @param find The search, only its text is used.
+ * @param regex The expression, or NULL to search the text.
+ * @param ranges The ranges, grown if needed.
+ * @param capacity The capacity of the ranges.
+ * @return The count of ranges, or UTF_NPOS if an error occured.
+*/
+size_t		find_ranges(t_Line *line, const t_Find *find, t_Regex *regex,
+	t_Range **ranges, size_t *capacity);
+
 // +===----- Data -----===+ //
 
+/**
+ * @brief Get the data after the gap of the line, the gap is left in place.
+ * @param line The line.
+ * @return The tail, or the data of a line without a gap buffer.
+*/
+char		*line_tail(const t_Line *line);
+
+/**
+ * @brief Get the contiguous data of the given line, the gap is closed if needed.
+ * @param line The line.
+ * @return The data content.
+*/
+const char	*line_get_data(t_Line *line);
+
+/**
+ * @brief Converts the index of a character to the position of its first byte.
+ * ASCII lines resolve it directly, long lines from the nearest checkpoint.
+ * @param line The line.
+ * @param index The index of the character.
+ * @return The position of the first byte, or UTF_NPOS if out of range.
+*/
+size_t		line_char_to_byte(t_Line *line, size_t index);
+
+/**
+ * @brief Skips characters from the given byte position.
+ * @param line The line.
+ * @param byte The position of the first byte of a character.
+ * @param count The count of characters to skip.
+ * @return The position after the characters, or UTF_NPOS if out of range.
+*/
+size_t		line_char_skip(const t_Line *line, size_t byte, size_t count);
+
+/**
+ * @brief Skips UTF-16 code units from the given byte position, a unit inside
+ * a surrogate pair gives the position of the pair.
+ * Lines without characters above U+FFFF use the character checkpoints.
+ * @param line The line.
+ * @param byte The position of the first byte of a character.
+ * @param units The count of code units to skip, set to 1 if the last one is
+ * inside a surrogate pair or 0 otherwise.
+ * @return The position after the code units, or UTF_NPOS if out of range.
+*/
+size_t		line_utf16_skip(t_Line *line, size_t byte, size_t *units);
+
+/**
+ * @brief Counts the UTF-16 code units between two byte positions.
+ * @param line The line.
+ * @param start The position of the first byte of a character.
+ * @param end The position of the first byte of a character (<= size).
+ * @return The count of code units.
+*/
+size_t		line_utf16_count(t_Line *line, size_t start, size_t end);
+
+/**
+ * @brief Walks the grapheme clusters of the line from the given position
+ * until a limit, a cluster that crosses a limit is not walked.
+ * Lines where each character is a cluster of one cell use the character
+ * checkpoints.
+ * @param line The line.
+ * @param byte The position of the first byte of a cluster.
+ * @param column The column of the position, set to the column reached.
+ * @param end The byte position limit, or UTF_NPOS.
+ * @param end_column The column limit, or UTF_NPOS.
+ * @param tab The count of columns between two tab stops (> 0).
+ * @return The position reached.
+*/
+size_t		line_column_walk(t_Line *line, size_t byte, size_t *column,
+	size_t end, size_t end_column, size_t tab);
+
+/**
+ * @brief Walks the wrapped rows of the line until the given row or the row
+ * that contains the given position.
+ * Lines where each character is a cluster of one cell are cut by count.
+ * @param line The line.
+ * @param wrap The layout, a width of 0 gives one row.
+ * @param row The last row walked, or UTF_NPOS; set to the row reached.
+ * @param byte The position of the first byte of a character, or UTF_NPOS.
+ * @return The position of the start of the row reached.
+*/
+size_t		line_wrap(t_Line *line, const t_Wrap *wrap, size_t *row,
+	size_t byte);
+
 /**
  * @brief Add the data to the given line.
+ * @param buffer The buffer that contains the line.
  * @param line The line.
  * @param column The first column where data is added.
  * @param size The size of the data.
  * @param data The data that will be added.
  * @return TRUE for success or FALSE if an error occured.
 */
-bool		line_insert_data(t_Line *line, ssize_t column, size_t size, const char *data);
+bool		line_insert_data(t_Buffer *buffer, t_Line *line, ssize_t column,
+	size_t size, const char *data);
 
 /**
  * @brief Delete the data to the given line.
+ * @param buffer The buffer that contains the line.
  * @param line The line.
  * @param column The first column where data is added.
  * @param size The size of the data.
  * @return TRUE for success or FALSE if an error occured.
 */
-bool		line_delete_data(t_Line *line, size_t column, size_t size);
+bool		line_delete_data(t_Buffer *buffer, t_Line *line, size_t column,
+	size_t size);
+
+/**
+ * @brief Replaces ranges of the line with the same data in one pass.
+ * The new content is copied once in an allocation sized for it, which
+ * replaces the data of the line.
+ * @param buffer The buffer that contains the line.
+ * @param line The line.
+ * @param ranges The sorted ranges, which do not overlap.
+ * @param count The count of ranges.
+ * @param size The size of the data.
+ * @param data The data, without line endings.
+ * @return TRUE for success or FALSE if an error occured.
+*/
+bool		line_replace_ranges(t_Buffer *buffer, t_Line *line,
+	const t_Range *ranges, size_t count, size_t size, const char *data);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,121 @@
+#ifndef SEED_WRITING_POOL_H
+# define SEED_WRITING_POOL_H
+
+# include "dependency.h"
+
+# define POOL_LINES 1024	/* The count of lines of a line block */
+# define POOL_CHUNK 65536	/* The size of a data chunk */
+# define POOL_MIN 48	/* The smallest data class */
+# define POOL_MAX 4096	/* The largest data class */
+# define POOL_CLASSES 14	/* The count of data classes */
+
+// +===----- Types -----===+ //
+
+typedef struct s_Line	t_Line;
+
+/* Lines allocated at once */
+typedef struct	s_LineBlock
+{
+	struct s_LineBlock	*next;	/* The next block */
+	size_t				count;	/* The count of lines */
+	size_t				used;	/* The count of lines handed out */
+	t_Line				*lines;	/* The lines */
+}	t_LineBlock;
+
+/* Line data allocated at once */
+typedef struct	s_DataChunk
+{
+	struct s_DataChunk	*next;	/* The next chunk */
+}	t_DataChunk;
+
+/* The allocator of a buffer */
+// Lines come from blocks and line data from classes carved in chunks, both
+// are released in bulk with the pool. The classes alternate between 3 * 2^k
+// and 4 * 2^k bytes so that a line wastes at most a third of its data.
+// Data larger than POOL_MAX uses the heap and doubles when it grows.
+typedef struct	s_Pool
+{
+	t_LineBlock	*blocks;	/* The line blocks */
+	t_Line		*free_lines;	/* The released lines */
+	t_DataChunk	*chunks;	/* The data chunks */
+	char		*cursor;	/* The free space of the current chunk */
+	size_t		left;	/* The size of the free space */
+	void		*free_data[POOL_CLASSES];	/* The released data by class */
+	size_t		allocs;	/* The count of heap allocations */
+}	t_Pool;
+
+// +===----- Pool -----===+ //
+
+/**
+ * @brief Initializes an empty pool.
+ * @param pool The pool.
+*/
+void	pool_init(t_Pool *pool);
+
+/**
+ * @brief Releases every line and data of the pool.
+ * @param pool The pool.
+*/
+void	pool_clean(t_Pool *pool);
+
+// +===----- Lines -----===+ //
+
+/**
+ * @brief Allocates an uninitialized line.
+ * @param pool The pool.
+ * @return The line, or NULL if an error occured.
+*/
+t_Line	*pool_line_alloc(t_Pool *pool);
+
+/**
+ * @brief Allocates contiguous uninitialized lines.
+ * @param pool The pool.
+ * @param count The count of lines.
+ * @return The first line, or NULL if an error occured.
+*/
+t_Line	*pool_lines_alloc(t_Pool *pool, size_t count);
+
+/**
+ * @brief Releases a line, its data is not released.
+ * @param pool The pool.
+ * @param line The line.
+*/
+void	pool_line_free(t_Pool *pool, t_Line *line);
+
+// +===----- Data -----===+ //
+
+/**
+ * @brief Get the capacity that will be allocated for the given size.
+ * @param size The needed size.
+ * @return The capacity.
+*/
+size_t	pool_data_capacity(size_t size);
+
+/**
+ * @brief Allocates a line data.
+ * @param pool The pool.
+ * @param capacity The capacity, given by pool_data_capacity.
+ * @return The data, or NULL if an error occured.
+*/
+char	*pool_data_alloc(t_Pool *pool, size_t capacity);
+
+/**
+ * @brief Grows a line data, its content is kept.
+ * @param pool The pool.
+ * @param data The data, or NULL.
+ * @param capacity The current capacity.
+ * @param new_capacity The new capacity, given by pool_data_capacity.
+ * @return The data, or NULL if an error occured.
+*/
+char	*pool_data_realloc(t_Pool *pool, char *data, size_t capacity,
+	size_t new_capacity);
+
+/**
+ * @brief Releases a line data.
+ * @param pool The pool.
+ * @param data The data.
+ * @param capacity The capacity of the data.
+*/
+void	pool_data_free(t_Pool *pool, char *data, size_t capacity);
+
+#endif
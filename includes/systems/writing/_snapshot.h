@@ -0,0 +1,214 @@
+#ifndef SEED_WRITING_SNAPSHOT_H
+# define SEED_WRITING_SNAPSHOT_H
+
+# include "dependency.h"
+# include "seed.h"
+# include "systems/writing/_pool.h"
+# include <stdatomic.h>
+
+# define VIEW_FANOUT 32	/* The maximum count of entries or children of a view node */
+# define VIEW_LATE 16	/* The maximum count of edited lines with a late view */
+
+// +===----- Types -----===+ //
+
+typedef struct s_Line	t_Line;
+typedef struct s_Buffer	t_Buffer;
+
+/* A mapped file shared by a buffer and its snapshots */
+typedef struct	s_Mapping
+{
+	atomic_size_t	refs;	/* The count of owners */
+	const char		*data;	/* The mapped content */
+	size_t			size;	/* The mapped size */
+}	t_Mapping;
+
+/* The view of a line kept in the view tree */
+typedef struct	s_ViewEntry
+{
+	const char		*data;	/* The data of the line, contiguous */
+	size_t			size;	/* The data size */
+	unsigned char	flags;	/* LINE_CRLF if the line ends with CRLF */
+}	t_ViewEntry;
+
+/* A node of the view tree */
+// The views of the lines form a B-tree indexed by line, the leaves hold the
+// entries and the other nodes hold children. A node stamped before the last
+// snapshot may be read by a snapshot: it is never changed again, an edit
+// copies it with the path from the root instead.
+typedef struct	s_ViewNode
+{
+	size_t			count;	/* The count of lines in this subtree */
+	unsigned int	stamp;	/* The stamp of the buffer when it was created */
+	unsigned int	used;	/* The count of entries or children */
+	bool			leaf;	/* The node holds entries */
+	union
+	{
+		struct
+		{
+			struct s_ViewNode	*nodes[VIEW_FANOUT];	/* The children */
+			size_t				counts[VIEW_FANOUT];	/* The count of lines of each child */
+		};
+		t_ViewEntry			entries[VIEW_FANOUT];	/* The entries */
+	};
+}	t_ViewNode;
+
+/* The kinds of retired memory */
+typedef enum	e_RetiredKind
+{
+	RETIRED_NODE,	/* A node of the view tree */
+	RETIRED_DATA,	/* The data of a line, allocated in the pool */
+	RETIRED_LINE	/* A line whose inline data was viewed */
+}	t_RetiredKind;
+
+/* Memory that the buffer no longer uses but a snapshot may read */
+typedef struct	s_Retired
+{
+	void			*ptr;	/* The memory */
+	size_t			capacity;	/* The capacity of the data */
+	unsigned int	stamp;	/* The stamp of the buffer when it was retired */
+	unsigned char	kind;	/* The kind of memory */
+}	t_Retired;
+
+/* The memory shared by a buffer and its snapshots */
+// Retired memory is released by the buffer once every snapshot taken before
+// its retirement is released. The live snapshots are listed from the oldest
+// one under the lock, since they are released from any thread. When the
+// buffer is destroyed first, it leaves its pool and its view tree to the
+// last snapshot.
+typedef struct	s_Shared
+{
+	atomic_size_t		refs;	/* The count of owners */
+	atomic_flag			lock;	/* The lock of the list of snapshots */
+	struct s_Snapshot	*oldest;	/* The oldest live snapshot */
+	struct s_Snapshot	*newest;	/* The newest live snapshot */
+	t_Retired			*retired;	/* The retired memory, oldest first */
+	size_t				count;	/* The count of retired memory */
+	size_t				capacity;	/* The capacity of the retired memory */
+	t_Pool				pool;	/* The pool left by the buffer, or an empty one */
+	t_ViewNode			*root;	/* The view tree left by the buffer, or NULL */
+}	t_Shared;
+
+/* The views of the lines of a buffer */
+// The view tree is kept in step with the line tree. An edited line is
+// listed as late instead of updating its view at each keystroke, its view is
+// updated when it leaves the list or before a snapshot.
+typedef struct	s_Views
+{
+	t_ViewNode		*root;	/* The root of the view tree, or NULL */
+	t_Line			*late[VIEW_LATE];	/* The edited lines, oldest first */
+	size_t			late_count;	/* The count of late lines */
+	unsigned int	stamp;	/* The count of snapshots taken */
+	bool			lost;	/* The tree could not follow an edit */
+	t_Shared		*shared;	/* The memory shared with snapshots, or NULL */
+}	t_Views;
+
+/* An immutable version of the lines of a buffer */
+// A snapshot takes a reference to the root of the view tree, the nodes and
+// the line data it reaches are not changed until it is released. Only the
+// count of owners and the list of snapshots change after the creation, a
+// snapshot can be read from any thread.
+struct	s_Snapshot
+{
+	atomic_size_t		refs;	/* The count of owners */
+	size_t				count;	/* The count of lines */
+	unsigned int		stamp;	/* The stamp of the buffer it was taken at */
+	t_ViewNode			*root;	/* The root of the view tree, or NULL */
+	t_Mapping			*mapping;	/* The mapped file, or NULL */
+	t_Shared			*shared;	/* The memory shared with the buffer */
+	struct s_Snapshot	*older;	/* The previous live snapshot */
+	struct s_Snapshot	*newer;	/* The next live snapshot */
+};
+
+// +===----- Mapping -----===+ //
+
+/**
+ * @brief Maps a file read-only.
+ * @param fd The file descriptor of a regular file.
+ * @param size The file size (> 0).
+ * @return The mapping owned by the caller, or NULL if an error occured.
+*/
+t_Mapping	*mapping_create(int fd, size_t size);
+
+/**
+ * @brief Adds an owner to the mapping.
+ * @param mapping The mapping.
+ * @return The mapping.
+*/
+t_Mapping	*mapping_retain(t_Mapping *mapping);
+
+/**
+ * @brief Removes an owner of the mapping, the last one unmaps it.
+ * @param mapping The mapping, or NULL.
+*/
+void		mapping_release(t_Mapping *mapping);
+
+// +===----- Views -----===+ //
+
+/**
+ * @brief Initializes empty views.
+ * @param views The views.
+*/
+void		views_init(t_Views *views);
+
+/**
+ * @brief Releases the views of a buffer that is destroyed, the memory read
+ * by snapshots is left to them.
+ * @param buffer The buffer, its pool is emptied if it is left.
+*/
+void		views_clean(t_Buffer *buffer);
+
+/**
+ * @brief Builds the view tree again from the lines of the buffer.
+ * @param buffer The buffer.
+*/
+void		views_build(t_Buffer *buffer);
+
+/**
+ * @brief Adds the view of a line that has just been linked.
+ * @param buffer The buffer.
+ * @param line The line.
+ * @param index The index of the line.
+*/
+void		views_insert(t_Buffer *buffer, t_Line *line, size_t index);
+
+/**
+ * @brief Removes the views of lines that are about to be unlinked.
+ * @param buffer The buffer.
+ * @param first The first line.
+ * @param index The index of the first line.
+ * @param count The count of lines.
+*/
+void		views_remove(t_Buffer *buffer, t_Line *first, size_t index,
+	size_t count);
+
+/**
+ * @brief Lists an edited line as late, the oldest late line is updated if
+ * the list is full. Lines that are not linked are ignored.
+ * @param buffer The buffer.
+ * @param line The line.
+*/
+void		views_note(t_Buffer *buffer, t_Line *line);
+
+/**
+ * @brief Keeps memory that a snapshot may read until it is released.
+ * @param buffer The buffer.
+ * @param ptr The memory.
+ * @param capacity The capacity of line data, or 0.
+ * @param kind The kind of memory.
+*/
+void		views_retire(t_Buffer *buffer, void *ptr, size_t capacity,
+	t_RetiredKind kind);
+
+// +===----- Snapshot -----===+ //
+
+/**
+ * @brief Takes a snapshot of the buffer.
+ * The late views are updated, then the snapshot takes a reference to the
+ * root of the view tree: the cost does not depend on the size of the buffer.
+ * Each line and node is copied by the first edit that changes it afterwards.
+ * @param buffer The buffer.
+ * @return The snapshot owned by the caller, or NULL if an error occured.
+*/
+t_Snapshot	*snapshot_create(t_Buffer *buffer);
+
+#endif
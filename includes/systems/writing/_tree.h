@@ -0,0 +1,151 @@
+#ifndef SEED_WRITING_TREE_H
+# define SEED_WRITING_TREE_H
+
+# include "dependency.h"
+
+// +===----- Types -----===+ //
+
+typedef struct s_Line	t_Line;
+typedef struct s_Buffer	t_Buffer;
+
+// The lines of a buffer are indexed by a treap ordered by line position.
+// Each node stores the count of lines, of bytes and of wrapped rows of its
+// subtree, so that the lookup by position, by byte offset or by row, the
+// insertion and the removal of a line are O(log n).
+
+// +===----- Nodes -----===+ //
+
+/**
+ * @brief Recomputes the subtree summary of the given node from its children.
+ * @param node The node.
+*/
+void	tree_update(t_Line *node);
+
+/**
+ * @brief Recomputes the subtree summaries from the given node up to the root.
+ * @param node The first node that will be updated.
+*/
+void	tree_propagate(t_Line *node);
+
+/**
+ * @brief Adds the change of the size of the line to the byte counts of its
+ * subtree and of the subtrees above.
+ * @param line The line.
+ * @param delta The change of the size of the line, in bytes.
+*/
+void	tree_resize(t_Line *line, ssize_t delta);
+
+/**
+ * @brief Get the count of wrapped rows of the line, 1 without extra data.
+ * @param line The line.
+ * @return The count of rows.
+*/
+size_t	tree_height(const t_Line *line);
+
+/**
+ * @brief Sets the count of wrapped rows of the line and adds the change to
+ * the row counts of its subtree and of the subtrees above.
+ * @param line The line.
+ * @param height The count of rows of the line, the line must have extra data
+ * if it is not 1.
+*/
+void	tree_set_height(t_Line *line, size_t height);
+
+/**
+ * @brief Builds the tree of an empty buffer from contiguous lines.
+ * @param buffer The empty buffer.
+ * @param lines The lines, in order.
+ * @param count The count of lines.
+*/
+void	tree_build(t_Buffer *buffer, t_Line *lines, size_t count);
+
+// +===----- Lookup -----===+ //
+
+/**
+ * @brief Get the line at the given position.
+ * @param root The root of the line tree.
+ * @param index The position of the line.
+ * @return The line, or NULL if the index is out of range.
+*/
+t_Line	*tree_at(t_Line *root, size_t index);
+
+/**
+ * @brief Get the line that contains the given byte offset, a line counts its
+ * line ending.
+ * @param root The root of the line tree.
+ * @param offset The byte offset, changed to the offset in the line.
+ * @return The line, or NULL if the offset is out of range.
+*/
+t_Line	*tree_at_offset(t_Line *root, size_t *offset);
+
+/**
+ * @brief Get the line that contains the given wrapped row.
+ * @param root The root of the line tree.
+ * @param row The row, changed to the row in the line.
+ * @return The line, or NULL if the row is out of range.
+*/
+t_Line	*tree_at_row(t_Line *root, size_t *row);
+
+/**
+ * @brief Get the first wrapped row of the given line in its tree.
+ * @param line The line.
+ * @return The row of the line.
+*/
+size_t	tree_row(const t_Line *line);
+
+/**
+ * @brief Get the byte offset of the start of the given line in its tree.
+ * @param line The line.
+ * @return The offset of the line.
+*/
+size_t	tree_offset(const t_Line *line);
+
+/**
+ * @brief Get the position of the given line in its tree.
+ * @param line The line.
+ * @return The position of the line.
+*/
+size_t	tree_index(const t_Line *line);
+
+// +===----- Edition -----===+ //
+
+/**
+ * @brief Links the line in the tree of the buffer at the given position.
+ * @param buffer The buffer that contains lines.
+ * @param line The line that will be linked.
+ * @param index The position of the line (<= buffer->size).
+*/
+void	tree_insert(t_Buffer *buffer, t_Line *line, size_t index);
+
+/**
+ * @brief Links lines at the given position at once, they are built in a
+ * balanced subtree which is merged in the tree of the buffer.
+ * @param buffer The buffer that contains lines.
+ * @param first The first line, the lines are linked by their next line.
+ * @param last The last line.
+ * @param count The count of lines.
+ * @param index The position of the first line (<= buffer->size).
+*/
+void	tree_insert_list(t_Buffer *buffer, t_Line *first, t_Line *last,
+	size_t count, size_t index);
+
+/**
+ * @brief Unlinks consecutive lines at once, they stay linked to each other
+ * by their next line.
+ * @param buffer The buffer that contains lines.
+ * @param first The first line.
+ * @param last The last line.
+ * @param count The count of lines.
+ * @param index The position of the first line.
+*/
+void	tree_remove_list(t_Buffer *buffer, t_Line *first, t_Line *last,
+	size_t count, size_t index);
+
+/**
+ * @brief Unlinks the line from the tree of the buffer.
+ * @param buffer The buffer that contains lines.
+ * @param line The line that will be unlinked.
+*/
+void	tree_remove(t_Buffer *buffer, t_Line *line);
+
+#endif
@@ -21,6 +21,22 @@ t_ErrorCode	cmd_buffer_create(t_Manager *manager, const t_Command *cmd);
 */
 t_ErrorCode	cmd_buffer_destroy(t_Manager *manager, const t_Command *cmd);
 
+/**
+ * @brief Loads a file of the root directory in a new buffer.
+ * @param manager The manager that will contains contexts.
+ * @param cmd The content of the command.
+ * @return An error code or SUCCESS (=0).
+*/
+t_ErrorCode	cmd_buffer_load_file(t_Manager *manager, const t_Command *cmd);
+
+/**
+ * @brief Saves the buffer in a file of the root directory.
+ * @param manager The manager that will contains contexts.
+ * @param cmd The content of the command.
+ * @return An error code or SUCCESS (=0).
+*/
+t_ErrorCode	cmd_buffer_save(t_Manager *manager, const t_Command *cmd);
+
 // +===----- Lines -----===+ //
 
 /**
@@ -63,6 +79,103 @@ t_ErrorCode	cmd_buffer_line_join(t_Manager *manager, const t_Command *cmd);
 */
 t_ErrorCode	cmd_buffer_get_line(t_Manager *manager, const t_Command *cmd);
 
+/**
+ * @brief Get the consecutive lines from the given index in one walk.
+ * @param manager The manager that will contains contexts.
+ * @param cmd The content of the command.
+ * @return An error code or SUCCESS (=0).
+*/
+t_ErrorCode	cmd_buffer_get_lines(t_Manager *manager, const t_Command *cmd);
+
+/**
+ * @brief Finds the occurrences of a text from a position of the buffer.
+ * @param manager The manager that will contains contexts.
+ * @param cmd The content of the command.
+ * @return An error code or SUCCESS (=0).
+*/
+t_ErrorCode	cmd_buffer_find(t_Manager *manager, const t_Command *cmd);
+
+/**
+ * @brief Finds the matches of a regular expression, chunk by chunk.
+ * @param manager The manager that will contains contexts.
+ * @param cmd The content of the command.
+ * @return An error code or SUCCESS (=0).
+*/
+t_ErrorCode	cmd_buffer_regex_find(t_Manager *manager, const t_Command *cmd);
+
+/**
+ * @brief Finds the occurrences of a text in all buffers, chunk by chunk.
+ * @param manager The manager that will contains contexts.
+ * @param cmd The content of the command.
+ * @return An error code or SUCCESS (=0).
+*/
+t_ErrorCode	cmd_buffer_find_all(t_Manager *manager, const t_Command *cmd);
+
+/**
+ * @brief Builds or releases the trigram index of a buffer.
+ * @param manager The manager that will contains contexts.
+ * @param cmd The content of the command.
+ * @return An error code or SUCCESS (=0).
+*/
+t_ErrorCode	cmd_buffer_set_index(t_Manager *manager, const t_Command *cmd);
+
+/**
+ * @brief Get the position of a byte offset in a buffer.
+ * @param manager The manager that will contains contexts.
+ * @param cmd The content of the command.
+ * @return An error code or SUCCESS (=0).
+*/
+t_ErrorCode	cmd_buffer_offset_to_pos(t_Manager *manager, const t_Command *cmd);
+
+/**
+ * @brief Get the byte offset of a position in a buffer.
+ * @param manager The manager that will contains contexts.
+ * @param cmd The content of the command.
+ * @return An error code or SUCCESS (=0).
+*/
+t_ErrorCode	cmd_buffer_pos_to_offset(t_Manager *manager, const t_Command *cmd);
+
+/**
+ * @brief Converts a batch of positions between UTF-16 columns and bytes.
+ * @param manager The manager that will contains contexts.
+ * @param cmd The content of the command.
+ * @return An error code or SUCCESS (=0).
+*/
+t_ErrorCode	cmd_buffer_convert_utf16(t_Manager *manager, const t_Command *cmd);
+
+/**
+ * @brief Converts a batch of positions between character indexes and display
+ * columns.
+ * @param manager The manager that will contains contexts.
+ * @param cmd The content of the command.
+ * @return An error code or SUCCESS (=0).
+*/
+t_ErrorCode	cmd_buffer_convert_columns(t_Manager *manager, const t_Command *cmd);
+
+/**
+ * @brief Wraps the lines of a buffer at a width, or unwraps them.
+ * @param manager The manager that will contains contexts.
+ * @param cmd The content of the command.
+ * @return An error code or SUCCESS (=0).
+*/
+t_ErrorCode	cmd_buffer_set_wrap(t_Manager *manager, const t_Command *cmd);
+
+/**
+ * @brief Get the position of the start of a wrapped row in a buffer.
+ * @param manager The manager that will contains contexts.
+ * @param cmd The content of the command.
+ * @return An error code or SUCCESS (=0).
+*/
+t_ErrorCode	cmd_buffer_row_to_pos(t_Manager *manager, const t_Command *cmd);
+
+/**
+ * @brief Get the wrapped row of a position in a buffer.
+ * @param manager The manager that will contains contexts.
+ * @param cmd The content of the command.
+ * @return An error code or SUCCESS (=0).
+*/
+t_ErrorCode	cmd_buffer_pos_to_row(t_Manager *manager, const t_Command *cmd);
+
 // +===----- Data -----===+ //
 
 /**
@@ -81,4 +194,74 @@ t_ErrorCode	cmd_line_insert_data(t_Manager *manager, const t_Command *cmd);
 */
 t_ErrorCode	cmd_line_delete_data(t_Manager *manager, const t_Command *cmd);
 
+/**
+ * @brief Insert the data over several lines from the given line.
+ * @param manager The manager that will contains contexts.
+ * @param cmd The content of the command.
+ * @return An error code or SUCCESS (=0).
+*/
+t_ErrorCode	cmd_line_insert_range(t_Manager *manager, const t_Command *cmd);
+
+/**
+ * @brief Delete the data over several lines from the given line.
+ * @param manager The manager that will contains contexts.
+ * @param cmd The content of the command.
+ * @return An error code or SUCCESS (=0).
+*/
+t_ErrorCode	cmd_line_delete_range(t_Manager *manager, const t_Command *cmd);
+
+/**
+ * @brief Applies a batch of edits inside lines in one pass.
+ * @param manager The manager that will contains contexts.
+ * @param cmd The content of the command.
+ * @return An error code or SUCCESS (=0).
+*/
+t_ErrorCode	cmd_line_multi_edit(t_Manager *manager, const t_Command *cmd);
+
+/**
+ * @brief Applies a batch of range replacements in order, the batch is undone
+ * at once.
+ * @param manager The manager that will contains contexts.
+ * @param cmd The content of the command.
+ * @return An error code or SUCCESS (=0).
+*/
+t_ErrorCode	cmd_buffer_apply_changes(t_Manager *manager, const t_Command *cmd);
+
+/**
+ * @brief Replaces every match of a text or regular expression in a buffer.
+ * @param manager The manager that will contains contexts.
+ * @param cmd The content of the command.
+ * @return An error code or SUCCESS (=0).
+*/
+t_ErrorCode	cmd_buffer_replace_all(t_Manager *manager, const t_Command *cmd);
+
+// +===----- History -----===+ //
+
+/**
+ * @brief Reverts the last edit of the buffer.
+ * @param manager The manager that will contains contexts.
+ * @param cmd The content of the command.
+ * @return An error code or SUCCESS (=0).
+*/
+t_ErrorCode	cmd_buffer_undo(t_Manager *manager, const t_Command *cmd);
+
+/**
+ * @brief Applies again the last reverted edit of the buffer.
+ * @param manager The manager that will contains contexts.
+ * @param cmd The content of the command.
+ * @return An error code or SUCCESS (=0).
+*/
+t_ErrorCode	cmd_buffer_redo(t_Manager *manager, const t_Command *cmd);
+
+// +===----- Snapshots -----===+ //
+
+/**
+ * @brief Takes an immutable snapshot of the buffer, that shares the lines and
+ * their views until they are edited.
+ * @param manager The manager that will contains contexts.
+ * @param cmd The content of the command.
+ * @return An error code or SUCCESS (=0).
+*/
+t_ErrorCode	cmd_buffer_snapshot(t_Manager *manager, const t_Command *cmd);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,47 @@
+#ifndef SEED_TOOLS_SEARCH_H
+# define SEED_TOOLS_SEARCH_H
+
+# include "dependency.h"
+# include "tools/utf8.h"
+
+# define SEARCH_NPOS ((size_t)-1)	/* No match */
+
+// The kernels compare the first and the last byte of the needle with a block
+// of positions at once, and only check the candidates where both are equal.
+// They are chosen on the first call like the UTF-8 ones. Case folding only
+// applies to ASCII letters.
+
+// +===----- Functions -----===+ //
+
+/**
+ * @brief Forces the kernels of the given instruction set.
+ * @param isa The instruction set.
+ * @return TRUE for success or FALSE if the CPU does not support it.
+*/
+bool	search_use(t_Utf8Isa isa);
+
+/**
+ * @brief Get the position of the first occurrence of the needle.
+ * @param str The data.
+ * @param size The data size.
+ * @param needle The needle.
+ * @param needle_size The needle size (> 0).
+ * @param fold TRUE to ignore the case of ASCII letters.
+ * @return The position of the occurrence, or SEARCH_NPOS if not found.
+*/
+size_t	search_find(const char *str, size_t size, const char *needle,
+	size_t needle_size, bool fold);
+
+/**
+ * @brief Get the position of the last occurrence of the needle.
+ * @param str The data.
+ * @param size The data size.
+ * @param needle The needle.
+ * @param needle_size The needle size (> 0).
+ * @param fold TRUE to ignore the case of ASCII letters.
+ * @return The position of the occurrence, or SEARCH_NPOS if not found.
+*/
+size_t	search_find_last(const char *str, size_t size, const char *needle,
+	size_t needle_size, bool fold);
+
+#endif
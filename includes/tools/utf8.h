@@ -0,0 +1,92 @@
+#ifndef SEED_TOOLS_UTF8_H
+# define SEED_TOOLS_UTF8_H
+
+# include "dependency.h"
+
+// +===----- Types -----===+ //
+
+/* The instruction sets of the UTF-8 kernels */
+typedef enum	e_Utf8Isa
+{
+	UTF8_SCALAR,	/* One byte at a time */
+	UTF8_SSE2,	/* 16 bytes at a time */
+	UTF8_AVX2	/* 32 bytes at a time */
+}	t_Utf8Isa;
+
+// The kernels are chosen on the first call from the instruction sets of the
+// running CPU, the scalar ones are used on other architectures.
+
+// +===----- Functions -----===+ //
+
+/**
+ * @brief Forces the kernels of the given instruction set.
+ * @param isa The instruction set.
+ * @return TRUE for success or FALSE if the CPU does not support it.
+*/
+bool	utf8_use(t_Utf8Isa isa);
+
+/**
+ * @brief Counts the characters of the data.
+ * @param str The data.
+ * @param size The data size.
+ * @return The count of characters.
+*/
+size_t	utf8_count(const char *str, size_t size);
+
+/**
+ * @brief Get the position of the given character in the data.
+ * @param str The data.
+ * @param size The data size.
+ * @param index The index of the character, decreased by the count of
+ * characters of the data if it is not found.
+ * @return The position of the character, or (size_t)-1 if not in the data.
+*/
+size_t	utf8_offset(const char *str, size_t size, size_t *index);
+
+/**
+ * @brief Counts the UTF-16 code units of the data, a character above U+FFFF
+ * takes two of them (a surrogate pair).
+ * @param str The data.
+ * @param size The data size.
+ * @return The count of code units.
+*/
+size_t	utf8_utf16_count(const char *str, size_t size);
+
+/**
+ * @brief Get the position of the character at the given UTF-16 code unit,
+ * a unit inside a surrogate pair gives the character of the pair.
+ * @param str The data.
+ * @param size The data size.
+ * @param units The index of the code unit, decreased by the count of code
+ * units of the data if it is not found.
+ * @return The position of the character, or (size_t)-1 if not in the data.
+*/
+size_t	utf8_utf16_offset(const char *str, size_t size, size_t *units);
+
+/**
+ * @brief Check if every character of the data is below U+10000, so that it
+ * takes one UTF-16 code unit.
+ * @param str The data.
+ * @param size The data size.
+ * @return TRUE if the data has no 4 bytes sequence or FALSE otherwise.
+*/
+bool	utf8_is_bmp(const char *str, size_t size);
+
+/**
+ * @brief Check if the data is only ASCII.
+ * @param str The data.
+ * @param size The data size.
+ * @return TRUE if every byte is below 0x80 or FALSE otherwise.
+*/
+bool	utf8_is_ascii(const char *str, size_t size);
+
+/**
+ * @brief Check if the data is valid UTF-8 (no overlong form, surrogate,
+ * truncated sequence or character above U+10FFFF).
+ * @param str The data.
+ * @param size The data size.
+ * @return TRUE if the data is valid or FALSE otherwise.
+*/
+bool	utf8_validate(const char *str, size_t size);
+
+#endif
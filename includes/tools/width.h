@@ -0,0 +1,48 @@
+#ifndef SEED_TOOLS_WIDTH_H
+# define SEED_TOOLS_WIDTH_H
+
+# include "dependency.h"
+# include <stdint.h>
+
+// The widths follow wcwidth: East Asian wide and fullwidth characters take
+// two cells, combining marks and format characters none and the others one,
+// controls included (they are shown as a symbol). A tab goes to the next tab
+// stop.
+// The grapheme clusters follow the rules of UAX #29 that move a cursor: the
+// marks, the joiners and the emoji modifiers stay with their base, wide
+// characters after a ZWJ join it and regional indicators go by pairs.
+// Hangul jamo sequences and prepended marks are not joined. A cluster takes
+// the cells of its characters, except the ones joined by a ZWJ.
+// The tables are built from the Unicode 14.0 database.
+
+// +===----- Functions -----===+ //
+
+/**
+ * @brief Get the count of cells of a character alone.
+ * @param c The code point.
+ * @return 0, 1 or 2.
+*/
+size_t	width_char(uint32_t c);
+
+/**
+ * @brief Get the grapheme cluster at the start of the data.
+ * @param str The data (size > 0).
+ * @param size The data size.
+ * @param column The column of the cluster, for the tab stops.
+ * @param tab The count of columns between two tab stops (> 0).
+ * @param cells The count of cells of the cluster.
+ * @return The size of the cluster.
+*/
+size_t	width_cluster(const char *str, size_t size, size_t column, size_t tab,
+	size_t *cells);
+
+/**
+ * @brief Check if each character of the data is a cluster of one cell.
+ * @param str The data.
+ * @param size The data size.
+ * @return TRUE if no character is a tab, wide, zero-width or joined, FALSE
+ * otherwise.
+*/
+bool	width_is_narrow(const char *str, size_t size);
+
+#endif
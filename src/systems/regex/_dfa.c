@@ -0,0 +1,428 @@
+#include "systems/regex/_regex.h"
+
+// +===----- Static functions -----===+ //
+
+static bool	set_has(const t_ByteSet *set, uint8_t c)
+{
+	return ((set->bits[c >> 6] >> (c & 63)) & 1);
+}
+
+static int	dfa_compare(const void *a, const void *b)
+{
+	return ((*(const uint32_t *)a > *(const uint32_t *)b)
+		- (*(const uint32_t *)a < *(const uint32_t *)b));
+}
+
+static uint32_t	dfa_hash(const uint32_t *list, size_t count)
+{
+	uint32_t	_hash;
+	size_t		_i;
+
+	_hash = 2166136261u;
+	for (_i = 0; _i < count; _i++)
+		_hash = (_hash ^ list[_i]) * 16777619u;
+	return (_hash);
+}
+
+/**
+ * @brief Starts a new set of marked NFA states.
+ * @param dfa The DFA.
+*/
+static void	dfa_generation(t_Dfa *dfa)
+{
+	if (0 == ++dfa->generation)
+	{
+		memset(dfa->marks, 0, dfa->nfa.count * sizeof(uint32_t));
+		dfa->generation = 1;
+	}
+}
+
+static void	dfa_push(t_Dfa *dfa, uint32_t state, size_t *top)
+{
+	if (dfa->marks[state] == dfa->generation)
+		return ;
+	dfa->marks[state] = dfa->generation;
+	dfa->stack[(*top)++] = state;
+}
+
+/**
+ * @brief Adds an NFA state to the list with the states it reaches without
+ * reading a byte.
+ * @param dfa The DFA.
+ * @param state The NFA state.
+ * @param bol TRUE at the start of the line.
+ * @param count The size of the list.
+*/
+static void	dfa_follow(t_Dfa *dfa, uint32_t state, bool bol, size_t *count)
+{
+	const t_NfaState	*_state;
+	uint32_t			_id;
+	size_t				_top;
+
+	_top = 0;
+	dfa_push(dfa, state, &_top);
+	while (_top > 0)
+	{
+		_id = dfa->stack[--_top];
+		_state = &dfa->nfa.states[_id];
+		if (NFA_SPLIT == _state->kind)
+			dfa_push(dfa, _state->out1, &_top);
+		if (NFA_SPLIT == _state->kind || NFA_EMPTY == _state->kind
+			|| (NFA_BOL == _state->kind && bol))
+			dfa_push(dfa, _state->out, &_top);
+		else if (NFA_BOL != _state->kind)
+			dfa->list[(*count)++] = _id;
+	}
+}
+
+/**
+ * @brief Tells if an NFA state reaches a match at the end of the line without
+ * reading a byte. The states marked in the generation are skipped, so a list
+ * can be checked state after state in one generation.
+ * @param dfa The DFA.
+ * @param state The NFA state.
+ * @param bol TRUE if the end of the line is also its start.
+ * @return TRUE if a match is reached.
+*/
+static bool	dfa_eol_match(t_Dfa *dfa, uint32_t state, bool bol)
+{
+	const t_NfaState	*_state;
+	size_t				_top;
+
+	_top = 0;
+	dfa_push(dfa, state, &_top);
+	while (_top > 0)
+	{
+		_state = &dfa->nfa.states[dfa->stack[--_top]];
+		if (NFA_MATCH == _state->kind)
+			return (true);
+		if (NFA_SPLIT == _state->kind)
+			dfa_push(dfa, _state->out1, &_top);
+		if (NFA_SPLIT == _state->kind || NFA_EMPTY == _state->kind
+			|| NFA_EOL == _state->kind || (NFA_BOL == _state->kind && bol))
+			dfa_push(dfa, _state->out, &_top);
+	}
+	return (false);
+}
+
+/**
+ * @brief Get the flags of a list of NFA states.
+ * @param dfa The DFA.
+ * @param list The list.
+ * @param count The size of the list.
+ * @return The flags.
+*/
+static uint8_t	dfa_flags(t_Dfa *dfa, const uint32_t *list, size_t count)
+{
+	uint8_t	_flags;
+	size_t	_i;
+
+	for (_i = 0; _i < count; _i++)
+		if (NFA_MATCH == dfa->nfa.states[list[_i]].kind)
+			return (DFA_MATCH | DFA_MATCH_EOL | DFA_MATCH_LINE);
+	_flags = 0;
+	dfa_generation(dfa);
+	for (_i = 0; _i < count && 0 == _flags; _i++)
+		if (NFA_EOL == dfa->nfa.states[list[_i]].kind
+			&& dfa_eol_match(dfa, list[_i], false))
+			_flags = DFA_MATCH_EOL | DFA_MATCH_LINE;
+	dfa_generation(dfa);
+	for (_i = 0; _i < count && 0 == _flags; _i++)
+		if (NFA_EOL == dfa->nfa.states[list[_i]].kind
+			&& dfa_eol_match(dfa, list[_i], true))
+			_flags = DFA_MATCH_LINE;
+	return (_flags);
+}
+
+/**
+ * @brief Doubles the capacity of states and rebuilds the hash table.
+ * @param dfa The DFA.
+ * @return TRUE for success or FALSE if the cache is full.
+*/
+static bool	dfa_grow(t_Dfa *dfa)
+{
+	void	*_new;
+	size_t	_capacity;
+	size_t	_slot;
+	size_t	_i;
+
+	_capacity = dfa->capacity * 2;
+	if (_capacity > DFA_MAX_STATES)
+		return (false);
+	_new = realloc(dfa->next, _capacity * dfa->class_count * sizeof(int32_t));
+	TEST_NULL(_new, false);
+	dfa->next = _new;
+	_new = realloc(dfa->flags, _capacity);
+	TEST_NULL(_new, false);
+	dfa->flags = _new;
+	_new = realloc(dfa->offsets, (_capacity + 1) * sizeof(uint32_t));
+	TEST_NULL(_new, false);
+	dfa->offsets = _new;
+	_new = malloc(_capacity * 2 * sizeof(int32_t));
+	TEST_NULL(_new, false);
+	free(dfa->table);
+	dfa->table = _new;
+	dfa->table_size = _capacity * 2;
+	dfa->capacity = _capacity;
+	memset(dfa->table, 0xFF, dfa->table_size * sizeof(int32_t));
+	for (_i = 0; _i < dfa->count; _i++)
+	{
+		_slot = dfa_hash(dfa->pool + dfa->offsets[_i],
+			dfa->offsets[_i + 1] - dfa->offsets[_i]) & (dfa->table_size - 1);
+		while (dfa->table[_slot] >= 0)
+			_slot = (_slot + 1) & (dfa->table_size - 1);
+		dfa->table[_slot] = _i;
+	}
+	return (true);
+}
+
+/**
+ * @brief Doubles the capacity of the pool until the list fits.
+ * @param dfa The DFA.
+ * @param count The size of the list.
+ * @return TRUE for success or FALSE if the cache is full.
+*/
+static bool	dfa_grow_pool(t_Dfa *dfa, size_t count)
+{
+	uint32_t	*_pool;
+	size_t		_capacity;
+
+	for (_capacity = dfa->pool_capacity; _capacity < dfa->pool_size + count;)
+		_capacity *= 2;
+	if (_capacity > DFA_MAX_POOL)
+		return (false);
+	_pool = realloc(dfa->pool, _capacity * sizeof(uint32_t));
+	TEST_NULL(_pool, false);
+	dfa->pool = _pool;
+	dfa->pool_capacity = _capacity;
+	return (true);
+}
+
+static int32_t	dfa_insert(t_Dfa *dfa, const uint32_t *list, size_t count);
+
+/**
+ * @brief Drops every state, only the dead one is built again.
+ * @param dfa The DFA.
+*/
+static void	dfa_reset(t_Dfa *dfa)
+{
+	uint32_t	_none;
+
+	_none = REGEX_NONE;
+	dfa->count = 0;
+	dfa->pool_size = 0;
+	dfa->offsets[0] = 0;
+	dfa->starts[0] = DFA_UNKNOWN;
+	dfa->starts[1] = DFA_UNKNOWN;
+	memset(dfa->table, 0xFF, dfa->table_size * sizeof(int32_t));
+	dfa->resets++;
+	dfa_insert(dfa, &_none, 0);
+}
+
+/**
+ * @brief Get the state of a sorted list of NFA states, it is added if needed.
+ * @param dfa The DFA.
+ * @param list The list.
+ * @param count The size of the list.
+ * @return The state.
+*/
+static int32_t	dfa_insert(t_Dfa *dfa, const uint32_t *list, size_t count)
+{
+	int32_t	_state;
+	size_t	_slot;
+
+	_slot = dfa_hash(list, count) & (dfa->table_size - 1);
+	for (; (_state = dfa->table[_slot]) >= 0;
+		_slot = (_slot + 1) & (dfa->table_size - 1))
+	{
+		if (dfa->offsets[_state + 1] - dfa->offsets[_state] == count
+			&& 0 == memcmp(dfa->pool + dfa->offsets[_state], list,
+				count * sizeof(uint32_t)))
+			return (_state);
+	}
+	if ((dfa->count == dfa->capacity && false == dfa_grow(dfa))
+		|| (dfa->pool_size + count > dfa->pool_capacity
+			&& false == dfa_grow_pool(dfa, count)))
+		dfa_reset(dfa);
+	_slot = dfa_hash(list, count) & (dfa->table_size - 1);
+	while (dfa->table[_slot] >= 0)
+		_slot = (_slot + 1) & (dfa->table_size - 1);
+	_state = dfa->count++;
+	dfa->table[_slot] = _state;
+	memcpy(dfa->pool + dfa->pool_size, list, count * sizeof(uint32_t));
+	dfa->pool_size += count;
+	dfa->offsets[_state + 1] = dfa->pool_size;
+	dfa->flags[_state] = dfa_flags(dfa, list, count);
+	for (_slot = 0; _slot < dfa->class_count; _slot++)
+		dfa->next[_state * dfa->class_count + _slot] = DFA_UNKNOWN;
+	return (_state);
+}
+
+/**
+ * @brief Splits the bytes in classes that no byte set tells apart.
+ * @param dfa The DFA.
+*/
+static void	dfa_classes(t_Dfa *dfa)
+{
+	bool	_bounds[256];
+	size_t	_set;
+	size_t	_c;
+
+	memset(_bounds, 0, sizeof(_bounds));
+	for (_set = 0; _set < dfa->nfa.set_count; _set++)
+	{
+		for (_c = 1; _c < 256; _c++)
+			if (set_has(&dfa->nfa.sets[_set], _c)
+				!= set_has(&dfa->nfa.sets[_set], _c - 1))
+				_bounds[_c] = true;
+	}
+	dfa->class_count = 1;
+	dfa->classes[0] = 0;
+	for (_c = 1; _c < 256; _c++)
+	{
+		dfa->class_count += _bounds[_c];
+		dfa->classes[_c] = dfa->class_count - 1;
+	}
+}
+
+// +===----- DFA -----===+ //
+
+bool	dfa_init(t_Dfa *dfa, bool unanchored)
+{
+	dfa_classes(dfa);
+	dfa->unanchored = unanchored;
+	dfa->capacity = 16;
+	dfa->table_size = 32;
+	dfa->pool_capacity = 4 * dfa->nfa.count + 64;
+	dfa->next = malloc(dfa->capacity * dfa->class_count * sizeof(int32_t));
+	dfa->flags = malloc(dfa->capacity);
+	dfa->offsets = malloc((dfa->capacity + 1) * sizeof(uint32_t));
+	dfa->pool = malloc(dfa->pool_capacity * sizeof(uint32_t));
+	dfa->table = malloc(dfa->table_size * sizeof(int32_t));
+	dfa->marks = calloc(dfa->nfa.count, sizeof(uint32_t));
+	dfa->stack = malloc(dfa->nfa.count * sizeof(uint32_t));
+	dfa->list = malloc(dfa->nfa.count * sizeof(uint32_t));
+	if (NULL == dfa->next || NULL == dfa->flags || NULL == dfa->offsets
+		|| NULL == dfa->pool || NULL == dfa->table || NULL == dfa->marks
+		|| NULL == dfa->stack || NULL == dfa->list)
+		return (false);
+	dfa->generation = 0;
+	dfa_reset(dfa);
+	dfa->resets = 0;
+	return (true);
+}
+
+void	dfa_clean(t_Dfa *dfa)
+{
+	free(dfa->next);
+	free(dfa->flags);
+	free(dfa->offsets);
+	free(dfa->pool);
+	free(dfa->table);
+	free(dfa->marks);
+	free(dfa->stack);
+	free(dfa->list);
+	nfa_clean(&dfa->nfa);
+}
+
+int32_t	dfa_start(t_Dfa *dfa, bool bol)
+{
+	size_t	_count;
+	int32_t	_state;
+
+	if (DFA_UNKNOWN != dfa->starts[bol])
+		return (dfa->starts[bol]);
+	dfa_generation(dfa);
+	_count = 0;
+	dfa_follow(dfa, dfa->nfa.start, bol, &_count);
+	qsort(dfa->list, _count, sizeof(uint32_t), dfa_compare);
+	_state = dfa_insert(dfa, dfa->list, _count);
+	dfa->starts[bol] = _state;
+	return (_state);
+}
+
+int32_t	dfa_build(t_Dfa *dfa, int32_t state, uint8_t byte)
+{
+	const t_NfaState	*_state;
+	size_t				_resets;
+	size_t				_count;
+	size_t				_i;
+	int32_t				_next;
+
+	dfa_generation(dfa);
+	_count = 0;
+	for (_i = dfa->offsets[state]; _i < dfa->offsets[state + 1]; _i++)
+	{
+		_state = &dfa->nfa.states[dfa->pool[_i]];
+		if (NFA_BYTES == _state->kind
+			&& set_has(&dfa->nfa.sets[_state->set], byte))
+			dfa_follow(dfa, _state->out, false, &_count);
+	}
+	if (dfa->unanchored)
+		dfa_follow(dfa, dfa->nfa.start, false, &_count);
+	qsort(dfa->list, _count, sizeof(uint32_t), dfa_compare);
+	_resets = dfa->resets;
+	_next = dfa_insert(dfa, dfa->list, _count);
+	if (_resets == dfa->resets)
+		dfa->next[state * dfa->class_count + dfa->classes[byte]] = _next;
+	return (_next);
+}
+
+bool	dfa_longest(t_Dfa *dfa, const char *data, size_t size, size_t *ends)
+{
+	const t_NfaState	*_state;
+	uint32_t			*_states;
+	size_t				*_from;
+	size_t				*_to;
+	size_t				_count;
+	size_t				_first;
+	size_t				_prev;
+	size_t				_i;
+	size_t				_k;
+
+	_from = malloc(dfa->nfa.count * (2 * sizeof(size_t) + sizeof(uint32_t)));
+	TEST_NULL(_from, false);
+	_to = _from + dfa->nfa.count;
+	_states = (uint32_t *)(_to + dfa->nfa.count);
+	dfa_generation(dfa);
+	_count = 0;
+	dfa_follow(dfa, dfa->nfa.start, true, &_count);
+	for (_k = 0; _k < _count; _k++)
+		_to[_k] = size;
+	for (_i = size; ; _i--)
+	{
+		if (0 == _i)
+			dfa_generation(dfa);
+		ends[_i] = REGEX_NPOS;
+		for (_k = 0; _k < _count && REGEX_NPOS == ends[_i]; _k++)
+		{
+			_state = &dfa->nfa.states[dfa->list[_k]];
+			if (NFA_MATCH == _state->kind || (0 == _i && NFA_EOL == _state->kind
+				&& dfa_eol_match(dfa, dfa->list[_k], 0 == size)))
+				ends[_i] = _to[_k];
+		}
+		if (0 == _i)
+			break ;
+		memcpy(_states, dfa->list, _count * sizeof(uint32_t));
+		memcpy(_from, _to, _count * sizeof(size_t));
+		dfa_generation(dfa);
+		_prev = _count;
+		_count = 0;
+		for (_k = 0; _k < _prev; _k++)
+		{
+			_state = &dfa->nfa.states[_states[_k]];
+			if (NFA_BYTES != _state->kind
+				|| false == set_has(&dfa->nfa.sets[_state->set], data[_i - 1]))
+				continue ;
+			_first = _count;
+			dfa_follow(dfa, _state->out, false, &_count);
+			while (_first < _count)
+				_to[_first++] = _from[_k];
+		}
+		_first = _count;
+		dfa_follow(dfa, dfa->nfa.start, false, &_count);
+		while (_first < _count)
+			_to[_first++] = _i - 1;
+	}
+	return (free(_from), true);
+}
@@ -0,0 +1,727 @@
+#include "systems/regex/_regex.h"
+#include "tools/utf8.h"
+#include <ctype.h>
+
+#define FRAG_NONE ((t_Frag){REGEX_NONE, REGEX_NONE})	/* A failed fragment */
+
+// +===----- Types -----===+ //
+
+/* A part of the NFA, its dangling transitions are chained in a list */
+// An element of the list is a state index and a slot (out or out1), the slot
+// holds the next element until it is patched.
+typedef struct	s_Frag
+{
+	uint32_t	start;	/* The first state */
+	uint32_t	out;	/* The first dangling transition */
+}	t_Frag;
+
+/* The state of a compilation */
+typedef struct	s_Parser
+{
+	t_Nfa		*nfa;	/* The NFA being built */
+	const char	*pattern;	/* The pattern */
+	size_t		size;	/* The size of the pattern */
+	size_t		pos;	/* The position in the pattern */
+	size_t		depth;	/* The depth of groups */
+	bool		fold;	/* Ignore the case of ASCII letters */
+	bool		reverse;	/* Build the pattern read backward */
+	t_ErrorCode	error;	/* The first error */
+}	t_Parser;
+
+/* The members of a bracket class */
+typedef struct	s_Class
+{
+	t_ByteSet	ascii;	/* The ASCII members */
+	bool		multi;	/* Every non-ASCII character is a member */
+	char		chars[REGEX_CLASS_CHARS][4];	/* The other non-ASCII members */
+	uint8_t		sizes[REGEX_CLASS_CHARS];	/* The size of each member */
+	size_t		count;	/* The count of non-ASCII members */
+}	t_Class;
+
+static t_Frag	parse_alt(t_Parser *p);
+
+// +===----- Byte sets -----===+ //
+
+static void	set_add(t_ByteSet *set, unsigned char c)
+{
+	set->bits[c >> 6] |= (uint64_t)1 << (c & 63);
+}
+
+static bool	set_has(const t_ByteSet *set, unsigned char c)
+{
+	return ((set->bits[c >> 6] >> (c & 63)) & 1);
+}
+
+/**
+ * @brief Adds both cases of the ASCII letters of the set.
+ * @param set The set.
+*/
+static void	set_fold(t_ByteSet *set)
+{
+	unsigned char	_c;
+
+	for (_c = 'A'; _c <= 'Z'; _c++)
+	{
+		if (set_has(set, _c) || set_has(set, _c | 0x20))
+		{
+			set_add(set, _c);
+			set_add(set, _c | 0x20);
+		}
+	}
+}
+
+// +===----- Fragments -----===+ //
+
+/**
+ * @brief Get the slot of a dangling transition.
+ * @param nfa The NFA.
+ * @param ptr The element of a list.
+ * @return The slot.
+*/
+static uint32_t	*nfa_slot(t_Nfa *nfa, uint32_t ptr)
+{
+	if (ptr & 1)
+		return (&nfa->states[ptr >> 1].out1);
+	return (&nfa->states[ptr >> 1].out);
+}
+
+/**
+ * @brief Points every transition of the list to the state.
+ * @param nfa The NFA.
+ * @param list The list.
+ * @param state The state.
+*/
+static void	nfa_patch(t_Nfa *nfa, uint32_t list, uint32_t state)
+{
+	uint32_t	_next;
+
+	while (REGEX_NONE != list)
+	{
+		_next = *nfa_slot(nfa, list);
+		*nfa_slot(nfa, list) = state;
+		list = _next;
+	}
+}
+
+/**
+ * @brief Chains two lists of dangling transitions.
+ * @param nfa The NFA.
+ * @param list The first list.
+ * @param other The second list.
+ * @return The chained list.
+*/
+static uint32_t	nfa_append(t_Nfa *nfa, uint32_t list, uint32_t other)
+{
+	uint32_t	_last;
+
+	if (REGEX_NONE == list)
+		return (other);
+	for (_last = list; REGEX_NONE != *nfa_slot(nfa, _last);)
+		_last = *nfa_slot(nfa, _last);
+	*nfa_slot(nfa, _last) = other;
+	return (list);
+}
+
+/**
+ * @brief Records an error of the compilation.
+ * @param p The parser.
+ * @param error The error.
+ * @return A failed fragment.
+*/
+static t_Frag	parse_error(t_Parser *p, t_ErrorCode error)
+{
+	if (ERR_SUCCESS == p->error)
+		p->error = error;
+	return (FRAG_NONE);
+}
+
+/**
+ * @brief Adds a state to the NFA.
+ * @param p The parser.
+ * @param kind The kind of state.
+ * @param out The next state.
+ * @param out1 The other next state.
+ * @return The state, or REGEX_NONE if an error occured.
+*/
+static uint32_t	nfa_state(t_Parser *p, uint32_t kind, uint32_t out,
+	uint32_t out1)
+{
+	t_Nfa		*_nfa;
+	t_NfaState	*_states;
+
+	_nfa = p->nfa;
+	if (ERR_SUCCESS != p->error)
+		return (REGEX_NONE);
+	if (_nfa->count == _nfa->capacity)
+	{
+		if (_nfa->capacity >= REGEX_MAX_STATES)
+			return (parse_error(p, ERR_INVALID_PATTERN), REGEX_NONE);
+		_states = realloc(_nfa->states,
+			(_nfa->capacity ? _nfa->capacity * 2 : 64) * sizeof(t_NfaState));
+		if (NULL == _states)
+			return (parse_error(p, ERR_INTERNAL_MEMORY), REGEX_NONE);
+		_nfa->states = _states;
+		_nfa->capacity = _nfa->capacity ? _nfa->capacity * 2 : 64;
+	}
+	_nfa->states[_nfa->count] = (t_NfaState){kind, out, out1, 0};
+	return (_nfa->count++);
+}
+
+static t_Frag	frag_state(t_Parser *p, uint32_t kind)
+{
+	uint32_t	_state;
+
+	_state = nfa_state(p, kind, REGEX_NONE, REGEX_NONE);
+	if (REGEX_NONE == _state)
+		return (FRAG_NONE);
+	return ((t_Frag){_state, _state << 1});
+}
+
+static t_Frag	frag_bytes(t_Parser *p, const t_ByteSet *set)
+{
+	t_Nfa		*_nfa;
+	t_ByteSet	*_sets;
+	t_Frag		_frag;
+
+	_nfa = p->nfa;
+	if (ERR_SUCCESS == p->error && _nfa->set_count == _nfa->set_capacity)
+	{
+		_sets = realloc(_nfa->sets, (_nfa->set_capacity ? _nfa->set_capacity * 2
+			: 16) * sizeof(t_ByteSet));
+		if (NULL == _sets)
+			return (parse_error(p, ERR_INTERNAL_MEMORY));
+		_nfa->sets = _sets;
+		_nfa->set_capacity = _nfa->set_capacity ? _nfa->set_capacity * 2 : 16;
+	}
+	_frag = frag_state(p, NFA_BYTES);
+	if (REGEX_NONE == _frag.start)
+		return (FRAG_NONE);
+	_nfa->sets[_nfa->set_count] = *set;
+	_nfa->states[_frag.start].set = _nfa->set_count++;
+	return (_frag);
+}
+
+static t_Frag	frag_concat(t_Parser *p, t_Frag first, t_Frag second)
+{
+	t_Frag	_swap;
+
+	if (REGEX_NONE == first.start || REGEX_NONE == second.start)
+		return (FRAG_NONE);
+	if (p->reverse)
+	{
+		_swap = first;
+		first = second;
+		second = _swap;
+	}
+	nfa_patch(p->nfa, first.out, second.start);
+	return ((t_Frag){first.start, second.out});
+}
+
+static t_Frag	frag_alt(t_Parser *p, t_Frag first, t_Frag second)
+{
+	uint32_t	_split;
+
+	if (REGEX_NONE == first.start || REGEX_NONE == second.start)
+		return (FRAG_NONE);
+	_split = nfa_state(p, NFA_SPLIT, first.start, second.start);
+	if (REGEX_NONE == _split)
+		return (FRAG_NONE);
+	return ((t_Frag){_split, nfa_append(p->nfa, first.out, second.out)});
+}
+
+/**
+ * @brief Repeats a fragment.
+ * @param p The parser.
+ * @param frag The fragment.
+ * @param op The repetition: '*', '+' or '?'.
+ * @return The repeated fragment.
+*/
+static t_Frag	frag_repeat(t_Parser *p, t_Frag frag, char op)
+{
+	uint32_t	_split;
+
+	if (REGEX_NONE == frag.start)
+		return (FRAG_NONE);
+	_split = nfa_state(p, NFA_SPLIT, frag.start, REGEX_NONE);
+	if (REGEX_NONE == _split)
+		return (FRAG_NONE);
+	if ('?' == op)
+		return ((t_Frag){_split, nfa_append(p->nfa, frag.out, _split << 1 | 1)});
+	nfa_patch(p->nfa, frag.out, _split);
+	if ('+' == op)
+		return ((t_Frag){frag.start, _split << 1 | 1});
+	return ((t_Frag){_split, _split << 1 | 1});
+}
+
+/**
+ * @brief Builds a sequence of bytes, ASCII letters are folded if needed.
+ * @param p The parser.
+ * @param data The bytes.
+ * @param size The count of bytes (> 0).
+ * @return The fragment.
+*/
+static t_Frag	frag_literal(t_Parser *p, const char *data, size_t size)
+{
+	t_ByteSet	_set;
+	t_Frag		_frag;
+	size_t		_i;
+
+	_frag = FRAG_NONE;
+	for (_i = 0; _i < size; _i++)
+	{
+		memset(&_set, 0, sizeof(_set));
+		set_add(&_set, data[_i]);
+		if (p->fold)
+			set_fold(&_set);
+		if (0 == _i)
+			_frag = frag_bytes(p, &_set);
+		else
+			_frag = frag_concat(p, _frag, frag_bytes(p, &_set));
+	}
+	return (_frag);
+}
+
+/**
+ * @brief Builds any non-ASCII character.
+ * @param p The parser.
+ * @return The fragment.
+*/
+static t_Frag	frag_multi(t_Parser *p)
+{
+	static const unsigned char	leads[3][2] = {{0xC2, 0xDF}, {0xE0, 0xEF},
+		{0xF0, 0xF4}};
+	t_ByteSet					_lead;
+	t_ByteSet					_tail;
+	t_Frag						_frag;
+	t_Frag						_seq;
+	size_t						_size;
+	size_t						_i;
+
+	memset(&_tail, 0, sizeof(_tail));
+	for (_i = 0x80; _i < 0xC0; _i++)
+		set_add(&_tail, _i);
+	_frag = FRAG_NONE;
+	for (_size = 2; _size <= 4; _size++)
+	{
+		memset(&_lead, 0, sizeof(_lead));
+		for (_i = leads[_size - 2][0]; _i <= leads[_size - 2][1]; _i++)
+			set_add(&_lead, _i);
+		_seq = frag_bytes(p, &_lead);
+		for (_i = 1; _i < _size; _i++)
+			_seq = frag_concat(p, _seq, frag_bytes(p, &_tail));
+		_frag = (2 == _size) ? _seq : frag_alt(p, _frag, _seq);
+	}
+	return (_frag);
+}
+
+/**
+ * @brief Builds the members of a class.
+ * @param p The parser.
+ * @param cls The class.
+ * @return The fragment.
+*/
+static t_Frag	frag_class(t_Parser *p, t_Class *cls)
+{
+	t_Frag	_frag;
+	size_t	_i;
+
+	_frag = frag_bytes(p, &cls->ascii);
+	for (_i = 0; _i < cls->count; _i++)
+		_frag = frag_alt(p, _frag,
+			frag_literal(p, cls->chars[_i], cls->sizes[_i]));
+	if (cls->multi)
+		_frag = frag_alt(p, _frag, frag_multi(p));
+	return (_frag);
+}
+
+// +===----- Parser -----===+ //
+
+/**
+ * @brief Get the size of the UTF-8 character at the position.
+ * @param p The parser.
+ * @return The size, or 0 if the character is invalid.
+*/
+static size_t	parse_char_size(t_Parser *p)
+{
+	unsigned char	_c;
+	size_t			_size;
+
+	_c = p->pattern[p->pos];
+	_size = 1;
+	if (_c >= 0xF0)
+		_size = 4;
+	else if (_c >= 0xE0)
+		_size = 3;
+	else if (_c >= 0xC0)
+		_size = 2;
+	if (_size > p->size - p->pos
+		|| false == utf8_validate(p->pattern + p->pos, _size))
+		return (0);
+	return (_size);
+}
+
+/**
+ * @brief Adds the members of a shorthand class (\d \w \s \D \W \S).
+ * @param cls The class.
+ * @param c The letter of the shorthand.
+ * @return TRUE if the letter is a shorthand or FALSE otherwise.
+*/
+static bool	parse_shorthand(t_Class *cls, char c)
+{
+	size_t	_i;
+	bool	_member;
+
+	if ('\0' == c || NULL == strchr("dwsDWS", c))
+		return (false);
+	for (_i = 0; _i < 128; _i++)
+	{
+		if ('d' == (c | 0x20))
+			_member = isdigit(_i);
+		else if ('w' == (c | 0x20))
+			_member = isalnum(_i) || '_' == _i;
+		else
+			_member = isspace(_i);
+		if (_member != (c >= 'A' && c <= 'Z'))
+			set_add(&cls->ascii, _i);
+	}
+	if (c >= 'A' && c <= 'Z')
+		cls->multi = true;
+	return (true);
+}
+
+/**
+ * @brief Get the byte of an escaped literal.
+ * @param c The escaped character, replaced by the byte.
+ * @return TRUE if the escape is a literal or FALSE otherwise.
+*/
+static bool	parse_escape(unsigned char *c)
+{
+	const char	*_pos;
+
+	_pos = strchr("tnrfv", *c);
+	if (NULL != _pos && '\0' != *c)
+	{
+		*c = "\t\n\r\f\v"[_pos - "tnrfv"];
+		return (true);
+	}
+	return (*c < 0x80 && (ispunct(*c) || ' ' == *c));
+}
+
+/**
+ * @brief Parses a member of a class.
+ * @param p The parser.
+ * @param cls The class.
+ * @param c The ASCII member.
+ * @return 1 for an ASCII member in c, 2 for a member already added, 0 for an
+ * error.
+*/
+static int	parse_member(t_Parser *p, t_Class *cls, unsigned char *c)
+{
+	size_t	_size;
+
+	*c = p->pattern[p->pos];
+	if ('\\' == *c)
+	{
+		if (++p->pos >= p->size)
+			return (0);
+		*c = p->pattern[p->pos++];
+		if (parse_shorthand(cls, *c))
+			return (2);
+		return (parse_escape(c) ? 1 : 0);
+	}
+	_size = parse_char_size(p);
+	if (1 == _size)
+		p->pos++;
+	if (_size <= 1)
+		return (_size);
+	if (REGEX_CLASS_CHARS == cls->count)
+		return (0);
+	memcpy(cls->chars[cls->count], p->pattern + p->pos, _size);
+	cls->sizes[cls->count++] = _size;
+	p->pos += _size;
+	if (p->pos + 1 < p->size && '-' == p->pattern[p->pos]
+		&& ']' != p->pattern[p->pos + 1])
+		return (0);
+	return (2);
+}
+
+/**
+ * @brief Parses a bracket class, after the '['.
+ * @param p The parser.
+ * @return The fragment.
+*/
+static t_Frag	parse_class(t_Parser *p)
+{
+	t_Class			_cls;
+	unsigned char	_lo;
+	unsigned char	_hi;
+	bool			_negate;
+	int				_kind;
+
+	memset(&_cls, 0, sizeof(_cls));
+	_negate = (p->pos < p->size && '^' == p->pattern[p->pos]);
+	p->pos += _negate;
+	for (_kind = -1; p->pos < p->size
+		&& (-1 == _kind || ']' != p->pattern[p->pos]);)
+	{
+		_kind = parse_member(p, &_cls, &_lo);
+		if (0 == _kind)
+			return (parse_error(p, ERR_INVALID_PATTERN));
+		_hi = _lo;
+		if (1 == _kind && p->pos + 1 < p->size && '-' == p->pattern[p->pos]
+			&& ']' != p->pattern[p->pos + 1])
+		{
+			p->pos++;
+			if (1 != parse_member(p, &_cls, &_hi) || _hi < _lo)
+				return (parse_error(p, ERR_INVALID_PATTERN));
+		}
+		for (; 1 == _kind && _lo <= _hi; _lo++)
+			set_add(&_cls.ascii, _lo);
+	}
+	if (p->pos++ >= p->size || (_negate && _cls.count > 0))
+		return (parse_error(p, ERR_INVALID_PATTERN));
+	if (p->fold)
+		set_fold(&_cls.ascii);
+	if (_negate)
+	{
+		_cls.ascii.bits[0] = ~_cls.ascii.bits[0];
+		_cls.ascii.bits[1] = ~_cls.ascii.bits[1];
+		_cls.multi = !_cls.multi;
+	}
+	return (frag_class(p, &_cls));
+}
+
+/**
+ * @brief Parses an atom: a character, a class, an anchor or a group.
+ * @param p The parser.
+ * @return The fragment.
+*/
+static t_Frag	parse_atom(t_Parser *p)
+{
+	t_Class			_cls;
+	t_Frag			_frag;
+	unsigned char	_c;
+	size_t			_size;
+
+	memset(&_cls, 0, sizeof(_cls));
+	_c = p->pattern[p->pos++];
+	if ('(' == _c)
+	{
+		if (++p->depth > REGEX_MAX_DEPTH)
+			return (parse_error(p, ERR_INVALID_PATTERN));
+		if (p->pos < p->size && '?' == p->pattern[p->pos])
+		{
+			if (p->pos + 1 >= p->size || ':' != p->pattern[p->pos + 1])
+				return (parse_error(p, ERR_INVALID_PATTERN));
+			p->pos += 2;
+		}
+		_frag = parse_alt(p);
+		if (p->pos >= p->size || ')' != p->pattern[p->pos++])
+			return (parse_error(p, ERR_INVALID_PATTERN));
+		p->depth--;
+		return (_frag);
+	}
+	if ('[' == _c)
+		return (parse_class(p));
+	if ('^' == _c || '$' == _c)
+		return (frag_state(p, (('^' == _c) != p->reverse) ? NFA_BOL : NFA_EOL));
+	if ('.' == _c)
+	{
+		_cls.ascii.bits[0] = ~(uint64_t)0;
+		_cls.ascii.bits[1] = ~(uint64_t)0;
+		_cls.multi = true;
+		return (frag_class(p, &_cls));
+	}
+	if ('*' == _c || '+' == _c || '?' == _c)
+		return (parse_error(p, ERR_INVALID_PATTERN));
+	if ('\\' == _c)
+	{
+		if (p->pos >= p->size)
+			return (parse_error(p, ERR_INVALID_PATTERN));
+		_c = p->pattern[p->pos++];
+		if (parse_shorthand(&_cls, _c))
+			return (frag_class(p, &_cls));
+		if (false == parse_escape(&_c))
+			return (parse_error(p, ERR_INVALID_PATTERN));
+		return (frag_literal(p, (char *)&_c, 1));
+	}
+	p->pos--;
+	_size = parse_char_size(p);
+	if (0 == _size)
+		return (parse_error(p, ERR_INVALID_PATTERN));
+	p->pos += _size;
+	return (frag_literal(p, p->pattern + p->pos - _size, _size));
+}
+
+/**
+ * @brief Parses the bounds of a counted repetition, at the '{'.
+ * @param p The parser.
+ * @param min The minimum count.
+ * @param max The maximum count, or REGEX_NPOS without limit.
+ * @return 1 for bounds, 0 if the '{' is a literal, -1 for invalid bounds.
+*/
+static int	parse_bounds(t_Parser *p, size_t *min, size_t *max)
+{
+	const char	*_str;
+	char		*_end;
+
+	_str = p->pattern + p->pos + 1;
+	if (p->pos + 1 >= p->size || false == isdigit((unsigned char)*_str))
+		return (0);
+	*min = strtoul(_str, &_end, 10);
+	*max = *min;
+	if (_end < p->pattern + p->size && ',' == *_end)
+	{
+		*max = REGEX_NPOS;
+		if (++_end < p->pattern + p->size && isdigit((unsigned char)*_end))
+			*max = strtoul(_end, &_end, 10);
+	}
+	if (_end >= p->pattern + p->size || '}' != *_end)
+		return (0);
+	p->pos = _end + 1 - p->pattern;
+	if (*min > REGEX_MAX_REPEAT || *min > *max
+		|| (REGEX_NPOS != *max && *max > REGEX_MAX_REPEAT))
+		return (-1);
+	return (1);
+}
+
+static t_Frag	parse_piece(t_Parser *p, size_t limit);
+
+/**
+ * @brief Builds a counted repetition, the atom is parsed again for each copy.
+ * @param p The parser, after the bounds.
+ * @param frag The first copy.
+ * @param atom The position of the atom.
+ * @param bounds The position of the bounds.
+ * @param min The minimum count.
+ * @param max The maximum count, or REGEX_NPOS without limit.
+ * @return The fragment.
+*/
+static t_Frag	parse_counted(t_Parser *p, t_Frag frag, size_t atom[2],
+	size_t min, size_t max)
+{
+	t_Frag	_copy;
+	t_Frag	_result;
+	size_t	_end;
+	size_t	_copies;
+	size_t	_i;
+
+	_end = p->pos;
+	_copies = (REGEX_NPOS == max) ? min + 1 : max;
+	if (0 == _copies)
+		return (frag_state(p, NFA_EMPTY));
+	_result = FRAG_NONE;
+	for (_i = 0; _i < _copies && ERR_SUCCESS == p->error; _i++)
+	{
+		_copy = frag;
+		if (_i > 0)
+		{
+			p->pos = atom[0];
+			_copy = parse_piece(p, atom[1]);
+		}
+		if (_i >= min)
+			_copy = frag_repeat(p, _copy, (REGEX_NPOS == max) ? '*' : '?');
+		_result = (0 == _i) ? _copy : frag_concat(p, _result, _copy);
+	}
+	p->pos = _end;
+	return (_result);
+}
+
+/**
+ * @brief Parses an atom and its repetitions.
+ * @param p The parser.
+ * @param limit The position where the repetitions stop.
+ * @return The fragment.
+*/
+static t_Frag	parse_piece(t_Parser *p, size_t limit)
+{
+	t_Frag	_frag;
+	size_t	_atom[2];
+	size_t	_min;
+	size_t	_max;
+	int		_bounds;
+	char	_c;
+
+	_atom[0] = p->pos;
+	_frag = parse_atom(p);
+	while (p->pos < limit && ERR_SUCCESS == p->error)
+	{
+		_c = p->pattern[p->pos];
+		_atom[1] = p->pos;
+		if ('*' == _c || '+' == _c || '?' == _c)
+		{
+			p->pos++;
+			_frag = frag_repeat(p, _frag, _c);
+			continue ;
+		}
+		_bounds = ('{' == _c) ? parse_bounds(p, &_min, &_max) : 0;
+		if (-1 == _bounds)
+			return (parse_error(p, ERR_INVALID_PATTERN));
+		if (0 == _bounds)
+			break ;
+		_frag = parse_counted(p, _frag, _atom, _min, _max);
+	}
+	return (_frag);
+}
+
+static t_Frag	parse_concat(t_Parser *p)
+{
+	t_Frag	_frag;
+	bool	_first;
+
+	_frag = FRAG_NONE;
+	for (_first = true; p->pos < p->size && ERR_SUCCESS == p->error
+		&& '|' != p->pattern[p->pos] && ')' != p->pattern[p->pos];
+		_first = false)
+	{
+		if (_first)
+			_frag = parse_piece(p, p->size);
+		else
+			_frag = frag_concat(p, _frag, parse_piece(p, p->size));
+	}
+	if (_first)
+		return (frag_state(p, NFA_EMPTY));
+	return (_frag);
+}
+
+static t_Frag	parse_alt(t_Parser *p)
+{
+	t_Frag	_frag;
+
+	_frag = parse_concat(p);
+	while (p->pos < p->size && ERR_SUCCESS == p->error
+		&& '|' == p->pattern[p->pos])
+	{
+		p->pos++;
+		_frag = frag_alt(p, _frag, parse_concat(p));
+	}
+	return (_frag);
+}
+
+// +===----- NFA -----===+ //
+
+t_ErrorCode	nfa_compile(t_Nfa *nfa, const char *pattern, size_t size,
+	bool fold, bool reverse)
+{
+	t_Parser	_p;
+	t_Frag		_frag;
+	uint32_t	_match;
+
+	_p = (t_Parser){nfa, pattern, size, 0, 0, fold, reverse, ERR_SUCCESS};
+	_frag = parse_alt(&_p);
+	if (_p.pos < size)
+		parse_error(&_p, ERR_INVALID_PATTERN);
+	_match = nfa_state(&_p, NFA_MATCH, REGEX_NONE, REGEX_NONE);
+	if (ERR_SUCCESS != _p.error)
+		return (nfa_clean(nfa), _p.error);
+	nfa_patch(nfa, _frag.out, _match);
+	nfa->start = _frag.start;
+	return (ERR_SUCCESS);
+}
+
+void		nfa_clean(t_Nfa *nfa)
+{
+	free(nfa->states);
+	free(nfa->sets);
+	memset(nfa, 0, sizeof(t_Nfa));
+}
@@ -0,0 +1,134 @@
+#include "systems/regex/_regex.h"
+
+// +===----- Regex -----===+ //
+
+t_ErrorCode	regex_compile(const char *pattern, size_t size, bool fold,
+	t_Regex **regex)
+{
+	t_ErrorCode	_error;
+
+	*regex = calloc(1, sizeof(t_Regex));
+	TEST_NULL(*regex, ERR_INTERNAL_MEMORY);
+	_error = nfa_compile(&(*regex)->forward.nfa, pattern, size, fold, false);
+	if (ERR_SUCCESS == _error)
+		_error = nfa_compile(&(*regex)->reverse.nfa, pattern, size, fold, true);
+	if (ERR_SUCCESS == _error && (false == dfa_init(&(*regex)->forward, false)
+		|| false == dfa_init(&(*regex)->reverse, true)))
+		_error = ERR_INTERNAL_MEMORY;
+	if (ERR_SUCCESS != _error)
+	{
+		regex_destroy(*regex);
+		*regex = NULL;
+	}
+	return (_error);
+}
+
+void		regex_destroy(t_Regex *regex)
+{
+	if (NULL == regex)
+		return ;
+	dfa_clean(&regex->forward);
+	dfa_clean(&regex->reverse);
+	free(regex->starts);
+	free(regex->ends);
+	free(regex);
+}
+
+bool		regex_line(t_Regex *regex, const char *data, size_t size)
+{
+	t_Dfa	*_dfa;
+	uint8_t	*_starts;
+	int32_t	_state;
+	int32_t	_next;
+	size_t	_i;
+
+	if (size + 1 > regex->capacity)
+	{
+		_starts = realloc(regex->starts, size + 1 > regex->capacity * 2
+			? size + 1 : regex->capacity * 2);
+		TEST_NULL(_starts, false);
+		regex->starts = _starts;
+		regex->capacity = size + 1 > regex->capacity * 2
+			? size + 1 : regex->capacity * 2;
+	}
+	regex->data = data;
+	regex->size = size;
+	regex->scanned = 0;
+	regex->longest = false;
+	_dfa = &regex->reverse;
+	_state = dfa_start(_dfa, true);
+	regex->starts[size] = _dfa->flags[_state] & DFA_MATCH;
+	for (_i = size; _i-- > 0;)
+	{
+		_next = _dfa->next[_state * _dfa->class_count
+			+ _dfa->classes[(uint8_t)data[_i]]];
+		if (DFA_UNKNOWN == _next)
+			_next = dfa_build(_dfa, _state, data[_i]);
+		_state = _next;
+		regex->starts[_i] = _dfa->flags[_state] & DFA_MATCH;
+	}
+	if (_dfa->flags[_state] & (0 == size ? DFA_MATCH_LINE : DFA_MATCH_EOL))
+		regex->starts[0] = DFA_MATCH;
+	return (true);
+}
+
+/**
+ * @brief Fills the end of the longest match from each position of the line.
+ * @param regex The expression.
+ * @return TRUE for success or FALSE if an error occured.
+*/
+static bool	regex_longest(t_Regex *regex)
+{
+	size_t	*_ends;
+
+	if (regex->size + 1 > regex->ends_capacity)
+	{
+		_ends = realloc(regex->ends, regex->capacity * sizeof(size_t));
+		TEST_NULL(_ends, false);
+		regex->ends = _ends;
+		regex->ends_capacity = regex->capacity;
+	}
+	regex->longest = dfa_longest(&regex->reverse, regex->data, regex->size,
+		regex->ends);
+	return (regex->longest);
+}
+
+bool		regex_next(t_Regex *regex, size_t from, size_t *start, size_t *end)
+{
+	const uint8_t	*_found;
+	t_Dfa			*_dfa;
+	int32_t			_state;
+	int32_t			_next;
+	size_t			_i;
+
+	_found = memchr(regex->starts + from, DFA_MATCH, regex->size + 1 - from);
+	if (NULL == _found)
+		return (false);
+	*start = _found - regex->starts;
+	if (false == regex->longest && regex->scanned
+		> REGEX_SCAN_RATIO * regex->size + REGEX_SCAN_MIN)
+		regex_longest(regex);
+	if (regex->longest)
+		return (*end = regex->ends[*start], REGEX_NPOS != *end);
+	*end = REGEX_NPOS;
+	_dfa = &regex->forward;
+	_state = dfa_start(_dfa, 0 == *start);
+	if (_dfa->flags[_state] & DFA_MATCH)
+		*end = *start;
+	for (_i = *start; _i < regex->size && DFA_DEAD != _state; _i++)
+	{
+		_next = _dfa->next[_state * _dfa->class_count
+			+ _dfa->classes[(uint8_t)regex->data[_i]]];
+		if (DFA_UNKNOWN == _next)
+			_next = dfa_build(_dfa, _state, regex->data[_i]);
+		_state = _next;
+		if (_dfa->flags[_state] & DFA_MATCH)
+			*end = _i + 1;
+	}
+	regex->scanned += _i - *start;
+	if (_i == regex->size && DFA_DEAD != _state
+		&& (_dfa->flags[_state]
+			& (0 == regex->size ? DFA_MATCH_LINE : DFA_MATCH_EOL)))
+		*end = regex->size;
+	return (REGEX_NPOS != *end);
+}
@@ -0,0 +1,258 @@
+#include "systems/writing/_internal.h"
+#include "systems/writing/_tree.h"
+#include "systems/regex/_regex.h"
+#include "tools/search.h"
+#include "tools/utf8.h"
+
+// +===----- Static functions -----===+ //
+
+/**
+ * @brief Get the count of characters of a part of a line.
+ * @param line The line.
+ * @param data The part.
+ * @param size The size of the part.
+ * @return The count of characters.
+*/
+static size_t	find_chars(const t_Line *line, const char *data, size_t size)
+{
+	if (line->flags & LINE_ASCII)
+		return (size);
+	return (utf8_count(data, size));
+}
+
+/**
+ * @brief Appends a match to the search.
+ * @param find The search.
+ * @param line The line of the match, with contiguous data.
+ * @param index The index of the line.
+ * @param byte The byte position of the match.
+ * @return TRUE if the search can take more matches or FALSE otherwise.
+*/
+static bool	find_push(t_Find *find, const t_Line *line, size_t index,
+	size_t byte)
+{
+	find->matches[find->count].line = index;
+	find->matches[find->count].index = find_chars(line, line->data, byte);
+	find->matches[find->count].size = find_chars(line, line->data + byte,
+		find->size);
+	return (++find->count < find->capacity);
+}
+
+/**
+ * @brief Get the last line of the run of unedited lines that follow each
+ * other in the mapping, from the given unedited line.
+ * @param line The first line of the run.
+ * @param count The count of lines of the run.
+ * @return The last line of the run.
+*/
+static t_Line	*find_span(t_Line *line, size_t *count)
+{
+	t_Line	*_next;
+
+	*count = 1;
+	for (_next = line->next; _next && 0 == _next->capacity; _next = _next->next)
+	{
+		if (_next->data != line->data + line->size
+			+ (line->flags & LINE_CRLF ? 2 : 1))
+			break ;
+		line = _next;
+		(*count)++;
+	}
+	return (line);
+}
+
+// +===----- Search -----===+ //
+
+void	find_forward(t_Line *line, size_t byte, t_Find *find)
+{
+	t_Line		*_last;
+	const char	*_cursor;
+	const char	*_end;
+	size_t		_index;
+	size_t		_count;
+	size_t		_pos;
+
+	_index = tree_index(line);
+	_cursor = line_get_data(line) + byte;
+	while (line && find->count < find->capacity)
+	{
+		_last = line;
+		_count = 1;
+		if (0 == line->capacity)
+			_last = find_span(line, &_count);
+		_end = _last->data + _last->size;
+		_count += _index;
+		while (SEARCH_NPOS != (_pos = search_find(_cursor, _end - _cursor,
+			find->needle, find->size, find->fold)))
+		{
+			_cursor += _pos;
+			for (; _cursor >= line->data + line->size; _index++)
+				line = line->next;
+			if (false == find_push(find, line, _index, _cursor - line->data))
+				return ;
+			_cursor += find->size;
+		}
+		line = _last->next;
+		_index = _count;
+		if (line)
+			_cursor = line_get_data(line);
+	}
+}
+
+void	find_backward(t_Line *line, size_t byte, t_Find *find)
+{
+	const char	*_data;
+	size_t		_index;
+	size_t		_end;
+	size_t		_pos;
+
+	_index = tree_index(line);
+	while (line && find->count < find->capacity)
+	{
+		_data = line_get_data(line);
+		_end = line->size;
+		if (byte < line->size && byte + find->size - 1 < line->size)
+			_end = byte + find->size - 1;
+		_pos = search_find_last(_data, _end, find->needle, find->size,
+			find->fold);
+		if (SEARCH_NPOS == _pos)
+		{
+			line = line->prev;
+			_index--;
+			byte = UTF_NPOS;
+			continue ;
+		}
+		if (false == find_push(find, line, _index, _pos))
+			return ;
+		byte = _pos;
+		if (0 == byte)
+		{
+			line = line->prev;
+			_index--;
+			byte = UTF_NPOS;
+		}
+	}
+}
+
+bool	find_regex(t_Line *line, size_t byte, t_Regex *regex, size_t version,
+	t_Find *find, t_Match *next)
+{
+	const char	*_data;
+	size_t		_index;
+	size_t		_chars;
+	size_t		_cursor;
+	size_t		_start;
+	size_t		_end;
+
+	for (_index = tree_index(line); line; line = line->next, _index++)
+	{
+		_data = line_get_data(line);
+		if (NULL == regex->starts || regex->data != _data
+			|| regex->size != line->size || regex->version != version)
+			TEST_ERROR_FN(regex_line(regex, _data, line->size), false);
+		regex->version = version;
+		_chars = 0;
+		_cursor = 0;
+		for (; byte <= line->size && regex_next(regex, byte, &_start, &_end);)
+		{
+			_chars += find_chars(line, _data + _cursor, _start - _cursor);
+			_cursor = _start;
+			*next = (t_Match){_index, _chars,
+				find_chars(line, _data + _start, _end - _start)};
+			if (find->count == find->capacity)
+				return (true);
+			find->matches[find->count++] = *next;
+			byte = _end;
+			if (_end == _start)
+				while (++byte < line->size && 0x80 == (_data[byte] & 0xC0))
+					;
+		}
+		byte = 0;
+	}
+	*next = (t_Match){_index, 0, 0};
+	return (true);
+}
+
+void	find_indexed(t_Buffer *buffer, t_Line *line, size_t byte, t_Find *find,
+	t_Match *next)
+{
+	t_GramMask	_mask;
+	const char	*_data;
+	size_t		_index;
+	size_t		_chars;
+	size_t		_cursor;
+	size_t		_pos;
+
+	grams_mask(find->needle, find->size, &_mask);
+	if (false == grams_match_buffer(buffer, &_mask))
+	{
+		*next = (t_Match){buffer->size, 0, 0};
+		return ;
+	}
+	for (_index = tree_index(line); line; line = line->next, _index++, byte = 0)
+	{
+		if (false == grams_match(buffer, line, &_mask))
+			continue ;
+		_data = line_get_data(line);
+		_chars = 0;
+		_cursor = 0;
+		while (byte < line->size && SEARCH_NPOS != (_pos = search_find(
+			_data + byte, line->size - byte, find->needle, find->size, find->fold)))
+		{
+			byte += _pos;
+			_chars += find_chars(line, _data + _cursor, byte - _cursor);
+			_cursor = byte;
+			*next = (t_Match){_index, _chars,
+				find_chars(line, _data + byte, find->size)};
+			if (find->count == find->capacity)
+				return ;
+			find->matches[find->count++] = *next;
+			byte += find->size;
+		}
+	}
+	*next = (t_Match){_index, 0, 0};
+}
+
+size_t	find_ranges(t_Line *line, const t_Find *find, t_Regex *regex,
+	t_Range **ranges, size_t *capacity)
+{
+	const char	*_data;
+	t_Range		*_new;
+	t_Range		_range;
+	size_t		_count;
+	size_t		_byte;
+	size_t		_pos;
+
+	_data = line_get_data(line);
+	if (regex)
+		TEST_ERROR_FN(regex_line(regex, _data, line->size), UTF_NPOS);
+	_count = 0;
+	for (_byte = 0; _byte <= line->size; _count++)
+	{
+		if (regex && false == regex_next(regex, _byte, &_range.start,
+			&_range.end))
+			break ;
+		if (NULL == regex)
+		{
+			_pos = search_find(_data + _byte, line->size - _byte, find->needle,
+				find->size, find->fold);
+			if (SEARCH_NPOS == _pos)
+				break ;
+			_range = (t_Range){_byte + _pos, _byte + _pos + find->size};
+		}
+		if (_count == *capacity)
+		{
+			_new = realloc(*ranges, (*capacity ? *capacity * 2 : 16)
+				* sizeof(t_Range));
+			TEST_NULL(_new, UTF_NPOS);
+			*ranges = _new;
+			*capacity = *capacity ? *capacity * 2 : 16;
+		}
+		(*ranges)[_count] = _range;
+		_byte = _range.end;
+		if (_range.end == _range.start)
+			while (++_byte < line->size && 0x80 == (_data[_byte] & 0xC0))
+				;
+	}
+	return (_count);
+}
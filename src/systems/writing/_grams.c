@@ -0,0 +1,275 @@
+#include "systems/writing/_internal.h"
+#include "systems/writing/_grams.h"
+#include "systems/writing/_pool.h"
+
+#define GRAM_HASH 0x9E3779B1u	/* The multiplier of the line signatures */
+#define GRAM_BLOOM_HASH 0x85EBCA6Bu	/* The multiplier of the buffer filters */
+#define GRAM_BYTES (GRAM_WORDS * sizeof(uint64_t))	/* The size of a signature */
+#define GRAM_CONTEXT 2	/* The count of bytes around an edit in its trigrams */
+
+// +===----- Types -----===+ //
+
+/* A scan of the trigrams of a text */
+typedef struct	s_GramScan
+{
+	uint64_t	*bits;	/* The line signature filled, or NULL */
+	uint64_t	*bloom;	/* The buffer filter filled, or NULL */
+	uint32_t	gram;	/* The last three bytes read */
+	size_t		count;	/* The count of bytes read */
+}	t_GramScan;
+
+// +===----- Static functions -----===+ //
+
+/**
+ * @brief Get the bit of a trigram in a line signature.
+ * @param gram The trigram.
+ * @return The bit.
+*/
+static uint32_t	grams_line_bit(uint32_t gram)
+{
+	return (((uint64_t)(uint32_t)(gram * GRAM_HASH) * GRAM_BITS) >> 32);
+}
+
+/**
+ * @brief Get the bit of a trigram in a buffer filter.
+ * @param gram The trigram.
+ * @return The bit.
+*/
+static uint32_t	grams_bloom_bit(uint32_t gram)
+{
+	return (((uint64_t)(uint32_t)(gram * GRAM_BLOOM_HASH) * GRAM_BLOOM_BITS)
+		>> 32);
+}
+
+/**
+ * @brief Get the trigram that ends with the given byte.
+ * @param gram The previous trigram.
+ * @param c The byte, lowercased if it is an ASCII letter.
+ * @return The trigram.
+*/
+static uint32_t	grams_next(uint32_t gram, unsigned char c)
+{
+	if ((unsigned char)(c - 'A') < 26)
+		c |= 0x20;
+	return (((gram << 8) | c) & 0xFFFFFF);
+}
+
+/**
+ * @brief Sets the bits of the trigrams of a part of a text.
+ * @param scan The scan, continued from the previous part.
+ * @param data The part.
+ * @param size The size of the part.
+*/
+static void	grams_scan(t_GramScan *scan, const char *data, size_t size)
+{
+	uint32_t	_bit;
+	size_t		_i;
+
+	for (_i = 0; _i < size; _i++)
+	{
+		scan->gram = grams_next(scan->gram, data[_i]);
+		if (++scan->count < 3)
+			continue ;
+		if (scan->bits)
+		{
+			_bit = grams_line_bit(scan->gram);
+			scan->bits[_bit / 64] |= (uint64_t)1 << (_bit % 64);
+		}
+		if (scan->bloom)
+		{
+			_bit = grams_bloom_bit(scan->gram);
+			scan->bloom[_bit / 64] |= (uint64_t)1 << (_bit % 64);
+		}
+	}
+}
+
+/**
+ * @brief Scans a part of a line, the gap is skipped.
+ * @param scan The scan.
+ * @param line The line.
+ * @param start The byte position of the part.
+ * @param end The byte position after the part.
+*/
+static void	grams_scan_line(t_GramScan *scan, const t_Line *line, size_t start,
+	size_t end)
+{
+	const char	*_tail;
+
+	if (start < line->gap)
+		grams_scan(scan, line->data + start,
+			(end < line->gap ? end : line->gap) - start);
+	if (end > line->gap)
+	{
+		_tail = line_tail(line);
+		if (start < line->gap)
+			start = line->gap;
+		grams_scan(scan, _tail + (start - line->gap), end - start);
+	}
+}
+
+/**
+ * @brief Computes the signature of the line if it is stale.
+ * @param buffer The buffer that contains the line.
+ * @param line The line.
+ * @param bloom The buffer filter also filled, or NULL.
+ * @return TRUE for success or FALSE if an error occured.
+*/
+static bool	grams_update(t_Buffer *buffer, t_Line *line, uint64_t *bloom)
+{
+	t_LineExtra	*_extra;
+	t_GramScan	_scan;
+
+	if (line->flags & LINE_GRAMS)
+		return (true);
+	_extra = line_extra(line);
+	TEST_NULL(_extra, false);
+	if (NULL == _extra->grams)
+	{
+		_extra->grams = (uint64_t *)pool_data_alloc(&buffer->pool,
+			pool_data_capacity(GRAM_BYTES));
+		TEST_NULL(_extra->grams, false);
+	}
+	memset(_extra->grams, 0, GRAM_BYTES);
+	_scan = (t_GramScan){_extra->grams, bloom, 0, 0};
+	grams_scan_line(&_scan, line, 0, line->size);
+	line->flags |= LINE_GRAMS;
+	return (true);
+}
+
+/**
+ * @brief Builds the buffer filter from the lines.
+ * @param buffer The buffer, with a filter.
+ * @param lines TRUE to compute the stale signatures in the same pass.
+ * @return TRUE for success or FALSE if an error occured.
+*/
+static bool	grams_build(t_Buffer *buffer, bool lines)
+{
+	t_GramScan	_scan;
+	t_Line		*_line;
+
+	memset(buffer->grams.bloom, 0, GRAM_BLOOM_BITS / 8);
+	buffer->grams.size = 0;
+	buffer->grams.removed = 0;
+	for (_line = buffer->line; _line; _line = _line->next)
+	{
+		buffer->grams.size += _line->size;
+		if (lines && 0 == (_line->flags & LINE_GRAMS))
+		{
+			TEST_ERROR_FN(grams_update(buffer, _line, buffer->grams.bloom),
+				false);
+			continue ;
+		}
+		_scan = (t_GramScan){NULL, buffer->grams.bloom, 0, 0};
+		grams_scan_line(&_scan, _line, 0, _line->size);
+	}
+	return (true);
+}
+
+// +===----- Index -----===+ //
+
+bool	grams_enable(t_Buffer *buffer)
+{
+	TEST_NULL(buffer, false);
+	if (NULL == buffer->grams.bloom)
+	{
+		buffer->grams.bloom = malloc(GRAM_BLOOM_BITS / 8);
+		TEST_NULL(buffer->grams.bloom, false);
+	}
+	if (false == grams_build(buffer, true))
+		return (grams_disable(buffer), false);
+	return (true);
+}
+
+void	grams_disable(t_Buffer *buffer)
+{
+	t_Line	*_line;
+
+	if (NULL == buffer || NULL == buffer->grams.bloom)
+		return ;
+	free(buffer->grams.bloom);
+	buffer->grams.bloom = NULL;
+	for (_line = buffer->line; _line; _line = _line->next)
+		grams_clean(buffer, _line);
+}
+
+void	grams_note(t_Buffer *buffer, t_Line *line, size_t start, size_t end,
+	size_t removed)
+{
+	t_GramScan	_scan;
+
+	if (NULL == buffer->grams.bloom)
+		return ;
+	buffer->grams.size += end - start;
+	buffer->grams.removed += removed;
+	start = start > GRAM_CONTEXT ? start - GRAM_CONTEXT : 0;
+	end = end + GRAM_CONTEXT < line->size ? end + GRAM_CONTEXT : line->size;
+	_scan = (t_GramScan){NULL, buffer->grams.bloom, 0, 0};
+	grams_scan_line(&_scan, line, start, end);
+}
+
+void	grams_clean(t_Buffer *buffer, t_Line *line)
+{
+	if (buffer->grams.bloom)
+		buffer->grams.removed += line->size;
+	line->flags &= ~LINE_GRAMS;
+	if (NULL == line->extra || NULL == line->extra->grams)
+		return ;
+	pool_data_free(&buffer->pool, (char *)line->extra->grams,
+		pool_data_capacity(GRAM_BYTES));
+	line->extra->grams = NULL;
+}
+
+// +===----- Queries -----===+ //
+
+void	grams_mask(const char *data, size_t size, t_GramMask *mask)
+{
+	uint32_t	_gram;
+	uint32_t	_bit;
+	size_t		_i;
+
+	memset(mask->bits, 0, GRAM_BYTES);
+	mask->key_count = 0;
+	_gram = 0;
+	for (_i = 0; _i < size; _i++)
+	{
+		_gram = grams_next(_gram, data[_i]);
+		if (_i < 2)
+			continue ;
+		_bit = grams_line_bit(_gram);
+		mask->bits[_bit / 64] |= (uint64_t)1 << (_bit % 64);
+		if (mask->key_count < GRAM_KEYS)
+			mask->keys[mask->key_count++] = grams_bloom_bit(_gram);
+	}
+}
+
+bool	grams_match_buffer(t_Buffer *buffer, const t_GramMask *mask)
+{
+	size_t	_i;
+
+	if (NULL == buffer->grams.bloom || 0 == mask->key_count)
+		return (true);
+	if (buffer->grams.removed * 2 > buffer->grams.size)
+		grams_build(buffer, false);
+	for (_i = 0; _i < mask->key_count; _i++)
+	{
+		if (0 == (buffer->grams.bloom[mask->keys[_i] / 64]
+			& (uint64_t)1 << (mask->keys[_i] % 64)))
+			return (false);
+	}
+	return (true);
+}
+
+bool	grams_match(t_Buffer *buffer, t_Line *line, const t_GramMask *mask)
+{
+	size_t	_i;
+
+	if (NULL == buffer->grams.bloom || 0 == mask->key_count
+		|| false == grams_update(buffer, line, NULL))
+		return (true);
+	for (_i = 0; _i < GRAM_WORDS; _i++)
+	{
+		if (mask->bits[_i] & ~line->extra->grams[_i])
+			return (false);
+	}
+	return (true);
+}
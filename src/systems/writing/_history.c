@@ -0,0 +1,569 @@
+#include "systems/writing/_internal.h"
+#include "systems/writing/_history.h"
+#include "systems/writing/_tree.h"
+
+#define RECORD_ALIGN 8	/* The alignment of the records in the arena */
+
+// +===----- Static functions -----===+ //
+
+/**
+ * @brief Get the size taken by a record in the arena.
+ * @param size The text size of the record.
+ * @return The size of the record.
+*/
+static size_t	record_length(size_t size)
+{
+	return ((sizeof(t_Record) + size + RECORD_ALIGN - 1) & ~(size_t)(RECORD_ALIGN - 1));
+}
+
+/**
+ * @brief Get the record at the given position of the arena.
+ * @param history The history.
+ * @param offset The position of the record.
+ * @return The record.
+*/
+static t_Record	*record_at(t_History *history, size_t offset)
+{
+	return ((t_Record *)(history->data + offset));
+}
+
+/**
+ * @brief Get the text of the record.
+ * @param record The record.
+ * @return The text.
+*/
+static char	*record_text(t_Record *record)
+{
+	return ((char *)(record + 1));
+}
+
+/**
+ * @brief Get the line ending of the line.
+ * @param line The line.
+ * @param size The size of the line ending.
+ * @return The line ending.
+*/
+static const char	*line_eol(const t_Line *line, size_t *size)
+{
+	*size = line->flags & LINE_CRLF ? 2 : 1;
+	return (line->flags & LINE_CRLF ? "\r\n" : "\n");
+}
+
+/**
+ * @brief Makes sure the arena can hold the given size.
+ * @param history The history.
+ * @param size The needed size.
+ * @return TRUE for success or FALSE if an error occured.
+*/
+static bool	history_reserve(t_History *history, size_t size)
+{
+	char	*_data;
+	size_t	_capacity;
+
+	if (size <= history->capacity)
+		return (true);
+	_capacity = history->capacity ? history->capacity : 4096;
+	while (_capacity < size)
+		_capacity *= 2;
+	_data = realloc(history->data, _capacity);
+	TEST_NULL(_data, false);
+	history->data = _data;
+	history->capacity = _capacity;
+	return (true);
+}
+
+/**
+ * @brief Drops the oldest records until the given size fits in half of the
+ * budget, so that the next drop is far away.
+ * @param history The history, without records after the cursor.
+ * @param needed The size that will be appended.
+*/
+static void	history_trim(t_History *history, size_t needed)
+{
+	size_t	_offset;
+
+	_offset = 0;
+	while (_offset < history->size
+		&& history->size - _offset + needed > HISTORY_BUDGET / 2)
+		_offset += record_length(record_at(history, _offset)->size);
+	memmove(history->data, history->data + _offset, history->size - _offset);
+	history->size -= _offset;
+	history->cursor = history->size;
+	history->last = history->size ? history->last - _offset : 0;
+	if (history->size)
+		record_at(history, 0)->back = 0;
+}
+
+/**
+ * @brief Appends a new record after the cursor, the records after the cursor
+ * are dropped.
+ * @param history The history.
+ * @param kind The kind of the record.
+ * @param line The line of the edit.
+ * @param byte The byte position of the edit.
+ * @param size The text size.
+ * @return The record, or NULL if it could not be allocated (the history is
+ * then cleaned, unless it is in a group).
+*/
+static t_Record	*history_append(t_History *history, t_RecordKind kind,
+	size_t line, size_t byte, size_t size)
+{
+	t_Record	*_record;
+	size_t		_length;
+
+	_length = record_length(size);
+	history->size = history->cursor;
+	if (false == history->group && _length > HISTORY_BUDGET / 2)
+		return (history_clean(history), NULL);
+	if (false == history->group && history->size + _length > HISTORY_BUDGET)
+		history_trim(history, _length);
+	if (false == history_reserve(history, history->size + _length))
+	{
+		if (false == history->group)
+			history_clean(history);
+		return (NULL);
+	}
+	_record = record_at(history, history->size);
+	_record->line = line;
+	_record->byte = byte;
+	_record->size = size;
+	_record->back = history->size ? history->size - history->last : 0;
+	_record->kind = kind;
+	_record->flags = 0;
+	_record->lines = false;
+	_record->chain = history->chain;
+	history->chain = history->group;
+	history->last = history->size;
+	history->size += _length;
+	history->cursor = history->size;
+	history->merge = true;
+	return (_record);
+}
+
+/**
+ * @brief Grows the text of the last record, which is the last of the arena.
+ * @param history The history.
+ * @param size The size added to the text.
+ * @return The record, or NULL if the history was cleaned.
+*/
+static t_Record	*history_extend(t_History *history, size_t size)
+{
+	t_Record	*_record;
+	size_t		_length;
+
+	_length = record_length(record_at(history, history->last)->size + size);
+	if (false == history_reserve(history, history->last + _length))
+		return (history_clean(history), NULL);
+	_record = record_at(history, history->last);
+	_record->size += size;
+	history->size = history->last + _length;
+	history->cursor = history->size;
+	return (_record);
+}
+
+/**
+ * @brief Get the last record if the next edit of the given kind can extend it.
+ * @param history The history.
+ * @param kind The kind of the edit.
+ * @param line The line of the edit.
+ * @param size The size added to the text.
+ * @return The record, or NULL if a new record is needed.
+*/
+static t_Record	*history_mergeable(t_History *history, t_RecordKind kind,
+	size_t line, size_t size)
+{
+	t_Record	*_record;
+
+	if (false == history->merge || history->group || 0 == history->cursor
+		|| history->cursor != history->size)
+		return (NULL);
+	_record = record_at(history, history->last);
+	if (_record->kind != kind || _record->line != line || _record->lines
+		|| history->last + record_length(_record->size + size) > HISTORY_BUDGET)
+		return (NULL);
+	return (_record);
+}
+
+/**
+ * @brief Copies the text between two positions, with the line endings.
+ * @param dst The destination.
+ * @param first The line where the text starts.
+ * @param start The byte position of the start in the first line.
+ * @param last The line where the text ends.
+ * @param end The byte position of the end in the last line.
+ * @return The size of the text, nothing is copied if the destination is NULL.
+*/
+static size_t	text_copy(char *dst, t_Line *first, size_t start, t_Line *last,
+	size_t end)
+{
+	const char	*_eol;
+	size_t		_eol_size;
+	size_t		_size;
+
+	if (first == last)
+	{
+		if (dst)
+			memcpy(dst, line_get_data(first) + start, end - start);
+		return (end - start);
+	}
+	_size = 0;
+	while (first != last)
+	{
+		_eol = line_eol(first, &_eol_size);
+		if (dst)
+		{
+			memcpy(dst + _size, line_get_data(first) + start, first->size - start);
+			memcpy(dst + _size + first->size - start, _eol, _eol_size);
+		}
+		_size += first->size - start + _eol_size;
+		start = 0;
+		first = first->next;
+	}
+	if (dst)
+		memcpy(dst + _size, line_get_data(last), end);
+	return (_size + end);
+}
+
+/**
+ * @brief Get the position after the text of the record.
+ * @param record The record.
+ * @param line The line after the text.
+ * @param byte The byte position after the text.
+*/
+static void	record_end(t_Record *record, size_t *line, size_t *byte)
+{
+	const char	*_text;
+	const char	*_eol;
+	size_t		_size;
+
+	_text = record_text(record);
+	_size = record->size;
+	*line = record->line;
+	*byte = record->byte + record->size;
+	while (NULL != (_eol = memchr(_text, '\n', _size)))
+	{
+		(*line)++;
+		_size -= _eol + 1 - _text;
+		_text = _eol + 1;
+		*byte = _size;
+	}
+}
+
+/**
+ * @brief Inserts the text of the record.
+ * @param buffer The buffer.
+ * @param record The record.
+ * @return TRUE for success or FALSE if an error occured.
+*/
+static bool	replay_insert(t_Buffer *buffer, t_Record *record)
+{
+	t_Line	*_line;
+	size_t	_end;
+
+	_line = buffer_get_line(buffer, record->line);
+	TEST_NULL(_line, false);
+	return (NULL != buffer_insert_text(buffer, _line, record->byte, record->size,
+		record_text(record), &_end));
+}
+
+/**
+ * @brief Deletes the text of the record.
+ * @param buffer The buffer.
+ * @param record The record.
+ * @return TRUE for success or FALSE if an error occured.
+*/
+static bool	replay_delete(t_Buffer *buffer, t_Record *record)
+{
+	t_Line	*_first;
+	t_Line	*_last;
+	size_t	_line;
+	size_t	_byte;
+
+	record_end(record, &_line, &_byte);
+	_first = buffer_get_line(buffer, record->line);
+	_last = buffer_get_line(buffer, _line);
+	TEST_NULL(_first, false);
+	TEST_NULL(_last, false);
+	return (buffer_delete_text(buffer, _first, record->byte, _last, _byte));
+}
+
+/**
+ * @brief Inserts the line of the record with its text.
+ * @param buffer The buffer.
+ * @param record The record.
+ * @return TRUE for success or FALSE if an error occured.
+*/
+static bool	replay_line_insert(t_Buffer *buffer, t_Record *record)
+{
+	t_Line	*_line;
+
+	_line = line_create(buffer);
+	TEST_NULL(_line, false);
+	_line->flags = (_line->flags & ~LINE_CRLF) | record->flags;
+	if ((record->size > 0 && false == line_insert_data(buffer, _line, 0,
+		record->size, record_text(record)))
+		|| false == buffer_line_insert(buffer, _line, record->line))
+		return (line_destroy(buffer, _line), false);
+	return (true);
+}
+
+/**
+ * @brief Deletes the line of the record.
+ * @param buffer The buffer.
+ * @param record The record.
+ * @return TRUE for success or FALSE if an error occured.
+*/
+static bool	replay_line_delete(t_Buffer *buffer, t_Record *record)
+{
+	t_Line	*_line;
+
+	_line = buffer_get_line(buffer, record->line);
+	TEST_NULL(_line, false);
+	buffer_line_destroy(buffer, _line);
+	return (true);
+}
+
+/**
+ * @brief Reverts the given record.
+ * @param buffer The buffer.
+ * @param record The record.
+ * @return TRUE for success or FALSE if an error occured.
+*/
+static bool	undo_record(t_Buffer *buffer, t_Record *record)
+{
+	if (RECORD_INSERT == record->kind)
+		return (replay_delete(buffer, record));
+	if (RECORD_DELETE == record->kind)
+		return (replay_insert(buffer, record));
+	if (RECORD_LINE_INSERT == record->kind)
+		return (replay_line_delete(buffer, record));
+	return (replay_line_insert(buffer, record));
+}
+
+/**
+ * @brief Applies again the given record.
+ * @param buffer The buffer.
+ * @param record The record.
+ * @return TRUE for success or FALSE if an error occured.
+*/
+static bool	redo_record(t_Buffer *buffer, t_Record *record)
+{
+	if (RECORD_INSERT == record->kind)
+		return (replay_insert(buffer, record));
+	if (RECORD_DELETE == record->kind)
+		return (replay_delete(buffer, record));
+	if (RECORD_LINE_INSERT == record->kind)
+		return (replay_line_insert(buffer, record));
+	return (replay_line_delete(buffer, record));
+}
+
+// +===----- History -----===+ //
+
+void	history_init(t_History *history)
+{
+	history->data = NULL;
+	history->size = 0;
+	history->capacity = 0;
+	history->cursor = 0;
+	history->last = 0;
+	history->floor = 0;
+	history->merge = false;
+	history->group = false;
+	history->chain = false;
+}
+
+void	history_clean(t_History *history)
+{
+	free(history->data);
+	history_init(history);
+}
+
+void	history_group(t_History *history, bool group)
+{
+	if (group)
+		history->floor = history->cursor;
+	else if (history->group && history->size - history->floor > HISTORY_BUDGET / 2)
+		history_clean(history);
+	else if (history->group && history->size > HISTORY_BUDGET)
+		history_trim(history, 0);
+	history->group = group;
+	history->chain = false;
+	history->merge = false;
+}
+
+void	history_drop(t_History *history, size_t cursor)
+{
+	while (history->cursor > cursor)
+	{
+		history->cursor = history->last;
+		history->last -= record_at(history, history->last)->back;
+	}
+	history->size = history->cursor;
+}
+
+bool	history_rollback(t_Buffer *buffer)
+{
+	t_History	*_history;
+	t_Record	*_record;
+
+	_history = &buffer->history;
+	buffer->version++;
+	while (_history->cursor > _history->floor)
+	{
+		_record = record_at(_history, _history->last);
+		if (false == undo_record(buffer, _record))
+			return (history_clean(_history), false);
+		_history->cursor = _history->last;
+		_history->last -= _record->back;
+	}
+	_history->size = _history->cursor;
+	return (true);
+}
+
+// +===----- Records -----===+ //
+
+bool	history_insert(t_Buffer *buffer, t_Line *line, size_t byte, size_t size,
+	const char *data)
+{
+	t_Record	*_record;
+	size_t		_line;
+
+	if (0 == size)
+		return (true);
+	buffer->version++;
+	_line = tree_index(line);
+	_record = history_mergeable(&buffer->history, RECORD_INSERT, _line, size);
+	if (_record && _record->byte + _record->size == byte
+		&& NULL == memchr(data, '\n', size))
+	{
+		_record = history_extend(&buffer->history, size);
+		if (_record)
+			memcpy(record_text(_record) + _record->size - size, data, size);
+		return (NULL != _record);
+	}
+	_record = history_append(&buffer->history, RECORD_INSERT, _line, byte, size);
+	if (NULL == _record)
+		return (false);
+	memcpy(record_text(_record), data, size);
+	_record->lines = NULL != memchr(data, '\n', size);
+	return (true);
+}
+
+bool	history_delete(t_Buffer *buffer, t_Line *first, size_t start,
+	t_Line *last, size_t end)
+{
+	t_Record	*_record;
+	size_t		_line;
+	size_t		_size;
+
+	_size = text_copy(NULL, first, start, last, end);
+	if (0 == _size)
+		return (true);
+	buffer->version++;
+	_line = tree_index(first);
+	_record = NULL;
+	if (first == last)
+		_record = history_mergeable(&buffer->history, RECORD_DELETE, _line, _size);
+	if (_record && _record->byte == start)
+	{
+		_record = history_extend(&buffer->history, _size);
+		if (_record)
+			text_copy(record_text(_record) + _record->size - _size, first, start,
+				last, end);
+		return (NULL != _record);
+	}
+	if (_record && _record->byte == end)
+	{
+		_record = history_extend(&buffer->history, _size);
+		if (NULL == _record)
+			return (false);
+		memmove(record_text(_record) + _size, record_text(_record),
+			_record->size - _size);
+		text_copy(record_text(_record), first, start, last, end);
+		_record->byte = start;
+		return (true);
+	}
+	_record = history_append(&buffer->history, RECORD_DELETE, _line, start, _size);
+	if (NULL == _record)
+		return (false);
+	text_copy(record_text(_record), first, start, last, end);
+	_record->lines = first != last;
+	return (true);
+}
+
+void	history_line_insert(t_Buffer *buffer, t_Line *line)
+{
+	t_Record	*_record;
+
+	buffer->version++;
+	_record = history_append(&buffer->history, RECORD_LINE_INSERT,
+		tree_index(line), 0, 0);
+	if (NULL == _record)
+		return ;
+	_record->flags = line->flags & LINE_CRLF;
+	buffer->history.merge = false;
+}
+
+void	history_line_delete(t_Buffer *buffer, t_Line *line)
+{
+	t_Record	*_record;
+
+	buffer->version++;
+	_record = history_append(&buffer->history, RECORD_LINE_DELETE,
+		tree_index(line), 0, line->size);
+	if (NULL == _record)
+		return ;
+	if (line->size > 0)
+		memcpy(record_text(_record), line_get_data(line), line->size);
+	_record->flags = line->flags & LINE_CRLF;
+	buffer->history.merge = false;
+}
+
+// +===----- Replay -----===+ //
+
+bool	history_undo(t_Buffer *buffer, size_t *line, size_t *byte)
+{
+	t_History	*_history;
+	t_Record	*_record;
+
+	_history = &buffer->history;
+	buffer->version++;
+	do
+	{
+		_record = record_at(_history, _history->last);
+		if (false == undo_record(buffer, _record))
+			return (history_clean(_history), false);
+		*line = _record->line;
+		*byte = _record->byte;
+		_history->cursor = _history->last;
+		_history->last -= _record->back;
+	}
+	while (_record->chain && _history->cursor > 0);
+	_history->merge = false;
+	return (true);
+}
+
+bool	history_redo(t_Buffer *buffer, size_t *line, size_t *byte)
+{
+	t_History	*_history;
+	t_Record	*_record;
+
+	_history = &buffer->history;
+	buffer->version++;
+	do
+	{
+		_record = record_at(_history, _history->cursor);
+		if (false == redo_record(buffer, _record))
+			return (history_clean(_history), false);
+		*line = _record->line;
+		*byte = _record->byte;
+		if (RECORD_INSERT == _record->kind)
+			record_end(_record, line, byte);
+		_history->last = _history->cursor;
+		_history->cursor += record_length(_record->size);
+	}
+	while (_history->cursor < _history->size
+		&& record_at(_history, _history->cursor)->chain);
+	_history->merge = false;
+	return (true);
+}
@@ -1,8 +1,507 @@
 #include <stdlib.h>
 #include <string.h>
 #include "systems/writing/_internal.h"
+#include "systems/writing/_pool.h"
+#include "systems/writing/_tree.h"
+#include "tools/utf8.h"
+#include "tools/width.h"
 
-#define DATA_ALLOC 256
+#define GAP_MIN 4096
+#define TREE_SEED 0x9E3779B9u
+#define WRITE_IOV 1024	/* The count of iovecs written at once */
+
+// +===----- Static functions -----===+ //
+
+/**
+ * @brief Check if the data of the line is allocated in the pool.
+ * @param line The line.
+ * @return TRUE if the data is allocated or FALSE otherwise.
+*/
+static bool	line_is_allocated(const t_Line *line)
+{
+	return (line->capacity > 0 && line->data != line->inline_data);
+}
+
+/**
+ * @brief Releases the data of the line. Data that a snapshot may read is
+ * retired instead, and inline data is left to snapshots with the line.
+ * @param buffer The buffer that has created the line.
+ * @param line The line.
+*/
+static void	line_release_data(t_Buffer *buffer, t_Line *line)
+{
+	if (line->stamp == buffer->views.stamp)
+	{
+		if (line_is_allocated(line))
+			pool_data_free(&buffer->pool, line->data, line->capacity);
+	}
+	else if (line_is_allocated(line))
+		views_retire(buffer, line->data, line->capacity, RETIRED_DATA);
+	else if (line->capacity > 0 && line->size > 0)
+		line->loan = buffer->views.stamp;
+}
+
+/**
+ * @brief Makes sure no snapshot reads the data of the line before it is
+ * changed, owned data stamped before the last snapshot is copied.
+ * @param buffer The buffer that has created the line.
+ * @param line The line.
+ * @return TRUE for success or FALSE if an error occured.
+*/
+static bool	line_unshare(t_Buffer *buffer, t_Line *line)
+{
+	char	*_data;
+	size_t	_capacity;
+	size_t	_tail;
+
+	if (line->stamp == buffer->views.stamp)
+		return (true);
+	if (line->capacity > 0)
+	{
+		_capacity = line_is_allocated(line) ? line->capacity
+			: pool_data_capacity(LINE_INLINE);
+		_data = pool_data_alloc(&buffer->pool, _capacity);
+		TEST_NULL(_data, false);
+		_tail = line->size - line->gap;
+		memcpy(_data, line->data, line->gap);
+		memcpy(_data + _capacity - 1 - _tail, line_tail(line), _tail);
+		line_release_data(buffer, line);
+		line->data = _data;
+		line->capacity = _capacity;
+	}
+	line->stamp = buffer->views.stamp;
+	return (true);
+}
+
+/**
+ * @brief Makes sure the line owns a data of at least the given capacity.
+ * A borrowed data is copied (in the line itself if it fits), an owned data
+ * is grown.
+ * @param pool The pool of the buffer.
+ * @param line The line.
+ * @param needed The needed capacity.
+ * @return TRUE for success or FALSE if an error occured.
+*/
+static bool	line_reserve(t_Pool *pool, t_Line *line, size_t needed)
+{
+	char	*_new_data;
+	size_t	_new_capacity;
+	size_t	_tail;
+
+	if (needed <= line->capacity)
+		return (true);
+	if (0 == line->capacity && needed <= LINE_INLINE)
+	{
+		if (line->size > 0)
+			memcpy(line->inline_data, line->data, line->size);
+		line->data = line->inline_data;
+		line->capacity = LINE_INLINE;
+		return (true);
+	}
+	_new_capacity = pool_data_capacity(needed);
+	_tail = line->size - line->gap;
+	if (line_is_allocated(line))
+		_new_data = pool_data_realloc(pool, line->data, line->capacity,
+			_new_capacity);
+	else
+	{
+		_new_data = pool_data_alloc(pool, _new_capacity);
+		if (_new_data && line->size > 0)
+			memcpy(_new_data, line->data, line->size);
+	}
+	TEST_NULL(_new_data, false);
+	if (_tail > 0)
+		memmove(
+			_new_data + _new_capacity - 1 - _tail,
+			_new_data + line->capacity - 1 - _tail,
+			_tail
+		);
+	line->data = _new_data;
+	line->capacity = _new_capacity;
+	return (true);
+}
+
+/**
+ * @brief Moves the gap of an owned line to the given position.
+ * @param line The line.
+ * @param index The new position of the gap.
+*/
+static void	line_move_gap(t_Line *line, size_t index)
+{
+	char	*_tail;
+
+	_tail = line_tail(line);
+	if (index < line->gap)
+		memmove(_tail - (line->gap - index), line->data + index, line->gap - index);
+	else if (index > line->gap)
+		memmove(line->data + line->gap, _tail, index - line->gap);
+	line->gap = index;
+}
+
+/**
+ * @brief Get the position of the given character from a known character.
+ * @param line The line.
+ * @param byte The position of the known character.
+ * @param count The index of the known character.
+ * @param index The index of the character.
+ * @return The position of the character, or UTF_NPOS if out of range.
+*/
+static size_t	line_scan(const t_Line *line, size_t byte, size_t count,
+	size_t index)
+{
+	const char	*_tail;
+	size_t		_pos;
+
+	if (index < count)
+		return (UTF_NPOS);
+	index -= count;
+	if (byte < line->gap)
+	{
+		_pos = utf8_offset(line->data + byte, line->gap - byte, &index);
+		if (UTF_NPOS != _pos)
+			return (byte + _pos);
+		byte = line->gap;
+	}
+	if (byte < line->size)
+	{
+		_tail = line_tail(line);
+		_pos = utf8_offset(_tail + (byte - line->gap), line->size - byte, &index);
+		if (UTF_NPOS != _pos)
+			return (byte + _pos);
+	}
+	if (0 == index)
+		return (line->size);
+	return (UTF_NPOS);
+}
+
+/**
+ * @brief Scans the checkpoints of the line up to the given one.
+ * The scan stops early at the end of the line or if an allocation fails.
+ * @param line The line.
+ * @param mark The index of the checkpoint.
+*/
+static void	line_marks_extend(t_Line *line, size_t mark)
+{
+	t_LineExtra	*_marks;
+	size_t		_capacity;
+	size_t		_byte;
+
+	_marks = line->extra;
+	if (NULL == _marks || mark >= _marks->capacity)
+	{
+		_capacity = _marks && _marks->capacity ? _marks->capacity * 2 : 16;
+		while (_capacity <= mark)
+			_capacity *= 2;
+		_marks = realloc(line->extra,
+			sizeof(t_LineExtra) + _capacity * sizeof(size_t));
+		if (NULL == _marks)
+			return ;
+		if (NULL == line->extra)
+			*_marks = (t_LineExtra){NULL, 1, 0, 0};
+		_marks->capacity = _capacity;
+		line->extra = _marks;
+	}
+	if (0 == _marks->count)
+	{
+		_marks->count = 1;
+		_marks->bytes[0] = 0;
+	}
+	while (_marks->count <= mark)
+	{
+		_byte = line_scan(line, _marks->bytes[_marks->count - 1],
+			(_marks->count - 1) * UTF_STEP, _marks->count * UTF_STEP);
+		if (UTF_NPOS == _byte || _byte == line->size)
+			return ;
+		_marks->bytes[_marks->count++] = _byte;
+	}
+}
+
+/**
+ * @brief Drops the checkpoints after the given byte position.
+ * @param line The line.
+ * @param byte The position of the edit.
+*/
+static void	line_marks_truncate(t_Line *line, size_t byte)
+{
+	size_t	_low;
+	size_t	_high;
+	size_t	_mid;
+
+	if (NULL == line->extra || 0 == line->extra->count)
+		return ;
+	_low = 1;
+	_high = line->extra->count;
+	while (_low < _high)
+	{
+		_mid = _low + (_high - _low) / 2;
+		if (line->extra->bytes[_mid] <= byte)
+			_low = _mid + 1;
+		else
+			_high = _mid;
+	}
+	line->extra->count = _low;
+}
+
+/**
+ * @brief Check if the characters of the line take one UTF-16 code unit each,
+ * the answer is kept in the flags until an edit may change it.
+ * @param line The line.
+ * @return TRUE if the line has no character above U+FFFF or FALSE otherwise.
+*/
+static bool	line_is_bmp(t_Line *line)
+{
+	const char	*_tail;
+
+	if (line->flags & LINE_ASCII)
+		return (true);
+	if (0 == (line->flags & LINE_UTF16))
+	{
+		_tail = line_tail(line);
+		line->flags |= LINE_UTF16 | LINE_ASTRAL;
+		if (utf8_is_bmp(line->data, line->gap)
+			&& utf8_is_bmp(_tail, line->size - line->gap))
+			line->flags &= ~LINE_ASTRAL;
+	}
+	return (0 == (line->flags & LINE_ASTRAL));
+}
+
+/**
+ * @brief Check if each character of the line is a grapheme cluster of one
+ * cell, the answer is kept in the flags until an edit may change it.
+ * @param line The line.
+ * @return TRUE if the line has no tab, wide, zero-width or joined character
+ * or FALSE otherwise.
+*/
+static bool	line_is_narrow(t_Line *line)
+{
+	const char	*_tail;
+
+	if (0 == (line->flags & LINE_CELLS))
+	{
+		_tail = line_tail(line);
+		line->flags |= LINE_CELLS | LINE_WIDE;
+		if (width_is_narrow(line->data, line->gap)
+			&& width_is_narrow(_tail, line->size - line->gap))
+			line->flags &= ~LINE_WIDE;
+	}
+	return (0 == (line->flags & LINE_WIDE));
+}
+
+/**
+ * @brief Counts again the wrapped rows of the line after an edit, if the
+ * buffer is wrapped. The line keeps its rows if its extra data cannot be
+ * allocated.
+ * @param buffer The buffer that contains the line.
+ * @param line The line.
+*/
+static void	line_wrap_note(t_Buffer *buffer, t_Line *line)
+{
+	size_t	_row;
+
+	if (0 == buffer->wrap.width)
+		return ;
+	_row = UTF_NPOS;
+	line_wrap(line, &buffer->wrap, &_row, line->size);
+	if (_row > 0 && NULL == line_extra(line))
+		return ;
+	tree_set_height(line, _row + 1);
+}
+
+/**
+ * @brief Sets the line ending of the line.
+ * @param buffer The buffer that has created the line.
+ * @param line The line.
+ * @param crlf LINE_CRLF for a CRLF line ending or 0 for a LF one.
+*/
+static void	line_set_ending(t_Buffer *buffer, t_Line *line, unsigned char crlf)
+{
+	if ((line->flags & LINE_CRLF) == crlf)
+		return ;
+	line->flags ^= LINE_CRLF;
+	tree_resize(line, crlf ? 1 : -1);
+	views_note(buffer, line);
+}
+
+/**
+ * @brief Creates the lines of the buffer from its origin.
+ * @param buffer The buffer.
+ * @return TRUE for success or FALSE if an error occured.
+*/
+static bool	buffer_split_origin(t_Buffer *buffer)
+{
+	t_Line		*_lines;
+	t_Line		*_line;
+	const char	*_cursor;
+	const char	*_end;
+	const char	*_eol;
+	size_t		_count;
+
+	_count = 1;
+	_cursor = buffer->origin;
+	_end = buffer->origin + buffer->origin_size;
+	while (_cursor < _end
+		&& NULL != (_eol = memchr(_cursor, '\n', _end - _cursor)))
+	{
+		_count++;
+		_cursor = _eol + 1;
+	}
+	_lines = pool_lines_alloc(&buffer->pool, _count);
+	TEST_NULL(_lines, false);
+	_cursor = buffer->origin;
+	_line = _lines;
+	while (_line < _lines + _count)
+	{
+		_eol = _cursor < _end ? memchr(_cursor, '\n', _end - _cursor) : NULL;
+		if (NULL == _eol)
+			_eol = _end;
+		_line->data = (char *)_cursor;
+		_line->size = _eol - _cursor;
+		_line->flags = 0;
+		if (_eol < _end && _line->size > 0 && '\r' == _eol[-1])
+		{
+			_line->size--;
+			_line->flags = LINE_CRLF;
+		}
+		_line->capacity = 0;
+		_line->gap = _line->size;
+		_line->extra = NULL;
+		_line->stamp = buffer->views.stamp;
+		_line->loan = 0;
+		if (utf8_is_ascii(_line->data, _line->size))
+			_line->flags |= LINE_ASCII;
+		_cursor = _eol + 1;
+		_line++;
+	}
+	tree_build(buffer, _lines, _count);
+	buffer->crlf = _lines[0].flags & LINE_CRLF;
+	if (buffer->wrap.width)
+		return (buffer_wrap(buffer, buffer->wrap.width, buffer->wrap.tab));
+	return (true);
+}
+
+/**
+ * @brief Appends a pasted line to the line, a CR before the LF gives the line
+ * ending instead of being added.
+ * @param buffer The buffer that contains the line.
+ * @param line The line.
+ * @param data The first byte of the pasted line.
+ * @param eol The LF that ends the pasted line.
+ * @return TRUE for success or FALSE if an error occured.
+*/
+static bool	line_insert_segment(t_Buffer *buffer, t_Line *line,
+	const char *data, const char *eol)
+{
+	line_set_ending(buffer, line, 0);
+	if (eol > data && '\r' == eol[-1])
+	{
+		line_set_ending(buffer, line, LINE_CRLF);
+		eol--;
+	}
+	if (eol == data)
+		return (true);
+	return (line_insert_data(buffer, line, -1, eol - data, data));
+}
+
+/**
+ * @brief Moves the end of the line to a new line that is not linked.
+ * @param buffer The buffer that contains the line.
+ * @param line The line.
+ * @param index The byte position of the cut.
+ * @return The new line, or NULL if an error occured.
+*/
+static t_Line	*line_cut(t_Buffer *buffer, t_Line *line, size_t index)
+{
+	t_Line	*_new_line;
+	size_t	_size;
+
+	if (index > line->size)
+		return (NULL);
+	_new_line = line_create(buffer);
+	TEST_NULL(_new_line, NULL);
+	line_set_ending(buffer, _new_line, line->flags & LINE_CRLF);
+	_size = line->size - index;
+	if (_size > 0)
+	{
+		if (false == line_insert_data(buffer, _new_line, 0, _size,
+			line_get_data(line) + index))
+			return (line_destroy(buffer, _new_line), NULL);
+		if (false == line_delete_data(buffer, line, index, _size))
+			return (line_destroy(buffer, _new_line), NULL);
+	}
+	return (_new_line);
+}
+
+/**
+ * @brief Destroys lines that are not linked in the buffer.
+ * @param buffer The buffer that has created the lines.
+ * @param line The first line, the lines are linked by their next line.
+*/
+static void	line_destroy_list(t_Buffer *buffer, t_Line *line)
+{
+	t_Line	*_next;
+
+	while (line)
+	{
+		_next = line->next;
+		line_destroy(buffer, line);
+		line = _next;
+	}
+}
+
+/**
+ * @brief Adds a range to the batch of iovecs, merged with the last one when
+ * they are contiguous (unedited lines of a mapped file).
+ * @param iov The iovecs.
+ * @param count The count of iovecs, increased if a new one is used.
+ * @param data The range.
+ * @param size The range size.
+*/
+static void	write_push(struct iovec *iov, int *count, const char *data,
+	size_t size)
+{
+	if (0 == size)
+		return ;
+	if (*count > 0
+		&& (char *)iov[*count - 1].iov_base + iov[*count - 1].iov_len == data)
+	{
+		iov[*count - 1].iov_len += size;
+		return ;
+	}
+	iov[(*count)++] = (struct iovec){(char *)data, size};
+}
+
+/**
+ * @brief Writes the whole batch of iovecs, retried after partial writes.
+ * @param fd The file descriptor.
+ * @param iov The iovecs, modified.
+ * @param count The count of iovecs.
+ * @return TRUE for success or FALSE if an error occured.
+*/
+static bool	write_iov(int fd, struct iovec *iov, int count)
+{
+	ssize_t	_written;
+
+	while (count > 0)
+	{
+		_written = writev(fd, iov, count);
+		if (-1 == _written && EINTR == errno)
+			continue ;
+		if (-1 == _written)
+			return (false);
+		while (count > 0 && (size_t)_written >= iov->iov_len)
+		{
+			_written -= iov->iov_len;
+			iov++;
+			count--;
+		}
+		if (count > 0)
+		{
+			iov->iov_base = (char *)iov->iov_base + _written;
+			iov->iov_len -= _written;
+		}
+	}
+	return (true);
+}
 
 // +===----- BUFFER -----===+ //
 
@@ -13,68 +512,174 @@ t_Buffer	*buffer_create(void)
 	buffer = malloc(sizeof(t_Buffer));
 	TEST_NULL(buffer, NULL);
 	buffer->line = NULL;
+	buffer->last = NULL;
+	buffer->root = NULL;
 	buffer->size = 0;
+	buffer->version = 0;
+	buffer->seed = TREE_SEED;
+	buffer->crlf = false;
+	buffer->grams = (t_GramIndex){NULL, 0, 0};
+	buffer->wrap = (t_Wrap){0, 0};
+	buffer->origin = NULL;
+	buffer->origin_size = 0;
+	buffer->mapping = NULL;
+	pool_init(&buffer->pool);
+	history_init(&buffer->history);
+	views_init(&buffer->views);
 	return (buffer);
 }
 
 void		buffer_destroy(t_Buffer *buffer)
 {
-	t_Line	*_tmp;
-
 	if (NULL == buffer)
 		return ;
-	while (buffer->line)
+	views_clean(buffer);
+	pool_clean(&buffer->pool);
+	history_clean(&buffer->history);
+	free(buffer->grams.bloom);
+	mapping_release(buffer->mapping);
+	free(buffer);
+}
+
+bool		buffer_map_file(t_Buffer *buffer, const char *path)
+{
+	struct stat	_st;
+	int			_fd;
+
+	TEST_NULL(buffer, false);
+	TEST_NULL(path, false);
+	if (buffer->size > 0 || buffer->origin)
+		return (false);
+	_fd = open(path, O_RDONLY);
+	if (-1 == _fd)
+		return (false);
+	if (-1 == fstat(_fd, &_st) || false == S_ISREG(_st.st_mode))
+		return (close(_fd), false);
+	if (_st.st_size > 0)
 	{
-		_tmp = buffer->line->next;
-		buffer_line_destroy(buffer, buffer->line);
-		buffer->line = _tmp;
+		buffer->mapping = mapping_create(_fd, _st.st_size);
+		if (NULL == buffer->mapping)
+			return (close(_fd), false);
+		buffer->origin = buffer->mapping->data;
+		buffer->origin_size = buffer->mapping->size;
 	}
-	free(buffer);
+	close(_fd);
+	if (false == buffer_split_origin(buffer))
+	{
+		mapping_release(buffer->mapping);
+		buffer->mapping = NULL;
+		buffer->origin = NULL;
+		buffer->origin_size = 0;
+		return (false);
+	}
+	return (true);
+}
+
+bool		buffer_write(t_Buffer *buffer, int fd, size_t *size)
+{
+	struct iovec	_iov[WRITE_IOV];
+	t_Line			*_line;
+	const char		*_eol;
+	size_t			_eol_size;
+	int				_count;
+
+	TEST_NULL(buffer, false);
+	*size = 0;
+	_count = 0;
+	for (_line = buffer->line; _line; _line = _line->next)
+	{
+		if (_count + 3 > WRITE_IOV)
+		{
+			TEST_ERROR_FN(write_iov(fd, _iov, _count), false);
+			_count = 0;
+		}
+		write_push(_iov, &_count, _line->data, _line->gap);
+		if (_line->gap < _line->size)
+			write_push(_iov, &_count, line_tail(_line), _line->size - _line->gap);
+		*size += _line->size;
+		if (NULL == _line->next)
+			break ;
+		_eol = _line->flags & LINE_CRLF ? "\r\n" : "\n";
+		_eol_size = _line->flags & LINE_CRLF ? 2 : 1;
+		if (0 == _line->capacity && _line->data + _line->size + _eol_size
+			<= buffer->origin + buffer->origin_size
+			&& 0 == memcmp(_line->data + _line->size, _eol, _eol_size))
+			_eol = _line->data + _line->size;
+		write_push(_iov, &_count, _eol, _eol_size);
+		*size += _eol_size;
+	}
+	return (write_iov(fd, _iov, _count));
 }
 
 // +===----- LINES -----===+ //
 
-t_Line		*line_create(void)
+t_Line		*line_create(t_Buffer *buffer)
 {
 	t_Line	*line;
 
-	line = malloc(sizeof(t_Line));
+	TEST_NULL(buffer, NULL);
+	line = pool_line_alloc(&buffer->pool);
 	TEST_NULL(line, NULL);
-	line->data = NULL;
+	line->inline_data[0] = '\0';
+	line->data = line->inline_data;
 	line->size = 0;
-	line->capacity = 0;
+	line->capacity = LINE_INLINE;
+	line->gap = 0;
+	line->flags = LINE_ASCII | LINE_UTF16 | LINE_CELLS
+		| (buffer->crlf ? LINE_CRLF : 0);
 	line->prev = NULL;
 	line->next = NULL;
+	line->parent = NULL;
+	line->left = NULL;
+	line->right = NULL;
+	line->count = 1;
+	line->bytes = line->flags & LINE_CRLF ? 2 : 1;
+	line->rows = 1;
+	line->extra = NULL;
+	line->priority = 0;
+	line->stamp = buffer->views.stamp;
+	line->loan = 0;
 	return (line);
 }
 
-void		buffer_line_destroy(t_Buffer *buffer, t_Line *line)
+void		line_destroy(t_Buffer *buffer, t_Line *line)
 {
-	t_Line	*_prev;
-	t_Line	*_next;
-
-	if (NULL == line)
+	if (NULL == buffer || NULL == line)
 		return ;
-	
-	_prev = line->prev;
-	_next = line->next;
-	if (_prev)
-		_prev->next = _next;
+	line_release_data(buffer, line);
+	grams_clean(buffer, line);
+	free(line->extra);
+	if (line->loan)
+	{
+		line->flags = LINE_FREE;
+		views_retire(buffer, line, 0, RETIRED_LINE);
+	}
 	else
-		buffer->line = _next;
-	if (_next)
-		_next->prev = _prev;
-	if (buffer->size > 0)
-		buffer->size--;
-	free(line->data);
-	free(line);
+		pool_line_free(&buffer->pool, line);
 }
 
-bool		buffer_line_insert(t_Buffer *buffer, t_Line *line, ssize_t index)
+t_LineExtra	*line_extra(t_Line *line)
 {
-	t_Line	*_tmp;
-	ssize_t	_i;
+	TEST_NULL(line, NULL);
+	if (NULL == line->extra)
+	{
+		line->extra = malloc(sizeof(t_LineExtra));
+		TEST_NULL(line->extra, NULL);
+		*line->extra = (t_LineExtra){NULL, 1, 0, 0};
+	}
+	return (line->extra);
+}
 
+void		buffer_line_destroy(t_Buffer *buffer, t_Line *line)
+{
+	if (NULL == buffer || NULL == line)
+		return ;
+	tree_remove(buffer, line);
+	line_destroy(buffer, line);
+}
+
+bool		buffer_line_insert(t_Buffer *buffer, t_Line *line, ssize_t index)
+{
 	TEST_NULL(buffer, false);
 	TEST_NULL(line, false);
 
@@ -82,101 +687,320 @@ bool		buffer_line_insert(t_Buffer *buffer, t_Line *line, ssize_t index)
 		index = buffer->size;
 	if ((size_t)index > buffer->size)
 		return (false);
-
-	if (index == 0)
-	{
-		line->next = buffer->line;
-		line->prev = NULL;
-		if (buffer->line)
-			buffer->line->prev = line;
-		buffer->line = line;
-		buffer->size++;
-		return (true);
-	}
-	_i = 0;
-	_tmp = buffer->line;
-	while (_tmp && _i < index - 1)
-	{
-		_tmp = _tmp->next;
-		_i++;
-	}
-	TEST_NULL(_tmp, false);
-	line->next = _tmp->next;
-	line->prev = _tmp;
-	if (_tmp->next)
-		_tmp->next->prev = line;
-	_tmp->next = line;
-	buffer->size++;
+	tree_insert(buffer, line, index);
 	return (true);
 }
 
 t_Line		*buffer_line_split(t_Buffer *buffer, t_Line *line, size_t index)
 {
 	t_Line	*_new_line;
-	t_Line	*_tmp;
-	size_t	_size;
-
-	TEST_NULL(buffer, false);
-	TEST_NULL(line, false);
-	if (index > line->size)
-		return (NULL);
 
-	_new_line = line_create();
-	TEST_NULL(_new_line, false);
-	_size = line->size - index;
-	if (false == line_insert_data(_new_line, 0, _size, line->data + index))
-		return (buffer_line_destroy(buffer, _new_line), NULL);
-	if (false == line_delete_data(line, index, _size))
-		return (buffer_line_destroy(buffer, _new_line), NULL);
-	_tmp = line->next;
-	_new_line->prev = line;
-	_new_line->next = _tmp;
-	if (_tmp)
-		_tmp->prev = _new_line;
-	line->next = _new_line;
-	buffer->size++;
+	TEST_NULL(buffer, NULL);
+	TEST_NULL(line, NULL);
+	_new_line = line_cut(buffer, line, index);
+	TEST_NULL(_new_line, NULL);
+	tree_insert(buffer, _new_line, tree_index(line) + 1);
 	return (_new_line);
 }
 
 t_Line		*buffer_line_join(t_Buffer *buffer, t_Line *dst, t_Line *src)
 {
-	TEST_NULL(dst, false);
-	TEST_NULL(src, false);
-	TEST_ERROR_FN(line_insert_data(dst, dst->size, src->size, src->data), NULL);
+	TEST_NULL(dst, NULL);
+	TEST_NULL(src, NULL);
+	if (src->size > 0)
+		TEST_ERROR_FN(line_insert_data(buffer, dst, dst->size, src->size,
+			line_get_data(src)), NULL);
+	line_set_ending(buffer, dst, src->flags & LINE_CRLF);
 	buffer_line_destroy(buffer, src);
 	return (dst);
 }
 
-t_Line		*buffer_get_line(t_Buffer *buffer, ssize_t index)
+t_Line		*buffer_insert_text(t_Buffer *buffer, t_Line *line, size_t index,
+	size_t size, const char *data, size_t *end_line)
 {
-	t_Line	*_tmp;
-	ssize_t	_i;
+	t_Line		*_first;
+	t_Line		*_last;
+	t_Line		*_new_line;
+	const char	*_eol;
+	const char	*_start;
+	size_t		_count;
 
+	TEST_NULL(buffer, NULL);
+	TEST_NULL(line, NULL);
+	TEST_NULL(data, NULL);
+	*end_line = tree_index(line);
+	_eol = memchr(data, '\n', size);
+	if (NULL == _eol)
+	{
+		TEST_ERROR_FN(line_insert_data(buffer, line, index, size, data), NULL);
+		return (line);
+	}
+	_first = NULL;
+	_last = NULL;
+	_count = 0;
+	_start = _eol + 1;
+	while (NULL != (_eol = memchr(_start, '\n', data + size - _start)))
+	{
+		_new_line = line_create(buffer);
+		if (NULL == _new_line || false == line_insert_segment(buffer, _new_line,
+			_start, _eol))
+			return (line_destroy(buffer, _new_line), line_destroy_list(buffer, _first), NULL);
+		_new_line->prev = _last;
+		if (_last)
+			_last->next = _new_line;
+		else
+			_first = _new_line;
+		_last = _new_line;
+		_count++;
+		_start = _eol + 1;
+	}
+	_new_line = line_cut(buffer, line, index);
+	if (NULL == _new_line)
+		return (line_destroy_list(buffer, _first), NULL);
+	if (_start < data + size && false == line_insert_data(buffer, _new_line, 0,
+		data + size - _start, _start))
+		return (line_destroy(buffer, _new_line), line_destroy_list(buffer, _first), NULL);
+	_new_line->prev = _last;
+	if (_last)
+		_last->next = _new_line;
+	else
+		_first = _new_line;
+	_eol = memchr(data, '\n', size);
+	if (false == line_insert_segment(buffer, line, data, _eol))
+		return (line_destroy_list(buffer, _first), NULL);
+	tree_insert_list(buffer, _first, _new_line, _count + 1, *end_line + 1);
+	*end_line += _count + 1;
+	return (_new_line);
+}
+
+bool		buffer_delete_text(t_Buffer *buffer, t_Line *first, size_t start,
+	t_Line *last, size_t end)
+{
+	t_Line	*_removed;
+	size_t	_index;
+
+	TEST_NULL(buffer, false);
+	TEST_NULL(first, false);
+	TEST_NULL(last, false);
+	if (first == last)
+		return (end <= start || line_delete_data(buffer, first, start, end - start));
+	if (start > first->size || end > last->size)
+		return (false);
+	if (start < first->size)
+		TEST_ERROR_FN(line_delete_data(buffer, first, start, first->size - start), false);
+	if (end < last->size)
+		TEST_ERROR_FN(line_insert_data(buffer, first, -1, last->size - end,
+			line_get_data(last) + end), false);
+	line_set_ending(buffer, first, last->flags & LINE_CRLF);
+	_removed = first->next;
+	_index = tree_index(first) + 1;
+	tree_remove_list(buffer, _removed, last, tree_index(last) - _index + 1, _index);
+	line_destroy_list(buffer, _removed);
+	return (true);
+}
+
+bool		buffer_wrap(t_Buffer *buffer, size_t width, size_t tab)
+{
+	t_Line	*_line;
+	size_t	_row;
+	bool	_status;
+
+	TEST_NULL(buffer, false);
+	buffer->wrap = (t_Wrap){width, tab};
+	_status = true;
+	for (_line = buffer->line; _line; _line = _line->next)
+	{
+		_row = 0;
+		if (width)
+		{
+			_row = UTF_NPOS;
+			line_wrap(_line, &buffer->wrap, &_row, _line->size);
+		}
+		if (_row > 0 && NULL == line_extra(_line))
+			_status = false;
+		else
+			tree_set_height(_line, _row + 1);
+	}
+	return (_status);
+}
+
+t_Line		*buffer_get_line(t_Buffer *buffer, ssize_t index)
+{
 	TEST_NULL(buffer, NULL);
 
 	if (index < 0)
 		index = buffer->size - 1;
 	if ((size_t)index >= buffer->size)
 		return (NULL);
+	return (tree_at(buffer->root, index));
+}
+
+// +===----- DATA -----===+ //
 
-	_tmp = buffer->line;
-	_i = 0;
-	while (_tmp && _i < index)
+char		*line_tail(const t_Line *line)
+{
+	if (0 == line->capacity)
+		return (line->data);
+	return (line->data + line->capacity - 1 - (line->size - line->gap));
+}
+
+const char	*line_get_data(t_Line *line)
+{
+	TEST_NULL(line, NULL);
+	if (line->capacity > 0)
 	{
-		_tmp = _tmp->next;
-		_i++;
+		if (line->gap != line->size)
+			line_move_gap(line, line->size);
+		line->data[line->size] = '\0';
 	}
-	return (_tmp);
+	return (line->data);
 }
 
-// +===----- DATA -----===+ //
+size_t		line_char_to_byte(t_Line *line, size_t index)
+{
+	size_t	_mark;
+
+	TEST_NULL(line, UTF_NPOS);
+	if (line->flags & LINE_ASCII)
+		return (index <= line->size ? index : UTF_NPOS);
+	_mark = index / UTF_STEP;
+	if (0 == _mark || line->size < UTF_MARKS_MIN)
+		return (line_scan(line, 0, 0, index));
+	if (NULL == line->extra || _mark >= line->extra->count)
+		line_marks_extend(line, _mark);
+	if (NULL == line->extra || 0 == line->extra->count)
+		return (line_scan(line, 0, 0, index));
+	if (_mark >= line->extra->count)
+		_mark = line->extra->count - 1;
+	return (line_scan(line, line->extra->bytes[_mark], _mark * UTF_STEP, index));
+}
 
-bool		line_insert_data(t_Line *line, ssize_t index, size_t size, const char *data)
+size_t		line_char_skip(const t_Line *line, size_t byte, size_t count)
 {
-	char	*_new_data;
-	size_t	_needed_capacity;
-	size_t	_new_capacity;
+	TEST_NULL(line, UTF_NPOS);
+	if (byte > line->size)
+		return (UTF_NPOS);
+	if (line->flags & LINE_ASCII)
+		return (count <= line->size - byte ? byte + count : UTF_NPOS);
+	return (line_scan(line, byte, 0, count));
+}
+
+size_t		line_utf16_skip(t_Line *line, size_t byte, size_t *units)
+{
+	const char	*_data;
+	size_t		_pos;
+
+	TEST_NULL(line, UTF_NPOS);
+	if (byte > line->size)
+		return (UTF_NPOS);
+	if (line_is_bmp(line))
+	{
+		_pos = 0 == byte ? line_char_to_byte(line, *units)
+			: line_char_skip(line, byte, *units);
+		*units = 0;
+		return (_pos);
+	}
+	_data = line_get_data(line);
+	_pos = utf8_utf16_offset(_data + byte, line->size - byte, units);
+	if (UTF_NPOS != _pos)
+		return (byte + _pos);
+	return (0 == *units ? line->size : UTF_NPOS);
+}
+
+size_t		line_utf16_count(t_Line *line, size_t start, size_t end)
+{
+	const char	*_data;
+
+	TEST_NULL(line, 0);
+	if (line->flags & LINE_ASCII)
+		return (end - start);
+	_data = line_get_data(line);
+	if (line_is_bmp(line))
+		return (utf8_count(_data + start, end - start));
+	return (utf8_utf16_count(_data + start, end - start));
+}
+
+size_t		line_column_walk(t_Line *line, size_t byte, size_t *column,
+	size_t end, size_t end_column, size_t tab)
+{
+	const char	*_data;
+	size_t		_pos;
+	size_t		_cells;
+
+	TEST_NULL(line, UTF_NPOS);
+	if (end > line->size)
+		end = line->size;
+	if (byte >= end || *column >= end_column)
+		return (byte);
+	_data = line_get_data(line);
+	if (line_is_narrow(line))
+	{
+		_pos = UTF_NPOS;
+		if (UTF_NPOS != end_column)
+			_pos = 0 == byte ? line_char_to_byte(line, end_column)
+				: line_char_skip(line, byte, end_column - *column);
+		if (_pos > end)
+			_pos = end;
+		*column += line->flags & LINE_ASCII ? _pos - byte
+			: utf8_count(_data + byte, _pos - byte);
+		return (_pos);
+	}
+	for (; byte < end; byte += _pos)
+	{
+		_pos = width_cluster(_data + byte, line->size - byte, *column, tab,
+			&_cells);
+		if (byte + _pos > end || *column >= end_column
+			|| _cells > end_column - *column)
+			break ;
+		*column += _cells;
+	}
+	return (byte);
+}
 
+size_t		line_wrap(t_Line *line, const t_Wrap *wrap, size_t *row, size_t byte)
+{
+	const char	*_data;
+	size_t		_start;
+	size_t		_next;
+	size_t		_cells;
+	size_t		_r;
+
+	TEST_NULL(line, UTF_NPOS);
+	if (0 == wrap->width)
+		return (*row = 0, 0);
+	_data = line_get_data(line);
+	if (line_is_narrow(line))
+	{
+		_next = line->flags & LINE_ASCII ? line->size
+			: utf8_count(_data, line->size);
+		_r = _next ? (_next - 1) / wrap->width : 0;
+		if (byte < line->size)
+			_next = line->flags & LINE_ASCII ? byte : utf8_count(_data, byte);
+		if (byte < line->size && _next / wrap->width < _r)
+			_r = _next / wrap->width;
+		*row = *row < _r ? *row : _r;
+		return (line_char_to_byte(line, *row * wrap->width));
+	}
+	_start = 0;
+	for (_r = 0; _r != *row && _start < line->size; _r++, _start = _next)
+	{
+		_cells = 0;
+		_next = line_column_walk(line, _start, &_cells, UTF_NPOS, wrap->width,
+			wrap->tab);
+		if (_next == _start)
+			_next += width_cluster(_data + _start, line->size - _start, 0,
+				wrap->tab, &_cells);
+		if (_next >= line->size || byte < _next)
+			break ;
+	}
+	*row = _r;
+	return (_start);
+}
+
+bool		line_insert_data(t_Buffer *buffer, t_Line *line, ssize_t index,
+	size_t size, const char *data)
+{
+	TEST_NULL(buffer, false);
 	TEST_NULL(line, false);
 	TEST_NULL(data, false);
 
@@ -185,17 +1009,31 @@ bool		line_insert_data(t_Line *line, ssize_t index, size_t size, const char *dat
 	if ((size_t)index > line->size)
 		return (false);
 
-	_needed_capacity = line->size + size + 1;
-	if (_needed_capacity > line->capacity)
+	TEST_ERROR_FN(line_unshare(buffer, line), false);
+	views_note(buffer, line);
+	TEST_ERROR_FN(line_reserve(&buffer->pool, line, line->size + size + 1), false);
+	line_marks_truncate(line, index);
+	line->flags &= ~LINE_GRAMS;
+	if ((line->flags & LINE_ASCII) && false == utf8_is_ascii(data, size))
+		line->flags &= ~LINE_ASCII;
+	if (LINE_UTF16 == (line->flags & (LINE_ASCII | LINE_UTF16 | LINE_ASTRAL))
+		&& false == utf8_is_bmp(data, size))
+		line->flags |= LINE_ASTRAL;
+	if (LINE_CELLS == (line->flags & (LINE_CELLS | LINE_WIDE))
+		&& false == width_is_narrow(data, size))
+		line->flags |= LINE_WIDE;
+	if (line->size + size >= GAP_MIN)
 	{
-		_new_capacity = line->capacity ? line->capacity : DATA_ALLOC;
-		while (_new_capacity < _needed_capacity)
-			_new_capacity *= 2;
-		_new_data = realloc(line->data, _new_capacity * sizeof(char));
-		TEST_NULL(_new_data, false);
-		line->data = _new_data;
-		line->capacity = _new_capacity;
+		line_move_gap(line, index);
+		memcpy(line->data + line->gap, data, size);
+		line->gap += size;
+		line->size += size;
+		tree_resize(line, size);
+		grams_note(buffer, line, index, index + size, 0);
+		line_wrap_note(buffer, line);
+		return (true);
 	}
+	line_get_data(line);
 	memmove(
 		line->data + index + size,
 		line->data + index,
@@ -203,12 +1041,18 @@ bool		line_insert_data(t_Line *line, ssize_t index, size_t size, const char *dat
 	);
 	memcpy(line->data + index, data, size);
 	line->size += size;
+	line->gap = line->size;
 	line->data[line->size] = '\0';
+	tree_resize(line, size);
+	grams_note(buffer, line, index, index + size, 0);
+	line_wrap_note(buffer, line);
 	return (true);
 }
 
-bool		line_delete_data(t_Line *line, size_t index, size_t size)
+bool		line_delete_data(t_Buffer *buffer, t_Line *line, size_t index,
+	size_t size)
 {
+	TEST_NULL(buffer, false);
 	TEST_NULL(line, false);
 	if (index > line->size)
 		return (false);
@@ -216,13 +1060,109 @@ bool		line_delete_data(t_Line *line, size_t index, size_t size)
     	size = line->size - index;
 	if (NULL == line->data || line->size == 0)
 		return (false);
+	TEST_ERROR_FN(line_unshare(buffer, line), false);
+	views_note(buffer, line);
+	line_marks_truncate(line, index);
+	line->flags &= ~LINE_GRAMS;
+	if (line->flags & LINE_ASTRAL)
+		line->flags &= ~LINE_UTF16;
+	if (line->flags & LINE_WIDE)
+		line->flags &= ~LINE_CELLS;
 
+	if (0 == line->capacity && (0 == index || index + size == line->size))
+	{
+		if (0 == index)
+			line->data += size;
+		line->size -= size;
+		line->gap = line->size;
+		tree_resize(line, -(ssize_t)size);
+		grams_note(buffer, line, index, index, size);
+		line_wrap_note(buffer, line);
+		return (true);
+	}
+	TEST_ERROR_FN(line_reserve(&buffer->pool, line, line->size + 1), false);
+	if (line->size >= GAP_MIN)
+	{
+		line_move_gap(line, index);
+		line->size -= size;
+		tree_resize(line, -(ssize_t)size);
+		grams_note(buffer, line, index, index, size);
+		line_wrap_note(buffer, line);
+		return (true);
+	}
+	line_get_data(line);
 	memmove(
 			line->data + index,
 			line->data + index + size,
 			line->size - (index + size)
 	);
 	line->size = line->size - size;
+	line->gap = line->size;
 	line->data[line->size] = '\0';
+	tree_resize(line, -(ssize_t)size);
+	grams_note(buffer, line, index, index, size);
+	line_wrap_note(buffer, line);
+	return (true);
+}
+
+bool		line_replace_ranges(t_Buffer *buffer, t_Line *line,
+	const t_Range *ranges, size_t count, size_t size, const char *data)
+{
+	char		_inline[LINE_INLINE];
+	const char	*_old;
+	char		*_new;
+	char		*_dst;
+	size_t		_new_size;
+	size_t		_capacity;
+	size_t		_cursor;
+	size_t		_i;
+
+	TEST_NULL(buffer, false);
+	TEST_NULL(line, false);
+	if (0 == count)
+		return (true);
+	_old = line_get_data(line);
+	_new_size = line->size + count * size;
+	for (_i = 0; _i < count; _i++)
+		_new_size -= ranges[_i].end - ranges[_i].start;
+	_capacity = LINE_INLINE;
+	_new = _inline;
+	if (_new_size + 1 > LINE_INLINE || line->loan
+		|| line->stamp != buffer->views.stamp)
+	{
+		_capacity = pool_data_capacity(_new_size + 1);
+		_new = pool_data_alloc(&buffer->pool, _capacity);
+		TEST_NULL(_new, false);
+	}
+	_dst = _new;
+	_cursor = 0;
+	for (_i = 0; _i < count; _i++)
+	{
+		memcpy(_dst, _old + _cursor, ranges[_i].start - _cursor);
+		_dst += ranges[_i].start - _cursor;
+		if (size > 0)
+			_dst = (char *)memcpy(_dst, data, size) + size;
+		_cursor = ranges[_i].end;
+	}
+	memcpy(_dst, _old + _cursor, line->size - _cursor);
+	line_marks_truncate(line, ranges[0].start);
+	grams_note(buffer, line, 0, 0, line->size);
+	line_release_data(buffer, line);
+	line->stamp = buffer->views.stamp;
+	views_note(buffer, line);
+	if (_new == _inline)
+		_new = memcpy(line->inline_data, _inline, _new_size);
+	tree_resize(line, (ssize_t)_new_size - (ssize_t)line->size);
+	line->data = _new;
+	line->size = _new_size;
+	line->capacity = _capacity;
+	line->gap = _new_size;
+	line->data[_new_size] = '\0';
+	line->flags &= ~(LINE_GRAMS | LINE_UTF16 | LINE_CELLS);
+	if ((line->flags & LINE_ASCII) ? false == utf8_is_ascii(data, size)
+		: utf8_is_ascii(line->data, line->size))
+		line->flags ^= LINE_ASCII;
+	grams_note(buffer, line, 0, _new_size, 0);
+	line_wrap_note(buffer, line);
 	return (true);
 }
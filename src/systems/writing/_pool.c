@@ -0,0 +1,252 @@
+#include "systems/writing/_internal.h"
+#include "systems/writing/_pool.h"
+
+// +===----- Static functions -----===+ //
+
+/**
+ * @brief Get the capacity of the given class.
+ * @param class The class index.
+ * @return The capacity.
+*/
+static size_t	pool_class_size(size_t class)
+{
+	if (class % 2)
+		return ((size_t)POOL_MIN / 3 * 4 << class / 2);
+	return ((size_t)POOL_MIN << class / 2);
+}
+
+/**
+ * @brief Get the smallest class that fits the given capacity.
+ * @param capacity The capacity (<= POOL_MAX).
+ * @return The class index.
+*/
+static size_t	pool_class(size_t capacity)
+{
+	size_t	_class;
+
+	_class = 0;
+	while (pool_class_size(_class) < capacity)
+		_class++;
+	return (_class);
+}
+
+/**
+ * @brief Allocates a new line block.
+ * @param pool The pool.
+ * @param count The count of lines of the block.
+ * @return The block, or NULL if an error occured.
+*/
+static t_LineBlock	*pool_block_new(t_Pool *pool, size_t count)
+{
+	t_LineBlock	*_block;
+
+	_block = malloc(sizeof(t_LineBlock) + count * sizeof(t_Line));
+	TEST_NULL(_block, NULL);
+	pool->allocs++;
+	_block->count = count;
+	_block->used = 0;
+	_block->lines = (t_Line *)(_block + 1);
+	return (_block);
+}
+
+/**
+ * @brief Starts a new data chunk, the rest of the current one is released
+ * in the classes that fit.
+ * @param pool The pool.
+ * @return TRUE for success or FALSE if an error occured.
+*/
+static bool	pool_chunk_new(t_Pool *pool)
+{
+	t_DataChunk	*_chunk;
+	size_t		_class;
+	size_t		_size;
+
+	_class = POOL_CLASSES - 1;
+	while (pool->left >= POOL_MIN)
+	{
+		while (pool_class_size(_class) > pool->left)
+			_class--;
+		_size = pool_class_size(_class);
+		pool_data_free(pool, pool->cursor, _size);
+		pool->cursor += _size;
+		pool->left -= _size;
+	}
+	_chunk = malloc(sizeof(t_DataChunk) + POOL_CHUNK);
+	TEST_NULL(_chunk, false);
+	pool->allocs++;
+	_chunk->next = pool->chunks;
+	pool->chunks = _chunk;
+	pool->cursor = (char *)(_chunk + 1);
+	pool->left = POOL_CHUNK;
+	return (true);
+}
+
+// +===----- Pool -----===+ //
+
+void	pool_init(t_Pool *pool)
+{
+	size_t	_i;
+
+	pool->blocks = NULL;
+	pool->free_lines = NULL;
+	pool->chunks = NULL;
+	pool->cursor = NULL;
+	pool->left = 0;
+	for (_i = 0; _i < POOL_CLASSES; _i++)
+		pool->free_data[_i] = NULL;
+	pool->allocs = 0;
+}
+
+void	pool_clean(t_Pool *pool)
+{
+	t_LineBlock	*_block;
+	t_DataChunk	*_chunk;
+	size_t		_i;
+
+	while (pool->blocks)
+	{
+		_block = pool->blocks;
+		for (_i = 0; _i < _block->used; _i++)
+		{
+			if (_block->lines[_i].flags & LINE_FREE)
+				continue ;
+			if (_block->lines[_i].capacity > POOL_MAX)
+				free(_block->lines[_i].data);
+			free(_block->lines[_i].extra);
+		}
+		pool->blocks = _block->next;
+		free(_block);
+	}
+	while (pool->chunks)
+	{
+		_chunk = pool->chunks->next;
+		free(pool->chunks);
+		pool->chunks = _chunk;
+	}
+	pool_init(pool);
+}
+
+// +===----- Lines -----===+ //
+
+t_Line	*pool_line_alloc(t_Pool *pool)
+{
+	t_Line		*line;
+	t_LineBlock	*_block;
+
+	if (pool->free_lines)
+	{
+		line = pool->free_lines;
+		pool->free_lines = line->next;
+		return (line);
+	}
+	_block = pool->blocks;
+	if (NULL == _block || _block->used >= _block->count)
+	{
+		_block = pool_block_new(pool, POOL_LINES);
+		TEST_NULL(_block, NULL);
+		_block->next = pool->blocks;
+		pool->blocks = _block;
+	}
+	return (&_block->lines[_block->used++]);
+}
+
+t_Line	*pool_lines_alloc(t_Pool *pool, size_t count)
+{
+	t_LineBlock	*_block;
+
+	_block = pool_block_new(pool, count);
+	TEST_NULL(_block, NULL);
+	_block->used = count;
+	if (pool->blocks)
+	{
+		_block->next = pool->blocks->next;
+		pool->blocks->next = _block;
+	}
+	else
+	{
+		_block->next = NULL;
+		pool->blocks = _block;
+	}
+	return (_block->lines);
+}
+
+void	pool_line_free(t_Pool *pool, t_Line *line)
+{
+	line->flags = LINE_FREE;
+	line->next = pool->free_lines;
+	pool->free_lines = line;
+}
+
+// +===----- Data -----===+ //
+
+size_t	pool_data_capacity(size_t size)
+{
+	size_t	_capacity;
+
+	if (size <= POOL_MAX)
+		return (pool_class_size(pool_class(size)));
+	_capacity = POOL_MAX;
+	while (_capacity < size)
+		_capacity *= 2;
+	return (_capacity);
+}
+
+char	*pool_data_alloc(t_Pool *pool, size_t capacity)
+{
+	char	*data;
+	size_t	_class;
+
+	if (capacity > POOL_MAX)
+	{
+		data = malloc(capacity);
+		if (data)
+			pool->allocs++;
+		return (data);
+	}
+	_class = pool_class(capacity);
+	if (pool->free_data[_class])
+	{
+		data = pool->free_data[_class];
+		pool->free_data[_class] = *(void **)data;
+		return (data);
+	}
+	if (pool->left < capacity)
+		TEST_ERROR_FN(pool_chunk_new(pool), NULL);
+	data = pool->cursor;
+	pool->cursor += capacity;
+	pool->left -= capacity;
+	return (data);
+}
+
+char	*pool_data_realloc(t_Pool *pool, char *data, size_t capacity,
+	size_t new_capacity)
+{
+	char	*new_data;
+
+	if (capacity > POOL_MAX)
+		return (realloc(data, new_capacity));
+	new_data = pool_data_alloc(pool, new_capacity);
+	TEST_NULL(new_data, NULL);
+	if (data)
+	{
+		memcpy(new_data, data, capacity);
+		pool_data_free(pool, data, capacity);
+	}
+	return (new_data);
+}
+
+void	pool_data_free(t_Pool *pool, char *data, size_t capacity)
+{
+	size_t	_class;
+
+	if (NULL == data)
+		return ;
+	if (capacity > POOL_MAX)
+	{
+		free(data);
+		return ;
+	}
+	_class = pool_class(capacity);
+	*(void **)data = pool->free_data[_class];
+	pool->free_data[_class] = data;
+}
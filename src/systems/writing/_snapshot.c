@@ -0,0 +1,947 @@
+#include <limits.h>
+#include <stddef.h>
+#include "systems/writing/_internal.h"
+#include "systems/writing/_snapshot.h"
+#include "systems/writing/_tree.h"
+
+#define VIEW_MIN (VIEW_FANOUT / 4)	/* The count under which a node is merged */
+#define RETIRED_MIN 64	/* The first capacity of the retired memory */
+
+// +===----- Static functions -----===+ //
+
+/**
+ * @brief Takes the lock of the list of snapshots.
+ * @param shared The shared memory.
+*/
+static void	shared_lock(t_Shared *shared)
+{
+	while (atomic_flag_test_and_set_explicit(&shared->lock,
+		memory_order_acquire))
+		;
+}
+
+/**
+ * @brief Releases the lock of the list of snapshots.
+ * @param shared The shared memory.
+*/
+static void	shared_unlock(t_Shared *shared)
+{
+	atomic_flag_clear_explicit(&shared->lock, memory_order_release);
+}
+
+/**
+ * @brief Releases a view tree that no snapshot reads.
+ * @param node The root of the tree, or NULL.
+*/
+static void	view_free(t_ViewNode *node)
+{
+	unsigned int	_i;
+
+	if (NULL == node)
+		return ;
+	if (false == node->leaf)
+		for (_i = 0; _i < node->used; _i++)
+			view_free(node->nodes[_i]);
+	free(node);
+}
+
+/**
+ * @brief Releases retired memory whose pool is cleaned afterwards, only
+ * the memory outside of the pool chunks is freed.
+ * @param retired The retired memory.
+*/
+static void	retired_free(const t_Retired *retired)
+{
+	if (RETIRED_NODE == retired->kind
+		|| (RETIRED_DATA == retired->kind && retired->capacity > POOL_MAX))
+		free(retired->ptr);
+}
+
+/**
+ * @brief Releases retired memory to the pool of the buffer.
+ * @param buffer The buffer.
+ * @param retired The retired memory.
+*/
+static void	retired_release(t_Buffer *buffer, const t_Retired *retired)
+{
+	if (RETIRED_NODE == retired->kind)
+		free(retired->ptr);
+	else if (RETIRED_DATA == retired->kind)
+		pool_data_free(&buffer->pool, retired->ptr, retired->capacity);
+	else
+		pool_line_free(&buffer->pool, retired->ptr);
+}
+
+/**
+ * @brief Creates the memory shared by a buffer and its snapshots.
+ * @return The shared memory owned by the buffer, or NULL if an error occured.
+*/
+static t_Shared	*shared_create(void)
+{
+	t_Shared	*shared;
+
+	shared = malloc(sizeof(t_Shared));
+	TEST_NULL(shared, NULL);
+	atomic_init(&shared->refs, 1);
+	atomic_flag_clear(&shared->lock);
+	shared->oldest = NULL;
+	shared->newest = NULL;
+	shared->retired = NULL;
+	shared->count = 0;
+	shared->capacity = 0;
+	pool_init(&shared->pool);
+	shared->root = NULL;
+	return (shared);
+}
+
+/**
+ * @brief Removes an owner of the shared memory, the last one releases the
+ * retired memory and what the buffer has left.
+ * @param shared The shared memory.
+*/
+static void	shared_release(t_Shared *shared)
+{
+	size_t	_i;
+
+	if (atomic_fetch_sub_explicit(&shared->refs, 1, memory_order_acq_rel) > 1)
+		return ;
+	for (_i = 0; _i < shared->count; _i++)
+		retired_free(&shared->retired[_i]);
+	view_free(shared->root);
+	pool_clean(&shared->pool);
+	free(shared->retired);
+	free(shared);
+}
+
+/**
+ * @brief Releases the retired memory that no live snapshot can read.
+ * @param buffer The buffer.
+*/
+static void	shared_reclaim(t_Buffer *buffer)
+{
+	t_Shared		*_shared;
+	unsigned int	_oldest;
+	size_t			_i;
+
+	_shared = buffer->views.shared;
+	shared_lock(_shared);
+	_oldest = _shared->oldest ? _shared->oldest->stamp : UINT_MAX;
+	shared_unlock(_shared);
+	for (_i = 0; _i < _shared->count && _shared->retired[_i].stamp < _oldest; _i++)
+		retired_release(buffer, &_shared->retired[_i]);
+	if (0 == _i)
+		return ;
+	_shared->count -= _i;
+	memmove(_shared->retired, _shared->retired + _i,
+		_shared->count * sizeof(t_Retired));
+}
+
+/**
+ * @brief Gives up the view tree after an error, it is built again by the
+ * next snapshot.
+ * @param buffer The buffer.
+*/
+static void	views_lose(t_Buffer *buffer)
+{
+	buffer->views.lost = true;
+	buffer->views.late_count = 0;
+}
+
+/**
+ * @brief Fills the entry with the view of the line, the gap of the line is
+ * closed.
+ * @param entry The entry.
+ * @param line The line.
+*/
+static void	view_entry(t_ViewEntry *entry, t_Line *line)
+{
+	entry->data = line_get_data(line);
+	entry->size = line->size;
+	entry->flags = line->flags & LINE_CRLF;
+}
+
+/**
+ * @brief Finds the child of a node that holds a line, scanned from the
+ * closest end of the node.
+ * @param node The node, that holds children.
+ * @param index The index of the line in the node, replaced by its index in
+ * the child.
+ * @param end The index is an insertion position, it may be the count of
+ * lines of the child.
+ * @return The position of the child.
+*/
+static unsigned int	view_child(const t_ViewNode *node, size_t *index, bool end)
+{
+	unsigned int	_i;
+	size_t			_after;
+
+	if (*index < node->count / 2)
+	{
+		for (_i = 0; _i + 1 < node->used
+			&& *index >= node->counts[_i] + end; _i++)
+			*index -= node->counts[_i];
+		return (_i);
+	}
+	_after = node->count - *index;
+	for (_i = node->used - 1; _i > 0 && _after > node->counts[_i]; _i--)
+		_after -= node->counts[_i];
+	*index = node->counts[_i] - _after;
+	return (_i);
+}
+
+/**
+ * @brief Creates an empty node.
+ * @param buffer The buffer.
+ * @param leaf The node holds entries.
+ * @return The node, or NULL if an error occured.
+*/
+static t_ViewNode	*view_new(t_Buffer *buffer, bool leaf)
+{
+	t_ViewNode	*node;
+
+	node = malloc(sizeof(t_ViewNode));
+	TEST_NULL(node, NULL);
+	node->count = 0;
+	node->stamp = buffer->views.stamp;
+	node->used = 0;
+	node->leaf = leaf;
+	return (node);
+}
+
+/**
+ * @brief Get a node that can be changed, a node that a snapshot may read is
+ * copied and retired.
+ * @param buffer The buffer.
+ * @param node The node.
+ * @return The node or its copy, or NULL if an error occured.
+*/
+static t_ViewNode	*view_own(t_Buffer *buffer, t_ViewNode *node)
+{
+	t_ViewNode	*copy;
+
+	if (node->stamp == buffer->views.stamp)
+		return (node);
+	copy = malloc(sizeof(t_ViewNode));
+	TEST_NULL(copy, NULL);
+	if (node->leaf)
+		memcpy(copy, node, offsetof(t_ViewNode, entries)
+			+ node->used * sizeof(t_ViewEntry));
+	else
+		memcpy(copy, node, sizeof(t_ViewNode));
+	copy->stamp = buffer->views.stamp;
+	views_retire(buffer, node, 0, RETIRED_NODE);
+	return (copy);
+}
+
+/**
+ * @brief Releases a node that has left the tree, its children are kept.
+ * @param buffer The buffer.
+ * @param node The node.
+*/
+static void	view_release(t_Buffer *buffer, t_ViewNode *node)
+{
+	if (node->stamp == buffer->views.stamp)
+		free(node);
+	else
+		views_retire(buffer, node, 0, RETIRED_NODE);
+}
+
+/**
+ * @brief Releases a subtree that has left the tree.
+ * @param buffer The buffer.
+ * @param node The root of the subtree.
+*/
+static void	view_drop(t_Buffer *buffer, t_ViewNode *node)
+{
+	unsigned int	_i;
+
+	if (false == node->leaf)
+		for (_i = 0; _i < node->used; _i++)
+			view_drop(buffer, node->nodes[_i]);
+	view_release(buffer, node);
+}
+
+/**
+ * @brief Sums the lines of the children of a node.
+ * @param node The node.
+*/
+static void	view_count(t_ViewNode *node)
+{
+	unsigned int	_i;
+
+	if (node->leaf)
+	{
+		node->count = node->used;
+		return ;
+	}
+	node->count = 0;
+	for (_i = 0; _i < node->used; _i++)
+		node->count += node->counts[_i];
+}
+
+/**
+ * @brief Moves the upper half of a full node to a new node. A node full
+ * after an append keeps its slots, so that lines added in order fill the
+ * nodes.
+ * @param buffer The buffer.
+ * @param node The node, that can be changed.
+ * @param index The position of the slot about to be added.
+ * @return The new node, or NULL if an error occured.
+*/
+static t_ViewNode	*view_split(t_Buffer *buffer, t_ViewNode *node,
+	size_t index)
+{
+	t_ViewNode	*right;
+
+	right = view_new(buffer, node->leaf);
+	TEST_NULL(right, NULL);
+	right->used = VIEW_FANOUT == index ? 0 : node->used - VIEW_FANOUT / 2;
+	node->used -= right->used;
+	if (node->leaf)
+		memcpy(right->entries, node->entries + node->used,
+			right->used * sizeof(t_ViewEntry));
+	else
+	{
+		memcpy(right->nodes, node->nodes + node->used,
+			right->used * sizeof(t_ViewNode *));
+		memcpy(right->counts, node->counts + node->used,
+			right->used * sizeof(size_t));
+	}
+	view_count(node);
+	view_count(right);
+	return (right);
+}
+
+/**
+ * @brief Adds a child to a node, the node is split if it is full.
+ * @param buffer The buffer.
+ * @param node The node, that can be changed.
+ * @param index The position of the child.
+ * @param child The child.
+ * @param split The new node after a split, or NULL.
+ * @return TRUE for success or FALSE if an error occured.
+*/
+static bool	view_add(t_Buffer *buffer, t_ViewNode *node, unsigned int index,
+	t_ViewNode *child, t_ViewNode **split)
+{
+	t_ViewNode	*_target;
+
+	_target = node;
+	if (VIEW_FANOUT == node->used)
+	{
+		*split = view_split(buffer, node, index);
+		if (NULL == *split)
+			return (view_drop(buffer, child), false);
+		if (index >= node->used)
+		{
+			index -= node->used;
+			_target = *split;
+		}
+	}
+	memmove(_target->nodes + index + 1, _target->nodes + index,
+		(_target->used - index) * sizeof(t_ViewNode *));
+	memmove(_target->counts + index + 1, _target->counts + index,
+		(_target->used - index) * sizeof(size_t));
+	_target->nodes[index] = child;
+	_target->counts[index] = child->count;
+	_target->used++;
+	view_count(_target);
+	return (true);
+}
+
+/**
+ * @brief Inserts the view of a line in a subtree.
+ * @param buffer The buffer.
+ * @param slot The root of the subtree, replaced by its copy if it is shared.
+ * @param line The line.
+ * @param index The index of the line in the subtree.
+ * @param split The new node after a split of the root, or NULL.
+ * @return TRUE for success or FALSE if an error occured.
+*/
+static bool	view_insert(t_Buffer *buffer, t_ViewNode **slot, t_Line *line,
+	size_t index, t_ViewNode **split)
+{
+	t_ViewNode		*_node;
+	t_ViewNode		*_child;
+	unsigned int	_i;
+
+	*split = NULL;
+	_node = view_own(buffer, *slot);
+	TEST_NULL(_node, false);
+	*slot = _node;
+	if (_node->leaf)
+	{
+		if (VIEW_FANOUT == _node->used)
+		{
+			*split = view_split(buffer, _node, index);
+			TEST_NULL(*split, false);
+			if (index >= _node->used)
+			{
+				index -= _node->used;
+				_node = *split;
+			}
+		}
+		memmove(_node->entries + index + 1, _node->entries + index,
+			(_node->used - index) * sizeof(t_ViewEntry));
+		view_entry(&_node->entries[index], line);
+		_node->used++;
+		_node->count++;
+		return (true);
+	}
+	_i = view_child(_node, &index, true);
+	TEST_ERROR_FN(view_insert(buffer, &_node->nodes[_i], line, index, &_child),
+		false);
+	_node->counts[_i] = _node->nodes[_i]->count;
+	_node->count++;
+	if (NULL == _child)
+		return (true);
+	return (view_add(buffer, _node, _i + 1, _child, split));
+}
+
+/**
+ * @brief Merges a child of a node with the next one if they fit in one node.
+ * @param buffer The buffer.
+ * @param node The node, that can be changed.
+ * @param index The position of the child.
+ * @return TRUE for success or FALSE if an error occured.
+*/
+static bool	view_merge(t_Buffer *buffer, t_ViewNode *node, unsigned int index)
+{
+	t_ViewNode	*_left;
+	t_ViewNode	*_right;
+
+	if (index + 1 >= node->used)
+		return (true);
+	_left = node->nodes[index];
+	_right = node->nodes[index + 1];
+	if (_left->used + _right->used > VIEW_FANOUT)
+		return (true);
+	_left = view_own(buffer, _left);
+	TEST_NULL(_left, false);
+	node->nodes[index] = _left;
+	if (_left->leaf)
+		memcpy(_left->entries + _left->used, _right->entries,
+			_right->used * sizeof(t_ViewEntry));
+	else
+		memcpy(_left->nodes + _left->used, _right->nodes,
+			_right->used * sizeof(t_ViewNode *));
+	if (false == _left->leaf)
+		memcpy(_left->counts + _left->used, _right->counts,
+			_right->used * sizeof(size_t));
+	_left->used += _right->used;
+	_left->count += _right->count;
+	node->counts[index] = _left->count;
+	view_release(buffer, _right);
+	node->used--;
+	memmove(node->nodes + index + 1, node->nodes + index + 2,
+		(node->used - index - 1) * sizeof(t_ViewNode *));
+	memmove(node->counts + index + 1, node->counts + index + 2,
+		(node->used - index - 1) * sizeof(size_t));
+	return (true);
+}
+
+/**
+ * @brief Merges a small child of a node with one of its neighbours.
+ * @param buffer The buffer.
+ * @param node The node, that can be changed.
+ * @param index The position of the child.
+ * @return TRUE for success or FALSE if an error occured.
+*/
+static bool	view_fix(t_Buffer *buffer, t_ViewNode *node, unsigned int index)
+{
+	if (index >= node->used || node->nodes[index]->used >= VIEW_MIN)
+		return (true);
+	if (index + 1 < node->used)
+		return (view_merge(buffer, node, index));
+	if (index > 0)
+		return (view_merge(buffer, node, index - 1));
+	return (true);
+}
+
+/**
+ * @brief Removes the views of consecutive lines from a subtree.
+ * @param buffer The buffer.
+ * @param slot The root of the subtree, replaced by its copy if it is shared.
+ * @param index The index of the first line in the subtree.
+ * @param count The count of lines, all in the subtree.
+ * @return TRUE for success or FALSE if an error occured.
+*/
+static bool	view_remove(t_Buffer *buffer, t_ViewNode **slot, size_t index,
+	size_t count)
+{
+	t_ViewNode		*_node;
+	unsigned int	_first;
+	unsigned int	_i;
+	size_t			_part;
+
+	_node = view_own(buffer, *slot);
+	TEST_NULL(_node, false);
+	*slot = _node;
+	if (_node->leaf)
+	{
+		_node->count -= count;
+		_node->used -= count;
+		memmove(_node->entries + index, _node->entries + index + count,
+			(_node->used - index) * sizeof(t_ViewEntry));
+		return (true);
+	}
+	_i = view_child(_node, &index, false);
+	_first = _i;
+	_node->count -= count;
+	while (count > 0)
+	{
+		_part = _node->counts[_i] - index;
+		_part = _part < count ? _part : count;
+		if (_part == _node->counts[_i])
+		{
+			view_drop(buffer, _node->nodes[_i]);
+			_node->used--;
+			memmove(_node->nodes + _i, _node->nodes + _i + 1,
+				(_node->used - _i) * sizeof(t_ViewNode *));
+			memmove(_node->counts + _i, _node->counts + _i + 1,
+				(_node->used - _i) * sizeof(size_t));
+		}
+		else
+		{
+			TEST_ERROR_FN(view_remove(buffer, &_node->nodes[_i], index,
+				_part), false);
+			_node->counts[_i++] -= _part;
+		}
+		count -= _part;
+		index = 0;
+	}
+	return (view_fix(buffer, _node, _first + 1)
+		&& view_fix(buffer, _node, _first));
+}
+
+/**
+ * @brief Updates the view of a line.
+ * @param buffer The buffer.
+ * @param line The line.
+ * @param index The index of the line.
+ * @return TRUE for success or FALSE if an error occured.
+*/
+static bool	view_set(t_Buffer *buffer, t_Line *line, size_t index)
+{
+	t_ViewNode	**_slot;
+	t_ViewNode	*_node;
+
+	_slot = &buffer->views.root;
+	while (true)
+	{
+		_node = view_own(buffer, *_slot);
+		TEST_NULL(_node, false);
+		*_slot = _node;
+		if (_node->leaf)
+			break ;
+		_slot = &_node->nodes[view_child(_node, &index, false)];
+	}
+	view_entry(&_node->entries[index], line);
+	return (true);
+}
+
+/**
+ * @brief Updates the view of a late line, the views are lost if an error
+ * occurs.
+ * @param buffer The buffer.
+ * @param line The line.
+*/
+static void	view_flush(t_Buffer *buffer, t_Line *line)
+{
+	if (false == view_set(buffer, line, tree_index(line)))
+		views_lose(buffer);
+}
+
+/**
+ * @brief Get the entry of a line.
+ * @param node The root of the tree.
+ * @param index The index of the line.
+ * @return The entry.
+*/
+static const t_ViewEntry	*view_at(const t_ViewNode *node, size_t index)
+{
+	while (false == node->leaf)
+		node = node->nodes[view_child(node, &index, false)];
+	return (&node->entries[index]);
+}
+
+/**
+ * @brief Fills views with consecutive lines of a subtree.
+ * @param node The root of the subtree.
+ * @param index The index of the first line in the subtree.
+ * @param count The maximum count of views.
+ * @param views The views.
+ * @return The count of filled views.
+*/
+static size_t	view_fill(const t_ViewNode *node, size_t index, size_t count,
+	t_LineView *views)
+{
+	size_t			_filled;
+	unsigned int	_i;
+
+	_filled = 0;
+	if (node->leaf)
+	{
+		for (_i = index; _i < node->used && _filled < count; _i++, _filled++)
+			views[_filled] = (t_LineView){node->entries[_i].data,
+				node->entries[_i].size};
+		return (_filled);
+	}
+	for (_i = 0; _i < node->used && _filled < count; _i++)
+	{
+		if (index >= node->counts[_i])
+		{
+			index -= node->counts[_i];
+			continue ;
+		}
+		_filled += view_fill(node->nodes[_i], index, count - _filled,
+			views + _filled);
+		index = 0;
+	}
+	return (_filled);
+}
+
+/**
+ * @brief Groups the nodes of a level under new parents.
+ * @param buffer The buffer.
+ * @param level The nodes, replaced by their parents.
+ * @param count The count of nodes, replaced by the count of parents.
+ * @return TRUE for success or FALSE if an error occured, the nodes are
+ * released and the count is 0 then.
+*/
+static bool	view_build_level(t_Buffer *buffer, t_ViewNode **level,
+	size_t *count)
+{
+	t_ViewNode	*_node;
+	size_t		_parents;
+	size_t		_i;
+	size_t		_j;
+
+	_parents = (*count + VIEW_FANOUT - 1) / VIEW_FANOUT;
+	for (_i = 0; _i < _parents; _i++)
+	{
+		_node = view_new(buffer, false);
+		if (NULL == _node)
+		{
+			for (_j = 0; _j < _i; _j++)
+				view_drop(buffer, level[_j]);
+			for (_j = _i * VIEW_FANOUT; _j < *count; _j++)
+				view_drop(buffer, level[_j]);
+			*count = 0;
+			return (false);
+		}
+		for (_j = _i * VIEW_FANOUT; _j < *count && _node->used < VIEW_FANOUT; _j++)
+		{
+			_node->nodes[_node->used] = level[_j];
+			_node->counts[_node->used++] = level[_j]->count;
+		}
+		view_count(_node);
+		level[_i] = _node;
+	}
+	*count = _parents;
+	return (true);
+}
+
+// +===----- Mapping -----===+ //
+
+t_Mapping	*mapping_create(int fd, size_t size)
+{
+	t_Mapping	*mapping;
+	void		*_map;
+
+	mapping = malloc(sizeof(t_Mapping));
+	TEST_NULL(mapping, NULL);
+	_map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (MAP_FAILED == _map)
+		return (free(mapping), NULL);
+	madvise(_map, size, MADV_SEQUENTIAL);
+	atomic_init(&mapping->refs, 1);
+	mapping->data = _map;
+	mapping->size = size;
+	return (mapping);
+}
+
+t_Mapping	*mapping_retain(t_Mapping *mapping)
+{
+	atomic_fetch_add_explicit(&mapping->refs, 1, memory_order_relaxed);
+	return (mapping);
+}
+
+void		mapping_release(t_Mapping *mapping)
+{
+	if (NULL == mapping)
+		return ;
+	if (atomic_fetch_sub_explicit(&mapping->refs, 1, memory_order_acq_rel) > 1)
+		return ;
+	munmap((void *)mapping->data, mapping->size);
+	free(mapping);
+}
+
+// +===----- Views -----===+ //
+
+void		views_init(t_Views *views)
+{
+	views->root = NULL;
+	views->late_count = 0;
+	views->stamp = 0;
+	views->lost = false;
+	views->shared = NULL;
+}
+
+void		views_clean(t_Buffer *buffer)
+{
+	t_Shared	*_shared;
+
+	_shared = buffer->views.shared;
+	if (NULL == _shared)
+		return (view_free(buffer->views.root));
+	_shared->root = buffer->views.root;
+	if (atomic_load_explicit(&_shared->refs, memory_order_acquire) > 1)
+	{
+		_shared->pool = buffer->pool;
+		pool_init(&buffer->pool);
+	}
+	shared_release(_shared);
+}
+
+void		views_build(t_Buffer *buffer)
+{
+	t_ViewNode	**_level;
+	t_Line		*_line;
+	size_t		_count;
+	size_t		_i;
+	bool		_status;
+
+	if (buffer->views.root)
+		view_drop(buffer, buffer->views.root);
+	buffer->views.root = NULL;
+	buffer->views.late_count = 0;
+	buffer->views.lost = false;
+	if (0 == buffer->size)
+		return ;
+	_count = (buffer->size + VIEW_FANOUT - 1) / VIEW_FANOUT;
+	_level = malloc(_count * sizeof(t_ViewNode *));
+	if (NULL == _level)
+		return (views_lose(buffer));
+	_line = buffer->line;
+	for (_i = 0; _i < _count && NULL != (_level[_i] = view_new(buffer, true));
+		_i++)
+	{
+		for (; _line && _level[_i]->used < VIEW_FANOUT; _line = _line->next)
+			view_entry(&_level[_i]->entries[_level[_i]->used++], _line);
+		view_count(_level[_i]);
+	}
+	_status = _i == _count;
+	_count = _i;
+	while (_status && _count > 1)
+		_status = view_build_level(buffer, _level, &_count);
+	if (_status)
+		buffer->views.root = _level[0];
+	else
+	{
+		for (_i = 0; _i < _count; _i++)
+			view_drop(buffer, _level[_i]);
+		views_lose(buffer);
+	}
+	free(_level);
+}
+
+void		views_insert(t_Buffer *buffer, t_Line *line, size_t index)
+{
+	t_ViewNode	*_split;
+	t_ViewNode	*_root;
+
+	if (buffer->views.lost)
+		return ;
+	if (NULL == buffer->views.root)
+		buffer->views.root = view_new(buffer, true);
+	if (NULL == buffer->views.root
+		|| false == view_insert(buffer, &buffer->views.root, line, index,
+			&_split))
+		return (views_lose(buffer));
+	if (NULL == _split)
+		return ;
+	_root = view_new(buffer, false);
+	if (NULL == _root)
+		return (view_drop(buffer, _split), views_lose(buffer));
+	_root->nodes[0] = buffer->views.root;
+	_root->counts[0] = buffer->views.root->count;
+	_root->nodes[1] = _split;
+	_root->counts[1] = _split->count;
+	_root->used = 2;
+	view_count(_root);
+	buffer->views.root = _root;
+}
+
+void		views_remove(t_Buffer *buffer, t_Line *first, size_t index,
+	size_t count)
+{
+	t_Views		*_views;
+	t_ViewNode	*_root;
+	size_t		_i;
+
+	_views = &buffer->views;
+	for (_i = 0; _i < _views->late_count; )
+	{
+		if (_views->late[_i] == first
+			|| (count > 1 && tree_index(_views->late[_i]) - index < count))
+			memmove(_views->late + _i, _views->late + _i + 1,
+				(--_views->late_count - _i) * sizeof(t_Line *));
+		else
+			_i++;
+	}
+	if (_views->lost)
+		return ;
+	if (false == view_remove(buffer, &_views->root, index, count))
+		return (views_lose(buffer));
+	while (NULL != (_root = _views->root)
+		&& (0 == _root->count || (false == _root->leaf && 1 == _root->used)))
+	{
+		_views->root = _root->count ? _root->nodes[0] : NULL;
+		if (NULL == _views->root)
+			view_drop(buffer, _root);
+		else
+			view_release(buffer, _root);
+	}
+}
+
+void		views_note(t_Buffer *buffer, t_Line *line)
+{
+	t_Views	*_views;
+	size_t	_i;
+
+	_views = &buffer->views;
+	if (_views->lost || (NULL == line->parent && buffer->root != line))
+		return ;
+	for (_i = _views->late_count; _i > 0; _i--)
+		if (_views->late[_i - 1] == line)
+			return ;
+	if (VIEW_LATE == _views->late_count)
+	{
+		view_flush(buffer, _views->late[0]);
+		if (_views->lost)
+			return ;
+		memmove(_views->late, _views->late + 1,
+			(VIEW_LATE - 1) * sizeof(t_Line *));
+		_views->late_count--;
+	}
+	_views->late[_views->late_count++] = line;
+}
+
+void		views_retire(t_Buffer *buffer, void *ptr, size_t capacity,
+	t_RetiredKind kind)
+{
+	t_Shared	*_shared;
+	t_Retired	*_retired;
+	size_t		_capacity;
+
+	_shared = buffer->views.shared;
+	if (_shared->count == _shared->capacity)
+		shared_reclaim(buffer);
+	if (_shared->count == _shared->capacity)
+	{
+		_capacity = _shared->capacity ? _shared->capacity * 2 : RETIRED_MIN;
+		_retired = realloc(_shared->retired, _capacity * sizeof(t_Retired));
+		if (NULL == _retired)
+			return ;
+		_shared->retired = _retired;
+		_shared->capacity = _capacity;
+	}
+	_shared->retired[_shared->count++] = (t_Retired){ptr, capacity,
+		buffer->views.stamp, kind};
+}
+
+// +===----- Snapshot -----===+ //
+
+t_Snapshot	*snapshot_create(t_Buffer *buffer)
+{
+	t_Snapshot	*snapshot;
+	t_Views		*_views;
+	size_t		_i;
+
+	_views = &buffer->views;
+	for (_i = 0; _i < _views->late_count && false == _views->lost; _i++)
+		view_flush(buffer, _views->late[_i]);
+	_views->late_count = 0;
+	if (_views->lost)
+		views_build(buffer);
+	if (_views->lost)
+		return (NULL);
+	if (NULL == _views->shared)
+		_views->shared = shared_create();
+	TEST_NULL(_views->shared, NULL);
+	snapshot = malloc(sizeof(t_Snapshot));
+	TEST_NULL(snapshot, NULL);
+	shared_reclaim(buffer);
+	atomic_init(&snapshot->refs, 1);
+	snapshot->count = _views->root ? _views->root->count : 0;
+	snapshot->stamp = ++_views->stamp;
+	snapshot->root = _views->root;
+	snapshot->mapping = buffer->mapping ? mapping_retain(buffer->mapping) : NULL;
+	snapshot->shared = _views->shared;
+	atomic_fetch_add_explicit(&snapshot->shared->refs, 1, memory_order_relaxed);
+	snapshot->newer = NULL;
+	shared_lock(snapshot->shared);
+	snapshot->older = snapshot->shared->newest;
+	if (snapshot->older)
+		snapshot->older->newer = snapshot;
+	else
+		snapshot->shared->oldest = snapshot;
+	snapshot->shared->newest = snapshot;
+	shared_unlock(snapshot->shared);
+	return (snapshot);
+}
+
+size_t		snapshot_size(const t_Snapshot *snapshot)
+{
+	TEST_NULL(snapshot, 0);
+	return (snapshot->count);
+}
+
+size_t		snapshot_get_lines(const t_Snapshot *snapshot, size_t line,
+	size_t count, t_LineView *views)
+{
+	TEST_NULL(snapshot, 0);
+	if (line >= snapshot->count)
+		return (0);
+	return (view_fill(snapshot->root, line, count, views));
+}
+
+bool		snapshot_is_crlf(const t_Snapshot *snapshot, size_t line)
+{
+	TEST_NULL(snapshot, false);
+	if (line >= snapshot->count)
+		return (false);
+	return (0 != (view_at(snapshot->root, line)->flags & LINE_CRLF));
+}
+
+t_Snapshot	*snapshot_retain(t_Snapshot *snapshot)
+{
+	TEST_NULL(snapshot, NULL);
+	atomic_fetch_add_explicit(&snapshot->refs, 1, memory_order_relaxed);
+	return (snapshot);
+}
+
+void		snapshot_release(t_Snapshot *snapshot)
+{
+	t_Shared	*_shared;
+
+	if (NULL == snapshot)
+		return ;
+	if (atomic_fetch_sub_explicit(&snapshot->refs, 1, memory_order_acq_rel) > 1)
+		return ;
+	_shared = snapshot->shared;
+	shared_lock(_shared);
+	if (snapshot->older)
+		snapshot->older->newer = snapshot->newer;
+	else
+		_shared->oldest = snapshot->newer;
+	if (snapshot->newer)
+		snapshot->newer->older = snapshot->older;
+	else
+		_shared->newest = snapshot->older;
+	shared_unlock(_shared);
+	mapping_release(snapshot->mapping);
+	shared_release(_shared);
+	free(snapshot);
+}
@@ -0,0 +1,546 @@
+#include "systems/writing/_internal.h"
+#include "systems/writing/_tree.h"
+
+// +===----- Static functions -----===+ //
+
+/**
+ * @brief Get the count of lines of the given subtree.
+ * @param node The root of the subtree.
+ * @return The count of lines.
+*/
+static size_t	tree_count(const t_Line *node)
+{
+	if (NULL == node)
+		return (0);
+	return (node->count);
+}
+
+/**
+ * @brief Get the count of bytes of the given subtree.
+ * @param node The root of the subtree.
+ * @return The count of bytes, line endings included.
+*/
+static size_t	tree_bytes(const t_Line *node)
+{
+	if (NULL == node)
+		return (0);
+	return (node->bytes);
+}
+
+/**
+ * @brief Get the count of wrapped rows of the given subtree.
+ * @param node The root of the subtree.
+ * @return The count of rows.
+*/
+static size_t	tree_rows(const t_Line *node)
+{
+	if (NULL == node)
+		return (0);
+	return (node->rows);
+}
+
+/**
+ * @brief Generates the priority of a new node (xorshift32).
+ * @param buffer The buffer that contains the generator state.
+ * @return The priority.
+*/
+static unsigned int	tree_priority(t_Buffer *buffer)
+{
+	unsigned int	_x;
+
+	_x = buffer->seed;
+	_x ^= _x << 13;
+	_x ^= _x >> 17;
+	_x ^= _x << 5;
+	buffer->seed = _x;
+	return (_x);
+}
+
+/**
+ * @brief Replaces the child of the parent of the old node by the new node.
+ * @param buffer The buffer that contains lines.
+ * @param old The old child.
+ * @param new The new child.
+*/
+static void	tree_replace_child(t_Buffer *buffer, t_Line *old, t_Line *new)
+{
+	t_Line	*_parent;
+
+	_parent = old->parent;
+	if (NULL == _parent)
+		buffer->root = new;
+	else if (_parent->left == old)
+		_parent->left = new;
+	else
+		_parent->right = new;
+	if (new)
+		new->parent = _parent;
+}
+
+/**
+ * @brief Rotates the node above its parent.
+ * @param buffer The buffer that contains lines.
+ * @param node The node that will be moved up.
+*/
+static void	tree_rotate_up(t_Buffer *buffer, t_Line *node)
+{
+	t_Line	*_parent;
+
+	_parent = node->parent;
+	tree_replace_child(buffer, _parent, node);
+	if (_parent->left == node)
+	{
+		_parent->left = node->right;
+		if (node->right)
+			node->right->parent = _parent;
+		node->right = _parent;
+	}
+	else
+	{
+		_parent->right = node->left;
+		if (node->left)
+			node->left->parent = _parent;
+		node->left = _parent;
+	}
+	_parent->parent = node;
+	tree_update(_parent);
+	tree_update(node);
+}
+
+/**
+ * @brief Builds a balanced subtree from contiguous lines.
+ * The priority of a node depends on its depth so that the heap order holds.
+ * @param buffer The buffer that contains the generator state.
+ * @param lines The lines, in order.
+ * @param count The count of lines.
+ * @param depth The depth of the subtree root.
+ * @return The root of the subtree.
+*/
+static t_Line	*tree_build_range(t_Buffer *buffer, t_Line *lines, size_t count,
+	unsigned int depth)
+{
+	t_Line			*_root;
+	unsigned int	_span;
+
+	if (0 == count)
+		return (NULL);
+	_root = &lines[count / 2];
+	_span = depth < 32 ? 0x80000000u >> depth : 0;
+	_root->priority = _span ? _span + tree_priority(buffer) % _span : 0;
+	_root->left = tree_build_range(buffer, lines, count / 2, depth + 1);
+	_root->right = tree_build_range(buffer, _root + 1, count - count / 2 - 1,
+		depth + 1);
+	if (_root->left)
+		_root->left->parent = _root;
+	if (_root->right)
+		_root->right->parent = _root;
+	tree_update(_root);
+	return (_root);
+}
+
+/**
+ * @brief Builds a balanced subtree from lines linked by their next line.
+ * The priority of a node depends on its depth so that the heap order holds.
+ * @param buffer The buffer that contains the generator state.
+ * @param cursor The first line, moved after the last line of the subtree.
+ * @param count The count of lines.
+ * @param depth The depth of the subtree root.
+ * @return The root of the subtree.
+*/
+static t_Line	*tree_build_list(t_Buffer *buffer, t_Line **cursor, size_t count,
+	unsigned int depth)
+{
+	t_Line			*_root;
+	t_Line			*_left;
+	unsigned int	_span;
+
+	if (0 == count)
+		return (NULL);
+	_left = tree_build_list(buffer, cursor, count / 2, depth + 1);
+	_root = *cursor;
+	*cursor = _root->next;
+	_span = depth < 32 ? 0x80000000u >> depth : 0;
+	_root->priority = _span ? _span + tree_priority(buffer) % _span : 0;
+	_root->left = _left;
+	_root->right = tree_build_list(buffer, cursor, count - count / 2 - 1,
+		depth + 1);
+	if (_root->left)
+		_root->left->parent = _root;
+	if (_root->right)
+		_root->right->parent = _root;
+	tree_update(_root);
+	return (_root);
+}
+
+/**
+ * @brief Splits a subtree in its first lines and the other ones.
+ * @param node The root of the subtree.
+ * @param index The count of lines of the left part.
+ * @param left The root of the left part.
+ * @param right The root of the right part.
+*/
+static void	tree_split(t_Line *node, size_t index, t_Line **left, t_Line **right)
+{
+	if (NULL == node)
+	{
+		*left = NULL;
+		*right = NULL;
+		return ;
+	}
+	if (index <= tree_count(node->left))
+	{
+		tree_split(node->left, index, left, &node->left);
+		if (node->left)
+			node->left->parent = node;
+		*right = node;
+	}
+	else
+	{
+		tree_split(node->right, index - tree_count(node->left) - 1,
+			&node->right, right);
+		if (node->right)
+			node->right->parent = node;
+		*left = node;
+	}
+	tree_update(node);
+}
+
+/**
+ * @brief Merges two subtrees, every line of the left one comes first.
+ * @param left The root of the left subtree.
+ * @param right The root of the right subtree.
+ * @return The root of the merged subtree.
+*/
+static t_Line	*tree_merge(t_Line *left, t_Line *right)
+{
+	if (NULL == left)
+		return (right);
+	if (NULL == right)
+		return (left);
+	if (left->priority > right->priority)
+	{
+		left->right = tree_merge(left->right, right);
+		left->right->parent = left;
+		tree_update(left);
+		return (left);
+	}
+	right->left = tree_merge(left, right->left);
+	right->left->parent = right;
+	tree_update(right);
+	return (right);
+}
+
+// +===----- Nodes -----===+ //
+
+size_t	tree_height(const t_Line *line)
+{
+	if (NULL == line->extra)
+		return (1);
+	return (line->extra->height);
+}
+
+void	tree_update(t_Line *node)
+{
+	node->count = 1 + tree_count(node->left) + tree_count(node->right);
+	node->bytes = node->size + (node->flags & LINE_CRLF ? 2 : 1)
+		+ tree_bytes(node->left) + tree_bytes(node->right);
+	node->rows = tree_height(node) + tree_rows(node->left) + tree_rows(node->right);
+}
+
+void	tree_resize(t_Line *line, ssize_t delta)
+{
+	for (; line; line = line->parent)
+		line->bytes += delta;
+}
+
+void	tree_set_height(t_Line *line, size_t height)
+{
+	ssize_t	_delta;
+
+	_delta = (ssize_t)height - (ssize_t)tree_height(line);
+	if (line->extra)
+		line->extra->height = height;
+	for (; line && _delta; line = line->parent)
+		line->rows += _delta;
+}
+
+void	tree_propagate(t_Line *node)
+{
+	while (node)
+	{
+		tree_update(node);
+		node = node->parent;
+	}
+}
+
+void	tree_build(t_Buffer *buffer, t_Line *lines, size_t count)
+{
+	size_t	_i;
+
+	for (_i = 0; _i < count; _i++)
+	{
+		lines[_i].prev = _i > 0 ? &lines[_i - 1] : NULL;
+		lines[_i].next = _i + 1 < count ? &lines[_i + 1] : NULL;
+	}
+	buffer->root = tree_build_range(buffer, lines, count, 0);
+	if (buffer->root)
+		buffer->root->parent = NULL;
+	buffer->line = count ? &lines[0] : NULL;
+	buffer->last = count ? &lines[count - 1] : NULL;
+	buffer->size = count;
+	views_build(buffer);
+}
+
+// +===----- Lookup -----===+ //
+
+t_Line	*tree_at(t_Line *root, size_t index)
+{
+	size_t	_left;
+
+	if (index >= tree_count(root))
+		return (NULL);
+	while (root)
+	{
+		_left = tree_count(root->left);
+		if (index == _left)
+			return (root);
+		if (index < _left)
+			root = root->left;
+		else
+		{
+			index -= _left + 1;
+			root = root->right;
+		}
+	}
+	return (NULL);
+}
+
+t_Line	*tree_at_offset(t_Line *root, size_t *offset)
+{
+	size_t	_left;
+	size_t	_own;
+
+	if (*offset >= tree_bytes(root))
+		return (NULL);
+	while (root)
+	{
+		_left = tree_bytes(root->left);
+		_own = root->bytes - _left - tree_bytes(root->right);
+		if (*offset < _left)
+			root = root->left;
+		else if (*offset - _left < _own)
+		{
+			*offset -= _left;
+			return (root);
+		}
+		else
+		{
+			*offset -= _left + _own;
+			root = root->right;
+		}
+	}
+	return (NULL);
+}
+
+t_Line	*tree_at_row(t_Line *root, size_t *row)
+{
+	size_t	_left;
+
+	if (*row >= tree_rows(root))
+		return (NULL);
+	while (root)
+	{
+		_left = tree_rows(root->left);
+		if (*row < _left)
+			root = root->left;
+		else if (*row - _left < tree_height(root))
+		{
+			*row -= _left;
+			return (root);
+		}
+		else
+		{
+			*row -= _left + tree_height(root);
+			root = root->right;
+		}
+	}
+	return (NULL);
+}
+
+size_t	tree_row(const t_Line *line)
+{
+	size_t	_row;
+
+	_row = tree_rows(line->left);
+	while (line->parent)
+	{
+		if (line->parent->right == line)
+			_row += line->parent->rows - tree_rows(line);
+		line = line->parent;
+	}
+	return (_row);
+}
+
+size_t	tree_offset(const t_Line *line)
+{
+	size_t	_offset;
+
+	_offset = tree_bytes(line->left);
+	while (line->parent)
+	{
+		if (line->parent->right == line)
+			_offset += line->parent->bytes - tree_bytes(line);
+		line = line->parent;
+	}
+	return (_offset);
+}
+
+size_t	tree_index(const t_Line *line)
+{
+	size_t	_index;
+
+	_index = tree_count(line->left);
+	while (line->parent)
+	{
+		if (line->parent->right == line)
+			_index += tree_count(line->parent->left) + 1;
+		line = line->parent;
+	}
+	return (_index);
+}
+
+// +===----- Edition -----===+ //
+
+void	tree_insert(t_Buffer *buffer, t_Line *line, size_t index)
+{
+	t_Line	*_next;
+	t_Line	*_node;
+
+	line->left = NULL;
+	line->right = NULL;
+	line->priority = tree_priority(buffer);
+	tree_update(line);
+	_next = tree_at(buffer->root, index);
+	line->next = _next;
+	line->prev = _next ? _next->prev : buffer->last;
+	if (line->prev)
+		line->prev->next = line;
+	else
+		buffer->line = line;
+	if (_next)
+		_next->prev = line;
+	else
+		buffer->last = line;
+	if (NULL == buffer->root)
+	{
+		line->parent = NULL;
+		buffer->root = line;
+		buffer->size = 1;
+		return (views_insert(buffer, line, index));
+	}
+	if (_next && NULL == _next->left)
+	{
+		_next->left = line;
+		line->parent = _next;
+	}
+	else
+	{
+		_node = line->prev;
+		_node->right = line;
+		line->parent = _node;
+	}
+	tree_propagate(line->parent);
+	while (line->parent && line->parent->priority < line->priority)
+		tree_rotate_up(buffer, line);
+	buffer->size = buffer->root->count;
+	views_insert(buffer, line, index);
+}
+
+void	tree_insert_list(t_Buffer *buffer, t_Line *first, t_Line *last,
+	size_t count, size_t index)
+{
+	t_Line	*_cursor;
+	t_Line	*_next;
+	t_Line	*_left;
+	t_Line	*_right;
+	t_Line	*_sub;
+
+	_next = tree_at(buffer->root, index);
+	_cursor = first;
+	_sub = tree_build_list(buffer, &_cursor, count, 0);
+	first->prev = _next ? _next->prev : buffer->last;
+	last->next = _next;
+	if (first->prev)
+		first->prev->next = first;
+	else
+		buffer->line = first;
+	if (_next)
+		_next->prev = last;
+	else
+		buffer->last = last;
+	tree_split(buffer->root, index, &_left, &_right);
+	buffer->root = tree_merge(tree_merge(_left, _sub), _right);
+	buffer->root->parent = NULL;
+	buffer->size = buffer->root->count;
+	for (_cursor = first; _cursor != _next; _cursor = _cursor->next)
+		views_insert(buffer, _cursor, index++);
+}
+
+void	tree_remove_list(t_Buffer *buffer, t_Line *first, t_Line *last,
+	size_t count, size_t index)
+{
+	t_Line	*_left;
+	t_Line	*_middle;
+	t_Line	*_right;
+
+	views_remove(buffer, first, index, count);
+	tree_split(buffer->root, index, &_left, &_right);
+	tree_split(_right, count, &_middle, &_right);
+	buffer->root = tree_merge(_left, _right);
+	if (buffer->root)
+		buffer->root->parent = NULL;
+	if (first->prev)
+		first->prev->next = last->next;
+	else
+		buffer->line = last->next;
+	if (last->next)
+		last->next->prev = first->prev;
+	else
+		buffer->last = first->prev;
+	first->prev = NULL;
+	last->next = NULL;
+	buffer->size = buffer->root ? buffer->root->count : 0;
+}
+
+void	tree_remove(t_Buffer *buffer, t_Line *line)
+{
+	t_Line	*_child;
+	t_Line	*_parent;
+
+	views_remove(buffer, line, tree_index(line), 1);
+	while (line->left && line->right)
+	{
+		if (line->left->priority > line->right->priority)
+			tree_rotate_up(buffer, line->left);
+		else
+			tree_rotate_up(buffer, line->right);
+	}
+	_child = line->left ? line->left : line->right;
+	_parent = line->parent;
+	tree_replace_child(buffer, line, _child);
+	tree_propagate(_parent);
+	if (line->prev)
+		line->prev->next = line->next;
+	else
+		buffer->line = line->next;
+	if (line->next)
+		line->next->prev = line->prev;
+	else
+		buffer->last = line->prev;
+	line->parent = NULL;
+	line->left = NULL;
+	line->right = NULL;
+	line->prev = NULL;
+	line->next = NULL;
+	buffer->size = buffer->root ? buffer->root->count : 0;
+}
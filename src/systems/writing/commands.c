@@ -1,35 +1,30 @@
 #include "core/dispatcher.h"
 #include "systems/writing/_internal.h"
+#include "systems/writing/_tree.h"
 #include "systems/writing/commands.h"
 #include "systems/writing/system.h"
+#include "systems/regex/_regex.h"
+#include "systems/filesystem/commands.h"
+#include "systems/filesystem/system.h"
+#include "systems/filesystem/vfs/_internal.h"
+#include "tools/utf8.h"
 
 #define BUFFER_ALLOC 32
+#define SAVE_SUFFIX ".seed~"	/* The suffix of the file written before the rename */
+#define EDIT_WALK 64	/* The distance from which a line is found in the tree */
+#define FIND_BATCH 256	/* The count of matches searched at once in a buffer */
 
 /**
- * @brief Converts the index given to the actual index of the first byte of the character.
- * @param str The data content.
- * @param index The index of the character.
- * @return The real index to the first byte of the character. 
+ * @brief Get the buffer of the given ID.
+ * @param ctx The context of the system.
+ * @param id The id of the buffer.
+ * @return The buffer, or NULL if not found.
 */
-static size_t	utf_char_to_byte(const char *str, size_t index)
+static t_Buffer	*get_buffer(t_WritingCtx *ctx, size_t id)
 {
-	size_t	_i;
-	size_t	_count;
-
-	TEST_NULL(str, 0);
-	_i = 0;
-	_count = 0;
-	while (str[_i])
-	{
-		if ((str[_i] & 0xC0) != 0x80)
-		{
-			if (_count == index)
-				return (_i);
-			_count++;
-		}
-		_i++;
-	}
-	return (_i);
+	if (id >= ctx->capacity)
+		return (NULL);
+	return (ctx->buffers[id]);
 }
 
 // +===----- Buffer -----===+ //
@@ -72,27 +67,39 @@ static t_ErrorCode	manage_capacity(t_WritingCtx *ctx, size_t id)
 	return (ERR_SUCCESS);
 }
 
+/**
+ * @brief Adds the buffer in the first free slot of the context.
+ * @param ctx The context of the system.
+ * @param buffer The buffer.
+ * @param id The ID of the buffer.
+ * @return An error code or SUCCESS (=0).
+*/
+static t_ErrorCode	add_buffer(t_WritingCtx *ctx, t_Buffer *buffer, size_t *id)
+{
+	size_t	_i;
+
+	_i = 0;
+	while (_i < ctx->capacity && ctx->buffers[_i])
+		_i++;
+	if (manage_capacity(ctx, _i))
+		return (ERR_INTERNAL_MEMORY);
+	ctx->buffers[_i] = buffer;
+	*id = _i;
+	ctx->count++;
+	return (ERR_SUCCESS);
+}
+
 t_ErrorCode	cmd_buffer_create(t_Manager *manager, const t_Command *cmd)
 {
-	t_WritingCtx		*_ctx;
 	t_Buffer			*_buffer;
 	t_CmdCreateBuffer	*_payload;
-	size_t				_i;
 
-	_ctx = manager->writing_ctx;
 	_payload = cmd->payload;
-	_i = 0;
-	while (_i < _ctx->capacity && _ctx->buffers[_i])
-		_i++;
 	_buffer = buffer_create();
 	if (NULL == _buffer)
 		return (ERR_INTERNAL_MEMORY);
-	if (manage_capacity(_ctx, _i))
+	if (add_buffer(manager->writing_ctx, _buffer, &_payload->out_buffer_id))
 		return (buffer_destroy(_buffer), ERR_INTERNAL_MEMORY);
-
-	_ctx->buffers[_i] = _buffer;
-	_payload->out_buffer_id = _i;
-	_ctx->count++;
 	return (ERR_SUCCESS);
 }
 
@@ -113,151 +120,1329 @@ t_ErrorCode	cmd_buffer_destroy(t_Manager *manager, const t_Command *cmd)
 	return (ERR_SUCCESS);
 }
 
+t_ErrorCode	cmd_buffer_load_file(t_Manager *manager, const t_Command *cmd)
+{
+	t_FileSystemCtx	*_fs;
+	t_CmdLoadFile	*_payload;
+	t_Buffer		*_buffer;
+	t_ErrorCode		_err;
+	char			*_abs_path;
+
+	_fs = manager->fs_ctx;
+	_payload = cmd->payload;
+	TEST_NULL(_fs, ERR_FS_CONTEXT_NOT_INITIALIZED);
+	TEST_NULL(_fs->root, ERR_FS_CONTEXT_NOT_INITIALIZED);
+	TEST_NULL(_payload->path, ERR_INVALID_PAYLOAD);
+	_abs_path = join_path(_fs->root_path, _payload->path);
+	TEST_NULL(_abs_path, ERR_INTERNAL_MEMORY);
+	_buffer = buffer_create();
+	if (NULL == _buffer)
+		return (free(_abs_path), ERR_INTERNAL_MEMORY);
+	if (false == buffer_map_file(_buffer, _abs_path))
+	{
+		_err = get_file_error();
+		return (free(_abs_path), buffer_destroy(_buffer), _err);
+	}
+	free(_abs_path);
+	if (add_buffer(manager->writing_ctx, _buffer, &_payload->out_buffer_id))
+		return (buffer_destroy(_buffer), ERR_INTERNAL_MEMORY);
+	_payload->out_lines = _buffer->size;
+	_payload->out_crlf = _buffer->crlf;
+	return (ERR_SUCCESS);
+}
+
+/**
+ * @brief Writes the buffer in a new file, then renames it to the given path,
+ * so that the file is never left half written and a mapped origin is kept.
+ * @param buffer The buffer.
+ * @param path The absolute path of the file.
+ * @param size The count of bytes written.
+ * @return An error code or SUCCESS (=0).
+*/
+static t_ErrorCode	save_buffer(t_Buffer *buffer, const char *path, size_t *size)
+{
+	struct stat	_st;
+	char		*_tmp_path;
+	mode_t		_mode;
+	int			_fd;
+	bool		_written;
+
+	_tmp_path = malloc(strlen(path) + sizeof(SAVE_SUFFIX));
+	TEST_NULL(_tmp_path, ERR_INTERNAL_MEMORY);
+	strcpy(_tmp_path, path);
+	strcat(_tmp_path, SAVE_SUFFIX);
+	_mode = 0644;
+	if (0 == stat(path, &_st))
+		_mode = _st.st_mode & 07777;
+	_fd = open(_tmp_path, O_WRONLY | O_CREAT | O_TRUNC, _mode);
+	if (-1 == _fd)
+		return (free(_tmp_path), get_file_error());
+	_written = buffer_write(buffer, _fd, size);
+	if (-1 == close(_fd) || false == _written || -1 == rename(_tmp_path, path))
+	{
+		unlink(_tmp_path);
+		return (free(_tmp_path), ERR_OPERATION_FAILED);
+	}
+	free(_tmp_path);
+	return (ERR_SUCCESS);
+}
+
+t_ErrorCode	cmd_buffer_save(t_Manager *manager, const t_Command *cmd)
+{
+	t_FileSystemCtx	*_fs;
+	t_CmdSaveBuffer	*_payload;
+	t_Buffer		*_buffer;
+	t_ErrorCode		_err;
+	char			*_abs_path;
+
+	_fs = manager->fs_ctx;
+	_payload = cmd->payload;
+	_buffer = get_buffer(manager->writing_ctx, _payload->buffer_id);
+	if (NULL == _buffer)
+		return (ERR_BUFFER_NOT_FOUND);
+	TEST_NULL(_fs, ERR_FS_CONTEXT_NOT_INITIALIZED);
+	TEST_NULL(_fs->root, ERR_FS_CONTEXT_NOT_INITIALIZED);
+	TEST_NULL(_payload->path, ERR_INVALID_PAYLOAD);
+	_abs_path = join_path(_fs->root_path, _payload->path);
+	TEST_NULL(_abs_path, ERR_INTERNAL_MEMORY);
+	_err = save_buffer(_buffer, _abs_path, &_payload->out_size);
+	free(_abs_path);
+	return (_err);
+}
+
 // +===----- Lines -----===+ //
 
 t_ErrorCode	cmd_buffer_line_insert(t_Manager *manager, const t_Command *cmd)
 {
-	t_WritingCtx		*_ctx;
 	t_CmdInsertLine		*_payload;
+	t_Buffer			*_buffer;
 	t_Line				*_line;
 
-	_ctx = manager->writing_ctx;
 	_payload = cmd->payload;
-	if (NULL == _ctx->buffers[_payload->buffer_id])
+	_buffer = get_buffer(manager->writing_ctx, _payload->buffer_id);
+	if (NULL == _buffer)
 		return (ERR_BUFFER_NOT_FOUND);
-	if (_payload->line == -1)
-		_payload->line = _ctx->buffers[_payload->buffer_id]->size - 1;
-	if((size_t)_payload->line > _ctx->buffers[_payload->buffer_id]->size)
+	if (_payload->line < -1 || (_payload->line >= 0
+		&& (size_t)_payload->line > _buffer->size))
 		return (ERR_LINE_NOT_FOUND);
-	_line = line_create();
+	_line = line_create(_buffer);
 	if (NULL == _line)
 		return (ERR_INTERNAL_MEMORY);
-	if (false == buffer_line_insert(
-		_ctx->buffers[_payload->buffer_id],
-		_line,
-		_payload->line
-	))
-		return (free(_line), ERR_OPERATION_FAILED);
+	if (false == buffer_line_insert(_buffer, _line, _payload->line))
+		return (line_destroy(_buffer, _line), ERR_OPERATION_FAILED);
+	history_line_insert(_buffer, _line);
 	return (ERR_SUCCESS);
 }
 
 t_ErrorCode	cmd_buffer_line_delete(t_Manager *manager, const t_Command *cmd)
 {
-	t_WritingCtx		*_ctx;
 	t_CmdDeleteLine		*_payload;
+	t_Buffer			*_buffer;
 	t_Line				*_line;
 
-	_ctx = manager->writing_ctx;
 	_payload = cmd->payload;
-	if (NULL == _ctx->buffers[_payload->buffer_id])
+	_buffer = get_buffer(manager->writing_ctx, _payload->buffer_id);
+	if (NULL == _buffer)
 		return (ERR_BUFFER_NOT_FOUND);
-	_line = buffer_get_line(_ctx->buffers[_payload->buffer_id], _payload->line);
+	_line = buffer_get_line(_buffer, _payload->line);
 	if (NULL == _line)
 		return (ERR_LINE_NOT_FOUND);
-	buffer_line_destroy(_ctx->buffers[_payload->buffer_id], _line);
+	history_line_delete(_buffer, _line);
+	buffer_line_destroy(_buffer, _line);
 	return (ERR_SUCCESS);
 }
 
 t_ErrorCode	cmd_buffer_line_split(t_Manager *manager, const t_Command *cmd)
 {
-	t_WritingCtx		*_ctx;
 	t_CmdSplitLine		*_payload;
+	t_Buffer			*_buffer;
 	t_Line				*_line;
 	size_t				_byte_offset;
 
-	_ctx = manager->writing_ctx;
 	_payload = cmd->payload;
-	if (NULL == _ctx->buffers[_payload->buffer_id])
+	_buffer = get_buffer(manager->writing_ctx, _payload->buffer_id);
+	if (NULL == _buffer)
 		return (ERR_BUFFER_NOT_FOUND);
-	_line = buffer_get_line(_ctx->buffers[_payload->buffer_id], _payload->line);
+	_line = buffer_get_line(_buffer, _payload->line);
 	if (NULL == _line)
 		return (ERR_LINE_NOT_FOUND);
-	_byte_offset = utf_char_to_byte(_line->data, _payload->index);
-	if (NULL == buffer_line_split(_ctx->buffers[_payload->buffer_id], _line, _byte_offset))
+	_byte_offset = line_char_to_byte(_line, _payload->index);
+	if (UTF_NPOS == _byte_offset)
+		return (ERR_OPERATION_FAILED);
+	if (NULL == buffer_line_split(_buffer, _line, _byte_offset))
 		return (ERR_OPERATION_FAILED);
+	history_insert(_buffer, _line, _byte_offset, _line->flags & LINE_CRLF ? 2 : 1,
+		_line->flags & LINE_CRLF ? "\r\n" : "\n");
 	return (ERR_SUCCESS);
 }
 
 t_ErrorCode	cmd_buffer_line_join(t_Manager *manager, const t_Command *cmd)
 {
-	t_WritingCtx		*_ctx;
 	t_CmdJoinLine		*_payload;
+	t_Buffer			*_buffer;
 	t_Line				*_dst;
 	t_Line				*_src;
 
-	_ctx = manager->writing_ctx;
 	_payload = cmd->payload;
-	if (NULL == _ctx->buffers[_payload->buffer_id])
+	_buffer = get_buffer(manager->writing_ctx, _payload->buffer_id);
+	if (NULL == _buffer)
 		return (ERR_BUFFER_NOT_FOUND);
-	_dst = buffer_get_line(_ctx->buffers[_payload->buffer_id], _payload->dst);
-	_src = buffer_get_line(_ctx->buffers[_payload->buffer_id], _payload->src);
-	if (_src == _dst || _src->prev != _dst)
-		return (ERR_INVALID_PAYLOAD);
+	_dst = buffer_get_line(_buffer, _payload->dst);
+	_src = buffer_get_line(_buffer, _payload->src);
 	if (NULL == _dst || NULL == _src)
 		return (ERR_LINE_NOT_FOUND);
-	if (NULL == buffer_line_join(_ctx->buffers[_payload->buffer_id], _dst, _src))
-		return (ERR_OPERATION_FAILED);
+	if (_src == _dst || _src->prev != _dst)
+		return (ERR_INVALID_PAYLOAD);
+	history_delete(_buffer, _dst, _dst->size, _src, 0);
+	if (NULL == buffer_line_join(_buffer, _dst, _src))
+		return (history_clean(&_buffer->history), ERR_OPERATION_FAILED);
 	return (ERR_SUCCESS);
 }
 
 t_ErrorCode	cmd_buffer_get_line(t_Manager *manager, const t_Command *cmd)
 {
-	t_WritingCtx		*_ctx;
 	t_CmdGetLine		*_payload;
+	t_Buffer			*_buffer;
 	t_Line				*_line;
 
-	_ctx = manager->writing_ctx;
 	_payload = cmd->payload;
-	if (NULL == _ctx->buffers[_payload->buffer_id])
+	_buffer = get_buffer(manager->writing_ctx, _payload->buffer_id);
+	if (NULL == _buffer)
 		return (ERR_BUFFER_NOT_FOUND);
-	_line = buffer_get_line(_ctx->buffers[_payload->buffer_id], _payload->line);
+	_line = buffer_get_line(_buffer, _payload->line);
 	if (NULL == _line)
 		return (ERR_LINE_NOT_FOUND);
-	_payload->out_data = _line->data;
+	_payload->out_data = line_get_data(_line);
 	_payload->out_size = _line->size;
 	return (ERR_SUCCESS);
 }
 
+t_ErrorCode	cmd_buffer_get_lines(t_Manager *manager, const t_Command *cmd)
+{
+	t_CmdGetLines		*_payload;
+	t_Buffer			*_buffer;
+	t_Line				*_line;
+	size_t				_i;
+
+	_payload = cmd->payload;
+	_buffer = get_buffer(manager->writing_ctx, _payload->buffer_id);
+	if (NULL == _buffer)
+		return (ERR_BUFFER_NOT_FOUND);
+	if (NULL == _payload->views && _payload->count > 0)
+		return (ERR_INVALID_PAYLOAD);
+	_line = buffer_get_line(_buffer, _payload->line);
+	if (NULL == _line)
+		return (ERR_LINE_NOT_FOUND);
+	for (_i = 0; _i < _payload->count && _line; _i++)
+	{
+		_payload->views[_i].data = line_get_data(_line);
+		_payload->views[_i].size = _line->size;
+		_line = _line->next;
+	}
+	_payload->out_count = _i;
+	return (ERR_SUCCESS);
+}
+
+t_ErrorCode	cmd_buffer_find(t_Manager *manager, const t_Command *cmd)
+{
+	t_CmdFind			*_payload;
+	t_Buffer			*_buffer;
+	t_Line				*_line;
+	t_Find				_find;
+	size_t				_byte_offset;
+
+	_payload = cmd->payload;
+	_payload->out_count = 0;
+	_buffer = get_buffer(manager->writing_ctx, _payload->buffer_id);
+	if (NULL == _buffer)
+		return (ERR_BUFFER_NOT_FOUND);
+	if (NULL == _payload->data || 0 == _payload->size
+		|| memchr(_payload->data, '\n', _payload->size)
+		|| memchr(_payload->data, '\r', _payload->size)
+		|| (NULL == _payload->matches && _payload->count > 0))
+		return (ERR_INVALID_PAYLOAD);
+	_line = buffer_get_line(_buffer, _payload->line);
+	if (NULL == _line)
+		return (ERR_LINE_NOT_FOUND);
+	if (_payload->index < 0)
+		_byte_offset = _line->size;
+	else
+		_byte_offset = line_char_to_byte(_line, _payload->index);
+	if (UTF_NPOS == _byte_offset)
+		return (ERR_OPERATION_FAILED);
+	if (0 == _payload->count)
+		return (ERR_SUCCESS);
+	_find = (t_Find){_payload->data, _payload->size, _payload->ignore_case,
+		_payload->matches, _payload->count, 0};
+	if (_payload->backward)
+		find_backward(_line, _byte_offset, &_find);
+	else
+		find_forward(_line, _byte_offset, &_find);
+	_payload->out_count = _find.count;
+	return (ERR_SUCCESS);
+}
+
+t_ErrorCode	cmd_buffer_regex_find(t_Manager *manager, const t_Command *cmd)
+{
+	t_CmdRegexFind		*_payload;
+	t_Buffer			*_buffer;
+	t_Line				*_line;
+	t_Find				_find;
+	t_Match				_next;
+	t_ErrorCode			_error;
+	size_t				_byte_offset;
+
+	_payload = cmd->payload;
+	_payload->out_count = 0;
+	_payload->out_done = false;
+	_buffer = get_buffer(manager->writing_ctx, _payload->buffer_id);
+	if (NULL == _buffer)
+		return (ERR_BUFFER_NOT_FOUND);
+	if ((NULL == _payload->regex && NULL == _payload->pattern)
+		|| (NULL == _payload->matches && _payload->count > 0))
+		return (ERR_INVALID_PAYLOAD);
+	_line = buffer_get_line(_buffer, _payload->line);
+	if (NULL == _line)
+		return (ERR_LINE_NOT_FOUND);
+	if (_payload->index < 0)
+		_byte_offset = _line->size;
+	else
+		_byte_offset = line_char_to_byte(_line, _payload->index);
+	if (UTF_NPOS == _byte_offset)
+		return (ERR_OPERATION_FAILED);
+	if (NULL == _payload->regex)
+	{
+		_error = regex_compile(_payload->pattern, _payload->size,
+			_payload->ignore_case, &_payload->regex);
+		if (ERR_SUCCESS != _error)
+			return (_error);
+	}
+	_find = (t_Find){NULL, 0, false, _payload->matches, _payload->count, 0};
+	if (false == find_regex(_line, _byte_offset, _payload->regex,
+		_buffer->version, &_find, &_next))
+		return (ERR_INTERNAL_MEMORY);
+	_payload->out_count = _find.count;
+	_payload->out_line = _next.line;
+	_payload->out_index = _next.index;
+	_payload->out_done = (_next.line >= _buffer->size);
+	return (ERR_SUCCESS);
+}
+
+/**
+ * @brief Finds the matches of one buffer, batch by batch, until the end of the
+ * buffer or until the payload is full.
+ * @param buffer The buffer.
+ * @param id The ID of the buffer.
+ * @param payload The payload, its matches are appended.
+ * @param next The position where the search starts, then the match that did
+ * not fit or the line after the last one.
+ * @return An error code or SUCCESS (=0).
+*/
+static t_ErrorCode	find_all_buffer(t_Buffer *buffer, size_t id,
+	t_CmdFindAll *payload, t_Match *next)
+{
+	t_Match	_batch[FIND_BATCH];
+	t_Find	_find;
+	t_Line	*_line;
+	size_t	_byte;
+	size_t	_i;
+
+	while (next->line < buffer->size)
+	{
+		_line = buffer_get_line(buffer, next->line);
+		_byte = line_char_to_byte(_line, next->index);
+		if (UTF_NPOS == _byte)
+			return (ERR_OPERATION_FAILED);
+		_find = (t_Find){payload->data, payload->size, payload->ignore_case,
+			_batch, payload->count - payload->out_count, 0};
+		if (_find.capacity > FIND_BATCH)
+			_find.capacity = FIND_BATCH;
+		find_indexed(buffer, _line, _byte, &_find, next);
+		for (_i = 0; _i < _find.count; _i++)
+			payload->matches[payload->out_count++] = (t_BufferMatch){id,
+				_batch[_i]};
+		if (payload->out_count == payload->count)
+			break ;
+	}
+	return (ERR_SUCCESS);
+}
+
+t_ErrorCode	cmd_buffer_find_all(t_Manager *manager, const t_Command *cmd)
+{
+	t_WritingCtx		*_ctx;
+	t_CmdFindAll		*_payload;
+	t_Buffer			*_buffer;
+	t_Match				_next;
+	t_ErrorCode			_error;
+	size_t				_id;
+
+	_ctx = manager->writing_ctx;
+	_payload = cmd->payload;
+	_payload->out_count = 0;
+	_payload->out_done = false;
+	if (NULL == _payload->data || 0 == _payload->size
+		|| memchr(_payload->data, '\n', _payload->size)
+		|| memchr(_payload->data, '\r', _payload->size)
+		|| (NULL == _payload->matches && _payload->count > 0))
+		return (ERR_INVALID_PAYLOAD);
+	_next = (t_Match){_payload->line, _payload->index, 0};
+	for (_id = _payload->buffer_id; _id < _ctx->capacity; _id++)
+	{
+		_buffer = _ctx->buffers[_id];
+		if (_buffer)
+		{
+			_error = find_all_buffer(_buffer, _id, _payload, &_next);
+			if (ERR_SUCCESS != _error)
+				return (_error);
+			if (_next.line < _buffer->size)
+			{
+				_payload->out_buffer_id = _id;
+				_payload->out_line = _next.line;
+				_payload->out_index = _next.index;
+				return (ERR_SUCCESS);
+			}
+		}
+		_next = (t_Match){0, 0, 0};
+	}
+	_payload->out_done = true;
+	return (ERR_SUCCESS);
+}
+
+t_ErrorCode	cmd_buffer_set_index(t_Manager *manager, const t_Command *cmd)
+{
+	t_CmdSetIndex		*_payload;
+	t_Buffer			*_buffer;
+
+	_payload = cmd->payload;
+	_buffer = get_buffer(manager->writing_ctx, _payload->buffer_id);
+	if (NULL == _buffer)
+		return (ERR_BUFFER_NOT_FOUND);
+	if (false == _payload->enable)
+		return (grams_disable(_buffer), ERR_SUCCESS);
+	if (false == grams_enable(_buffer))
+		return (ERR_INTERNAL_MEMORY);
+	return (ERR_SUCCESS);
+}
+
+t_ErrorCode	cmd_buffer_offset_to_pos(t_Manager *manager, const t_Command *cmd)
+{
+	t_CmdOffsetToPos	*_payload;
+	t_Buffer			*_buffer;
+	t_Line				*_line;
+	const char			*_data;
+	size_t				_byte;
+
+	_payload = cmd->payload;
+	_buffer = get_buffer(manager->writing_ctx, _payload->buffer_id);
+	if (NULL == _buffer)
+		return (ERR_BUFFER_NOT_FOUND);
+	_byte = _payload->offset;
+	_line = tree_at_offset(_buffer->root, &_byte);
+	if (NULL == _line || (_line == _buffer->last && _byte > _line->size))
+		return (ERR_LINE_NOT_FOUND);
+	if (_byte > _line->size)
+		_byte = _line->size;
+	_payload->out_line = tree_index(_line);
+	_payload->out_index = _byte;
+	if (_line->flags & LINE_ASCII)
+		return (ERR_SUCCESS);
+	_data = line_get_data(_line);
+	while (_byte > 0 && _byte < _line->size
+		&& 0x80 == (_data[_byte] & 0xC0))
+		_byte--;
+	_payload->out_index = utf8_count(_data, _byte);
+	return (ERR_SUCCESS);
+}
+
+t_ErrorCode	cmd_buffer_pos_to_offset(t_Manager *manager, const t_Command *cmd)
+{
+	t_CmdPosToOffset	*_payload;
+	t_Buffer			*_buffer;
+	t_Line				*_line;
+	size_t				_byte;
+
+	_payload = cmd->payload;
+	_buffer = get_buffer(manager->writing_ctx, _payload->buffer_id);
+	if (NULL == _buffer)
+		return (ERR_BUFFER_NOT_FOUND);
+	_line = buffer_get_line(_buffer, _payload->line);
+	if (NULL == _line)
+		return (ERR_LINE_NOT_FOUND);
+	if (_payload->index < 0)
+		_byte = _line->size;
+	else
+		_byte = line_char_to_byte(_line, _payload->index);
+	if (UTF_NPOS == _byte)
+		return (ERR_OPERATION_FAILED);
+	_payload->out_offset = tree_offset(_line) + _byte;
+	return (ERR_SUCCESS);
+}
+
+/**
+ * @brief Converts one position between UTF-16 code units and bytes, from the
+ * previous position of the line when it comes before.
+ * @param line The line of the position.
+ * @param position The position.
+ * @param to_utf16 TRUE to convert the byte, FALSE to convert the column.
+ * @param cursor The previous position of the line, in bytes then code units.
+ * @return TRUE for success or FALSE if the position is out of the line.
+*/
+static bool	utf16_convert(t_Line *line, t_Utf16Position *position,
+	bool to_utf16, size_t cursor[2])
+{
+	const char	*_data;
+	size_t		_units;
+
+	if ((to_utf16 && position->byte < cursor[0])
+		|| (false == to_utf16 && position->column < cursor[1]))
+	{
+		cursor[0] = 0;
+		cursor[1] = 0;
+	}
+	if (to_utf16)
+	{
+		if (position->byte > line->size)
+			return (false);
+		if (0 == (line->flags & LINE_ASCII))
+		{
+			_data = line_get_data(line);
+			while (position->byte > cursor[0] && position->byte < line->size
+				&& 0x80 == (_data[position->byte] & 0xC0))
+				position->byte--;
+		}
+		position->column = cursor[1]
+			+ line_utf16_count(line, cursor[0], position->byte);
+	}
+	else
+	{
+		_units = position->column - cursor[1];
+		position->byte = line_utf16_skip(line, cursor[0], &_units);
+		if (UTF_NPOS == position->byte)
+			return (false);
+		position->column -= _units;
+	}
+	cursor[0] = position->byte;
+	cursor[1] = position->column;
+	return (true);
+}
+
+t_ErrorCode	cmd_buffer_convert_utf16(t_Manager *manager, const t_Command *cmd)
+{
+	t_CmdConvertUtf16	*_payload;
+	t_Utf16Position		*_position;
+	t_Buffer			*_buffer;
+	t_Line				*_line;
+	ssize_t				_index;
+	size_t				_cursor[2];
+
+	_payload = cmd->payload;
+	_payload->out_count = 0;
+	_buffer = get_buffer(manager->writing_ctx, _payload->buffer_id);
+	if (NULL == _buffer)
+		return (ERR_BUFFER_NOT_FOUND);
+	if (NULL == _payload->positions && _payload->count > 0)
+		return (ERR_INVALID_PAYLOAD);
+	_line = NULL;
+	_index = 0;
+	for (; _payload->out_count < _payload->count; _payload->out_count++)
+	{
+		_position = &_payload->positions[_payload->out_count];
+		if (NULL == _line || _position->line != _index)
+		{
+			if (_line && _position->line > _index
+				&& _position->line - _index <= EDIT_WALK)
+				for (; _line && _index < _position->line; _index++)
+					_line = _line->next;
+			else
+				_line = buffer_get_line(_buffer, _position->line);
+			if (NULL == _line)
+				return (ERR_LINE_NOT_FOUND);
+			_index = _position->line;
+			_cursor[0] = 0;
+			_cursor[1] = 0;
+		}
+		if (false == utf16_convert(_line, _position, _payload->to_utf16, _cursor))
+			return (ERR_OPERATION_FAILED);
+	}
+	return (ERR_SUCCESS);
+}
+
+/**
+ * @brief Converts one position between character indexes and display
+ * columns, from the previous position of the line when it comes before.
+ * @param line The line of the position.
+ * @param position The position.
+ * @param payload The payload.
+ * @param cursor The previous position of the line, in bytes, characters then
+ * columns.
+ * @return TRUE for success or FALSE if the index is out of the line.
+*/
+static bool	columns_convert(t_Line *line, t_ColumnPosition *position,
+	const t_CmdConvertColumns *payload, size_t cursor[3])
+{
+	size_t	_end;
+	size_t	_byte;
+
+	if ((payload->to_columns && position->index < cursor[1])
+		|| (false == payload->to_columns && position->column < cursor[2]))
+	{
+		cursor[0] = 0;
+		cursor[1] = 0;
+		cursor[2] = 0;
+	}
+	if (payload->to_columns)
+	{
+		_end = 0 == cursor[0] ? line_char_to_byte(line, position->index)
+			: line_char_skip(line, cursor[0], position->index - cursor[1]);
+		if (UTF_NPOS == _end)
+			return (false);
+		_byte = line_column_walk(line, cursor[0], &cursor[2], _end, UTF_NPOS,
+			payload->tab_size);
+	}
+	else
+		_byte = line_column_walk(line, cursor[0], &cursor[2], UTF_NPOS,
+			position->column, payload->tab_size);
+	if (line->flags & LINE_ASCII)
+		cursor[1] += _byte - cursor[0];
+	else
+		cursor[1] += utf8_count(line_get_data(line) + cursor[0],
+			_byte - cursor[0]);
+	cursor[0] = _byte;
+	position->index = cursor[1];
+	position->column = cursor[2];
+	return (true);
+}
+
+t_ErrorCode	cmd_buffer_convert_columns(t_Manager *manager, const t_Command *cmd)
+{
+	t_CmdConvertColumns	*_payload;
+	t_ColumnPosition	*_position;
+	t_Buffer			*_buffer;
+	t_Line				*_line;
+	ssize_t				_index;
+	size_t				_cursor[3];
+
+	_payload = cmd->payload;
+	_payload->out_count = 0;
+	_buffer = get_buffer(manager->writing_ctx, _payload->buffer_id);
+	if (NULL == _buffer)
+		return (ERR_BUFFER_NOT_FOUND);
+	if ((NULL == _payload->positions && _payload->count > 0)
+		|| 0 == _payload->tab_size)
+		return (ERR_INVALID_PAYLOAD);
+	_line = NULL;
+	_index = 0;
+	for (; _payload->out_count < _payload->count; _payload->out_count++)
+	{
+		_position = &_payload->positions[_payload->out_count];
+		if (NULL == _line || _position->line != _index)
+		{
+			if (_line && _position->line > _index
+				&& _position->line - _index <= EDIT_WALK)
+				for (; _line && _index < _position->line; _index++)
+					_line = _line->next;
+			else
+				_line = buffer_get_line(_buffer, _position->line);
+			if (NULL == _line)
+				return (ERR_LINE_NOT_FOUND);
+			_index = _position->line;
+			_cursor[0] = 0;
+			_cursor[1] = 0;
+			_cursor[2] = 0;
+		}
+		if (false == columns_convert(_line, _position, _payload, _cursor))
+			return (ERR_OPERATION_FAILED);
+	}
+	return (ERR_SUCCESS);
+}
+
+t_ErrorCode	cmd_buffer_set_wrap(t_Manager *manager, const t_Command *cmd)
+{
+	t_CmdSetWrap	*_payload;
+	t_Buffer		*_buffer;
+
+	_payload = cmd->payload;
+	_buffer = get_buffer(manager->writing_ctx, _payload->buffer_id);
+	if (NULL == _buffer)
+		return (ERR_BUFFER_NOT_FOUND);
+	if (_payload->width > 0 && 0 == _payload->tab_size)
+		return (ERR_INVALID_PAYLOAD);
+	if (false == buffer_wrap(_buffer, _payload->width, _payload->tab_size))
+		return (ERR_INTERNAL_MEMORY);
+	_payload->out_rows = _buffer->root ? _buffer->root->rows : 0;
+	return (ERR_SUCCESS);
+}
+
+t_ErrorCode	cmd_buffer_row_to_pos(t_Manager *manager, const t_Command *cmd)
+{
+	t_CmdRowToPos	*_payload;
+	t_Buffer		*_buffer;
+	t_Line			*_line;
+	size_t			_row;
+	size_t			_byte;
+
+	_payload = cmd->payload;
+	_buffer = get_buffer(manager->writing_ctx, _payload->buffer_id);
+	if (NULL == _buffer)
+		return (ERR_BUFFER_NOT_FOUND);
+	_row = _payload->row;
+	_line = tree_at_row(_buffer->root, &_row);
+	if (NULL == _line)
+		return (ERR_LINE_NOT_FOUND);
+	_byte = line_wrap(_line, &_buffer->wrap, &_row, UTF_NPOS);
+	_payload->out_line = tree_index(_line);
+	_payload->out_index = _byte;
+	if (0 == (_line->flags & LINE_ASCII))
+		_payload->out_index = utf8_count(line_get_data(_line), _byte);
+	return (ERR_SUCCESS);
+}
+
+t_ErrorCode	cmd_buffer_pos_to_row(t_Manager *manager, const t_Command *cmd)
+{
+	t_CmdPosToRow	*_payload;
+	t_Buffer		*_buffer;
+	t_Line			*_line;
+	size_t			_row;
+	size_t			_byte;
+
+	_payload = cmd->payload;
+	_buffer = get_buffer(manager->writing_ctx, _payload->buffer_id);
+	if (NULL == _buffer)
+		return (ERR_BUFFER_NOT_FOUND);
+	_line = buffer_get_line(_buffer, _payload->line);
+	if (NULL == _line)
+		return (ERR_LINE_NOT_FOUND);
+	if (_payload->index < 0)
+		_byte = _line->size;
+	else
+		_byte = line_char_to_byte(_line, _payload->index);
+	if (UTF_NPOS == _byte)
+		return (ERR_OPERATION_FAILED);
+	_row = UTF_NPOS;
+	line_wrap(_line, &_buffer->wrap, &_row, _byte);
+	_payload->out_row = tree_row(_line) + _row;
+	return (ERR_SUCCESS);
+}
+
 // +===----- Data -----===+ //
 
 t_ErrorCode	cmd_line_insert_data(t_Manager *manager, const t_Command *cmd)
 {
-	t_WritingCtx		*_ctx;
 	t_CmdInsertData		*_payload;
+	t_Buffer			*_buffer;
 	t_Line				*_line;
 	size_t				_byte_offset;
 
-	_ctx = manager->writing_ctx;
 	_payload = cmd->payload;
-	if (NULL == _ctx->buffers[_payload->buffer_id])
+	_buffer = get_buffer(manager->writing_ctx, _payload->buffer_id);
+	if (NULL == _buffer)
 		return (ERR_BUFFER_NOT_FOUND);
-	_line = buffer_get_line(_ctx->buffers[_payload->buffer_id], _payload->line);
+	_line = buffer_get_line(_buffer, _payload->line);
 	if (NULL == _line)
 		return (ERR_LINE_NOT_FOUND);
-	_byte_offset = utf_char_to_byte(_line->data, _payload->index);
-	if (false == line_insert_data(_line, _byte_offset, _payload->size, _payload->data))
+	if (_payload->index < 0)
+		_byte_offset = _line->size;
+	else
+		_byte_offset = line_char_to_byte(_line, _payload->index);
+	if (UTF_NPOS == _byte_offset)
+		return (ERR_OPERATION_FAILED);
+	if (NULL == _payload->data || false == utf8_validate(_payload->data, _payload->size))
+		return (ERR_INVALID_ENCODING);
+	if (false == line_insert_data(_buffer, _line, _byte_offset, _payload->size, _payload->data))
 		return (ERR_OPERATION_FAILED);
+	history_insert(_buffer, _line, _byte_offset, _payload->size, _payload->data);
 	return (ERR_SUCCESS);
 }
 
 t_ErrorCode	cmd_line_delete_data(t_Manager *manager, const t_Command *cmd)
 {
-	t_WritingCtx		*_ctx;
 	t_CmdDeleteData		*_payload;
+	t_Buffer			*_buffer;
 	t_Line				*_line;
 	size_t				_byte_start;
 	size_t				_byte_end;
 
-	_ctx = manager->writing_ctx;
 	_payload = cmd->payload;
-	if (NULL == _ctx->buffers[_payload->buffer_id])
+	_buffer = get_buffer(manager->writing_ctx, _payload->buffer_id);
+	if (NULL == _buffer)
 		return (ERR_BUFFER_NOT_FOUND);
-	_line = buffer_get_line(_ctx->buffers[_payload->buffer_id], _payload->line);
+	_line = buffer_get_line(_buffer, _payload->line);
 	if (NULL == _line)
 		return (ERR_LINE_NOT_FOUND);
-	_byte_start = utf_char_to_byte(_line->data, _payload->index);
-	_byte_end = utf_char_to_byte(_line->data, _payload->index + _payload->size);
-	if (false == line_delete_data(_line, _byte_start, _byte_end - _byte_start))
+	_byte_start = line_char_to_byte(_line, _payload->index);
+	if (UTF_NPOS == _byte_start || _byte_start == _line->size)
 		return (ERR_OPERATION_FAILED);
+	_byte_end = line_char_skip(_line, _byte_start, _payload->size);
+	if (UTF_NPOS == _byte_end)
+		_byte_end = _line->size;
+	history_delete(_buffer, _line, _byte_start, _line, _byte_end);
+	if (false == line_delete_data(_buffer, _line, _byte_start, _byte_end - _byte_start))
+		return (history_clean(&_buffer->history), ERR_OPERATION_FAILED);
+	return (ERR_SUCCESS);
+}
+
+t_ErrorCode	cmd_line_insert_range(t_Manager *manager, const t_Command *cmd)
+{
+	t_CmdInsertRange	*_payload;
+	t_Buffer			*_buffer;
+	t_Line				*_line;
+	const char			*_last;
+	size_t				_byte_offset;
+
+	_payload = cmd->payload;
+	_buffer = get_buffer(manager->writing_ctx, _payload->buffer_id);
+	if (NULL == _buffer)
+		return (ERR_BUFFER_NOT_FOUND);
+	_line = buffer_get_line(_buffer, _payload->line);
+	if (NULL == _line)
+		return (ERR_LINE_NOT_FOUND);
+	if (_payload->index < 0)
+		_byte_offset = _line->size;
+	else
+		_byte_offset = line_char_to_byte(_line, _payload->index);
+	if (UTF_NPOS == _byte_offset)
+		return (ERR_OPERATION_FAILED);
+	if (NULL == _payload->data || false == utf8_validate(_payload->data, _payload->size))
+		return (ERR_INVALID_ENCODING);
+	_last = _payload->data + _payload->size;
+	while (_last > _payload->data && '\n' != _last[-1])
+		_last--;
+	_payload->out_index = 0;
+	if (_last == _payload->data && _payload->index >= 0)
+		_payload->out_index = _payload->index;
+	else if (_last == _payload->data)
+		_payload->out_index = utf8_count(line_get_data(_line), _byte_offset);
+	if (NULL == buffer_insert_text(_buffer, _line, _byte_offset, _payload->size,
+		_payload->data, &_payload->out_line))
+		return (ERR_OPERATION_FAILED);
+	history_insert(_buffer, _line, _byte_offset, _payload->size, _payload->data);
+	_payload->out_index += utf8_count(_last,
+		_payload->data + _payload->size - _last);
+	return (ERR_SUCCESS);
+}
+
+t_ErrorCode	cmd_line_delete_range(t_Manager *manager, const t_Command *cmd)
+{
+	t_CmdDeleteRange	*_payload;
+	t_Buffer			*_buffer;
+	t_Line				*_first;
+	t_Line				*_last;
+	size_t				_byte_start;
+	size_t				_byte_end;
+
+	_payload = cmd->payload;
+	_buffer = get_buffer(manager->writing_ctx, _payload->buffer_id);
+	if (NULL == _buffer)
+		return (ERR_BUFFER_NOT_FOUND);
+	_first = buffer_get_line(_buffer, _payload->line);
+	_last = buffer_get_line(_buffer, _payload->end_line);
+	if (NULL == _first || NULL == _last)
+		return (ERR_LINE_NOT_FOUND);
+	_byte_start = line_char_to_byte(_first, _payload->index);
+	if (UTF_NPOS == _byte_start)
+		return (ERR_OPERATION_FAILED);
+	_byte_end = line_char_to_byte(_last, _payload->end_index);
+	if (UTF_NPOS == _byte_end)
+		_byte_end = _last->size;
+	if ((_payload->end_line < 0 ? _buffer->size - 1 : (size_t)_payload->end_line)
+		< (_payload->line < 0 ? _buffer->size - 1 : (size_t)_payload->line)
+		|| (_first == _last && _byte_end < _byte_start))
+		return (ERR_INVALID_PAYLOAD);
+	history_delete(_buffer, _first, _byte_start, _last, _byte_end);
+	if (false == buffer_delete_text(_buffer, _first, _byte_start, _last, _byte_end))
+		return (history_clean(&_buffer->history), ERR_OPERATION_FAILED);
+	return (ERR_SUCCESS);
+}
+
+/**
+ * @brief Orders the edits of a batch by line, then by index, then by their
+ * order in the batch.
+ * @param a The first slot.
+ * @param b The second slot.
+ * @return A negative, zero or positive value as with strcmp.
+*/
+static int	edit_compare(const void *a, const void *b)
+{
+	const t_Edit	*_a;
+	const t_Edit	*_b;
+
+	_a = ((const t_EditSlot *)a)->edit;
+	_b = ((const t_EditSlot *)b)->edit;
+	if (_a->out_line != _b->out_line)
+		return (_a->out_line < _b->out_line ? -1 : 1);
+	if (_a->index != _b->index)
+		return (_a->index < _b->index ? -1 : 1);
+	return ((_a > _b) - (_a < _b));
+}
+
+/**
+ * @brief Resolves the edits of one line and computes the index after each
+ * edit, nothing is changed if an edit is invalid.
+ * @param line The line.
+ * @param slots The sorted slots of the line.
+ * @param count The count of slots.
+ * @return An error code or SUCCESS (=0).
+*/
+static t_ErrorCode	edit_resolve(t_Line *line, t_EditSlot *slots, size_t count)
+{
+	t_Edit	*_edit;
+	size_t	_end_index;
+	size_t	_deleted;
+	ssize_t	_delta;
+	size_t	_i;
+
+	_end_index = 0;
+	_delta = 0;
+	for (_i = 0; _i < count; _i++)
+	{
+		_edit = slots[_i].edit;
+		if (_edit->index < _end_index)
+			return (ERR_INVALID_PAYLOAD);
+		slots[_i].start = line_char_to_byte(line, _edit->index);
+		if (UTF_NPOS == slots[_i].start)
+			return (ERR_OPERATION_FAILED);
+		slots[_i].end = line_char_skip(line, slots[_i].start, _edit->delete_size);
+		_deleted = _edit->delete_size;
+		if (UTF_NPOS == slots[_i].end)
+		{
+			slots[_i].end = line->size;
+			_deleted = utf8_count(line_get_data(line) + slots[_i].start,
+				slots[_i].end - slots[_i].start);
+		}
+		_end_index = _edit->index + _deleted;
+		_edit->out_index = _edit->index + _delta + utf8_count(_edit->data, _edit->size);
+		_delta += utf8_count(_edit->data, _edit->size) - _deleted;
+	}
+	return (ERR_SUCCESS);
+}
+
+/**
+ * @brief Applies the resolved edits of one line from the last one, so that
+ * the positions of the previous ones stay valid. Each edit is recorded before
+ * it is done, so that the batch can be rolled back.
+ * @param buffer The buffer.
+ * @param line The line.
+ * @param slots The resolved slots of the line.
+ * @param count The count of slots.
+ * @return TRUE for success or FALSE if an error occured.
+*/
+static bool	edit_apply(t_Buffer *buffer, t_Line *line, t_EditSlot *slots,
+	size_t count)
+{
+	t_EditSlot	*_slot;
+	size_t		_cursor;
+
+	while (count-- > 0)
+	{
+		_slot = &slots[count];
+		_cursor = buffer->history.cursor;
+		if (_slot->end > _slot->start
+			&& (false == history_delete(buffer, line, _slot->start, line,
+				_slot->end)
+			|| false == line_delete_data(buffer, line, _slot->start,
+				_slot->end - _slot->start)))
+			return (history_drop(&buffer->history, _cursor), false);
+		_cursor = buffer->history.cursor;
+		if (_slot->edit->size > 0
+			&& (false == history_insert(buffer, line, _slot->start,
+				_slot->edit->size, _slot->edit->data)
+			|| false == line_insert_data(buffer, line, _slot->start,
+				_slot->edit->size, _slot->edit->data)))
+			return (history_drop(&buffer->history, _cursor), false);
+	}
+	return (true);
+}
+
+/**
+ * @brief Applies the sorted edits line after line. The edits never add or
+ * remove lines, so each line is resolved and edited while it is in cache,
+ * and the next one is walked down when it is close.
+ * @param buffer The buffer.
+ * @param slots The sorted slots.
+ * @param count The count of slots.
+ * @return An error code or SUCCESS (=0).
+*/
+static t_ErrorCode	edit_sweep(t_Buffer *buffer, t_EditSlot *slots, size_t count)
+{
+	t_Line		*_line;
+	t_ErrorCode	_err;
+	size_t		_line_index;
+	size_t		_i;
+	size_t		_next;
+
+	_line = NULL;
+	_line_index = 0;
+	for (_i = 0; _i < count; _i = _next)
+	{
+		if (_line && slots[_i].edit->out_line - _line_index <= EDIT_WALK)
+			for (; _line_index < slots[_i].edit->out_line; _line_index++)
+				_line = _line->next;
+		else
+			_line = buffer_get_line(buffer, slots[_i].edit->out_line);
+		_line_index = slots[_i].edit->out_line;
+		for (_next = _i + 1; _next < count
+			&& slots[_next].edit->out_line == _line_index; _next++)
+			;
+		_err = edit_resolve(_line, slots + _i, _next - _i);
+		if (ERR_SUCCESS != _err)
+			return (_err);
+		if (false == edit_apply(buffer, _line, slots + _i, _next - _i))
+			return (ERR_OPERATION_FAILED);
+	}
+	return (ERR_SUCCESS);
+}
+
+t_ErrorCode	cmd_line_multi_edit(t_Manager *manager, const t_Command *cmd)
+{
+	t_CmdMultiEdit	*_payload;
+	t_Buffer		*_buffer;
+	t_EditSlot		*_slots;
+	t_Edit			*_edit;
+	t_ErrorCode		_err;
+	size_t			_i;
+
+	_payload = cmd->payload;
+	_buffer = get_buffer(manager->writing_ctx, _payload->buffer_id);
+	if (NULL == _buffer)
+		return (ERR_BUFFER_NOT_FOUND);
+	if (0 == _payload->count)
+		return (ERR_SUCCESS);
+	TEST_NULL(_payload->edits, ERR_INVALID_PAYLOAD);
+	_slots = malloc(_payload->count * sizeof(t_EditSlot));
+	TEST_NULL(_slots, ERR_INTERNAL_MEMORY);
+	for (_i = 0; _i < _payload->count; _i++)
+	{
+		_edit = &_payload->edits[_i];
+		_edit->out_line = _edit->line < 0 ? _buffer->size - 1 : (size_t)_edit->line;
+		if (_edit->out_line >= _buffer->size)
+			return (free(_slots), ERR_LINE_NOT_FOUND);
+		if ((NULL == _edit->data && _edit->size > 0)
+			|| false == utf8_validate(_edit->data, _edit->size))
+			return (free(_slots), ERR_INVALID_ENCODING);
+		if (_edit->size > 0 && NULL != memchr(_edit->data, '\n', _edit->size))
+			return (free(_slots), ERR_INVALID_PAYLOAD);
+		_slots[_i].edit = _edit;
+	}
+	for (_i = 1; _i < _payload->count
+		&& edit_compare(&_slots[_i - 1], &_slots[_i]) < 0; _i++)
+		;
+	if (_i < _payload->count)
+		qsort(_slots, _payload->count, sizeof(t_EditSlot), edit_compare);
+	history_group(&_buffer->history, true);
+	_err = edit_sweep(_buffer, _slots, _payload->count);
+	if (ERR_SUCCESS != _err)
+		history_rollback(_buffer);
+	history_group(&_buffer->history, false);
+	free(_slots);
+	return (_err);
+}
+
+/**
+ * @brief Get the line of a change from the line of the previous one, which is
+ * walked from when it is close.
+ * @param buffer The buffer.
+ * @param line The line of the previous change, or NULL.
+ * @param from The index of that line.
+ * @param to The index of the line of the change (< size).
+ * @return The line of the change.
+*/
+static t_Line	*change_line(t_Buffer *buffer, t_Line *line, size_t from,
+	size_t to)
+{
+	if (NULL == line || (to > from ? to - from : from - to) > EDIT_WALK)
+		return (buffer_get_line(buffer, to));
+	for (; from < to; from++)
+		line = line->next;
+	for (; from > to; from--)
+		line = line->prev;
+	return (line);
+}
+
+/**
+ * @brief Converts a column of a change to a byte position in its line.
+ * @param line The line.
+ * @param column The column.
+ * @param utf16 TRUE if the column counts UTF-16 code units.
+ * @return The byte position, or UTF_NPOS if past the end of the line.
+*/
+static size_t	change_byte(t_Line *line, size_t column, bool utf16)
+{
+	if (false == utf16)
+		return (line_char_to_byte(line, column));
+	return (line_utf16_skip(line, 0, &column));
+}
+
+/**
+ * @brief Replaces the range of a change with its data, it is recorded before
+ * it is done so that the batch can be rolled back.
+ * @param buffer The buffer.
+ * @param change The change.
+ * @param utf16 TRUE if the columns count UTF-16 code units.
+ * @param line The line of the previous change, set to the line where the
+ * data ends.
+ * @param index The index of that line.
+ * @return An error code or SUCCESS (=0).
+*/
+static t_ErrorCode	change_apply(t_Buffer *buffer, const t_Change *change,
+	bool utf16, t_Line **line, size_t *index)
+{
+	t_Line	*_last;
+	size_t	_cursor;
+	size_t	_start;
+	size_t	_end;
+
+	if (change->end_line < change->line)
+		return (ERR_INVALID_PAYLOAD);
+	if (change->end_line >= buffer->size)
+		return (ERR_LINE_NOT_FOUND);
+	if ((NULL == change->data && change->size > 0)
+		|| false == utf8_validate(change->data, change->size))
+		return (ERR_INVALID_ENCODING);
+	*line = change_line(buffer, *line, *index, change->line);
+	*index = change->line;
+	_last = change_line(buffer, *line, change->line, change->end_line);
+	_start = change_byte(*line, change->index, utf16);
+	if (UTF_NPOS == _start)
+		return (ERR_OPERATION_FAILED);
+	_end = change_byte(_last, change->end_index, utf16);
+	if (UTF_NPOS == _end)
+		_end = _last->size;
+	if (*line == _last && _end < _start)
+		return (ERR_INVALID_PAYLOAD);
+	_cursor = buffer->history.cursor;
+	if ((*line != _last || _end > _start)
+		&& (false == history_delete(buffer, *line, _start, _last, _end)
+		|| false == buffer_delete_text(buffer, *line, _start, _last, _end)))
+		return (history_drop(&buffer->history, _cursor), ERR_OPERATION_FAILED);
+	if (0 == change->size)
+		return (ERR_SUCCESS);
+	_cursor = buffer->history.cursor;
+	if (false == history_insert(buffer, *line, _start, change->size, change->data))
+		return (ERR_OPERATION_FAILED);
+	_last = buffer_insert_text(buffer, *line, _start, change->size,
+		change->data, index);
+	if (NULL == _last)
+		return (history_drop(&buffer->history, _cursor), ERR_OPERATION_FAILED);
+	*line = _last;
+	return (ERR_SUCCESS);
+}
+
+t_ErrorCode	cmd_buffer_apply_changes(t_Manager *manager, const t_Command *cmd)
+{
+	t_CmdApplyChanges	*_payload;
+	t_Buffer			*_buffer;
+	t_Line				*_line;
+	t_ErrorCode			_err;
+	size_t				_index;
+
+	_payload = cmd->payload;
+	_payload->out_count = 0;
+	_buffer = get_buffer(manager->writing_ctx, _payload->buffer_id);
+	if (NULL == _buffer)
+		return (ERR_BUFFER_NOT_FOUND);
+	if (NULL == _payload->changes && _payload->count > 0)
+		return (ERR_INVALID_PAYLOAD);
+	_line = NULL;
+	_index = 0;
+	_err = ERR_SUCCESS;
+	history_group(&_buffer->history, true);
+	for (; _payload->out_count < _payload->count; _payload->out_count++)
+	{
+		_err = change_apply(_buffer, &_payload->changes[_payload->out_count],
+			_payload->utf16, &_line, &_index);
+		if (ERR_SUCCESS != _err)
+			break ;
+	}
+	if (ERR_SUCCESS != _err)
+		history_rollback(_buffer);
+	history_group(&_buffer->history, false);
+	_payload->out_version = _buffer->version;
+	return (_err);
+}
+
+/**
+ * @brief Replaces the matches of one line. The replacements are recorded from
+ * the last one, so that the position of each record is still valid when the
+ * previous ones are replayed.
+ * @param buffer The buffer.
+ * @param line The line.
+ * @param ranges The matches.
+ * @param count The count of matches.
+ * @param payload The payload.
+ * @return TRUE for success or FALSE if an error occured.
+*/
+static bool	replace_line(t_Buffer *buffer, t_Line *line, const t_Range *ranges,
+	size_t count, const t_CmdReplaceAll *payload)
+{
+	size_t	_cursor;
+	size_t	_i;
+
+	_cursor = buffer->history.cursor;
+	for (_i = count; _i-- > 0;)
+	{
+		if ((ranges[_i].end > ranges[_i].start && false == history_delete(buffer,
+			line, ranges[_i].start, line, ranges[_i].end))
+			|| false == history_insert(buffer, line, ranges[_i].start,
+			payload->replacement_size, payload->replacement))
+			return (history_drop(&buffer->history, _cursor), false);
+	}
+	if (false == line_replace_ranges(buffer, line, ranges, count,
+		payload->replacement_size, payload->replacement))
+		return (history_drop(&buffer->history, _cursor), false);
+	return (true);
+}
+
+/**
+ * @brief Replaces the matches of every line, the lines that cannot contain
+ * the text are skipped with the trigram index.
+ * @param buffer The buffer.
+ * @param payload The payload.
+ * @param regex The expression, or NULL to search the text.
+ * @return An error code or SUCCESS (=0).
+*/
+static t_ErrorCode	replace_sweep(t_Buffer *buffer, t_CmdReplaceAll *payload,
+	t_Regex *regex)
+{
+	t_GramMask	_mask;
+	t_Find		_find;
+	t_Line		*_line;
+	t_Range		*_ranges;
+	size_t		_capacity;
+	size_t		_count;
+
+	_find = (t_Find){payload->data, payload->size, payload->ignore_case,
+		NULL, 0, 0};
+	grams_mask(payload->data, regex ? 0 : payload->size, &_mask);
+	if (false == grams_match_buffer(buffer, &_mask))
+		return (ERR_SUCCESS);
+	_ranges = NULL;
+	_capacity = 0;
+	for (_line = buffer->line; _line; _line = _line->next)
+	{
+		if (false == grams_match(buffer, _line, &_mask))
+			continue ;
+		_count = find_ranges(_line, &_find, regex, &_ranges, &_capacity);
+		if (UTF_NPOS == _count)
+			return (free(_ranges), ERR_INTERNAL_MEMORY);
+		if (0 == _count)
+			continue ;
+		if (false == replace_line(buffer, _line, _ranges, _count, payload))
+			return (free(_ranges), ERR_INTERNAL_MEMORY);
+		payload->out_count += _count;
+		payload->out_lines++;
+	}
+	free(_ranges);
+	return (ERR_SUCCESS);
+}
+
+t_ErrorCode	cmd_buffer_replace_all(t_Manager *manager, const t_Command *cmd)
+{
+	t_CmdReplaceAll	*_payload;
+	t_Buffer		*_buffer;
+	t_Regex			*_regex;
+	t_ErrorCode		_err;
+
+	_payload = cmd->payload;
+	_payload->out_count = 0;
+	_payload->out_lines = 0;
+	_buffer = get_buffer(manager->writing_ctx, _payload->buffer_id);
+	if (NULL == _buffer)
+		return (ERR_BUFFER_NOT_FOUND);
+	if (NULL == _payload->data || 0 == _payload->size
+		|| (false == _payload->is_regex
+			&& (memchr(_payload->data, '\n', _payload->size)
+			|| memchr(_payload->data, '\r', _payload->size)))
+		|| (NULL == _payload->replacement && _payload->replacement_size > 0)
+		|| (_payload->replacement_size > 0
+			&& (memchr(_payload->replacement, '\n', _payload->replacement_size)
+			|| memchr(_payload->replacement, '\r', _payload->replacement_size))))
+		return (ERR_INVALID_PAYLOAD);
+	if (false == utf8_validate(_payload->data, _payload->size)
+		|| false == utf8_validate(_payload->replacement, _payload->replacement_size))
+		return (ERR_INVALID_ENCODING);
+	_regex = NULL;
+	if (_payload->is_regex)
+	{
+		_err = regex_compile(_payload->data, _payload->size,
+			_payload->ignore_case, &_regex);
+		if (ERR_SUCCESS != _err)
+			return (_err);
+	}
+	history_group(&_buffer->history, true);
+	_err = replace_sweep(_buffer, _payload, _regex);
+	if (ERR_SUCCESS != _err)
+	{
+		history_rollback(_buffer);
+		_payload->out_count = 0;
+		_payload->out_lines = 0;
+	}
+	history_group(&_buffer->history, false);
+	regex_destroy(_regex);
+	return (_err);
+}
+
+// +===----- History -----===+ //
+
+/**
+ * @brief Converts the position of an edit to the index of its character.
+ * @param buffer The buffer.
+ * @param payload The payload, its index holds the byte position.
+*/
+static void	history_position(t_Buffer *buffer, t_CmdHistory *payload)
+{
+	t_Line	*_line;
+
+	_line = buffer_get_line(buffer, payload->out_line);
+	if (_line && 0 == (_line->flags & LINE_ASCII))
+		payload->out_index = utf8_count(line_get_data(_line), payload->out_index);
+}
+
+t_ErrorCode	cmd_buffer_undo(t_Manager *manager, const t_Command *cmd)
+{
+	t_CmdHistory	*_payload;
+	t_Buffer		*_buffer;
+
+	_payload = cmd->payload;
+	_buffer = get_buffer(manager->writing_ctx, _payload->buffer_id);
+	if (NULL == _buffer)
+		return (ERR_BUFFER_NOT_FOUND);
+	if (0 == _buffer->history.cursor)
+		return (ERR_HISTORY_EMPTY);
+	if (false == history_undo(_buffer, &_payload->out_line, &_payload->out_index))
+		return (ERR_OPERATION_FAILED);
+	history_position(_buffer, _payload);
+	return (ERR_SUCCESS);
+}
+
+t_ErrorCode	cmd_buffer_redo(t_Manager *manager, const t_Command *cmd)
+{
+	t_CmdHistory	*_payload;
+	t_Buffer		*_buffer;
+
+	_payload = cmd->payload;
+	_buffer = get_buffer(manager->writing_ctx, _payload->buffer_id);
+	if (NULL == _buffer)
+		return (ERR_BUFFER_NOT_FOUND);
+	if (_buffer->history.cursor == _buffer->history.size)
+		return (ERR_HISTORY_EMPTY);
+	if (false == history_redo(_buffer, &_payload->out_line, &_payload->out_index))
+		return (ERR_OPERATION_FAILED);
+	history_position(_buffer, _payload);
+	return (ERR_SUCCESS);
+}
+
+// +===----- Snapshots -----===+ //
+
+t_ErrorCode	cmd_buffer_snapshot(t_Manager *manager, const t_Command *cmd)
+{
+	t_CmdSnapshot	*_payload;
+	t_Buffer		*_buffer;
+
+	_payload = cmd->payload;
+	_buffer = get_buffer(manager->writing_ctx, _payload->buffer_id);
+	if (NULL == _buffer)
+		return (ERR_BUFFER_NOT_FOUND);
+	_payload->out_snapshot = snapshot_create(_buffer);
+	TEST_NULL(_payload->out_snapshot, ERR_INTERNAL_MEMORY);
 	return (ERR_SUCCESS);
 }
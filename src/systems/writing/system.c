@@ -9,15 +9,39 @@
 const t_CommandEntry	writing_commands[] = {
 	{ CMD_WRITING_CREATE_BUFFER,	sizeof(t_CmdCreateBuffer),	cmd_buffer_create},
 	{ CMD_WRITING_DELETE_BUFFER,	sizeof(t_CmdDestroyBuffer),	cmd_buffer_destroy},
+	{ CMD_WRITING_LOAD_FILE,		sizeof(t_CmdLoadFile),		cmd_buffer_load_file},
+	{ CMD_WRITING_SAVE_BUFFER,		sizeof(t_CmdSaveBuffer),	cmd_buffer_save},
 	
 	{ CMD_WRITING_INSERT_LINE,		sizeof(t_CmdInsertLine),	cmd_buffer_line_insert},
 	{ CMD_WRITING_DELETE_LINE,		sizeof(t_CmdDeleteLine),	cmd_buffer_line_delete},
 	{ CMD_WRITING_SPLIT_LINE,		sizeof(t_CmdSplitLine),		cmd_buffer_line_split},
 	{ CMD_WRITING_JOIN_LINE,		sizeof(t_CmdJoinLine),		cmd_buffer_line_join},
 	{ CMD_WRITING_GET_LINE,			sizeof(t_CmdGetLine),		cmd_buffer_get_line},
+	{ CMD_WRITING_GET_LINES,		sizeof(t_CmdGetLines),		cmd_buffer_get_lines},
+	{ CMD_WRITING_FIND,		sizeof(t_CmdFind),			cmd_buffer_find},
+	{ CMD_WRITING_REGEX_FIND,	sizeof(t_CmdRegexFind),		cmd_buffer_regex_find},
+	{ CMD_WRITING_FIND_ALL,		sizeof(t_CmdFindAll),		cmd_buffer_find_all},
+	{ CMD_WRITING_SET_INDEX,	sizeof(t_CmdSetIndex),		cmd_buffer_set_index},
+	{ CMD_WRITING_OFFSET_TO_POS,	sizeof(t_CmdOffsetToPos),	cmd_buffer_offset_to_pos},
+	{ CMD_WRITING_POS_TO_OFFSET,	sizeof(t_CmdPosToOffset),	cmd_buffer_pos_to_offset},
+	{ CMD_WRITING_CONVERT_UTF16,	sizeof(t_CmdConvertUtf16),	cmd_buffer_convert_utf16},
+	{ CMD_WRITING_CONVERT_COLUMNS,	sizeof(t_CmdConvertColumns),	cmd_buffer_convert_columns},
+	{ CMD_WRITING_SET_WRAP,		sizeof(t_CmdSetWrap),		cmd_buffer_set_wrap},
+	{ CMD_WRITING_ROW_TO_POS,	sizeof(t_CmdRowToPos),		cmd_buffer_row_to_pos},
+	{ CMD_WRITING_POS_TO_ROW,	sizeof(t_CmdPosToRow),		cmd_buffer_pos_to_row},
 	
 	{ CMD_WRITING_INSERT_TEXT,		sizeof(t_CmdInsertData),	cmd_line_insert_data},
-	{ CMD_WRITING_DELETE_TEXT,		sizeof(t_CmdDeleteData),	cmd_line_delete_data}
+	{ CMD_WRITING_DELETE_TEXT,		sizeof(t_CmdDeleteData),	cmd_line_delete_data},
+	{ CMD_WRITING_INSERT_RANGE,		sizeof(t_CmdInsertRange),	cmd_line_insert_range},
+	{ CMD_WRITING_DELETE_RANGE,		sizeof(t_CmdDeleteRange),	cmd_line_delete_range},
+	{ CMD_WRITING_MULTI_EDIT,		sizeof(t_CmdMultiEdit),		cmd_line_multi_edit},
+	{ CMD_WRITING_APPLY_CHANGES,	sizeof(t_CmdApplyChanges),	cmd_buffer_apply_changes},
+	{ CMD_WRITING_REPLACE_ALL,		sizeof(t_CmdReplaceAll),	cmd_buffer_replace_all},
+
+	{ CMD_WRITING_UNDO,				sizeof(t_CmdHistory),		cmd_buffer_undo},
+	{ CMD_WRITING_REDO,				sizeof(t_CmdHistory),		cmd_buffer_redo},
+
+	{ CMD_WRITING_SNAPSHOT,			sizeof(t_CmdSnapshot),		cmd_buffer_snapshot}
 };
 
 // +===----- Functions -----===+ //
@@ -53,7 +77,7 @@ void	writing_clean(t_WritingCtx *ctx)
 	if (NULL == ctx)
 		return ;
 	_i = 0;
-	while (_i < ctx->count)
+	while (_i < ctx->capacity)
 	{
 		buffer_destroy(ctx->buffers[_i]);
 		_i++;
@@ -0,0 +1,351 @@
+#include "dependency.h"
+#include "tools/search.h"
+
+#if defined(__x86_64__)
+# include <immintrin.h>
+# define SEARCH_X86 1
+#else
+# define SEARCH_X86 0
+#endif
+
+// +===----- Types -----===+ //
+
+/* The kernels of one instruction set */
+typedef struct	s_SearchKernels
+{
+	size_t	(*find)(const char *, size_t, const char *, size_t, bool);	/* Finds the first occurrence */
+	size_t	(*find_last)(const char *, size_t, const char *, size_t, bool);	/* Finds the last occurrence */
+}	t_SearchKernels;
+
+// +===----- Static functions -----===+ //
+
+/**
+ * @brief Get the lowercase of an ASCII letter.
+ * @param c The byte.
+ * @return The lowercase letter, or the byte itself.
+*/
+static unsigned char	search_lower(unsigned char c)
+{
+	if (c >= 'A' && c <= 'Z')
+		return (c + 32);
+	return (c);
+}
+
+/**
+ * @brief Get the bits that fold a byte of the needle.
+ * @param c The byte.
+ * @param fold TRUE to ignore the case of ASCII letters.
+ * @return 0x20 for a letter when folding, 0 otherwise.
+*/
+static unsigned char	search_fold_bits(unsigned char c, bool fold)
+{
+	if (fold && search_lower(c) >= 'a' && search_lower(c) <= 'z')
+		return (0x20);
+	return (0);
+}
+
+/**
+ * @brief Compares the data with the needle.
+ * @param str The data, at least as long as the needle.
+ * @param needle The needle.
+ * @param size The needle size.
+ * @param fold TRUE to ignore the case of ASCII letters.
+ * @return TRUE if they are equal or FALSE otherwise.
+*/
+static bool	search_equal(const char *str, const char *needle, size_t size,
+	bool fold)
+{
+	size_t	_i;
+
+	if (false == fold)
+		return (0 == memcmp(str, needle, size));
+	for (_i = 0; _i < size; _i++)
+	{
+		if (search_lower(str[_i]) != search_lower(needle[_i]))
+			return (false);
+	}
+	return (true);
+}
+
+// +===----- Scalar kernels -----===+ //
+
+static size_t	scalar_find(const char *str, size_t size, const char *needle,
+	size_t needle_size, bool fold)
+{
+	const char	*_pos;
+	size_t		_i;
+
+	if (needle_size > size)
+		return (SEARCH_NPOS);
+	if (false == fold)
+	{
+		for (_i = 0; _i + needle_size <= size; _i = _pos - str + 1)
+		{
+			_pos = memchr(str + _i, needle[0], size - needle_size + 1 - _i);
+			if (NULL == _pos)
+				return (SEARCH_NPOS);
+			if (0 == memcmp(_pos, needle, needle_size))
+				return (_pos - str);
+		}
+		return (SEARCH_NPOS);
+	}
+	for (_i = 0; _i + needle_size <= size; _i++)
+	{
+		if (search_equal(str + _i, needle, needle_size, true))
+			return (_i);
+	}
+	return (SEARCH_NPOS);
+}
+
+static size_t	scalar_find_last(const char *str, size_t size,
+	const char *needle, size_t needle_size, bool fold)
+{
+	size_t	_i;
+
+	if (needle_size > size)
+		return (SEARCH_NPOS);
+	for (_i = size - needle_size + 1; _i-- > 0;)
+	{
+		if (search_equal(str + _i, needle, needle_size, fold))
+			return (_i);
+	}
+	return (SEARCH_NPOS);
+}
+
+#if SEARCH_X86
+
+// +===----- SSE2 kernels -----===+ //
+
+/**
+ * @brief Get the candidates of a block of 16 positions.
+ * @param str The first position of the block.
+ * @param last The distance to the last byte of the needle.
+ * @param needle The first and last bytes of the needle, folded.
+ * @param bits The fold bits of the first and last bytes.
+ * @return The mask of the positions where both bytes are equal.
+*/
+static unsigned int	sse2_candidates(const char *str, size_t last,
+	const __m128i *needle, const __m128i *bits)
+{
+	__m128i	_first;
+	__m128i	_last;
+
+	_first = _mm_or_si128(_mm_loadu_si128((const __m128i *)str), bits[0]);
+	_last = _mm_or_si128(_mm_loadu_si128((const __m128i *)(str + last)), bits[1]);
+	return (_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(_first, needle[0]),
+		_mm_cmpeq_epi8(_last, needle[1]))));
+}
+
+static size_t	sse2_find(const char *str, size_t size, const char *needle,
+	size_t needle_size, bool fold)
+{
+	__m128i			_needle[2];
+	__m128i			_bits[2];
+	unsigned int	_mask;
+	size_t			_last;
+	size_t			_i;
+	size_t			_pos;
+
+	_last = needle_size - 1;
+	_needle[0] = _mm_set1_epi8(fold ? search_lower(needle[0]) : needle[0]);
+	_needle[1] = _mm_set1_epi8(fold ? search_lower(needle[_last]) : needle[_last]);
+	_bits[0] = _mm_set1_epi8(search_fold_bits(needle[0], fold));
+	_bits[1] = _mm_set1_epi8(search_fold_bits(needle[_last], fold));
+	for (_i = 0; _i + _last + 16 <= size; _i += 16)
+	{
+		_mask = sse2_candidates(str + _i, _last, _needle, _bits);
+		for (; _mask; _mask &= _mask - 1)
+		{
+			if (search_equal(str + _i + __builtin_ctz(_mask), needle,
+				needle_size, fold))
+				return (_i + __builtin_ctz(_mask));
+		}
+	}
+	_pos = scalar_find(str + _i, size - _i, needle, needle_size, fold);
+	return (SEARCH_NPOS == _pos ? SEARCH_NPOS : _i + _pos);
+}
+
+static size_t	sse2_find_last(const char *str, size_t size, const char *needle,
+	size_t needle_size, bool fold)
+{
+	__m128i			_needle[2];
+	__m128i			_bits[2];
+	unsigned int	_mask;
+	size_t			_last;
+	size_t			_i;
+	size_t			_pos;
+
+	if (needle_size > size)
+		return (SEARCH_NPOS);
+	_last = needle_size - 1;
+	_needle[0] = _mm_set1_epi8(fold ? search_lower(needle[0]) : needle[0]);
+	_needle[1] = _mm_set1_epi8(fold ? search_lower(needle[_last]) : needle[_last]);
+	_bits[0] = _mm_set1_epi8(search_fold_bits(needle[0], fold));
+	_bits[1] = _mm_set1_epi8(search_fold_bits(needle[_last], fold));
+	for (_i = size - _last; _i >= 16; _i -= 16)
+	{
+		_mask = sse2_candidates(str + _i - 16, _last, _needle, _bits);
+		for (; _mask; _mask &= ~(1u << _pos))
+		{
+			_pos = 31 - __builtin_clz(_mask);
+			if (search_equal(str + _i - 16 + _pos, needle, needle_size, fold))
+				return (_i - 16 + _pos);
+		}
+	}
+	return (scalar_find_last(str, _i + _last, needle, needle_size, fold));
+}
+
+// +===----- AVX2 kernels -----===+ //
+
+/**
+ * @brief Get the candidates of a block of 32 positions.
+ * @param str The first position of the block.
+ * @param last The distance to the last byte of the needle.
+ * @param needle The first and last bytes of the needle, folded.
+ * @param bits The fold bits of the first and last bytes.
+ * @return The mask of the positions where both bytes are equal.
+*/
+__attribute__((target("avx2")))
+static unsigned int	avx2_candidates(const char *str, size_t last,
+	const __m256i *needle, const __m256i *bits)
+{
+	__m256i	_first;
+	__m256i	_last;
+
+	_first = _mm256_or_si256(_mm256_loadu_si256((const __m256i *)str), bits[0]);
+	_last = _mm256_or_si256(
+		_mm256_loadu_si256((const __m256i *)(str + last)), bits[1]);
+	return (_mm256_movemask_epi8(_mm256_and_si256(
+		_mm256_cmpeq_epi8(_first, needle[0]), _mm256_cmpeq_epi8(_last, needle[1]))));
+}
+
+__attribute__((target("avx2")))
+static size_t	avx2_find(const char *str, size_t size, const char *needle,
+	size_t needle_size, bool fold)
+{
+	__m256i			_needle[2];
+	__m256i			_bits[2];
+	unsigned int	_mask;
+	size_t			_last;
+	size_t			_i;
+	size_t			_pos;
+
+	_last = needle_size - 1;
+	_needle[0] = _mm256_set1_epi8(fold ? search_lower(needle[0]) : needle[0]);
+	_needle[1] = _mm256_set1_epi8(fold ? search_lower(needle[_last]) : needle[_last]);
+	_bits[0] = _mm256_set1_epi8(search_fold_bits(needle[0], fold));
+	_bits[1] = _mm256_set1_epi8(search_fold_bits(needle[_last], fold));
+	for (_i = 0; _i + _last + 32 <= size; _i += 32)
+	{
+		_mask = avx2_candidates(str + _i, _last, _needle, _bits);
+		for (; _mask; _mask &= _mask - 1)
+		{
+			if (search_equal(str + _i + __builtin_ctz(_mask), needle,
+				needle_size, fold))
+				return (_i + __builtin_ctz(_mask));
+		}
+	}
+	_pos = sse2_find(str + _i, size - _i, needle, needle_size, fold);
+	return (SEARCH_NPOS == _pos ? SEARCH_NPOS : _i + _pos);
+}
+
+__attribute__((target("avx2")))
+static size_t	avx2_find_last(const char *str, size_t size, const char *needle,
+	size_t needle_size, bool fold)
+{
+	__m256i			_needle[2];
+	__m256i			_bits[2];
+	unsigned int	_mask;
+	size_t			_last;
+	size_t			_i;
+	size_t			_pos;
+
+	if (needle_size > size)
+		return (SEARCH_NPOS);
+	_last = needle_size - 1;
+	_needle[0] = _mm256_set1_epi8(fold ? search_lower(needle[0]) : needle[0]);
+	_needle[1] = _mm256_set1_epi8(fold ? search_lower(needle[_last]) : needle[_last]);
+	_bits[0] = _mm256_set1_epi8(search_fold_bits(needle[0], fold));
+	_bits[1] = _mm256_set1_epi8(search_fold_bits(needle[_last], fold));
+	for (_i = size - _last; _i >= 32; _i -= 32)
+	{
+		_mask = avx2_candidates(str + _i - 32, _last, _needle, _bits);
+		for (; _mask; _mask &= ~(1u << _pos))
+		{
+			_pos = 31 - __builtin_clz(_mask);
+			if (search_equal(str + _i - 32 + _pos, needle, needle_size, fold))
+				return (_i - 32 + _pos);
+		}
+	}
+	return (sse2_find_last(str, _i + _last, needle, needle_size, fold));
+}
+
+#endif
+
+// +===----- Dispatch -----===+ //
+
+/**
+ * @brief Get the kernels in use.
+ * @return The kernels, without functions before the first choice.
+*/
+static t_SearchKernels	*search_state(void)
+{
+	static t_SearchKernels	kernels;
+
+	return (&kernels);
+}
+
+/**
+ * @brief Get the kernels in use, chosen on the first call.
+ * @return The kernels.
+*/
+static t_SearchKernels	*search_kernels(void)
+{
+	t_SearchKernels	*_kernels;
+
+	_kernels = search_state();
+	if (NULL == _kernels->find && false == search_use(UTF8_AVX2)
+		&& false == search_use(UTF8_SSE2))
+		search_use(UTF8_SCALAR);
+	return (_kernels);
+}
+
+bool	search_use(t_Utf8Isa isa)
+{
+	t_SearchKernels	_new;
+
+	_new = (t_SearchKernels){scalar_find, scalar_find_last};
+#if SEARCH_X86
+	if (UTF8_SSE2 == isa)
+		_new = (t_SearchKernels){sse2_find, sse2_find_last};
+	if (UTF8_AVX2 == isa)
+	{
+		if (!__builtin_cpu_supports("avx2"))
+			return (false);
+		_new = (t_SearchKernels){avx2_find, avx2_find_last};
+	}
+#else
+	if (UTF8_SCALAR != isa)
+		return (false);
+#endif
+	*search_state() = _new;
+	return (true);
+}
+
+// +===----- Functions -----===+ //
+
+size_t	search_find(const char *str, size_t size, const char *needle,
+	size_t needle_size, bool fold)
+{
+	if (0 == needle_size || needle_size > size)
+		return (SEARCH_NPOS);
+	return (search_kernels()->find(str, size, needle, needle_size, fold));
+}
+
+size_t	search_find_last(const char *str, size_t size, const char *needle,
+	size_t needle_size, bool fold)
+{
+	if (0 == needle_size || needle_size > size)
+		return (SEARCH_NPOS);
+	return (search_kernels()->find_last(str, size, needle, needle_size, fold));
+}
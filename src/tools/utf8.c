@@ -0,0 +1,566 @@
+#include "dependency.h"
+#include "tools/utf8.h"
+
+#if defined(__x86_64__)
+# include <immintrin.h>
+# define UTF8_X86 1
+#else
+# define UTF8_X86 0
+#endif
+
+#define UTF8_NPOS ((size_t)-1)
+#define UTF8_LEAD -65	/* Bytes above, as signed, are not continuations */
+#define UTF8_ASTRAL 0xF0	/* Bytes above start a 4 bytes sequence */
+#define UTF8_BLOCK 64	/* The size of the blocks skipped by a UTF-16 search */
+
+// +===----- Types -----===+ //
+
+/* The kernels of one instruction set */
+typedef struct	s_Utf8Kernels
+{
+	size_t	(*count)(const char *, size_t);	/* Counts the characters */
+	size_t	(*offset)(const char *, size_t, size_t *);	/* Finds a character */
+	bool	(*is_ascii)(const char *, size_t);	/* Checks for ASCII only */
+	bool	(*validate)(const char *, size_t);	/* Validates the data */
+}	t_Utf8Kernels;
+
+// +===----- Scalar kernels -----===+ //
+
+/**
+ * @brief Get the size of the valid sequence at the start of the data.
+ * @param str The data.
+ * @param size The data size.
+ * @return The size of the sequence, or 0 if it is invalid.
+*/
+static size_t	scalar_sequence(const unsigned char *str, size_t size)
+{
+	size_t			_len;
+	size_t			_i;
+	unsigned char	_low;
+	unsigned char	_high;
+
+	_low = 0x80;
+	_high = 0xBF;
+	if (str[0] < 0x80)
+		return (1);
+	if (str[0] < 0xC2)
+		return (0);
+	if (str[0] < 0xE0)
+		_len = 2;
+	else if (str[0] < 0xF0)
+	{
+		_len = 3;
+		_low = 0xE0 == str[0] ? 0xA0 : _low;
+		_high = 0xED == str[0] ? 0x9F : _high;
+	}
+	else if (str[0] < 0xF5)
+	{
+		_len = 4;
+		_low = 0xF0 == str[0] ? 0x90 : _low;
+		_high = 0xF4 == str[0] ? 0x8F : _high;
+	}
+	else
+		return (0);
+	if (size < _len || str[1] < _low || str[1] > _high)
+		return (0);
+	for (_i = 2; _i < _len; _i++)
+	{
+		if ((str[_i] & 0xC0) != 0x80)
+			return (0);
+	}
+	return (_len);
+}
+
+static size_t	scalar_count(const char *str, size_t size)
+{
+	size_t	_count;
+	size_t	_i;
+
+	_count = 0;
+	for (_i = 0; _i < size; _i++)
+		_count += (str[_i] & 0xC0) != 0x80;
+	return (_count);
+}
+
+static size_t	scalar_offset(const char *str, size_t size, size_t *index)
+{
+	size_t	_i;
+
+	for (_i = 0; _i < size; _i++)
+	{
+		if ((str[_i] & 0xC0) != 0x80)
+		{
+			if (0 == *index)
+				return (_i);
+			(*index)--;
+		}
+	}
+	return (UTF8_NPOS);
+}
+
+static bool	scalar_is_ascii(const char *str, size_t size)
+{
+	unsigned char	_bits;
+	size_t			_i;
+
+	_bits = 0;
+	for (_i = 0; _i < size; _i++)
+		_bits |= (unsigned char)str[_i];
+	return (_bits < 0x80);
+}
+
+static bool	scalar_validate(const char *str, size_t size)
+{
+	size_t	_i;
+	size_t	_len;
+
+	_i = 0;
+	while (_i < size)
+	{
+		_len = scalar_sequence((const unsigned char *)str + _i, size - _i);
+		if (0 == _len)
+			return (false);
+		_i += _len;
+	}
+	return (true);
+}
+
+#if UTF8_X86
+
+/**
+ * @brief Get the position of the nth set bit of the mask.
+ * @param mask The mask.
+ * @param n The index of the bit (< popcount(mask)).
+ * @return The position of the bit.
+*/
+static size_t	mask_nth_bit(unsigned int mask, size_t n)
+{
+	while (n--)
+		mask &= mask - 1;
+	return (__builtin_ctz(mask));
+}
+
+// +===----- SSE2 kernels -----===+ //
+
+static size_t	sse2_count(const char *str, size_t size)
+{
+	__m128i	_lead;
+	__m128i	_acc;
+	__m128i	_sum;
+	size_t	_i;
+	size_t	_round;
+
+	_lead = _mm_set1_epi8(UTF8_LEAD);
+	_sum = _mm_setzero_si128();
+	_i = 0;
+	while (_i + 16 <= size)
+	{
+		_acc = _mm_setzero_si128();
+		for (_round = 0; _round < 255 && _i + 16 <= size; _round++, _i += 16)
+			_acc = _mm_sub_epi8(_acc, _mm_cmpgt_epi8(
+				_mm_loadu_si128((const __m128i *)(str + _i)), _lead));
+		_sum = _mm_add_epi64(_sum, _mm_sad_epu8(_acc, _mm_setzero_si128()));
+	}
+	return ((size_t)_mm_cvtsi128_si64(_sum)
+		+ (size_t)_mm_cvtsi128_si64(_mm_unpackhi_epi64(_sum, _sum))
+		+ scalar_count(str + _i, size - _i));
+}
+
+static size_t	sse2_offset(const char *str, size_t size, size_t *index)
+{
+	__m128i			_lead;
+	__m128i			_acc;
+	unsigned int	_mask;
+	size_t			_count;
+	size_t			_i;
+	size_t			_pos;
+
+	_lead = _mm_set1_epi8(UTF8_LEAD);
+	_i = 0;
+	while (_i + 64 <= size)
+	{
+		_acc = _mm_setzero_si128();
+		for (_pos = 0; _pos < 64; _pos += 16)
+			_acc = _mm_sub_epi8(_acc, _mm_cmpgt_epi8(
+				_mm_loadu_si128((const __m128i *)(str + _i + _pos)), _lead));
+		_acc = _mm_sad_epu8(_acc, _mm_setzero_si128());
+		_count = _mm_cvtsi128_si32(_acc)
+			+ _mm_cvtsi128_si32(_mm_unpackhi_epi64(_acc, _acc));
+		if (*index < _count)
+			break ;
+		*index -= _count;
+		_i += 64;
+	}
+	for (; _i + 16 <= size; _i += 16)
+	{
+		_mask = _mm_movemask_epi8(_mm_cmpgt_epi8(
+			_mm_loadu_si128((const __m128i *)(str + _i)), _lead));
+		_count = __builtin_popcount(_mask);
+		if (*index < _count)
+			return (_i + mask_nth_bit(_mask, *index));
+		*index -= _count;
+	}
+	_pos = scalar_offset(str + _i, size - _i, index);
+	return (UTF8_NPOS == _pos ? UTF8_NPOS : _i + _pos);
+}
+
+static bool	sse2_is_ascii(const char *str, size_t size)
+{
+	__m128i	_bits;
+	size_t	_i;
+
+	_bits = _mm_setzero_si128();
+	for (_i = 0; _i + 16 <= size; _i += 16)
+		_bits = _mm_or_si128(_bits, _mm_loadu_si128((const __m128i *)(str + _i)));
+	return (0 == _mm_movemask_epi8(_bits)
+		&& scalar_is_ascii(str + _i, size - _i));
+}
+
+static bool	sse2_validate(const char *str, size_t size)
+{
+	size_t	_i;
+	size_t	_end;
+	size_t	_len;
+
+	_i = 0;
+	while (_i < size)
+	{
+		if (_i + 16 <= size && 0 == _mm_movemask_epi8(
+			_mm_loadu_si128((const __m128i *)(str + _i))))
+		{
+			_i += 16;
+			continue ;
+		}
+		_end = _i + 16 < size ? _i + 16 : size;
+		while (_i < _end)
+		{
+			_len = scalar_sequence((const unsigned char *)str + _i, size - _i);
+			if (0 == _len)
+				return (false);
+			_i += _len;
+		}
+	}
+	return (true);
+}
+
+// +===----- AVX2 kernels -----===+ //
+
+// The validation is the lookup algorithm of Keiser and Lemire: each error
+// kind is a bit, set by three nibble tables for every pair of consecutive
+// bytes. The third and fourth bytes of a sequence are checked separately.
+
+# define TOO_SHORT 0x01
+# define TOO_LONG 0x02
+# define OVERLONG_3 0x04
+# define TOO_LARGE 0x08
+# define SURROGATE 0x10
+# define OVERLONG_2 0x20
+# define TOO_LARGE_1000 0x40
+# define OVERLONG_4 0x40
+# define TWO_CONTS 0x80
+# define CARRY (TOO_SHORT | TOO_LONG | TWO_CONTS)
+
+/**
+ * @brief Get the bytes of the block shifted by n, with the end of the
+ * previous block first.
+*/
+# define AVX2_PREV(input, prev, n) _mm256_alignr_epi8(input, \
+	_mm256_permute2x128_si256(prev, input, 0x21), 16 - n)
+
+__attribute__((target("avx2")))
+static size_t	avx2_count(const char *str, size_t size)
+{
+	__m256i	_lead;
+	__m256i	_acc;
+	__m256i	_sum;
+	size_t	_i;
+	size_t	_round;
+
+	_lead = _mm256_set1_epi8(UTF8_LEAD);
+	_sum = _mm256_setzero_si256();
+	_i = 0;
+	while (_i + 32 <= size)
+	{
+		_acc = _mm256_setzero_si256();
+		for (_round = 0; _round < 255 && _i + 32 <= size; _round++, _i += 32)
+			_acc = _mm256_sub_epi8(_acc, _mm256_cmpgt_epi8(
+				_mm256_loadu_si256((const __m256i *)(str + _i)), _lead));
+		_sum = _mm256_add_epi64(_sum,
+			_mm256_sad_epu8(_acc, _mm256_setzero_si256()));
+	}
+	return ((size_t)_mm256_extract_epi64(_sum, 0)
+		+ (size_t)_mm256_extract_epi64(_sum, 1)
+		+ (size_t)_mm256_extract_epi64(_sum, 2)
+		+ (size_t)_mm256_extract_epi64(_sum, 3)
+		+ scalar_count(str + _i, size - _i));
+}
+
+__attribute__((target("avx2,popcnt")))
+static size_t	avx2_offset(const char *str, size_t size, size_t *index)
+{
+	__m256i			_lead;
+	unsigned int	_mask;
+	size_t			_count;
+	size_t			_i;
+	size_t			_pos;
+
+	_lead = _mm256_set1_epi8(UTF8_LEAD);
+	for (_i = 0; _i + 32 <= size; _i += 32)
+	{
+		_mask = _mm256_movemask_epi8(_mm256_cmpgt_epi8(
+			_mm256_loadu_si256((const __m256i *)(str + _i)), _lead));
+		_count = __builtin_popcount(_mask);
+		if (*index < _count)
+			return (_i + mask_nth_bit(_mask, *index));
+		*index -= _count;
+	}
+	_pos = scalar_offset(str + _i, size - _i, index);
+	return (UTF8_NPOS == _pos ? UTF8_NPOS : _i + _pos);
+}
+
+__attribute__((target("avx2")))
+static bool	avx2_is_ascii(const char *str, size_t size)
+{
+	__m256i	_bits;
+	size_t	_i;
+
+	_bits = _mm256_setzero_si256();
+	for (_i = 0; _i + 32 <= size; _i += 32)
+		_bits = _mm256_or_si256(_bits,
+			_mm256_loadu_si256((const __m256i *)(str + _i)));
+	return (0 == _mm256_movemask_epi8(_bits)
+		&& scalar_is_ascii(str + _i, size - _i));
+}
+
+/**
+ * @brief Get the errors of a block that is not only ASCII.
+ * @param input The block.
+ * @param prev The previous block.
+ * @param tables The three nibble tables.
+ * @return The errors, zero if the block is valid.
+*/
+__attribute__((target("avx2")))
+static __m256i	avx2_check(__m256i input, __m256i prev, const __m256i *tables)
+{
+	__m256i	_prev1;
+	__m256i	_nibble;
+	__m256i	_special;
+	__m256i	_must23;
+
+	_nibble = _mm256_set1_epi8(0x0F);
+	_prev1 = AVX2_PREV(input, prev, 1);
+	_special = _mm256_and_si256(
+		_mm256_and_si256(
+			_mm256_shuffle_epi8(tables[0],
+				_mm256_and_si256(_mm256_srli_epi16(_prev1, 4), _nibble)),
+			_mm256_shuffle_epi8(tables[1], _mm256_and_si256(_prev1, _nibble))
+		),
+		_mm256_shuffle_epi8(tables[2],
+			_mm256_and_si256(_mm256_srli_epi16(input, 4), _nibble))
+	);
+	_must23 = _mm256_and_si256(
+		_mm256_or_si256(
+			_mm256_subs_epu8(AVX2_PREV(input, prev, 2), _mm256_set1_epi8(0x60)),
+			_mm256_subs_epu8(AVX2_PREV(input, prev, 3), _mm256_set1_epi8(0x70))
+		),
+		_mm256_set1_epi8((char)0x80)
+	);
+	return (_mm256_xor_si256(_must23, _special));
+}
+
+__attribute__((target("avx2")))
+static bool	avx2_validate(const char *str, size_t size)
+{
+	static const char	_nibbles[3][16] = {
+		{TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+			TOO_LONG, TWO_CONTS, TWO_CONTS, TWO_CONTS, TWO_CONTS,
+			TOO_SHORT | OVERLONG_2, TOO_SHORT,
+			TOO_SHORT | OVERLONG_3 | SURROGATE,
+			TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4},
+		{(char)(CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4),
+			(char)(CARRY | OVERLONG_2), (char)CARRY, (char)CARRY,
+			(char)(CARRY | TOO_LARGE),
+			(char)(CARRY | TOO_LARGE | TOO_LARGE_1000),
+			(char)(CARRY | TOO_LARGE | TOO_LARGE_1000),
+			(char)(CARRY | TOO_LARGE | TOO_LARGE_1000),
+			(char)(CARRY | TOO_LARGE | TOO_LARGE_1000),
+			(char)(CARRY | TOO_LARGE | TOO_LARGE_1000),
+			(char)(CARRY | TOO_LARGE | TOO_LARGE_1000),
+			(char)(CARRY | TOO_LARGE | TOO_LARGE_1000),
+			(char)(CARRY | TOO_LARGE | TOO_LARGE_1000),
+			(char)(CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE),
+			(char)(CARRY | TOO_LARGE | TOO_LARGE_1000),
+			(char)(CARRY | TOO_LARGE | TOO_LARGE_1000)},
+		{TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+			TOO_SHORT, TOO_SHORT,
+			(char)(TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3
+				| TOO_LARGE_1000 | OVERLONG_4),
+			(char)(TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE),
+			(char)(TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE),
+			(char)(TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE),
+			TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT}
+	};
+	__m256i	_tables[3];
+	__m256i	_input;
+	__m256i	_prev;
+	__m256i	_error;
+	__m256i	_incomplete;
+	__m256i	_max;
+	char	_tail[32];
+	size_t	_i;
+
+	for (_i = 0; _i < 3; _i++)
+		_tables[_i] = _mm256_broadcastsi128_si256(
+			_mm_loadu_si128((const __m128i *)_nibbles[_i]));
+	_max = _mm256_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+		-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+		(char)(0xF0 - 1), (char)(0xE0 - 1), (char)(0xC0 - 1));
+	_prev = _mm256_setzero_si256();
+	_error = _mm256_setzero_si256();
+	_incomplete = _mm256_setzero_si256();
+	for (_i = 0; _i < size; _i += 32)
+	{
+		if (_i + 32 <= size)
+			_input = _mm256_loadu_si256((const __m256i *)(str + _i));
+		else
+		{
+			memset(_tail, 0, sizeof(_tail));
+			memcpy(_tail, str + _i, size - _i);
+			_input = _mm256_loadu_si256((const __m256i *)_tail);
+		}
+		if (0 == _mm256_movemask_epi8(_input))
+			_error = _mm256_or_si256(_error, _incomplete);
+		else
+		{
+			_error = _mm256_or_si256(_error, avx2_check(_input, _prev, _tables));
+			_incomplete = _mm256_subs_epu8(_input, _max);
+		}
+		_prev = _input;
+	}
+	_error = _mm256_or_si256(_error, _incomplete);
+	return (_mm256_testz_si256(_error, _error));
+}
+
+#endif
+
+// +===----- Dispatch -----===+ //
+
+/**
+ * @brief Get the kernels in use.
+ * @return The kernels, without functions before the first choice.
+*/
+static t_Utf8Kernels	*utf8_state(void)
+{
+	static t_Utf8Kernels	kernels;
+
+	return (&kernels);
+}
+
+/**
+ * @brief Get the kernels in use, chosen on the first call.
+ * @return The kernels.
+*/
+static t_Utf8Kernels	*utf8_kernels(void)
+{
+	t_Utf8Kernels	*_kernels;
+
+	_kernels = utf8_state();
+	if (NULL == _kernels->count && false == utf8_use(UTF8_AVX2)
+		&& false == utf8_use(UTF8_SSE2))
+		utf8_use(UTF8_SCALAR);
+	return (_kernels);
+}
+
+bool	utf8_use(t_Utf8Isa isa)
+{
+	t_Utf8Kernels	_new;
+
+	_new = (t_Utf8Kernels){scalar_count, scalar_offset,
+		scalar_is_ascii, scalar_validate};
+#if UTF8_X86
+	if (UTF8_SSE2 == isa)
+		_new = (t_Utf8Kernels){sse2_count, sse2_offset,
+			sse2_is_ascii, sse2_validate};
+	if (UTF8_AVX2 == isa)
+	{
+		if (!__builtin_cpu_supports("avx2") || !__builtin_cpu_supports("popcnt"))
+			return (false);
+		_new = (t_Utf8Kernels){avx2_count, avx2_offset,
+			avx2_is_ascii, avx2_validate};
+	}
+#else
+	if (UTF8_SCALAR != isa)
+		return (false);
+#endif
+	*utf8_state() = _new;
+	return (true);
+}
+
+// +===----- Functions -----===+ //
+
+size_t	utf8_count(const char *str, size_t size)
+{
+	return (utf8_kernels()->count(str, size));
+}
+
+size_t	utf8_offset(const char *str, size_t size, size_t *index)
+{
+	return (utf8_kernels()->offset(str, size, index));
+}
+
+size_t	utf8_utf16_count(const char *str, size_t size)
+{
+	size_t	_pairs;
+	size_t	_i;
+
+	_pairs = 0;
+	for (_i = 0; _i < size; _i++)
+		_pairs += (unsigned char)str[_i] >= UTF8_ASTRAL;
+	return (utf8_count(str, size) + _pairs);
+}
+
+size_t	utf8_utf16_offset(const char *str, size_t size, size_t *units)
+{
+	size_t	_count;
+	size_t	_width;
+	size_t	_i;
+
+	for (_i = 0; _i + UTF8_BLOCK <= size; _i += UTF8_BLOCK)
+	{
+		_count = utf8_utf16_count(str + _i, UTF8_BLOCK);
+		if (*units < _count)
+			break ;
+		*units -= _count;
+	}
+	for (; _i < size; _i++)
+	{
+		if (0x80 == (str[_i] & 0xC0))
+			continue ;
+		_width = (unsigned char)str[_i] >= UTF8_ASTRAL ? 2 : 1;
+		if (*units < _width)
+			return (_i);
+		*units -= _width;
+	}
+	return (UTF8_NPOS);
+}
+
+bool	utf8_is_bmp(const char *str, size_t size)
+{
+	unsigned char	_astral;
+	size_t			_i;
+
+	_astral = 0;
+	for (_i = 0; _i < size; _i++)
+		_astral |= (unsigned char)str[_i] >= UTF8_ASTRAL;
+	return (0 == _astral);
+}
+
+bool	utf8_is_ascii(const char *str, size_t size)
+{
+	return (utf8_kernels()->is_ascii(str, size));
+}
+
+bool	utf8_validate(const char *str, size_t size)
+{
+	return (utf8_kernels()->validate(str, size));
+}
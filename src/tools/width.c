@@ -0,0 +1,405 @@
+#include "tools/width.h"
+
+// +===----- Types -----===+ //
+
+/* The classes of the characters */
+typedef enum	e_WidthClass
+{
+	WIDTH_NARROW,	/* One cell */
+	WIDTH_WIDE,	/* Two cells */
+	WIDTH_EXTEND,	/* No cell, joins the previous character */
+	WIDTH_JOINER,	/* No cell, joins both characters around it (ZWJ) */
+	WIDTH_ZERO,	/* No cell, alone in its cluster */
+	WIDTH_REGIONAL	/* One cell, joins another one */
+}	t_WidthClass;
+
+/* A range of characters of the same class */
+typedef struct	s_WidthRange
+{
+	uint32_t	first;	/* The first character */
+	uint32_t	last;	/* The last character */
+	uint32_t	class;	/* The class */
+}	t_WidthRange;
+
+// +===----- Tables -----===+ //
+
+// The characters below U+0300 and the ones out of the table are narrow.
+static const t_WidthRange	g_width_ranges[] = {
+	{0x00300, 0x0036F, WIDTH_EXTEND}, {0x00483, 0x00489, WIDTH_EXTEND},
+	{0x00591, 0x005BD, WIDTH_EXTEND}, {0x005BF, 0x005BF, WIDTH_EXTEND},
+	{0x005C1, 0x005C2, WIDTH_EXTEND}, {0x005C4, 0x005C5, WIDTH_EXTEND},
+	{0x005C7, 0x005C7, WIDTH_EXTEND}, {0x00600, 0x00605, WIDTH_ZERO},
+	{0x00610, 0x0061A, WIDTH_EXTEND}, {0x0061C, 0x0061C, WIDTH_ZERO},
+	{0x0064B, 0x0065F, WIDTH_EXTEND}, {0x00670, 0x00670, WIDTH_EXTEND},
+	{0x006D6, 0x006DC, WIDTH_EXTEND}, {0x006DD, 0x006DD, WIDTH_ZERO},
+	{0x006DF, 0x006E4, WIDTH_EXTEND}, {0x006E7, 0x006E8, WIDTH_EXTEND},
+	{0x006EA, 0x006ED, WIDTH_EXTEND}, {0x0070F, 0x0070F, WIDTH_ZERO},
+	{0x00711, 0x00711, WIDTH_EXTEND}, {0x00730, 0x0074A, WIDTH_EXTEND},
+	{0x007A6, 0x007B0, WIDTH_EXTEND}, {0x007EB, 0x007F3, WIDTH_EXTEND},
+	{0x007FD, 0x007FD, WIDTH_EXTEND}, {0x00816, 0x00819, WIDTH_EXTEND},
+	{0x0081B, 0x00823, WIDTH_EXTEND}, {0x00825, 0x00827, WIDTH_EXTEND},
+	{0x00829, 0x0082D, WIDTH_EXTEND}, {0x00859, 0x0085B, WIDTH_EXTEND},
+	{0x00890, 0x00891, WIDTH_ZERO}, {0x00898, 0x0089F, WIDTH_EXTEND},
+	{0x008CA, 0x008E1, WIDTH_EXTEND}, {0x008E2, 0x008E2, WIDTH_ZERO},
+	{0x008E3, 0x00902, WIDTH_EXTEND}, {0x0093A, 0x0093A, WIDTH_EXTEND},
+	{0x0093C, 0x0093C, WIDTH_EXTEND}, {0x00941, 0x00948, WIDTH_EXTEND},
+	{0x0094D, 0x0094D, WIDTH_EXTEND}, {0x00951, 0x00957, WIDTH_EXTEND},
+	{0x00962, 0x00963, WIDTH_EXTEND}, {0x00981, 0x00981, WIDTH_EXTEND},
+	{0x009BC, 0x009BC, WIDTH_EXTEND}, {0x009C1, 0x009C4, WIDTH_EXTEND},
+	{0x009CD, 0x009CD, WIDTH_EXTEND}, {0x009E2, 0x009E3, WIDTH_EXTEND},
+	{0x009FE, 0x009FE, WIDTH_EXTEND}, {0x00A01, 0x00A02, WIDTH_EXTEND},
+	{0x00A3C, 0x00A3C, WIDTH_EXTEND}, {0x00A41, 0x00A42, WIDTH_EXTEND},
+	{0x00A47, 0x00A48, WIDTH_EXTEND}, {0x00A4B, 0x00A4D, WIDTH_EXTEND},
+	{0x00A51, 0x00A51, WIDTH_EXTEND}, {0x00A70, 0x00A71, WIDTH_EXTEND},
+	{0x00A75, 0x00A75, WIDTH_EXTEND}, {0x00A81, 0x00A82, WIDTH_EXTEND},
+	{0x00ABC, 0x00ABC, WIDTH_EXTEND}, {0x00AC1, 0x00AC5, WIDTH_EXTEND},
+	{0x00AC7, 0x00AC8, WIDTH_EXTEND}, {0x00ACD, 0x00ACD, WIDTH_EXTEND},
+	{0x00AE2, 0x00AE3, WIDTH_EXTEND}, {0x00AFA, 0x00AFF, WIDTH_EXTEND},
+	{0x00B01, 0x00B01, WIDTH_EXTEND}, {0x00B3C, 0x00B3C, WIDTH_EXTEND},
+	{0x00B3F, 0x00B3F, WIDTH_EXTEND}, {0x00B41, 0x00B44, WIDTH_EXTEND},
+	{0x00B4D, 0x00B4D, WIDTH_EXTEND}, {0x00B55, 0x00B56, WIDTH_EXTEND},
+	{0x00B62, 0x00B63, WIDTH_EXTEND}, {0x00B82, 0x00B82, WIDTH_EXTEND},
+	{0x00BC0, 0x00BC0, WIDTH_EXTEND}, {0x00BCD, 0x00BCD, WIDTH_EXTEND},
+	{0x00C00, 0x00C00, WIDTH_EXTEND}, {0x00C04, 0x00C04, WIDTH_EXTEND},
+	{0x00C3C, 0x00C3C, WIDTH_EXTEND}, {0x00C3E, 0x00C40, WIDTH_EXTEND},
+	{0x00C46, 0x00C48, WIDTH_EXTEND}, {0x00C4A, 0x00C4D, WIDTH_EXTEND},
+	{0x00C55, 0x00C56, WIDTH_EXTEND}, {0x00C62, 0x00C63, WIDTH_EXTEND},
+	{0x00C81, 0x00C81, WIDTH_EXTEND}, {0x00CBC, 0x00CBC, WIDTH_EXTEND},
+	{0x00CBF, 0x00CBF, WIDTH_EXTEND}, {0x00CC6, 0x00CC6, WIDTH_EXTEND},
+	{0x00CCC, 0x00CCD, WIDTH_EXTEND}, {0x00CE2, 0x00CE3, WIDTH_EXTEND},
+	{0x00D00, 0x00D01, WIDTH_EXTEND}, {0x00D3B, 0x00D3C, WIDTH_EXTEND},
+	{0x00D41, 0x00D44, WIDTH_EXTEND}, {0x00D4D, 0x00D4D, WIDTH_EXTEND},
+	{0x00D62, 0x00D63, WIDTH_EXTEND}, {0x00D81, 0x00D81, WIDTH_EXTEND},
+	{0x00DCA, 0x00DCA, WIDTH_EXTEND}, {0x00DD2, 0x00DD4, WIDTH_EXTEND},
+	{0x00DD6, 0x00DD6, WIDTH_EXTEND}, {0x00E31, 0x00E31, WIDTH_EXTEND},
+	{0x00E34, 0x00E3A, WIDTH_EXTEND}, {0x00E47, 0x00E4E, WIDTH_EXTEND},
+	{0x00EB1, 0x00EB1, WIDTH_EXTEND}, {0x00EB4, 0x00EBC, WIDTH_EXTEND},
+	{0x00EC8, 0x00ECD, WIDTH_EXTEND}, {0x00F18, 0x00F19, WIDTH_EXTEND},
+	{0x00F35, 0x00F35, WIDTH_EXTEND}, {0x00F37, 0x00F37, WIDTH_EXTEND},
+	{0x00F39, 0x00F39, WIDTH_EXTEND}, {0x00F71, 0x00F7E, WIDTH_EXTEND},
+	{0x00F80, 0x00F84, WIDTH_EXTEND}, {0x00F86, 0x00F87, WIDTH_EXTEND},
+	{0x00F8D, 0x00F97, WIDTH_EXTEND}, {0x00F99, 0x00FBC, WIDTH_EXTEND},
+	{0x00FC6, 0x00FC6, WIDTH_EXTEND}, {0x0102D, 0x01030, WIDTH_EXTEND},
+	{0x01032, 0x01037, WIDTH_EXTEND}, {0x01039, 0x0103A, WIDTH_EXTEND},
+	{0x0103D, 0x0103E, WIDTH_EXTEND}, {0x01058, 0x01059, WIDTH_EXTEND},
+	{0x0105E, 0x01060, WIDTH_EXTEND}, {0x01071, 0x01074, WIDTH_EXTEND},
+	{0x01082, 0x01082, WIDTH_EXTEND}, {0x01085, 0x01086, WIDTH_EXTEND},
+	{0x0108D, 0x0108D, WIDTH_EXTEND}, {0x0109D, 0x0109D, WIDTH_EXTEND},
+	{0x01100, 0x0115F, WIDTH_WIDE}, {0x01160, 0x011FF, WIDTH_EXTEND},
+	{0x0135D, 0x0135F, WIDTH_EXTEND}, {0x01712, 0x01714, WIDTH_EXTEND},
+	{0x01732, 0x01733, WIDTH_EXTEND}, {0x01752, 0x01753, WIDTH_EXTEND},
+	{0x01772, 0x01773, WIDTH_EXTEND}, {0x017B4, 0x017B5, WIDTH_EXTEND},
+	{0x017B7, 0x017BD, WIDTH_EXTEND}, {0x017C6, 0x017C6, WIDTH_EXTEND},
+	{0x017C9, 0x017D3, WIDTH_EXTEND}, {0x017DD, 0x017DD, WIDTH_EXTEND},
+	{0x0180B, 0x0180D, WIDTH_EXTEND}, {0x0180E, 0x0180E, WIDTH_ZERO},
+	{0x0180F, 0x0180F, WIDTH_EXTEND}, {0x01885, 0x01886, WIDTH_EXTEND},
+	{0x018A9, 0x018A9, WIDTH_EXTEND}, {0x01920, 0x01922, WIDTH_EXTEND},
+	{0x01927, 0x01928, WIDTH_EXTEND}, {0x01932, 0x01932, WIDTH_EXTEND},
+	{0x01939, 0x0193B, WIDTH_EXTEND}, {0x01A17, 0x01A18, WIDTH_EXTEND},
+	{0x01A1B, 0x01A1B, WIDTH_EXTEND}, {0x01A56, 0x01A56, WIDTH_EXTEND},
+	{0x01A58, 0x01A5E, WIDTH_EXTEND}, {0x01A60, 0x01A60, WIDTH_EXTEND},
+	{0x01A62, 0x01A62, WIDTH_EXTEND}, {0x01A65, 0x01A6C, WIDTH_EXTEND},
+	{0x01A73, 0x01A7C, WIDTH_EXTEND}, {0x01A7F, 0x01A7F, WIDTH_EXTEND},
+	{0x01AB0, 0x01ACE, WIDTH_EXTEND}, {0x01B00, 0x01B03, WIDTH_EXTEND},
+	{0x01B34, 0x01B34, WIDTH_EXTEND}, {0x01B36, 0x01B3A, WIDTH_EXTEND},
+	{0x01B3C, 0x01B3C, WIDTH_EXTEND}, {0x01B42, 0x01B42, WIDTH_EXTEND},
+	{0x01B6B, 0x01B73, WIDTH_EXTEND}, {0x01B80, 0x01B81, WIDTH_EXTEND},
+	{0x01BA2, 0x01BA5, WIDTH_EXTEND}, {0x01BA8, 0x01BA9, WIDTH_EXTEND},
+	{0x01BAB, 0x01BAD, WIDTH_EXTEND}, {0x01BE6, 0x01BE6, WIDTH_EXTEND},
+	{0x01BE8, 0x01BE9, WIDTH_EXTEND}, {0x01BED, 0x01BED, WIDTH_EXTEND},
+	{0x01BEF, 0x01BF1, WIDTH_EXTEND}, {0x01C2C, 0x01C33, WIDTH_EXTEND},
+	{0x01C36, 0x01C37, WIDTH_EXTEND}, {0x01CD0, 0x01CD2, WIDTH_EXTEND},
+	{0x01CD4, 0x01CE0, WIDTH_EXTEND}, {0x01CE2, 0x01CE8, WIDTH_EXTEND},
+	{0x01CED, 0x01CED, WIDTH_EXTEND}, {0x01CF4, 0x01CF4, WIDTH_EXTEND},
+	{0x01CF8, 0x01CF9, WIDTH_EXTEND}, {0x01DC0, 0x01DFF, WIDTH_EXTEND},
+	{0x0200B, 0x0200C, WIDTH_ZERO}, {0x0200D, 0x0200D, WIDTH_JOINER},
+	{0x0200E, 0x0200F, WIDTH_ZERO}, {0x0202A, 0x0202E, WIDTH_ZERO},
+	{0x02060, 0x02064, WIDTH_ZERO}, {0x02066, 0x0206F, WIDTH_ZERO},
+	{0x020D0, 0x020F0, WIDTH_EXTEND}, {0x0231A, 0x0231B, WIDTH_WIDE},
+	{0x02329, 0x0232A, WIDTH_WIDE}, {0x023E9, 0x023EC, WIDTH_WIDE},
+	{0x023F0, 0x023F0, WIDTH_WIDE}, {0x023F3, 0x023F3, WIDTH_WIDE},
+	{0x025FD, 0x025FE, WIDTH_WIDE}, {0x02614, 0x02615, WIDTH_WIDE},
+	{0x02648, 0x02653, WIDTH_WIDE}, {0x0267F, 0x0267F, WIDTH_WIDE},
+	{0x02693, 0x02693, WIDTH_WIDE}, {0x026A1, 0x026A1, WIDTH_WIDE},
+	{0x026AA, 0x026AB, WIDTH_WIDE}, {0x026BD, 0x026BE, WIDTH_WIDE},
+	{0x026C4, 0x026C5, WIDTH_WIDE}, {0x026CE, 0x026CE, WIDTH_WIDE},
+	{0x026D4, 0x026D4, WIDTH_WIDE}, {0x026EA, 0x026EA, WIDTH_WIDE},
+	{0x026F2, 0x026F3, WIDTH_WIDE}, {0x026F5, 0x026F5, WIDTH_WIDE},
+	{0x026FA, 0x026FA, WIDTH_WIDE}, {0x026FD, 0x026FD, WIDTH_WIDE},
+	{0x02705, 0x02705, WIDTH_WIDE}, {0x0270A, 0x0270B, WIDTH_WIDE},
+	{0x02728, 0x02728, WIDTH_WIDE}, {0x0274C, 0x0274C, WIDTH_WIDE},
+	{0x0274E, 0x0274E, WIDTH_WIDE}, {0x02753, 0x02755, WIDTH_WIDE},
+	{0x02757, 0x02757, WIDTH_WIDE}, {0x02795, 0x02797, WIDTH_WIDE},
+	{0x027B0, 0x027B0, WIDTH_WIDE}, {0x027BF, 0x027BF, WIDTH_WIDE},
+	{0x02B1B, 0x02B1C, WIDTH_WIDE}, {0x02B50, 0x02B50, WIDTH_WIDE},
+	{0x02B55, 0x02B55, WIDTH_WIDE}, {0x02CEF, 0x02CF1, WIDTH_EXTEND},
+	{0x02D7F, 0x02D7F, WIDTH_EXTEND}, {0x02DE0, 0x02DFF, WIDTH_EXTEND},
+	{0x02E80, 0x02E99, WIDTH_WIDE}, {0x02E9B, 0x02EF3, WIDTH_WIDE},
+	{0x02F00, 0x02FD5, WIDTH_WIDE}, {0x02FF0, 0x02FFB, WIDTH_WIDE},
+	{0x03000, 0x03029, WIDTH_WIDE}, {0x0302A, 0x0302D, WIDTH_EXTEND},
+	{0x0302E, 0x0303E, WIDTH_WIDE}, {0x03041, 0x03096, WIDTH_WIDE},
+	{0x03099, 0x0309A, WIDTH_EXTEND}, {0x0309B, 0x030FF, WIDTH_WIDE},
+	{0x03105, 0x0312F, WIDTH_WIDE}, {0x03131, 0x0318E, WIDTH_WIDE},
+	{0x03190, 0x031E3, WIDTH_WIDE}, {0x031F0, 0x0321E, WIDTH_WIDE},
+	{0x03220, 0x03247, WIDTH_WIDE}, {0x03250, 0x04DBF, WIDTH_WIDE},
+	{0x04E00, 0x0A48C, WIDTH_WIDE}, {0x0A490, 0x0A4C6, WIDTH_WIDE},
+	{0x0A66F, 0x0A672, WIDTH_EXTEND}, {0x0A674, 0x0A67D, WIDTH_EXTEND},
+	{0x0A69E, 0x0A69F, WIDTH_EXTEND}, {0x0A6F0, 0x0A6F1, WIDTH_EXTEND},
+	{0x0A802, 0x0A802, WIDTH_EXTEND}, {0x0A806, 0x0A806, WIDTH_EXTEND},
+	{0x0A80B, 0x0A80B, WIDTH_EXTEND}, {0x0A825, 0x0A826, WIDTH_EXTEND},
+	{0x0A82C, 0x0A82C, WIDTH_EXTEND}, {0x0A8C4, 0x0A8C5, WIDTH_EXTEND},
+	{0x0A8E0, 0x0A8F1, WIDTH_EXTEND}, {0x0A8FF, 0x0A8FF, WIDTH_EXTEND},
+	{0x0A926, 0x0A92D, WIDTH_EXTEND}, {0x0A947, 0x0A951, WIDTH_EXTEND},
+	{0x0A960, 0x0A97C, WIDTH_WIDE}, {0x0A980, 0x0A982, WIDTH_EXTEND},
+	{0x0A9B3, 0x0A9B3, WIDTH_EXTEND}, {0x0A9B6, 0x0A9B9, WIDTH_EXTEND},
+	{0x0A9BC, 0x0A9BD, WIDTH_EXTEND}, {0x0A9E5, 0x0A9E5, WIDTH_EXTEND},
+	{0x0AA29, 0x0AA2E, WIDTH_EXTEND}, {0x0AA31, 0x0AA32, WIDTH_EXTEND},
+	{0x0AA35, 0x0AA36, WIDTH_EXTEND}, {0x0AA43, 0x0AA43, WIDTH_EXTEND},
+	{0x0AA4C, 0x0AA4C, WIDTH_EXTEND}, {0x0AA7C, 0x0AA7C, WIDTH_EXTEND},
+	{0x0AAB0, 0x0AAB0, WIDTH_EXTEND}, {0x0AAB2, 0x0AAB4, WIDTH_EXTEND},
+	{0x0AAB7, 0x0AAB8, WIDTH_EXTEND}, {0x0AABE, 0x0AABF, WIDTH_EXTEND},
+	{0x0AAC1, 0x0AAC1, WIDTH_EXTEND}, {0x0AAEC, 0x0AAED, WIDTH_EXTEND},
+	{0x0AAF6, 0x0AAF6, WIDTH_EXTEND}, {0x0ABE5, 0x0ABE5, WIDTH_EXTEND},
+	{0x0ABE8, 0x0ABE8, WIDTH_EXTEND}, {0x0ABED, 0x0ABED, WIDTH_EXTEND},
+	{0x0AC00, 0x0D7A3, WIDTH_WIDE}, {0x0D7B0, 0x0D7FF, WIDTH_EXTEND},
+	{0x0F900, 0x0FA6D, WIDTH_WIDE}, {0x0FA70, 0x0FAD9, WIDTH_WIDE},
+	{0x0FB1E, 0x0FB1E, WIDTH_EXTEND}, {0x0FE00, 0x0FE0F, WIDTH_EXTEND},
+	{0x0FE10, 0x0FE19, WIDTH_WIDE}, {0x0FE20, 0x0FE2F, WIDTH_EXTEND},
+	{0x0FE30, 0x0FE52, WIDTH_WIDE}, {0x0FE54, 0x0FE66, WIDTH_WIDE},
+	{0x0FE68, 0x0FE6B, WIDTH_WIDE}, {0x0FEFF, 0x0FEFF, WIDTH_ZERO},
+	{0x0FF01, 0x0FF60, WIDTH_WIDE}, {0x0FFE0, 0x0FFE6, WIDTH_WIDE},
+	{0x0FFF9, 0x0FFFB, WIDTH_ZERO}, {0x101FD, 0x101FD, WIDTH_EXTEND},
+	{0x102E0, 0x102E0, WIDTH_EXTEND}, {0x10376, 0x1037A, WIDTH_EXTEND},
+	{0x10A01, 0x10A03, WIDTH_EXTEND}, {0x10A05, 0x10A06, WIDTH_EXTEND},
+	{0x10A0C, 0x10A0F, WIDTH_EXTEND}, {0x10A38, 0x10A3A, WIDTH_EXTEND},
+	{0x10A3F, 0x10A3F, WIDTH_EXTEND}, {0x10AE5, 0x10AE6, WIDTH_EXTEND},
+	{0x10D24, 0x10D27, WIDTH_EXTEND}, {0x10EAB, 0x10EAC, WIDTH_EXTEND},
+	{0x10F46, 0x10F50, WIDTH_EXTEND}, {0x10F82, 0x10F85, WIDTH_EXTEND},
+	{0x11001, 0x11001, WIDTH_EXTEND}, {0x11038, 0x11046, WIDTH_EXTEND},
+	{0x11070, 0x11070, WIDTH_EXTEND}, {0x11073, 0x11074, WIDTH_EXTEND},
+	{0x1107F, 0x11081, WIDTH_EXTEND}, {0x110B3, 0x110B6, WIDTH_EXTEND},
+	{0x110B9, 0x110BA, WIDTH_EXTEND}, {0x110BD, 0x110BD, WIDTH_ZERO},
+	{0x110C2, 0x110C2, WIDTH_EXTEND}, {0x110CD, 0x110CD, WIDTH_ZERO},
+	{0x11100, 0x11102, WIDTH_EXTEND}, {0x11127, 0x1112B, WIDTH_EXTEND},
+	{0x1112D, 0x11134, WIDTH_EXTEND}, {0x11173, 0x11173, WIDTH_EXTEND},
+	{0x11180, 0x11181, WIDTH_EXTEND}, {0x111B6, 0x111BE, WIDTH_EXTEND},
+	{0x111C9, 0x111CC, WIDTH_EXTEND}, {0x111CF, 0x111CF, WIDTH_EXTEND},
+	{0x1122F, 0x11231, WIDTH_EXTEND}, {0x11234, 0x11234, WIDTH_EXTEND},
+	{0x11236, 0x11237, WIDTH_EXTEND}, {0x1123E, 0x1123E, WIDTH_EXTEND},
+	{0x112DF, 0x112DF, WIDTH_EXTEND}, {0x112E3, 0x112EA, WIDTH_EXTEND},
+	{0x11300, 0x11301, WIDTH_EXTEND}, {0x1133B, 0x1133C, WIDTH_EXTEND},
+	{0x11340, 0x11340, WIDTH_EXTEND}, {0x11366, 0x1136C, WIDTH_EXTEND},
+	{0x11370, 0x11374, WIDTH_EXTEND}, {0x11438, 0x1143F, WIDTH_EXTEND},
+	{0x11442, 0x11444, WIDTH_EXTEND}, {0x11446, 0x11446, WIDTH_EXTEND},
+	{0x1145E, 0x1145E, WIDTH_EXTEND}, {0x114B3, 0x114B8, WIDTH_EXTEND},
+	{0x114BA, 0x114BA, WIDTH_EXTEND}, {0x114BF, 0x114C0, WIDTH_EXTEND},
+	{0x114C2, 0x114C3, WIDTH_EXTEND}, {0x115B2, 0x115B5, WIDTH_EXTEND},
+	{0x115BC, 0x115BD, WIDTH_EXTEND}, {0x115BF, 0x115C0, WIDTH_EXTEND},
+	{0x115DC, 0x115DD, WIDTH_EXTEND}, {0x11633, 0x1163A, WIDTH_EXTEND},
+	{0x1163D, 0x1163D, WIDTH_EXTEND}, {0x1163F, 0x11640, WIDTH_EXTEND},
+	{0x116AB, 0x116AB, WIDTH_EXTEND}, {0x116AD, 0x116AD, WIDTH_EXTEND},
+	{0x116B0, 0x116B5, WIDTH_EXTEND}, {0x116B7, 0x116B7, WIDTH_EXTEND},
+	{0x1171D, 0x1171F, WIDTH_EXTEND}, {0x11722, 0x11725, WIDTH_EXTEND},
+	{0x11727, 0x1172B, WIDTH_EXTEND}, {0x1182F, 0x11837, WIDTH_EXTEND},
+	{0x11839, 0x1183A, WIDTH_EXTEND}, {0x1193B, 0x1193C, WIDTH_EXTEND},
+	{0x1193E, 0x1193E, WIDTH_EXTEND}, {0x11943, 0x11943, WIDTH_EXTEND},
+	{0x119D4, 0x119D7, WIDTH_EXTEND}, {0x119DA, 0x119DB, WIDTH_EXTEND},
+	{0x119E0, 0x119E0, WIDTH_EXTEND}, {0x11A01, 0x11A0A, WIDTH_EXTEND},
+	{0x11A33, 0x11A38, WIDTH_EXTEND}, {0x11A3B, 0x11A3E, WIDTH_EXTEND},
+	{0x11A47, 0x11A47, WIDTH_EXTEND}, {0x11A51, 0x11A56, WIDTH_EXTEND},
+	{0x11A59, 0x11A5B, WIDTH_EXTEND}, {0x11A8A, 0x11A96, WIDTH_EXTEND},
+	{0x11A98, 0x11A99, WIDTH_EXTEND}, {0x11C30, 0x11C36, WIDTH_EXTEND},
+	{0x11C38, 0x11C3D, WIDTH_EXTEND}, {0x11C3F, 0x11C3F, WIDTH_EXTEND},
+	{0x11C92, 0x11CA7, WIDTH_EXTEND}, {0x11CAA, 0x11CB0, WIDTH_EXTEND},
+	{0x11CB2, 0x11CB3, WIDTH_EXTEND}, {0x11CB5, 0x11CB6, WIDTH_EXTEND},
+	{0x11D31, 0x11D36, WIDTH_EXTEND}, {0x11D3A, 0x11D3A, WIDTH_EXTEND},
+	{0x11D3C, 0x11D3D, WIDTH_EXTEND}, {0x11D3F, 0x11D45, WIDTH_EXTEND},
+	{0x11D47, 0x11D47, WIDTH_EXTEND}, {0x11D90, 0x11D91, WIDTH_EXTEND},
+	{0x11D95, 0x11D95, WIDTH_EXTEND}, {0x11D97, 0x11D97, WIDTH_EXTEND},
+	{0x11EF3, 0x11EF4, WIDTH_EXTEND}, {0x13430, 0x13438, WIDTH_ZERO},
+	{0x16AF0, 0x16AF4, WIDTH_EXTEND}, {0x16B30, 0x16B36, WIDTH_EXTEND},
+	{0x16F4F, 0x16F4F, WIDTH_EXTEND}, {0x16F8F, 0x16F92, WIDTH_EXTEND},
+	{0x16FE0, 0x16FE3, WIDTH_WIDE}, {0x16FE4, 0x16FE4, WIDTH_EXTEND},
+	{0x16FF0, 0x16FF1, WIDTH_WIDE}, {0x17000, 0x187F7, WIDTH_WIDE},
+	{0x18800, 0x18CD5, WIDTH_WIDE}, {0x18D00, 0x18D08, WIDTH_WIDE},
+	{0x1AFF0, 0x1AFF3, WIDTH_WIDE}, {0x1AFF5, 0x1AFFB, WIDTH_WIDE},
+	{0x1AFFD, 0x1AFFE, WIDTH_WIDE}, {0x1B000, 0x1B122, WIDTH_WIDE},
+	{0x1B150, 0x1B152, WIDTH_WIDE}, {0x1B164, 0x1B167, WIDTH_WIDE},
+	{0x1B170, 0x1B2FB, WIDTH_WIDE}, {0x1BC9D, 0x1BC9E, WIDTH_EXTEND},
+	{0x1BCA0, 0x1BCA3, WIDTH_ZERO}, {0x1CF00, 0x1CF2D, WIDTH_EXTEND},
+	{0x1CF30, 0x1CF46, WIDTH_EXTEND}, {0x1D167, 0x1D169, WIDTH_EXTEND},
+	{0x1D173, 0x1D17A, WIDTH_ZERO}, {0x1D17B, 0x1D182, WIDTH_EXTEND},
+	{0x1D185, 0x1D18B, WIDTH_EXTEND}, {0x1D1AA, 0x1D1AD, WIDTH_EXTEND},
+	{0x1D242, 0x1D244, WIDTH_EXTEND}, {0x1DA00, 0x1DA36, WIDTH_EXTEND},
+	{0x1DA3B, 0x1DA6C, WIDTH_EXTEND}, {0x1DA75, 0x1DA75, WIDTH_EXTEND},
+	{0x1DA84, 0x1DA84, WIDTH_EXTEND}, {0x1DA9B, 0x1DA9F, WIDTH_EXTEND},
+	{0x1DAA1, 0x1DAAF, WIDTH_EXTEND}, {0x1E000, 0x1E006, WIDTH_EXTEND},
+	{0x1E008, 0x1E018, WIDTH_EXTEND}, {0x1E01B, 0x1E021, WIDTH_EXTEND},
+	{0x1E023, 0x1E024, WIDTH_EXTEND}, {0x1E026, 0x1E02A, WIDTH_EXTEND},
+	{0x1E130, 0x1E136, WIDTH_EXTEND}, {0x1E2AE, 0x1E2AE, WIDTH_EXTEND},
+	{0x1E2EC, 0x1E2EF, WIDTH_EXTEND}, {0x1E8D0, 0x1E8D6, WIDTH_EXTEND},
+	{0x1E944, 0x1E94A, WIDTH_EXTEND}, {0x1F004, 0x1F004, WIDTH_WIDE},
+	{0x1F0CF, 0x1F0CF, WIDTH_WIDE}, {0x1F18E, 0x1F18E, WIDTH_WIDE},
+	{0x1F191, 0x1F19A, WIDTH_WIDE}, {0x1F1E6, 0x1F1FF, WIDTH_REGIONAL},
+	{0x1F200, 0x1F202, WIDTH_WIDE}, {0x1F210, 0x1F23B, WIDTH_WIDE},
+	{0x1F240, 0x1F248, WIDTH_WIDE}, {0x1F250, 0x1F251, WIDTH_WIDE},
+	{0x1F260, 0x1F265, WIDTH_WIDE}, {0x1F300, 0x1F320, WIDTH_WIDE},
+	{0x1F32D, 0x1F335, WIDTH_WIDE}, {0x1F337, 0x1F37C, WIDTH_WIDE},
+	{0x1F37E, 0x1F393, WIDTH_WIDE}, {0x1F3A0, 0x1F3CA, WIDTH_WIDE},
+	{0x1F3CF, 0x1F3D3, WIDTH_WIDE}, {0x1F3E0, 0x1F3F0, WIDTH_WIDE},
+	{0x1F3F4, 0x1F3F4, WIDTH_WIDE}, {0x1F3F8, 0x1F3FA, WIDTH_WIDE},
+	{0x1F3FB, 0x1F3FF, WIDTH_EXTEND}, {0x1F400, 0x1F43E, WIDTH_WIDE},
+	{0x1F440, 0x1F440, WIDTH_WIDE}, {0x1F442, 0x1F4FC, WIDTH_WIDE},
+	{0x1F4FF, 0x1F53D, WIDTH_WIDE}, {0x1F54B, 0x1F54E, WIDTH_WIDE},
+	{0x1F550, 0x1F567, WIDTH_WIDE}, {0x1F57A, 0x1F57A, WIDTH_WIDE},
+	{0x1F595, 0x1F596, WIDTH_WIDE}, {0x1F5A4, 0x1F5A4, WIDTH_WIDE},
+	{0x1F5FB, 0x1F64F, WIDTH_WIDE}, {0x1F680, 0x1F6C5, WIDTH_WIDE},
+	{0x1F6CC, 0x1F6CC, WIDTH_WIDE}, {0x1F6D0, 0x1F6D2, WIDTH_WIDE},
+	{0x1F6D5, 0x1F6D7, WIDTH_WIDE}, {0x1F6DD, 0x1F6DF, WIDTH_WIDE},
+	{0x1F6EB, 0x1F6EC, WIDTH_WIDE}, {0x1F6F4, 0x1F6FC, WIDTH_WIDE},
+	{0x1F7E0, 0x1F7EB, WIDTH_WIDE}, {0x1F7F0, 0x1F7F0, WIDTH_WIDE},
+	{0x1F90C, 0x1F93A, WIDTH_WIDE}, {0x1F93C, 0x1F945, WIDTH_WIDE},
+	{0x1F947, 0x1F9FF, WIDTH_WIDE}, {0x1FA70, 0x1FA74, WIDTH_WIDE},
+	{0x1FA78, 0x1FA7C, WIDTH_WIDE}, {0x1FA80, 0x1FA86, WIDTH_WIDE},
+	{0x1FA90, 0x1FAAC, WIDTH_WIDE}, {0x1FAB0, 0x1FABA, WIDTH_WIDE},
+	{0x1FAC0, 0x1FAC5, WIDTH_WIDE}, {0x1FAD0, 0x1FAD9, WIDTH_WIDE},
+	{0x1FAE0, 0x1FAE7, WIDTH_WIDE}, {0x1FAF0, 0x1FAF6, WIDTH_WIDE},
+	{0x20000, 0x3FFFD, WIDTH_WIDE}, {0xE0001, 0xE0001, WIDTH_ZERO},
+	{0xE0020, 0xE007F, WIDTH_EXTEND}, {0xE0100, 0xE01EF, WIDTH_EXTEND}
+};
+
+// +===----- Static functions -----===+ //
+
+/**
+ * @brief Get the class of a character.
+ * @param c The code point.
+ * @return The class.
+*/
+static t_WidthClass	width_class(uint32_t c)
+{
+	size_t	_low;
+	size_t	_high;
+	size_t	_mid;
+
+	if (c < 0x300)
+		return (WIDTH_NARROW);
+	_low = 0;
+	_high = sizeof(g_width_ranges) / sizeof(*g_width_ranges);
+	while (_low < _high)
+	{
+		_mid = (_low + _high) / 2;
+		if (c > g_width_ranges[_mid].last)
+			_low = _mid + 1;
+		else
+			_high = _mid;
+	}
+	if (_low < sizeof(g_width_ranges) / sizeof(*g_width_ranges)
+		&& c >= g_width_ranges[_low].first)
+		return (g_width_ranges[_low].class);
+	return (WIDTH_NARROW);
+}
+
+/**
+ * @brief Decodes the character at the start of the data, an invalid byte
+ * is read alone as U+FFFD.
+ * @param str The data (size > 0).
+ * @param size The data size.
+ * @param c The code point.
+ * @return The size of the character.
+*/
+static size_t	width_decode(const unsigned char *str, size_t size, uint32_t *c)
+{
+	size_t	_size;
+	size_t	_i;
+
+	*c = str[0];
+	if (str[0] < 0x80)
+		return (1);
+	_size = 1 + (str[0] >= 0xC0) + (str[0] >= 0xE0) + (str[0] >= 0xF0);
+	*c = 0xFFFD;
+	if (1 == _size || _size > size)
+		return (1);
+	*c = str[0] & (0x7F >> _size);
+	for (_i = 1; _i < _size; _i++)
+	{
+		if (0x80 != (str[_i] & 0xC0))
+			return (*c = 0xFFFD, 1);
+		*c = (*c << 6) | (str[_i] & 0x3F);
+	}
+	return (_size);
+}
+
+// +===----- Functions -----===+ //
+
+size_t	width_char(uint32_t c)
+{
+	t_WidthClass	_class;
+
+	_class = width_class(c);
+	if (WIDTH_WIDE == _class)
+		return (2);
+	return (WIDTH_NARROW == _class || WIDTH_REGIONAL == _class);
+}
+
+size_t	width_cluster(const char *str, size_t size, size_t column, size_t tab,
+	size_t *cells)
+{
+	const unsigned char	*_str;
+	t_WidthClass		_first;
+	t_WidthClass		_prev;
+	t_WidthClass		_next;
+	uint32_t			_c;
+	size_t				_pos;
+	size_t				_size;
+	bool				_pair;
+
+	_str = (const unsigned char *)str;
+	*cells = 1;
+	if ('\t' == str[0])
+		return (*cells = tab - column % tab, 1);
+	if (_str[0] < 0x80 && (1 == size || _str[1] < 0x80))
+		return (1);
+	_pos = width_decode(_str, size, &_c);
+	_first = width_class(_c);
+	*cells = width_char(_c);
+	_prev = _first;
+	_pair = WIDTH_REGIONAL == _first;
+	while (_pos < size && WIDTH_ZERO != _first)
+	{
+		_size = width_decode(_str + _pos, size - _pos, &_c);
+		_next = width_class(_c);
+		if (WIDTH_REGIONAL == _next && WIDTH_REGIONAL == _prev && _pair)
+		{
+			(*cells)++;
+			_pair = false;
+		}
+		else if (WIDTH_EXTEND != _next && WIDTH_JOINER != _next
+			&& (WIDTH_JOINER != _prev || WIDTH_WIDE != _next))
+			break ;
+		_prev = _next;
+		_pos += _size;
+	}
+	return (_pos);
+}
+
+bool	width_is_narrow(const char *str, size_t size)
+{
+	const unsigned char	*_str;
+	uint32_t			_c;
+	size_t				_i;
+
+	_str = (const unsigned char *)str;
+	for (_i = 0; _i < size;)
+	{
+		if (_str[_i] < 0x80)
+		{
+			if ('\t' == _str[_i++])
+				return (false);
+			continue ;
+		}
+		_i += width_decode(_str + _i, size - _i, &_c);
+		if (WIDTH_NARROW != width_class(_c))
+			return (false);
+	}
+	return (true);
+}
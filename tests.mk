@@ -12,6 +12,8 @@ SEED_ARCHIVE		=	seed_core.a
 
 CC					=	cc
 CFLAGS				=	-Wall -Wextra -Werror
+LDFLAGS				=	-pthread
+BENCH_CFLAGS		=	-O2
 
 # | ================================================ |
 # 					INCLUDES
@@ -34,6 +36,7 @@ WRITING_SRC			=	tests/systems/writing/TEST_writing_internal.c \
 
 FS_SRC				=	tests/systems/filesystem/TEST_fs.c
 
+BENCH_SRC			=	tests/benchmarks/BENCH_writing.c
 
 # | ================================================ |
 # 					OBJ FILES
@@ -49,6 +52,8 @@ WRITING_OBJ			=	$(addprefix $(BUILD_DIR)/, $(notdir $(WRITING_SRC:.c=.o)))
 
 FS_OBJ				=	$(addprefix $(BUILD_DIR)/, $(notdir $(FS_SRC:.c=.o)))
 
+BENCH_OBJ			=	$(addprefix $(BUILD_DIR)/, $(notdir $(BENCH_SRC:.c=.o)))
+
 # | ================================================ |
 # 					COLORS / WIDTH
 # | ================================================ |
@@ -65,7 +70,7 @@ WHITE		=	\033[37m
 
 define COMPILE_OBJ
 $(BUILD_DIR)/$(notdir $(1:.c=.o)): $(1) | $(BUILD_DIR)
-	@$(CC) $(CFLAGS) -c $$< -o $$@ $(INCLUDES)
+	@$(CC) $(CFLAGS) $(2) -c $$< -o $$@ $(INCLUDES)
 	@printf "$(BLUE)%-$(COL_WIDTH)s$(WHITE): ✔️\n" "$$(notdir $$@)"
 endef
 
@@ -96,13 +101,17 @@ dispatcher: $(TEST_OBJ) $(DISPATCHER_OBJ)
 	@echo "$(GREEN)Done$(WHITE)."
 
 writing: $(TEST_OBJ) $(WRITING_OBJ)
-	@$(CC) $(CFLAGS) $(TEST_OBJ) $(WRITING_OBJ) $(SEED_ARCHIVE) -o $(NAME)
+	@$(CC) $(CFLAGS) $(TEST_OBJ) $(WRITING_OBJ) $(SEED_ARCHIVE) $(LDFLAGS) -o $(NAME)
 	@echo "$(GREEN)Done$(WHITE)."
 
 fs: $(TEST_OBJ) $(FS_OBJ)
 	@$(CC) $(CFLAGS) $(TEST_OBJ) $(FS_OBJ) $(SEED_ARCHIVE) -o $(NAME)
 	@echo "$(GREEN)Done$(WHITE)."
 
+bench: $(TEST_OBJ) $(BENCH_OBJ)
+	@$(CC) $(CFLAGS) $(BENCH_CFLAGS) $(TEST_OBJ) $(BENCH_OBJ) $(SEED_ARCHIVE) -o $(NAME)
+	@echo "$(GREEN)Done$(WHITE)."
+
 # | ================================================ |
 # 					DIRECTORY
 # | ================================================ |
@@ -120,5 +129,6 @@ $(foreach src, $(MANAGER_SRC), $(eval $(call COMPILE_OBJ,$(src))))
 $(foreach src, $(DISPATCHER_SRC), $(eval $(call COMPILE_OBJ,$(src))))
 $(foreach src, $(WRITING_SRC), $(eval $(call COMPILE_OBJ,$(src))))
 $(foreach src, $(FS_SRC), $(eval $(call COMPILE_OBJ,$(src))))
+$(foreach src, $(BENCH_SRC), $(eval $(call COMPILE_OBJ,$(src),$(BENCH_CFLAGS))))
 
-.PHONY: all run manager dispatcher writing
\ No newline at end of file
+.PHONY: all run manager dispatcher writing fs bench
\ No newline at end of file
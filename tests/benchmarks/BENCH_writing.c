@@ -0,0 +1,2106 @@
+#define _GNU_SOURCE	/* memmem */
+#include <glob.h>
+#include <malloc.h>
+#include <regex.h>
+#include "tools.h"
+#include "seed.h"
+#include "core/manager.h"
+#include "systems/writing/_internal.h"
+#include "systems/writing/system.h"
+#include "tools/utf8.h"
+#include "tools/width.h"
+
+#define BENCH_EDITS 100000
+#define BENCH_DEFAULT_MAX 1000000
+#define BENCH_LONG_LINE (4 << 20)
+#define BENCH_FILE_LINES 1000000
+#define BENCH_UTF_LINE (1 << 20)
+#define BENCH_UTF_EDITS 10000
+#define BENCH_KERNEL_SIZE (1 << 20)
+#define BENCH_KERNEL_ROUNDS 200
+#define BENCH_LINE_TEXT "	if (NULL == line) return (false); // x"
+#define BENCH_PASTE_LINES 50000
+#define BENCH_SCREEN 80	/* The count of lines of a repaint */
+#define BENCH_REPAINTS 10000
+#define BENCH_CURSORS 5000
+#define BENCH_CHUNK 1024	/* The count of matches by regex chunk */
+#define BENCH_PATTERN "line_[a-z_]+\\(_[a-z]+\\)"
+#define BENCH_WORST_PATTERN "x|x.*y"	/* Each match may be read to the end of the line */
+#define BENCH_WORST_SIZE 10000	/* The smallest line of the worst regex case */
+#define BENCH_NEEDLE "line_get_data(_tail)"	/* Absent from the sources */
+#define BENCH_SOURCES "src/*/*/*.c"	/* The typical code replayed by the footprint */
+#define BENCH_BUFFERS 200	/* The count of buffers of the working set */
+#define BENCH_QUERIES 20	/* The count of repeated searches */
+#define BENCH_REPLACED "buffer"	/* The text replaced in the sources */
+#define BENCH_REPLACEMENT "buf"
+#define BENCH_COPIES 16	/* The count of copies of the sources replaced */
+#define BENCH_OFFSETS 100000	/* The count of random offsets converted */
+#define BENCH_DIAGNOSTICS 10000	/* The count of positions converted at once */
+#define BENCH_UTF16_LINES 50000	/* The count of lines with surrogate pairs */
+#define BENCH_UTF16_TEXT "ab \xC3\xA9t\xC3\xA9 \xF0\x9F\x98\x80 "
+#define BENCH_COLUMN_LINES 100000	/* The count of lines of the column buffer */
+#define BENCH_SNAPSHOTS 1000	/* The count of snapshots kept while typing */
+#define BENCH_WIDE_TEXT "\t// \xE4\xB8\xAD\xE6\x96\x87 caf\xC3\xA9 e\xCC\x81 x"
+#define BENCH_TAB 4	/* The tab size of the display columns */
+#define BENCH_WRAP 80	/* The count of columns of a wrapped row */
+#define BENCH_ROWS 100000	/* The count of random rows looked up */
+
+// +===----- Bench Utilities -----===+ //
+
+/**
+ * @brief Get the monotonic time in nanoseconds.
+ * @return The time.
+*/
+static double	bench_now(void)
+{
+	struct timespec	_ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &_ts);
+	return ((double)_ts.tv_sec * 1e9 + (double)_ts.tv_nsec);
+}
+
+/**
+ * @brief Creates a buffer filled with empty lines.
+ * @param manager The manager.
+ * @param lines The count of lines.
+ * @param buffer_id The ID of the buffer that was be created.
+ * @return 0 on success, 1 on failure.
+*/
+static int	bench_fill_buffer(t_Manager *manager, size_t lines, size_t *buffer_id)
+{
+	t_Command			cmd;
+	t_CmdCreateBuffer	create_payload;
+	t_CmdInsertLine		line_payload;
+	size_t				_i;
+
+	cmd.id = CMD_WRITING_CREATE_BUFFER;
+	cmd.payload = &create_payload;
+	if (ERR_SUCCESS != manager_exec(manager, &cmd))
+		return (1);
+	*buffer_id = create_payload.out_buffer_id;
+	line_payload.buffer_id = *buffer_id;
+	line_payload.line = -1;
+	cmd.id = CMD_WRITING_INSERT_LINE;
+	cmd.payload = &line_payload;
+	for (_i = 0; _i < lines; _i++)
+	{
+		if (ERR_SUCCESS != manager_exec(manager, &cmd))
+			return (1);
+	}
+	return (0);
+}
+
+/**
+ * @brief Get the resident set size of the process.
+ * @return The size in KiB.
+*/
+static long	bench_rss(void)
+{
+	FILE	*_file;
+	long	_size;
+	long	_resident;
+
+	malloc_trim(0);
+	_file = fopen("/proc/self/statm", "r");
+	if (NULL == _file)
+		return (0);
+	if (2 != fscanf(_file, "%ld %ld", &_size, &_resident))
+		_resident = 0;
+	fclose(_file);
+	return (_resident * (sysconf(_SC_PAGESIZE) / 1024));
+}
+
+/**
+ * @brief Reads the files that match the given pattern in one text.
+ * @param pattern The glob pattern of the files.
+ * @param size The size of the text.
+ * @return The text, or NULL if an error occured.
+*/
+static char	*bench_read_files(const char *pattern, size_t *size)
+{
+	glob_t	_glob;
+	FILE	*_file;
+	char	*text;
+	char	*_new_text;
+	size_t	_i;
+	long	_length;
+
+	if (0 != glob(pattern, 0, NULL, &_glob))
+		return (NULL);
+	text = NULL;
+	*size = 0;
+	for (_i = 0; _i < _glob.gl_pathc; _i++)
+	{
+		_file = fopen(_glob.gl_pathv[_i], "r");
+		if (NULL == _file)
+			continue ;
+		fseek(_file, 0, SEEK_END);
+		_length = ftell(_file);
+		rewind(_file);
+		_new_text = _length > 0 ? realloc(text, *size + _length) : NULL;
+		if (_new_text)
+		{
+			text = _new_text;
+			*size += fread(text + *size, 1, _length, _file);
+		}
+		fclose(_file);
+	}
+	globfree(&_glob);
+	return (text);
+}
+
+/**
+ * @brief Fills the data with the given text repeated.
+ * @param data The data.
+ * @param size The data size, reduced to a whole count of texts.
+ * @param text The text.
+*/
+static void	bench_fill_text(char *data, size_t *size, const char *text)
+{
+	size_t	_len;
+	size_t	_i;
+
+	_len = strlen(text);
+	for (_i = 0; _i + _len <= *size; _i += _len)
+		memcpy(data + _i, text, _len);
+	*size = _i;
+}
+
+/**
+ * @brief Allocates the text of a paste of the same line repeated.
+ * @param lines The count of lines.
+ * @param size The text size.
+ * @return The text, or NULL if an error occured.
+*/
+static char	*bench_paste_text(size_t lines, size_t *size)
+{
+	char	*text;
+	size_t	_line;
+	size_t	_i;
+
+	_line = sizeof(BENCH_LINE_TEXT);
+	text = malloc(_line * lines);
+	TEST_NULL(text, NULL);
+	for (_i = 0; _i < lines; _i++)
+	{
+		memcpy(text + _i * _line, BENCH_LINE_TEXT, _line - 1);
+		text[(_i + 1) * _line - 1] = '\n';
+	}
+	*size = _line * lines;
+	return (text);
+}
+
+// +===----- Benchmarks -----===+ //
+
+/**
+ * @brief Measures the latency of one edit at a random line.
+ * @param lines The count of lines of the buffer.
+ * @return 0 on success, 1 on failure.
+*/
+static int	bench_edit_latency(size_t lines)
+{
+	t_Manager		*manager;
+	t_Command		cmd;
+	t_CmdInsertData	payload;
+	size_t			buffer_id;
+	size_t			_i;
+	double			_start;
+	double			_elapsed;
+
+	manager = manager_init();
+	if (NULL == manager)
+		return (print_error("Failed to initialize manager"), 1);
+	if (bench_fill_buffer(manager, lines, &buffer_id))
+		return (manager_clean(manager), print_error("Failed to fill buffer"), 1);
+	payload.buffer_id = buffer_id;
+	payload.index = 0;
+	payload.size = 1;
+	payload.data = "x";
+	cmd.id = CMD_WRITING_INSERT_TEXT;
+	cmd.payload = &payload;
+	srand(42);
+	_start = bench_now();
+	for (_i = 0; _i < BENCH_EDITS; _i++)
+	{
+		payload.line = ((size_t)rand() * RAND_MAX + rand()) % lines;
+		if (ERR_SUCCESS != manager_exec(manager, &cmd))
+			return (manager_clean(manager), print_error("Edit failed"), 1);
+	}
+	_elapsed = bench_now() - _start;
+	printf("%10zu lines: %8.1f ns/edit\n", lines, _elapsed / BENCH_EDITS);
+	manager_clean(manager);
+	return (0);
+}
+
+/**
+ * @brief Measures the latency of typing and erasing in the middle of a long line.
+ * @return 0 on success, 1 on failure.
+*/
+static int	bench_long_line_typing(void)
+{
+	t_Buffer	*buffer;
+	t_Line		*line;
+	char		*data;
+	size_t		_cursor;
+	size_t		_i;
+	double		_start;
+	double		_elapsed;
+
+	buffer = buffer_create();
+	line = line_create(buffer);
+	data = malloc(BENCH_LONG_LINE);
+	if (NULL == line || NULL == data)
+		return (buffer_destroy(buffer), free(data), print_error("Allocation failed"), 1);
+	memset(data, 'x', BENCH_LONG_LINE);
+	if (false == line_insert_data(buffer, line, 0, BENCH_LONG_LINE, data))
+		return (buffer_destroy(buffer), free(data), print_error("Insert failed"), 1);
+	_cursor = BENCH_LONG_LINE / 2;
+	_start = bench_now();
+	for (_i = 0; _i < BENCH_EDITS; _i++)
+	{
+		line_insert_data(buffer, line, _cursor, 1, "y");
+		_cursor++;
+		if (_i % 4 == 3)
+			line_delete_data(buffer, line, --_cursor, 1);
+	}
+	_elapsed = bench_now() - _start;
+	printf("%10d bytes: %8.1f ns/keystroke\n", BENCH_LONG_LINE, _elapsed / BENCH_EDITS);
+	line_destroy(buffer, line);
+	buffer_destroy(buffer);
+	free(data);
+	return (0);
+}
+
+/**
+ * @brief Pastes the text line by line with one insert and one split per line.
+ * @param manager The manager.
+ * @param buffer_id The buffer ID.
+ * @param line The line of the cursor.
+ * @param text The pasted text.
+ * @param size The text size.
+ * @return 0 on success, 1 on failure.
+*/
+static int	bench_paste_lines(t_Manager *manager, size_t buffer_id, ssize_t line,
+	char *text, size_t size)
+{
+	t_Command		cmd;
+	t_CmdInsertData	text_payload;
+	t_CmdSplitLine	split_payload;
+	char			*_eol;
+
+	text_payload.buffer_id = buffer_id;
+	text_payload.index = 0;
+	split_payload.buffer_id = buffer_id;
+	while (size > 0)
+	{
+		_eol = memchr(text, '\n', size);
+		text_payload.line = line;
+		text_payload.data = text;
+		text_payload.size = _eol ? (size_t)(_eol - text) : size;
+		cmd.id = CMD_WRITING_INSERT_TEXT;
+		cmd.payload = &text_payload;
+		if (text_payload.size > 0 && ERR_SUCCESS != manager_exec(manager, &cmd))
+			return (1);
+		if (NULL == _eol)
+			break ;
+		split_payload.line = line++;
+		split_payload.index = text_payload.size;
+		cmd.id = CMD_WRITING_SPLIT_LINE;
+		cmd.payload = &split_payload;
+		if (ERR_SUCCESS != manager_exec(manager, &cmd))
+			return (1);
+		size -= _eol + 1 - text;
+		text = _eol + 1;
+	}
+	return (0);
+}
+
+/**
+ * @brief Measures the time to paste many lines in the middle of a buffer, with
+ * the range command and with one insert and one split per line.
+ * @return 0 on success, 1 on failure.
+*/
+static int	bench_paste(void)
+{
+	t_Manager			*manager;
+	t_Command			cmd;
+	t_CmdInsertRange	payload;
+	char				*text;
+	size_t				buffer_id;
+	size_t				_size;
+	double				_start;
+	int					status;
+
+	text = bench_paste_text(BENCH_PASTE_LINES, &_size);
+	TEST_NULL(text, 1);
+	status = 1;
+	manager = manager_init();
+	if (NULL != manager && 0 == bench_fill_buffer(manager, 2 * BENCH_PASTE_LINES, &buffer_id))
+	{
+		payload.buffer_id = buffer_id;
+		payload.line = BENCH_PASTE_LINES;
+		payload.index = 0;
+		payload.size = _size;
+		payload.data = text;
+		cmd.id = CMD_WRITING_INSERT_RANGE;
+		cmd.payload = &payload;
+		_start = bench_now();
+		if (ERR_SUCCESS == manager_exec(manager, &cmd))
+		{
+			printf("%10d lines: %8.1f ms with CMD_WRITING_INSERT_RANGE\n",
+				BENCH_PASTE_LINES, (bench_now() - _start) / 1e6);
+			status = 0;
+		}
+	}
+	manager_clean(manager);
+	manager = manager_init();
+	if (0 == status && NULL != manager
+		&& 0 == bench_fill_buffer(manager, 2 * BENCH_PASTE_LINES, &buffer_id))
+	{
+		_start = bench_now();
+		status = bench_paste_lines(manager, buffer_id, BENCH_PASTE_LINES, text,
+			_size);
+		if (0 == status)
+			printf("%10d lines: %8.1f ms with insert and split per line\n",
+				BENCH_PASTE_LINES, (bench_now() - _start) / 1e6);
+	}
+	if (status)
+		print_error("Paste failed");
+	manager_clean(manager);
+	free(text);
+	return (status);
+}
+
+/**
+ * @brief Fills a new buffer with the lines of a paste.
+ * @param manager The manager.
+ * @param lines The count of lines.
+ * @param buffer_id The ID of the buffer that was be created.
+ * @return 0 on success, 1 on failure.
+*/
+static int	bench_fill_paste(t_Manager *manager, size_t lines, size_t *buffer_id)
+{
+	t_Command			cmd;
+	t_CmdInsertRange	payload;
+	int					status;
+
+	payload.data = bench_paste_text(lines, &payload.size);
+	if (NULL == payload.data || bench_fill_buffer(manager, 1, buffer_id))
+		return (free(payload.data), 1);
+	payload.buffer_id = *buffer_id;
+	payload.line = 0;
+	payload.index = 0;
+	cmd.id = CMD_WRITING_INSERT_RANGE;
+	cmd.payload = &payload;
+	status = ERR_SUCCESS != manager_exec(manager, &cmd);
+	free(payload.data);
+	return (status);
+}
+
+/**
+ * @brief Measures the time to delete every line but the first and the last,
+ * with the range command and with one command per line.
+ * @param lines The count of deleted lines.
+ * @return 0 on success, 1 on failure.
+*/
+static int	bench_delete(size_t lines)
+{
+	t_Manager			*manager;
+	t_Command			cmd;
+	t_CmdDeleteRange	range_payload;
+	t_CmdDeleteLine		line_payload;
+	size_t				buffer_id;
+	size_t				_i;
+	double				_start;
+	int					status;
+
+	status = 1;
+	manager = manager_init();
+	if (NULL != manager && 0 == bench_fill_paste(manager, lines + 1, &buffer_id))
+	{
+		range_payload.buffer_id = buffer_id;
+		range_payload.line = 1;
+		range_payload.index = 0;
+		range_payload.end_line = lines + 1;
+		range_payload.end_index = 0;
+		cmd.id = CMD_WRITING_DELETE_RANGE;
+		cmd.payload = &range_payload;
+		_start = bench_now();
+		if (ERR_SUCCESS == manager_exec(manager, &cmd))
+		{
+			printf("%10zu lines: %8.1f ms with CMD_WRITING_DELETE_RANGE\n",
+				lines, (bench_now() - _start) / 1e6);
+			status = 0;
+		}
+	}
+	manager_clean(manager);
+	manager = manager_init();
+	if (0 == status && NULL != manager
+		&& 0 == bench_fill_paste(manager, lines + 1, &buffer_id))
+	{
+		line_payload.buffer_id = buffer_id;
+		line_payload.line = 1;
+		cmd.id = CMD_WRITING_DELETE_LINE;
+		cmd.payload = &line_payload;
+		_start = bench_now();
+		for (_i = 0; _i < lines && 0 == status; _i++)
+			status = ERR_SUCCESS != manager_exec(manager, &cmd);
+		if (0 == status)
+			printf("%10zu lines: %8.1f ms with one command per line\n",
+				lines, (bench_now() - _start) / 1e6);
+	}
+	if (status)
+		print_error("Delete failed");
+	manager_clean(manager);
+	return (status);
+}
+
+/**
+ * @brief Measures the time to read a screen of lines at random positions,
+ * with one command for the screen and with one command per line.
+ * @param lines The count of lines of the buffer.
+ * @return 0 on success, 1 on failure.
+*/
+static int	bench_repaint(size_t lines)
+{
+	t_Manager		*manager;
+	t_Command		cmd;
+	t_CmdGetLines	lines_payload;
+	t_CmdGetLine	line_payload;
+	t_LineView		views[BENCH_SCREEN];
+	size_t			buffer_id;
+	size_t			_i;
+	size_t			_j;
+	double			_start;
+	double			_elapsed;
+
+	manager = manager_init();
+	if (NULL == manager || bench_fill_paste(manager, lines, &buffer_id))
+		return (manager_clean(manager), print_error("Failed to fill buffer"), 1);
+	lines_payload.buffer_id = buffer_id;
+	lines_payload.count = BENCH_SCREEN;
+	lines_payload.views = views;
+	cmd.id = CMD_WRITING_GET_LINES;
+	cmd.payload = &lines_payload;
+	srand(42);
+	_start = bench_now();
+	for (_i = 0; _i < BENCH_REPAINTS; _i++)
+	{
+		lines_payload.line = ((size_t)rand() * RAND_MAX + rand()) % (lines - BENCH_SCREEN);
+		if (ERR_SUCCESS != manager_exec(manager, &cmd))
+			return (manager_clean(manager), print_error("Get lines failed"), 1);
+	}
+	_elapsed = bench_now() - _start;
+	printf("%10zu lines: %8.1f ns/screen with CMD_WRITING_GET_LINES\n", lines,
+		_elapsed / BENCH_REPAINTS);
+	line_payload.buffer_id = buffer_id;
+	cmd.id = CMD_WRITING_GET_LINE;
+	cmd.payload = &line_payload;
+	srand(42);
+	_start = bench_now();
+	for (_i = 0; _i < BENCH_REPAINTS; _i++)
+	{
+		line_payload.line = ((size_t)rand() * RAND_MAX + rand()) % (lines - BENCH_SCREEN);
+		for (_j = 0; _j < BENCH_SCREEN; _j++, line_payload.line++)
+		{
+			if (ERR_SUCCESS != manager_exec(manager, &cmd))
+				return (manager_clean(manager), print_error("Get line failed"), 1);
+		}
+	}
+	_elapsed = bench_now() - _start;
+	printf("%10zu lines: %8.1f ns/screen with one command per line\n", lines,
+		_elapsed / BENCH_REPAINTS);
+	manager_clean(manager);
+	return (0);
+}
+
+/**
+ * @brief Applies the edits with one command per edit.
+ * @param manager The manager.
+ * @param buffer_id The buffer.
+ * @param edits The edits.
+ * @param count The count of edits.
+ * @return 0 on success, 1 on failure.
+*/
+static int	bench_edit_commands(t_Manager *manager, size_t buffer_id, t_Edit *edits,
+	size_t count)
+{
+	t_Command		cmd;
+	t_CmdDeleteData	delete_payload;
+	t_CmdInsertData	insert_payload;
+	size_t			_i;
+
+	for (_i = 0; _i < count; _i++)
+	{
+		delete_payload = (t_CmdDeleteData){.buffer_id = buffer_id, .line = edits[_i].line,
+			.index = edits[_i].index, .size = edits[_i].delete_size};
+		insert_payload = (t_CmdInsertData){.buffer_id = buffer_id, .line = edits[_i].line,
+			.index = edits[_i].index, .size = edits[_i].size, .data = (char *)edits[_i].data};
+		cmd.id = CMD_WRITING_DELETE_TEXT;
+		cmd.payload = &delete_payload;
+		if (ERR_SUCCESS != manager_exec(manager, &cmd))
+			return (1);
+		cmd.id = CMD_WRITING_INSERT_TEXT;
+		cmd.payload = &insert_payload;
+		if (ERR_SUCCESS != manager_exec(manager, &cmd))
+			return (1);
+	}
+	return (0);
+}
+
+/**
+ * @brief Measures the time to rename a word under a cursor every `step`
+ * lines, with one batch and with two commands per cursor.
+ * @param lines The count of lines of the buffer.
+ * @param step The count of lines between two cursors.
+ * @return 0 on success, 1 on failure.
+*/
+static int	bench_multi_edit(size_t lines, size_t step)
+{
+	t_Manager		*manager;
+	t_Command		cmd;
+	t_CmdMultiEdit	payload;
+	t_Edit			*edits;
+	size_t			buffer_id;
+	size_t			_i;
+	double			_elapsed[2];
+	int				status;
+
+	edits = malloc(BENCH_CURSORS * sizeof(t_Edit));
+	TEST_NULL(edits, 1);
+	for (_i = 0; _i < BENCH_CURSORS; _i++)
+		edits[_i] = (t_Edit){.line = (BENCH_CURSORS - 1 - _i) * step, .index = 13,
+			.delete_size = 4, .size = 4, .data = "node"};
+	status = 0;
+	for (_i = 0; _i < 2 && 0 == status; _i++)
+	{
+		manager = manager_init();
+		if (NULL == manager || bench_fill_paste(manager, lines, &buffer_id))
+			status = 1;
+		payload = (t_CmdMultiEdit){.buffer_id = buffer_id, .count = BENCH_CURSORS,
+			.edits = edits};
+		cmd.id = CMD_WRITING_MULTI_EDIT;
+		cmd.payload = &payload;
+		_elapsed[_i] = bench_now();
+		if (0 == status && 0 == _i)
+			status = ERR_SUCCESS != manager_exec(manager, &cmd);
+		else if (0 == status)
+			status = bench_edit_commands(manager, buffer_id, edits, BENCH_CURSORS);
+		_elapsed[_i] = bench_now() - _elapsed[_i];
+		manager_clean(manager);
+	}
+	if (0 == status)
+	{
+		printf("%10d cursors: %7.2f ms with CMD_WRITING_MULTI_EDIT (every %zu lines)\n",
+			BENCH_CURSORS, _elapsed[0] / 1e6, step);
+		printf("%10d cursors: %7.2f ms with two commands per cursor (every %zu lines)\n",
+			BENCH_CURSORS, _elapsed[1] / 1e6, step);
+	}
+	else
+		print_error("Multi edit failed");
+	free(edits);
+	return (status);
+}
+
+/**
+ * @brief Applies the changes with a range delete and a range insert each.
+ * @param manager The manager.
+ * @param buffer_id The buffer.
+ * @param changes The changes.
+ * @param count The count of changes.
+ * @return 0 on success, 1 on failure.
+*/
+static int	bench_change_commands(t_Manager *manager, size_t buffer_id,
+	const t_Change *changes, size_t count)
+{
+	t_Command			cmd;
+	t_CmdDeleteRange	delete_payload;
+	t_CmdInsertRange	insert_payload;
+	size_t				_i;
+
+	for (_i = 0; _i < count; _i++)
+	{
+		delete_payload = (t_CmdDeleteRange){.buffer_id = buffer_id,
+			.line = changes[_i].line, .index = changes[_i].index,
+			.end_line = changes[_i].end_line, .end_index = changes[_i].end_index};
+		insert_payload = (t_CmdInsertRange){.buffer_id = buffer_id,
+			.line = changes[_i].line, .index = changes[_i].index,
+			.size = changes[_i].size, .data = (char *)changes[_i].data};
+		cmd.id = CMD_WRITING_DELETE_RANGE;
+		cmd.payload = &delete_payload;
+		if (ERR_SUCCESS != manager_exec(manager, &cmd))
+			return (1);
+		cmd.id = CMD_WRITING_INSERT_RANGE;
+		cmd.payload = &insert_payload;
+		if (ERR_SUCCESS != manager_exec(manager, &cmd))
+			return (1);
+	}
+	return (0);
+}
+
+/**
+ * @brief Measures the time to sync a batch of changes that each rewrite the
+ * end of a line and the start of the next one, every `step` lines, with one
+ * command and with two commands per change.
+ * @param lines The count of lines of the buffer.
+ * @param step The count of lines between two changes.
+ * @return 0 on success, 1 on failure.
+*/
+static int	bench_apply_changes(size_t lines, size_t step)
+{
+	t_Manager			*manager;
+	t_Command			cmd;
+	t_CmdApplyChanges	payload;
+	t_Change			*changes;
+	size_t				buffer_id;
+	size_t				_i;
+	double				_elapsed[2];
+	int					status;
+
+	changes = malloc(BENCH_CURSORS * sizeof(t_Change));
+	TEST_NULL(changes, 1);
+	for (_i = 0; _i < BENCH_CURSORS; _i++)
+		changes[_i] = (t_Change){_i * step, 30, _i * step + 1, 5, 19,
+			"// y\n\tif (node == "};
+	status = 0;
+	for (_i = 0; _i < 2 && 0 == status; _i++)
+	{
+		manager = manager_init();
+		if (NULL == manager || bench_fill_paste(manager, lines, &buffer_id))
+			status = 1;
+		payload = (t_CmdApplyChanges){.buffer_id = buffer_id,
+			.count = BENCH_CURSORS, .changes = changes};
+		cmd.id = CMD_WRITING_APPLY_CHANGES;
+		cmd.payload = &payload;
+		_elapsed[_i] = bench_now();
+		if (0 == status && 0 == _i)
+			status = ERR_SUCCESS != manager_exec(manager, &cmd);
+		else if (0 == status)
+			status = bench_change_commands(manager, buffer_id, changes,
+				BENCH_CURSORS);
+		_elapsed[_i] = bench_now() - _elapsed[_i];
+		manager_clean(manager);
+	}
+	if (0 == status)
+	{
+		printf("%10d changes: %7.2f ms with CMD_WRITING_APPLY_CHANGES (every %zu lines)\n",
+			BENCH_CURSORS, _elapsed[0] / 1e6, step);
+		printf("%10d changes: %7.2f ms with two commands per change (every %zu lines)\n",
+			BENCH_CURSORS, _elapsed[1] / 1e6, step);
+	}
+	else
+		print_error("Apply changes failed");
+	free(changes);
+	return (status);
+}
+
+/**
+ * @brief Measures the latency of typing at a column in the middle of a long
+ * line through the commands.
+ * @param name The name of the line content.
+ * @param text The text repeated in the line.
+ * @param key The text typed.
+ * @return 0 on success, 1 on failure.
+*/
+static int	bench_command_typing(const char *name, const char *text,
+	const char *key)
+{
+	t_Manager		*manager;
+	t_Command		cmd;
+	t_CmdInsertData	payload;
+	char			*data;
+	size_t			buffer_id;
+	size_t			_i;
+	double			_start;
+	double			_elapsed;
+
+	manager = manager_init();
+	data = malloc(BENCH_UTF_LINE);
+	if (NULL == manager || NULL == data)
+		return (manager_clean(manager), free(data), print_error("Allocation failed"), 1);
+	payload.size = BENCH_UTF_LINE;
+	bench_fill_text(data, &payload.size, text);
+	if (bench_fill_buffer(manager, 1, &buffer_id))
+		return (manager_clean(manager), free(data), print_error("Fill failed"), 1);
+	payload.buffer_id = buffer_id;
+	payload.line = 0;
+	payload.index = 0;
+	payload.data = data;
+	cmd.id = CMD_WRITING_INSERT_TEXT;
+	cmd.payload = &payload;
+	if (ERR_SUCCESS != manager_exec(manager, &cmd))
+		return (manager_clean(manager), free(data), print_error("Insert failed"), 1);
+	payload.index = utf8_count(data, payload.size) / 2;
+	payload.size = strlen(key);
+	payload.data = (char *)key;
+	_start = bench_now();
+	for (_i = 0; _i < BENCH_UTF_EDITS; _i++)
+	{
+		if (ERR_SUCCESS != manager_exec(manager, &cmd))
+			return (manager_clean(manager), free(data), print_error("Edit failed"), 1);
+		payload.index++;
+	}
+	_elapsed = bench_now() - _start;
+	printf("%10s: %8.1f ns/keystroke\n", name, _elapsed / BENCH_UTF_EDITS);
+	manager_clean(manager);
+	free(data);
+	return (0);
+}
+
+/**
+ * @brief Measures the memory used to replay a file line by line, and the
+ * time to destroy the buffer.
+ * @return 0 on success, 1 on failure.
+*/
+static int	bench_file_memory(void)
+{
+	t_Manager			*manager;
+	t_Command			cmd;
+	t_CmdInsertData		payload;
+	t_CmdDestroyBuffer	destroy_payload;
+	size_t				buffer_id;
+	size_t				_i;
+	size_t				_allocs;
+	long				_rss;
+	double				_start;
+
+	manager = manager_init();
+	if (NULL == manager)
+		return (print_error("Failed to initialize manager"), 1);
+	_rss = bench_rss();
+	_start = bench_now();
+	if (bench_fill_buffer(manager, BENCH_FILE_LINES, &buffer_id))
+		return (manager_clean(manager), print_error("Failed to fill buffer"), 1);
+	payload.buffer_id = buffer_id;
+	payload.index = 0;
+	payload.size = strlen(BENCH_LINE_TEXT);
+	payload.data = BENCH_LINE_TEXT;
+	cmd.id = CMD_WRITING_INSERT_TEXT;
+	cmd.payload = &payload;
+	for (_i = 0; _i < BENCH_FILE_LINES; _i++)
+	{
+		payload.line = _i;
+		if (ERR_SUCCESS != manager_exec(manager, &cmd))
+			return (manager_clean(manager), print_error("Insert failed"), 1);
+	}
+	printf("%10d lines: %8.1f ms to build\n", BENCH_FILE_LINES,
+		(bench_now() - _start) / 1e6);
+	_allocs = manager->writing_ctx->buffers[buffer_id]->pool.allocs;
+	printf("%10d lines: %8zu heap allocations\n", BENCH_FILE_LINES, _allocs);
+	printf("%10d lines: %8ld KiB resident (file: %zu KiB)\n", BENCH_FILE_LINES,
+		bench_rss() - _rss, BENCH_FILE_LINES * (payload.size + 1) / 1024);
+	destroy_payload.buffer_id = buffer_id;
+	cmd.id = CMD_WRITING_DELETE_BUFFER;
+	cmd.payload = &destroy_payload;
+	_start = bench_now();
+	if (ERR_SUCCESS != manager_exec(manager, &cmd))
+		return (manager_clean(manager), print_error("Destroy failed"), 1);
+	printf("%10d lines: %8.1f ms to destroy\n", BENCH_FILE_LINES,
+		(bench_now() - _start) / 1e6);
+	manager_clean(manager);
+	return (0);
+}
+
+/**
+ * @brief Measures the memory used by lines of typical code typed one by one,
+ * compared to the size of the text.
+ * @return 0 on success, 1 on failure.
+*/
+static int	bench_memory_footprint(void)
+{
+	t_Manager		*manager;
+	t_Command		cmd;
+	t_CmdInsertData	payload;
+	char			*text;
+	const char		*_cursor;
+	const char		*_eol;
+	size_t			buffer_id;
+	size_t			_size;
+	size_t			_bytes;
+	long			_rss;
+
+	text = bench_read_files(BENCH_SOURCES, &_size);
+	if (NULL == text)
+		return (print_error("Failed to read sources"), 1);
+	manager = manager_init();
+	if (NULL == manager)
+		return (free(text), print_error("Failed to initialize manager"), 1);
+	_rss = bench_rss();
+	if (bench_fill_buffer(manager, BENCH_FILE_LINES, &buffer_id))
+		return (free(text), manager_clean(manager), print_error("Fill failed"), 1);
+	payload.buffer_id = buffer_id;
+	payload.index = 0;
+	cmd.id = CMD_WRITING_INSERT_TEXT;
+	cmd.payload = &payload;
+	_cursor = text;
+	_bytes = 0;
+	for (payload.line = 0; payload.line < BENCH_FILE_LINES; payload.line++)
+	{
+		if (_cursor >= text + _size)
+			_cursor = text;
+		_eol = memchr(_cursor, '\n', text + _size - _cursor);
+		if (NULL == _eol)
+			_eol = text + _size;
+		payload.size = _eol - _cursor;
+		payload.data = (char *)_cursor;
+		if (payload.size > 0 && ERR_SUCCESS != manager_exec(manager, &cmd))
+			return (free(text), manager_clean(manager), print_error("Insert failed"), 1);
+		_bytes += payload.size + 1;
+		_cursor = _eol + 1;
+	}
+	_rss = bench_rss() - _rss;
+	printf("%10d lines: %8zu KiB of text, %ld KiB resident (x%.2f)\n",
+		BENCH_FILE_LINES, _bytes / 1024, _rss, (double)_rss * 1024 / _bytes);
+	printf("%10d lines: %8zu bytes per line\n", BENCH_FILE_LINES,
+		(size_t)_rss * 1024 / BENCH_FILE_LINES);
+	manager_clean(manager);
+	free(text);
+	return (0);
+}
+
+/**
+ * @brief Measures the throughput of the UTF-8 kernels of one instruction set.
+ * @param name The name of the instruction set.
+ * @param data The data.
+ * @param size The data size.
+ * @return 0 on success, 1 on failure.
+*/
+static int	bench_utf8_isa(const char *name, const char *data, size_t size)
+{
+	size_t	_count;
+	size_t	_index;
+	size_t	_i;
+	double	_times[3];
+	double	_start;
+
+	_count = utf8_count(data, size);
+	_start = bench_now();
+	for (_i = 0; _i < BENCH_KERNEL_ROUNDS; _i++)
+		if (utf8_count(data, size) != _count)
+			return (print_error("Count mismatch"), 1);
+	_times[0] = bench_now() - _start;
+	_start = bench_now();
+	for (_i = 0; _i < BENCH_KERNEL_ROUNDS; _i++)
+	{
+		_index = _count - 1;
+		if (UTF_NPOS == utf8_offset(data, size, &_index))
+			return (print_error("Offset mismatch"), 1);
+	}
+	_times[1] = bench_now() - _start;
+	_start = bench_now();
+	for (_i = 0; _i < BENCH_KERNEL_ROUNDS; _i++)
+		if (false == utf8_validate(data, size))
+			return (print_error("Validation failed"), 1);
+	_times[2] = bench_now() - _start;
+	printf("%10s: count %6.2f GB/s, offset %6.2f GB/s, validate %6.2f GB/s\n",
+		name, (double)size * BENCH_KERNEL_ROUNDS / _times[0],
+		(double)size * BENCH_KERNEL_ROUNDS / _times[1],
+		(double)size * BENCH_KERNEL_ROUNDS / _times[2]);
+	return (0);
+}
+
+/**
+ * @brief Measures the throughput of the UTF-8 kernels on ASCII heavy and CJK
+ * heavy lines, for each instruction set supported by the CPU.
+ * @return 0 on success, 1 on failure.
+*/
+static int	bench_utf8_kernels(void)
+{
+	const char	*texts[2] = {
+		"	if (NULL == line) return (false); // caf\xC3\xA9\n",
+		"\xE6\x96\x87\xE5\xAD\x97\xE5\x88\x97\xE3\x81\xAE\xE5\xA4\x89"
+		"\xE6\x8F\x9B (x)\xE3\x80\x82"
+	};
+	const char	*names[3] = {"scalar", "sse2", "avx2"};
+	char		*data;
+	size_t		_size;
+	size_t		_text;
+	size_t		_isa;
+	int			status;
+
+	data = malloc(BENCH_KERNEL_SIZE);
+	if (NULL == data)
+		return (print_error("Allocation failed"), 1);
+	status = 0;
+	for (_text = 0; _text < 2 && 0 == status; _text++)
+	{
+		_size = BENCH_KERNEL_SIZE;
+		bench_fill_text(data, &_size, texts[_text]);
+		printf("%s\n", _text ? "CJK heavy" : "ASCII heavy");
+		for (_isa = UTF8_SCALAR; _isa <= UTF8_AVX2 && 0 == status; _isa++)
+		{
+			if (utf8_use(_isa))
+				status |= bench_utf8_isa(names[_isa], data, _size);
+		}
+	}
+	if (false == utf8_use(UTF8_AVX2))
+		utf8_use(UTF8_SSE2);
+	free(data);
+	return (status);
+}
+
+/**
+ * @brief Replays the read file in a new buffer with one command per line.
+ * @param manager The manager.
+ * @param data The file content.
+ * @param size The file size.
+ * @return 0 on success, 1 on failure.
+*/
+static int	bench_replay_file(t_Manager *manager, char *data, size_t size)
+{
+	t_Command		cmd;
+	t_CmdInsertLine	line_payload;
+	t_CmdInsertData	text_payload;
+	char			*_cursor;
+	char			*_eol;
+	size_t			buffer_id;
+
+	if (bench_fill_buffer(manager, 0, &buffer_id))
+		return (1);
+	line_payload.buffer_id = buffer_id;
+	line_payload.line = -1;
+	text_payload.buffer_id = buffer_id;
+	text_payload.line = -1;
+	text_payload.index = 0;
+	_cursor = data;
+	while (_cursor <= data + size)
+	{
+		_eol = memchr(_cursor, '\n', data + size - _cursor);
+		if (NULL == _eol)
+			_eol = data + size;
+		cmd.id = CMD_WRITING_INSERT_LINE;
+		cmd.payload = &line_payload;
+		if (ERR_SUCCESS != manager_exec(manager, &cmd))
+			return (1);
+		text_payload.size = _eol - _cursor;
+		text_payload.data = _cursor;
+		cmd.id = CMD_WRITING_INSERT_TEXT;
+		cmd.payload = &text_payload;
+		if (text_payload.size > 0 && ERR_SUCCESS != manager_exec(manager, &cmd))
+			return (1);
+		_cursor = _eol + 1;
+	}
+	return (0);
+}
+
+/**
+ * @brief Saves the buffer by copying every line in one block written at once.
+ * @param manager The manager.
+ * @param buffer_id The buffer ID.
+ * @param lines The count of lines.
+ * @param path The absolute path of the file.
+ * @return 0 on success, 1 on failure.
+*/
+static int	bench_concat_save(t_Manager *manager, size_t buffer_id, size_t lines,
+	const char *path)
+{
+	t_Command		cmd;
+	t_CmdGetLine	get_payload;
+	char			*data;
+	char			*_new;
+	size_t			_size;
+	size_t			_capacity;
+	FILE			*file;
+
+	data = NULL;
+	_size = 0;
+	_capacity = 0;
+	get_payload.buffer_id = buffer_id;
+	cmd.id = CMD_WRITING_GET_LINE;
+	cmd.payload = &get_payload;
+	for (get_payload.line = 0; (size_t)get_payload.line < lines; get_payload.line++)
+	{
+		if (ERR_SUCCESS != manager_exec(manager, &cmd))
+			return (free(data), 1);
+		while (_size + get_payload.out_size + 1 > _capacity)
+		{
+			_capacity = _capacity ? _capacity * 2 : 4096;
+			_new = realloc(data, _capacity);
+			if (NULL == _new)
+				return (free(data), 1);
+			data = _new;
+		}
+		memcpy(data + _size, get_payload.out_data, get_payload.out_size);
+		_size += get_payload.out_size;
+		data[_size++] = '\n';
+	}
+	file = fopen(path, "w");
+	if (NULL == file)
+		return (free(data), 1);
+	fwrite(data, 1, _size, file);
+	fclose(file);
+	free(data);
+	return (0);
+}
+
+/**
+ * @brief Measures the time to take a snapshot of a loaded file, and the time
+ * to copy every line instead.
+ * @param manager The manager.
+ * @param buffer_id The buffer of the file.
+ * @param lines The count of lines of the buffer.
+ * @return 0 on success, 1 on failure.
+*/
+static int	bench_snapshot(t_Manager *manager, size_t buffer_id, size_t lines)
+{
+	t_Command		cmd;
+	t_CmdSnapshot	snapshot_payload;
+	t_CmdGetLines	lines_payload;
+	t_LineView		views[BENCH_SCREEN];
+	char			**copies;
+	double			_start;
+	size_t			_i;
+	size_t			_j;
+
+	snapshot_payload.buffer_id = buffer_id;
+	cmd.id = CMD_WRITING_SNAPSHOT;
+	cmd.payload = &snapshot_payload;
+	_start = bench_now();
+	if (ERR_SUCCESS != manager_exec(manager, &cmd))
+		return (print_error("Snapshot failed"), 1);
+	printf("%10zu lines: %8.3f ms with CMD_WRITING_SNAPSHOT\n", lines,
+		(bench_now() - _start) / 1e6);
+	snapshot_release(snapshot_payload.out_snapshot);
+	copies = malloc(lines * sizeof(char *));
+	TEST_NULL(copies, 1);
+	lines_payload.buffer_id = buffer_id;
+	lines_payload.count = BENCH_SCREEN;
+	lines_payload.views = views;
+	cmd.id = CMD_WRITING_GET_LINES;
+	cmd.payload = &lines_payload;
+	_start = bench_now();
+	for (_i = 0; _i < lines; _i += lines_payload.out_count)
+	{
+		lines_payload.line = _i;
+		if (ERR_SUCCESS != manager_exec(manager, &cmd))
+			break ;
+		for (_j = 0; _j < lines_payload.out_count; _j++)
+		{
+			copies[_i + _j] = malloc(views[_j].size + 1);
+			memcpy(copies[_i + _j], views[_j].data, views[_j].size);
+		}
+	}
+	printf("%10zu lines: %8.1f ms with a copy of every line\n", lines,
+		(bench_now() - _start) / 1e6);
+	while (_i > 0)
+		free(copies[--_i]);
+	free(copies);
+	return (0);
+}
+
+static int	bench_find(t_Manager *manager, size_t buffer_id, size_t lines,
+	size_t size)
+{
+	t_Command		cmd;
+	t_CmdFind		find_payload;
+	t_CmdGetLines	lines_payload;
+	t_LineView		views[BENCH_SCREEN];
+	t_Match			match;
+	double			_start;
+	double			_time;
+	size_t			_found;
+	size_t			_i;
+	size_t			_j;
+
+	memset(&find_payload, 0, sizeof(find_payload));
+	find_payload.buffer_id = buffer_id;
+	find_payload.data = BENCH_NEEDLE;
+	find_payload.size = strlen(BENCH_NEEDLE);
+	find_payload.count = 1;
+	find_payload.matches = &match;
+	cmd.id = CMD_WRITING_FIND;
+	cmd.payload = &find_payload;
+	_start = bench_now();
+	if (ERR_SUCCESS != manager_exec(manager, &cmd))
+		return (print_error("Find failed"), 1);
+	_time = bench_now() - _start;
+	printf("%10zu lines: %8.1f ms (%5.2f GB/s) with CMD_WRITING_FIND\n", lines,
+		_time / 1e6, size / _time);
+	lines_payload.buffer_id = buffer_id;
+	lines_payload.count = BENCH_SCREEN;
+	lines_payload.views = views;
+	cmd.id = CMD_WRITING_GET_LINES;
+	cmd.payload = &lines_payload;
+	_found = find_payload.out_count;
+	_start = bench_now();
+	for (_i = 0; _i < lines && 0 == _found; _i += lines_payload.out_count)
+	{
+		lines_payload.line = _i;
+		if (ERR_SUCCESS != manager_exec(manager, &cmd))
+			break ;
+		for (_j = 0; _j < lines_payload.out_count; _j++)
+			if (memmem(views[_j].data, views[_j].size, BENCH_NEEDLE,
+				find_payload.size))
+				_found++;
+	}
+	_time = bench_now() - _start;
+	printf("%10zu lines: %8.1f ms (%5.2f GB/s) with memmem on every line\n",
+		lines, _time / 1e6, size / _time);
+	return (0);
+}
+
+static int	bench_regex_find(t_Manager *manager, size_t buffer_id, size_t lines,
+	size_t size)
+{
+	t_Command		cmd;
+	t_CmdRegexFind	find_payload;
+	t_CmdGetLines	lines_payload;
+	t_LineView		views[BENCH_SCREEN];
+	t_Match			matches[BENCH_CHUNK];
+	regex_t			posix;
+	char			line[4096];
+	double			_start;
+	size_t			_found;
+	size_t			_i;
+	size_t			_j;
+
+	memset(&find_payload, 0, sizeof(find_payload));
+	find_payload.buffer_id = buffer_id;
+	find_payload.pattern = BENCH_PATTERN;
+	find_payload.size = strlen(BENCH_PATTERN);
+	find_payload.count = BENCH_CHUNK;
+	find_payload.matches = matches;
+	cmd.id = CMD_WRITING_REGEX_FIND;
+	cmd.payload = &find_payload;
+	_found = 0;
+	_start = bench_now();
+	do
+	{
+		if (ERR_SUCCESS != manager_exec(manager, &cmd))
+			return (regex_destroy(find_payload.regex), print_error("Regex find failed"), 1);
+		_found += find_payload.out_count;
+		find_payload.line = find_payload.out_line;
+		find_payload.index = find_payload.out_index;
+	}
+	while (false == find_payload.out_done);
+	printf("%10zu lines: %8.1f ms (%5.2f GB/s) with CMD_WRITING_REGEX_FIND, %zu matches\n",
+		lines, (bench_now() - _start) / 1e6, size / (bench_now() - _start), _found);
+	regex_destroy(find_payload.regex);
+	if (regcomp(&posix, BENCH_PATTERN, REG_EXTENDED))
+		return (print_error("regcomp failed"), 1);
+	lines_payload.buffer_id = buffer_id;
+	lines_payload.count = BENCH_SCREEN;
+	lines_payload.views = views;
+	cmd.id = CMD_WRITING_GET_LINES;
+	cmd.payload = &lines_payload;
+	_found = 0;
+	_start = bench_now();
+	for (_i = 0; _i < lines; _i += lines_payload.out_count)
+	{
+		lines_payload.line = _i;
+		if (ERR_SUCCESS != manager_exec(manager, &cmd))
+			break ;
+		for (_j = 0; _j < lines_payload.out_count && views[_j].size < sizeof(line); _j++)
+		{
+			memcpy(line, views[_j].data, views[_j].size);
+			line[views[_j].size] = '\0';
+			_found += (0 == regexec(&posix, line, 0, NULL, 0));
+		}
+	}
+	printf("%10zu lines: %8.1f ms (%5.2f GB/s) with regexec on every line, %zu lines\n",
+		lines, (bench_now() - _start) / 1e6, size / (bench_now() - _start), _found);
+	regfree(&posix);
+	return (0);
+}
+
+/**
+ * @brief Searches a text in all buffers, chunk by chunk.
+ * @param manager The manager.
+ * @param needle The searched text.
+ * @param found The count of matches.
+ * @return The time of the search in nanoseconds, or -1 on failure.
+*/
+static double	bench_find_all_query(t_Manager *manager, const char *needle,
+	size_t *found)
+{
+	t_Command		cmd;
+	t_CmdFindAll	payload;
+	t_BufferMatch	matches[BENCH_CHUNK];
+	double			_start;
+
+	memset(&payload, 0, sizeof(payload));
+	payload.data = needle;
+	payload.size = strlen(needle);
+	payload.count = BENCH_CHUNK;
+	payload.matches = matches;
+	cmd.id = CMD_WRITING_FIND_ALL;
+	cmd.payload = &payload;
+	*found = 0;
+	_start = bench_now();
+	do
+	{
+		if (ERR_SUCCESS != manager_exec(manager, &cmd))
+			return (-1);
+		*found += payload.out_count;
+		payload.buffer_id = payload.out_buffer_id;
+		payload.line = payload.out_line;
+		payload.index = payload.out_index;
+	}
+	while (false == payload.out_done);
+	return (bench_now() - _start);
+}
+
+/**
+ * @brief Searches texts in many open buffers, with and without their index.
+ * @return 0 on success, 1 on failure.
+*/
+static int	bench_find_all(void)
+{
+	static const char	*needles[] = {BENCH_NEEDLE, "tree_remove_list",
+		"bench_marker_137"};
+	t_Manager			*manager;
+	t_Command			cmd;
+	t_CmdSetIndex		index_payload;
+	t_CmdInsertRange	range_payload;
+	t_Command			marker_cmd;
+	t_CmdInsertData		marker_payload;
+	char				marker[32];
+	size_t				ids[BENCH_BUFFERS];
+	char				*text;
+	double				_time;
+	double				_start;
+	size_t				_size;
+	size_t				_found;
+	size_t				_i;
+	size_t				_j;
+
+	text = bench_read_files(BENCH_SOURCES, &_size);
+	manager = manager_init();
+	if (NULL == text || NULL == manager)
+		return (free(text), manager_clean(manager), print_error("Setup failed"), 1);
+	range_payload.line = 0;
+	range_payload.index = 0;
+	range_payload.data = text;
+	range_payload.size = _size;
+	cmd.id = CMD_WRITING_INSERT_RANGE;
+	cmd.payload = &range_payload;
+	marker_payload.line = 0;
+	marker_payload.index = 0;
+	marker_payload.data = marker;
+	marker_cmd.id = CMD_WRITING_INSERT_TEXT;
+	marker_cmd.payload = &marker_payload;
+	for (_i = 0; _i < BENCH_BUFFERS; _i++)
+	{
+		if (bench_fill_buffer(manager, 1, &ids[_i]))
+			return (free(text), manager_clean(manager), print_error("Fill failed"), 1);
+		range_payload.buffer_id = ids[_i];
+		marker_payload.buffer_id = ids[_i];
+		marker_payload.size = snprintf(marker, sizeof(marker),
+			"bench_marker_%zu ", _i);
+		if (ERR_SUCCESS != manager_exec(manager, &cmd)
+			|| ERR_SUCCESS != manager_exec(manager, &marker_cmd))
+			return (free(text), manager_clean(manager), print_error("Fill failed"), 1);
+	}
+	for (_j = 0; _j < 3; _j++)
+	{
+		_time = bench_find_all_query(manager, needles[_j], &_found);
+		printf("%10d buffers: %8.2f ms, %zu matches of \"%s\" without index\n",
+			BENCH_BUFFERS, _time / 1e6, _found, needles[_j]);
+	}
+	index_payload.enable = true;
+	cmd.id = CMD_WRITING_SET_INDEX;
+	cmd.payload = &index_payload;
+	_start = bench_now();
+	for (_i = 0; _i < BENCH_BUFFERS; _i++)
+	{
+		index_payload.buffer_id = ids[_i];
+		if (ERR_SUCCESS != manager_exec(manager, &cmd))
+			return (free(text), manager_clean(manager), print_error("Index failed"), 1);
+	}
+	printf("%10d buffers: %8.2f ms to build the index\n", BENCH_BUFFERS,
+		(bench_now() - _start) / 1e6);
+	for (_j = 0; _j < 3; _j++)
+	{
+		_time = 0;
+		for (_i = 0; _i < BENCH_QUERIES; _i++)
+			_time += bench_find_all_query(manager, needles[_j], &_found);
+		printf("%10d buffers: %8.2f ms, %zu matches of \"%s\" with index\n",
+			BENCH_BUFFERS, _time / BENCH_QUERIES / 1e6, _found, needles[_j]);
+	}
+	free(text);
+	manager_clean(manager);
+	return (0);
+}
+
+/**
+ * @brief Replaces a text in a buffer one match at a time, with a find pass
+ * then delete and insert commands from the last match.
+ * @param manager The manager.
+ * @param buffer_id The buffer.
+ * @param count The count of replacements.
+ * @return 0 on success, 1 on failure.
+*/
+static int	bench_replace_edits(t_Manager *manager, size_t buffer_id,
+	size_t *count)
+{
+	t_Command		cmd;
+	t_CmdFind		find_payload;
+	t_CmdDeleteData	delete_payload;
+	t_CmdInsertData	insert_payload;
+	t_Match			*matches;
+	t_Match			*_new;
+	size_t			_capacity;
+	size_t			_i;
+
+	_capacity = BENCH_CHUNK;
+	matches = malloc(_capacity * sizeof(t_Match));
+	TEST_NULL(matches, 1);
+	memset(&find_payload, 0, sizeof(find_payload));
+	find_payload.buffer_id = buffer_id;
+	find_payload.data = BENCH_REPLACED;
+	find_payload.size = strlen(BENCH_REPLACED);
+	cmd.id = CMD_WRITING_FIND;
+	cmd.payload = &find_payload;
+	for (*count = 0;; *count += find_payload.out_count)
+	{
+		if (*count + BENCH_CHUNK > _capacity)
+		{
+			_capacity *= 2;
+			_new = realloc(matches, _capacity * sizeof(t_Match));
+			if (NULL == _new)
+				return (free(matches), 1);
+			matches = _new;
+		}
+		find_payload.matches = matches + *count;
+		find_payload.count = BENCH_CHUNK;
+		if (ERR_SUCCESS != manager_exec(manager, &cmd))
+			return (free(matches), 1);
+		if (find_payload.out_count < BENCH_CHUNK)
+			break ;
+		find_payload.line = matches[*count + BENCH_CHUNK - 1].line;
+		find_payload.index = matches[*count + BENCH_CHUNK - 1].index
+			+ find_payload.size;
+	}
+	*count += find_payload.out_count;
+	delete_payload.buffer_id = buffer_id;
+	delete_payload.size = find_payload.size;
+	insert_payload.buffer_id = buffer_id;
+	insert_payload.data = BENCH_REPLACEMENT;
+	insert_payload.size = strlen(BENCH_REPLACEMENT);
+	for (_i = *count; _i-- > 0;)
+	{
+		delete_payload.line = matches[_i].line;
+		delete_payload.index = matches[_i].index;
+		insert_payload.line = matches[_i].line;
+		insert_payload.index = matches[_i].index;
+		cmd.id = CMD_WRITING_DELETE_TEXT;
+		cmd.payload = &delete_payload;
+		if (ERR_SUCCESS != manager_exec(manager, &cmd))
+			return (free(matches), 1);
+		cmd.id = CMD_WRITING_INSERT_TEXT;
+		cmd.payload = &insert_payload;
+		if (ERR_SUCCESS != manager_exec(manager, &cmd))
+			return (free(matches), 1);
+	}
+	free(matches);
+	return (0);
+}
+
+/**
+ * @brief Replaces every match of a text and a regex in a buffer of code.
+ * @return 0 on success, 1 on failure.
+*/
+static int	bench_replace_all(void)
+{
+	t_Manager			*manager;
+	t_Command			cmd;
+	t_CmdInsertRange	range_payload;
+	t_CmdReplaceAll		replace_payload;
+	t_CmdHistory		history_payload;
+	size_t				buffer_id;
+	char				*text;
+	double				_start;
+	size_t				_size;
+	size_t				_count;
+
+	text = bench_read_files(BENCH_SOURCES, &_size);
+	manager = manager_init();
+	if (NULL == text || NULL == manager || bench_fill_buffer(manager, 1, &buffer_id))
+		return (free(text), manager_clean(manager), print_error("Setup failed"), 1);
+	range_payload.buffer_id = buffer_id;
+	range_payload.line = 0;
+	range_payload.index = 0;
+	range_payload.data = text;
+	range_payload.size = _size;
+	cmd.id = CMD_WRITING_INSERT_RANGE;
+	cmd.payload = &range_payload;
+	for (_count = 0; _count < BENCH_COPIES; _count++)
+		if (ERR_SUCCESS != manager_exec(manager, &cmd))
+			return (free(text), manager_clean(manager), print_error("Fill failed"), 1);
+	memset(&replace_payload, 0, sizeof(replace_payload));
+	replace_payload.buffer_id = buffer_id;
+	replace_payload.data = BENCH_REPLACED;
+	replace_payload.size = strlen(BENCH_REPLACED);
+	replace_payload.replacement = BENCH_REPLACEMENT;
+	replace_payload.replacement_size = strlen(BENCH_REPLACEMENT);
+	cmd.id = CMD_WRITING_REPLACE_ALL;
+	cmd.payload = &replace_payload;
+	_start = bench_now();
+	if (ERR_SUCCESS != manager_exec(manager, &cmd))
+		return (free(text), manager_clean(manager), print_error("Replace failed"), 1);
+	printf("%10zu matches: %8.2f ms on %zu lines with CMD_WRITING_REPLACE_ALL\n",
+		replace_payload.out_count, (bench_now() - _start) / 1e6,
+		replace_payload.out_lines);
+	history_payload.buffer_id = buffer_id;
+	cmd.id = CMD_WRITING_UNDO;
+	cmd.payload = &history_payload;
+	_start = bench_now();
+	if (ERR_SUCCESS != manager_exec(manager, &cmd))
+		return (free(text), manager_clean(manager), print_error("Undo failed"), 1);
+	printf("%10zu matches: %8.2f ms to undo the replace\n",
+		replace_payload.out_count, (bench_now() - _start) / 1e6);
+	_start = bench_now();
+	if (bench_replace_edits(manager, buffer_id, &_count))
+		return (free(text), manager_clean(manager), print_error("Edits failed"), 1);
+	printf("%10zu matches: %8.2f ms with find, delete and insert commands\n",
+		_count, (bench_now() - _start) / 1e6);
+	cmd.id = CMD_WRITING_REPLACE_ALL;
+	cmd.payload = &replace_payload;
+	replace_payload.data = BENCH_PATTERN;
+	replace_payload.size = strlen(BENCH_PATTERN);
+	replace_payload.is_regex = true;
+	_start = bench_now();
+	if (ERR_SUCCESS != manager_exec(manager, &cmd))
+		return (free(text), manager_clean(manager), print_error("Replace failed"), 1);
+	printf("%10zu matches: %8.2f ms on %zu lines with a regex\n",
+		replace_payload.out_count, (bench_now() - _start) / 1e6,
+		replace_payload.out_lines);
+	for (_count = 0; _count < _size; _count++)
+		if ('\n' == text[_count])
+			text[_count] = ' ';
+	if (bench_fill_buffer(manager, 1, &buffer_id))
+		return (free(text), manager_clean(manager), print_error("Fill failed"), 1);
+	range_payload.buffer_id = buffer_id;
+	cmd.id = CMD_WRITING_INSERT_RANGE;
+	cmd.payload = &range_payload;
+	if (ERR_SUCCESS != manager_exec(manager, &cmd))
+		return (free(text), manager_clean(manager), print_error("Fill failed"), 1);
+	replace_payload.buffer_id = buffer_id;
+	replace_payload.data = BENCH_REPLACED;
+	replace_payload.size = strlen(BENCH_REPLACED);
+	replace_payload.is_regex = false;
+	cmd.id = CMD_WRITING_REPLACE_ALL;
+	cmd.payload = &replace_payload;
+	_start = bench_now();
+	if (ERR_SUCCESS != manager_exec(manager, &cmd))
+		return (free(text), manager_clean(manager), print_error("Replace failed"), 1);
+	printf("%10zu matches: %8.2f ms on a %zu bytes line with CMD_WRITING_REPLACE_ALL\n",
+		replace_payload.out_count, (bench_now() - _start) / 1e6, _size);
+	cmd.id = CMD_WRITING_UNDO;
+	cmd.payload = &history_payload;
+	history_payload.buffer_id = buffer_id;
+	if (ERR_SUCCESS != manager_exec(manager, &cmd))
+		return (free(text), manager_clean(manager), print_error("Undo failed"), 1);
+	_start = bench_now();
+	if (bench_replace_edits(manager, buffer_id, &_count))
+		return (free(text), manager_clean(manager), print_error("Edits failed"), 1);
+	printf("%10zu matches: %8.2f ms on a %zu bytes line with find, delete and insert commands\n",
+		_count, (bench_now() - _start) / 1e6, _size);
+	free(text);
+	manager_clean(manager);
+	return (0);
+}
+
+/**
+ * @brief Converts random byte offsets to positions and back, against a sum
+ * of the line sizes from the first line.
+ * @param manager The manager.
+ * @param buffer_id The buffer.
+ * @param lines The count of lines.
+ * @param size The size of the buffer text.
+ * @return 0 on success, 1 on failure.
+*/
+static int	bench_offsets(t_Manager *manager, size_t buffer_id, size_t lines,
+	size_t size)
+{
+	t_Command			cmd;
+	t_CmdOffsetToPos	offset_payload;
+	t_CmdPosToOffset	pos_payload;
+	t_CmdGetLines		lines_payload;
+	t_LineView			views[BENCH_SCREEN];
+	double				_start;
+	size_t				_offset;
+	size_t				_i;
+	size_t				_j;
+
+	offset_payload.buffer_id = buffer_id;
+	pos_payload.buffer_id = buffer_id;
+	srand(3);
+	_start = bench_now();
+	for (_i = 0; _i < BENCH_OFFSETS; _i++)
+	{
+		offset_payload.offset = ((size_t)rand() * RAND_MAX + rand()) % size;
+		cmd.id = CMD_WRITING_OFFSET_TO_POS;
+		cmd.payload = &offset_payload;
+		if (ERR_SUCCESS != manager_exec(manager, &cmd))
+			return (print_error("Offset to position failed"), 1);
+		pos_payload.line = offset_payload.out_line;
+		pos_payload.index = offset_payload.out_index;
+		cmd.id = CMD_WRITING_POS_TO_OFFSET;
+		cmd.payload = &pos_payload;
+		if (ERR_SUCCESS != manager_exec(manager, &cmd))
+			return (print_error("Position to offset failed"), 1);
+	}
+	printf("%10zu lines: %8.1f ns per offset and back\n", lines,
+		(bench_now() - _start) / BENCH_OFFSETS);
+	lines_payload.buffer_id = buffer_id;
+	lines_payload.count = BENCH_SCREEN;
+	lines_payload.views = views;
+	cmd.id = CMD_WRITING_GET_LINES;
+	cmd.payload = &lines_payload;
+	_offset = 0;
+	_start = bench_now();
+	for (_i = 0; _i < lines; _i += lines_payload.out_count)
+	{
+		lines_payload.line = _i;
+		if (ERR_SUCCESS != manager_exec(manager, &cmd))
+			break ;
+		for (_j = 0; _j < lines_payload.out_count; _j++)
+			_offset += views[_j].size + 1;
+	}
+	printf("%10zu lines: %8.1f ms to sum the sizes of %zu bytes from the first line\n",
+		lines, (bench_now() - _start) / 1e6, _offset);
+	return (0);
+}
+
+/**
+ * @brief Get the byte of a UTF-16 column by scanning the line from its start.
+ * @param data The line.
+ * @param size The line size.
+ * @param column The column.
+ * @return The byte.
+*/
+static size_t	bench_utf16_scan(const char *data, size_t size, size_t column)
+{
+	size_t	_i;
+
+	for (_i = 0; _i < size && column > 0; _i++)
+	{
+		if (0x80 == (data[_i] & 0xC0))
+			continue ;
+		column -= (unsigned char)data[_i] >= 0xF0 ? 2 : 1;
+	}
+	while (_i < size && 0x80 == (data[_i] & 0xC0))
+		_i++;
+	return (_i);
+}
+
+/**
+ * @brief Get the display width of a line, the way a frontend scans it.
+ * @param data The line data.
+ * @param size The line size.
+ * @return The count of columns.
+*/
+static size_t	bench_width_scan(const char *data, size_t size)
+{
+	size_t	_column;
+	size_t	_cells;
+	size_t	_i;
+
+	_column = 0;
+	for (_i = 0; _i < size; _column += _cells)
+		_i += width_cluster(data + _i, size - _i, _column, BENCH_TAB, &_cells);
+	return (_column);
+}
+
+/**
+ * @brief Measures the time to get the display width of each line of a
+ * screen, with CMD_WRITING_CONVERT_COLUMNS and with a scan of the lines.
+ * @return 0 on success, 1 on failure.
+*/
+static int	bench_convert_columns(void)
+{
+	t_Manager			*manager;
+	t_Command			cmd;
+	t_CmdInsertRange	range_payload;
+	t_CmdConvertColumns	payload;
+	t_CmdGetLines		lines_payload;
+	t_ColumnPosition	positions[BENCH_SCREEN];
+	t_LineView			views[BENCH_SCREEN];
+	char				*text;
+	double				_start;
+	size_t				_size;
+	size_t				_sum;
+	size_t				_i;
+	size_t				_j;
+
+	text = malloc(BENCH_COLUMN_LINES
+		* (sizeof(BENCH_LINE_TEXT) + sizeof(BENCH_WIDE_TEXT)));
+	manager = manager_init();
+	if (NULL == text || NULL == manager
+		|| bench_fill_buffer(manager, 1, &range_payload.buffer_id))
+		return (free(text), manager_clean(manager), print_error("Setup failed"), 1);
+	_size = 0;
+	for (_i = 0; _i < BENCH_COLUMN_LINES; _i++)
+	{
+		_size += sprintf(text + _size, "%s\n",
+			_i % 4 ? BENCH_LINE_TEXT + 1 : BENCH_WIDE_TEXT);
+	}
+	range_payload.line = 0;
+	range_payload.index = 0;
+	range_payload.data = text;
+	range_payload.size = _size;
+	cmd.id = CMD_WRITING_INSERT_RANGE;
+	cmd.payload = &range_payload;
+	if (ERR_SUCCESS != manager_exec(manager, &cmd))
+		return (free(text), manager_clean(manager), print_error("Fill failed"), 1);
+	payload = (t_CmdConvertColumns){.buffer_id = range_payload.buffer_id,
+		.tab_size = BENCH_TAB, .count = BENCH_SCREEN, .positions = positions};
+	cmd.id = CMD_WRITING_CONVERT_COLUMNS;
+	cmd.payload = &payload;
+	srand(42);
+	_start = bench_now();
+	for (_i = 0; _i < BENCH_REPAINTS; _i++)
+	{
+		_size = (size_t)rand() % (BENCH_COLUMN_LINES - BENCH_SCREEN);
+		for (_j = 0; _j < BENCH_SCREEN; _j++)
+			positions[_j] = (t_ColumnPosition){.line = _size + _j,
+				.column = UTF_NPOS};
+		if (ERR_SUCCESS != manager_exec(manager, &cmd))
+			return (free(text), manager_clean(manager), print_error("Convert failed"), 1);
+	}
+	printf("%10d lines: %8.1f ns/screen with CMD_WRITING_CONVERT_COLUMNS\n",
+		BENCH_SCREEN, (bench_now() - _start) / BENCH_REPAINTS);
+	lines_payload = (t_CmdGetLines){.buffer_id = range_payload.buffer_id,
+		.count = BENCH_SCREEN, .views = views};
+	cmd.id = CMD_WRITING_GET_LINES;
+	cmd.payload = &lines_payload;
+	srand(42);
+	_sum = 0;
+	_start = bench_now();
+	for (_i = 0; _i < BENCH_REPAINTS; _i++)
+	{
+		lines_payload.line = (size_t)rand() % (BENCH_COLUMN_LINES - BENCH_SCREEN);
+		if (ERR_SUCCESS != manager_exec(manager, &cmd))
+			return (free(text), manager_clean(manager), print_error("Get lines failed"), 1);
+		for (_j = 0; _j < BENCH_SCREEN; _j++)
+			_sum += bench_width_scan(views[_j].data, views[_j].size);
+	}
+	printf("%10d lines: %8.1f ns/screen with a scan of each line (%zu columns)\n",
+		BENCH_SCREEN, (bench_now() - _start) / BENCH_REPAINTS, _sum / BENCH_REPAINTS);
+	free(text);
+	manager_clean(manager);
+	return (0);
+}
+
+/**
+ * @brief Wraps the buffer and looks up random rows and their positions,
+ * against a sum of the row counts of the lines from the first line.
+ * @param manager The manager.
+ * @param buffer_id The buffer.
+ * @param lines The count of lines.
+ * @return 0 on success, 1 on failure.
+*/
+static int	bench_wrap(t_Manager *manager, size_t buffer_id, size_t lines)
+{
+	t_Command		cmd;
+	t_CmdSetWrap	wrap_payload;
+	t_CmdRowToPos	row_payload;
+	t_CmdPosToRow	pos_payload;
+	t_CmdGetLines	lines_payload;
+	t_LineView		views[BENCH_SCREEN];
+	double			_start;
+	size_t			_rows;
+	size_t			_i;
+	size_t			_j;
+
+	wrap_payload = (t_CmdSetWrap){.buffer_id = buffer_id, .width = BENCH_WRAP,
+		.tab_size = BENCH_TAB};
+	cmd.id = CMD_WRITING_SET_WRAP;
+	cmd.payload = &wrap_payload;
+	_start = bench_now();
+	if (ERR_SUCCESS != manager_exec(manager, &cmd))
+		return (print_error("Set wrap failed"), 1);
+	printf("%10zu rows: %8.1f ms with CMD_WRITING_SET_WRAP\n",
+		wrap_payload.out_rows, (bench_now() - _start) / 1e6);
+	row_payload.buffer_id = buffer_id;
+	pos_payload.buffer_id = buffer_id;
+	srand(5);
+	_start = bench_now();
+	for (_i = 0; _i < BENCH_ROWS; _i++)
+	{
+		row_payload.row = ((size_t)rand() * RAND_MAX + rand())
+			% wrap_payload.out_rows;
+		cmd.id = CMD_WRITING_ROW_TO_POS;
+		cmd.payload = &row_payload;
+		if (ERR_SUCCESS != manager_exec(manager, &cmd))
+			return (print_error("Row to position failed"), 1);
+		pos_payload.line = row_payload.out_line;
+		pos_payload.index = row_payload.out_index;
+		cmd.id = CMD_WRITING_POS_TO_ROW;
+		cmd.payload = &pos_payload;
+		if (ERR_SUCCESS != manager_exec(manager, &cmd)
+			|| pos_payload.out_row != row_payload.row)
+			return (print_error("Position to row failed"), 1);
+	}
+	printf("%10zu lines: %8.1f ns per row and back\n", lines,
+		(bench_now() - _start) / BENCH_ROWS);
+	lines_payload = (t_CmdGetLines){.buffer_id = buffer_id,
+		.count = BENCH_SCREEN, .views = views};
+	cmd.id = CMD_WRITING_GET_LINES;
+	cmd.payload = &lines_payload;
+	_rows = 0;
+	_start = bench_now();
+	for (_i = 0; _i < lines; _i += lines_payload.out_count)
+	{
+		lines_payload.line = _i;
+		if (ERR_SUCCESS != manager_exec(manager, &cmd))
+			break ;
+		for (_j = 0; _j < lines_payload.out_count; _j++)
+			_rows += (bench_width_scan(views[_j].data, views[_j].size)
+				+ BENCH_WRAP - 1) / BENCH_WRAP + (0 == views[_j].size);
+	}
+	printf("%10zu lines: %8.1f ms to sum the rows of the lines from the first line (%zu rows)\n",
+		lines, (bench_now() - _start) / 1e6, _rows);
+	wrap_payload.width = 0;
+	cmd.id = CMD_WRITING_SET_WRAP;
+	cmd.payload = &wrap_payload;
+	return (ERR_SUCCESS != manager_exec(manager, &cmd));
+}
+
+/**
+ * @brief Converts the UTF-16 columns of diagnostics to bytes in one command,
+ * against a lookup and a scan of the line for each of them.
+ * @return 0 on success, 1 on failure.
+*/
+static int	bench_convert_utf16(void)
+{
+	t_Manager			*manager;
+	t_Command			cmd;
+	t_CmdInsertRange	range_payload;
+	t_CmdConvertUtf16	payload;
+	t_CmdGetLine		line_payload;
+	t_Utf16Position		*positions;
+	char				*text;
+	double				_start;
+	size_t				_size;
+	size_t				_sum;
+	size_t				_i;
+
+	text = malloc(BENCH_UTF16_LINES * (sizeof(BENCH_UTF16_TEXT) * 8 + 1));
+	positions = malloc(BENCH_DIAGNOSTICS * sizeof(t_Utf16Position));
+	manager = manager_init();
+	if (NULL == text || NULL == positions || NULL == manager
+		|| bench_fill_buffer(manager, 1, &range_payload.buffer_id))
+		return (free(text), free(positions), manager_clean(manager), print_error("Setup failed"), 1);
+	_size = 0;
+	for (_i = 0; _i < BENCH_UTF16_LINES * 8; _i++)
+	{
+		memcpy(text + _size, BENCH_UTF16_TEXT, sizeof(BENCH_UTF16_TEXT) - 1);
+		_size += sizeof(BENCH_UTF16_TEXT) - 1;
+		if (_i % 8 == 7)
+			text[_size++] = '\n';
+	}
+	range_payload.line = 0;
+	range_payload.index = 0;
+	range_payload.data = text;
+	range_payload.size = _size;
+	cmd.id = CMD_WRITING_INSERT_RANGE;
+	cmd.payload = &range_payload;
+	if (ERR_SUCCESS != manager_exec(manager, &cmd))
+		return (free(text), free(positions), manager_clean(manager), print_error("Fill failed"), 1);
+	for (_i = 0; _i < BENCH_DIAGNOSTICS; _i++)
+		positions[_i] = (t_Utf16Position){.line = _i * BENCH_UTF16_LINES
+			/ BENCH_DIAGNOSTICS, .column = _i * 37 % 80};
+	payload.buffer_id = range_payload.buffer_id;
+	payload.to_utf16 = false;
+	payload.count = BENCH_DIAGNOSTICS;
+	payload.positions = positions;
+	cmd.id = CMD_WRITING_CONVERT_UTF16;
+	cmd.payload = &payload;
+	_start = bench_now();
+	if (ERR_SUCCESS != manager_exec(manager, &cmd))
+		return (free(text), free(positions), manager_clean(manager), print_error("Convert failed"), 1);
+	printf("%10d positions: %8.2f ms with CMD_WRITING_CONVERT_UTF16\n",
+		BENCH_DIAGNOSTICS, (bench_now() - _start) / 1e6);
+	line_payload.buffer_id = range_payload.buffer_id;
+	cmd.id = CMD_WRITING_GET_LINE;
+	cmd.payload = &line_payload;
+	_sum = 0;
+	_start = bench_now();
+	for (_i = 0; _i < BENCH_DIAGNOSTICS; _i++)
+	{
+		line_payload.line = positions[_i].line;
+		if (ERR_SUCCESS != manager_exec(manager, &cmd))
+			break ;
+		_sum += bench_utf16_scan(line_payload.out_data, line_payload.out_size,
+			positions[_i].column) != positions[_i].byte;
+	}
+	printf("%10d positions: %8.2f ms with a line lookup and a scan each, %zu differ\n",
+		BENCH_DIAGNOSTICS, (bench_now() - _start) / 1e6, _sum);
+	free(text);
+	free(positions);
+	manager_clean(manager);
+	return (0);
+}
+
+/**
+ * @brief Measures the time to take a snapshot of buffers of growing size
+ * where every line was typed, then the time of a keystroke followed by a
+ * snapshot while the previous snapshots are kept: both must stay flat.
+ * @return 0 on success, 1 on failure.
+*/
+static int	bench_snapshot_edited(void)
+{
+	t_Manager		*manager;
+	t_Command		cmd;
+	t_CmdInsertData	payload;
+	t_CmdSnapshot	snapshot_payload;
+	t_Snapshot		*snapshots[BENCH_SNAPSHOTS];
+	double			_start;
+	size_t			buffer_id;
+	size_t			lines;
+	size_t			_i;
+
+	for (lines = BENCH_FILE_LINES / 100; lines <= BENCH_FILE_LINES; lines *= 10)
+	{
+		manager = manager_init();
+		if (NULL == manager || bench_fill_buffer(manager, lines, &buffer_id))
+			return (manager_clean(manager), print_error("Setup failed"), 1);
+		payload.buffer_id = buffer_id;
+		payload.index = 0;
+		payload.size = strlen(BENCH_LINE_TEXT);
+		payload.data = BENCH_LINE_TEXT;
+		cmd.id = CMD_WRITING_INSERT_TEXT;
+		cmd.payload = &payload;
+		for (payload.line = 0; (size_t)payload.line < lines; payload.line++)
+		{
+			if (ERR_SUCCESS != manager_exec(manager, &cmd))
+				return (manager_clean(manager), print_error("Insert failed"), 1);
+		}
+		if (bench_snapshot(manager, buffer_id, lines))
+			return (manager_clean(manager), 1);
+		snapshot_payload.buffer_id = buffer_id;
+		payload.size = 1;
+		_start = bench_now();
+		for (_i = 0; _i < BENCH_SNAPSHOTS; _i++)
+		{
+			payload.line = (_i * 7919) % lines;
+			cmd.id = CMD_WRITING_INSERT_TEXT;
+			cmd.payload = &payload;
+			manager_exec(manager, &cmd);
+			cmd.id = CMD_WRITING_SNAPSHOT;
+			cmd.payload = &snapshot_payload;
+			if (ERR_SUCCESS != manager_exec(manager, &cmd))
+				break ;
+			snapshots[_i] = snapshot_payload.out_snapshot;
+		}
+		printf("%10zu lines: %8.0f ns per keystroke and snapshot, all kept\n",
+			lines, (bench_now() - _start) / BENCH_SNAPSHOTS);
+		while (_i > 0)
+			snapshot_release(snapshots[--_i]);
+		manager_clean(manager);
+	}
+	return (0);
+}
+
+/**
+ * @brief Searches a regex whose every match may be read to the end of the
+ * line, on lines 4 times longer each time: the time must grow as the line.
+ * @return 0 on success, 1 on failure.
+*/
+static int	bench_regex_worst(void)
+{
+	t_Manager		*manager;
+	t_Command		cmd;
+	t_CmdInsertData	insert_payload;
+	t_CmdRegexFind	find_payload;
+	t_Match			matches[BENCH_CHUNK];
+	char			*_line;
+	double			_start;
+	size_t			_found;
+	size_t			_size;
+
+	_line = malloc(BENCH_WORST_SIZE * 16);
+	TEST_NULL(_line, 1);
+	memset(_line, 'x', BENCH_WORST_SIZE * 16);
+	for (_size = BENCH_WORST_SIZE; _size <= BENCH_WORST_SIZE * 16; _size *= 4)
+	{
+		manager = manager_init();
+		memset(&find_payload, 0, sizeof(find_payload));
+		if (NULL == manager
+			|| bench_fill_buffer(manager, 1, &find_payload.buffer_id))
+			return (free(_line), manager_clean(manager), print_error("Setup failed"), 1);
+		insert_payload = (t_CmdInsertData){.buffer_id = find_payload.buffer_id,
+			.line = 0, .index = 0, .size = _size, .data = _line};
+		cmd.id = CMD_WRITING_INSERT_TEXT;
+		cmd.payload = &insert_payload;
+		if (ERR_SUCCESS != manager_exec(manager, &cmd))
+			return (free(_line), manager_clean(manager), print_error("Insert failed"), 1);
+		find_payload.pattern = BENCH_WORST_PATTERN;
+		find_payload.size = strlen(BENCH_WORST_PATTERN);
+		find_payload.count = BENCH_CHUNK;
+		find_payload.matches = matches;
+		cmd.id = CMD_WRITING_REGEX_FIND;
+		cmd.payload = &find_payload;
+		_found = 0;
+		_start = bench_now();
+		do
+		{
+			if (ERR_SUCCESS != manager_exec(manager, &cmd))
+				return (free(_line), regex_destroy(find_payload.regex),
+					manager_clean(manager), print_error("Regex find failed"), 1);
+			_found += find_payload.out_count;
+			find_payload.line = find_payload.out_line;
+			find_payload.index = find_payload.out_index;
+		}
+		while (false == find_payload.out_done);
+		printf("%10zu bytes: %8.1f ms with CMD_WRITING_REGEX_FIND \"%s\", %zu matches\n",
+			_size, (bench_now() - _start) / 1e6, BENCH_WORST_PATTERN, _found);
+		regex_destroy(find_payload.regex);
+		manager_clean(manager);
+	}
+	free(_line);
+	return (0);
+}
+
+/**
+ * @brief Measures the time to open a file in a buffer, with the load command
+ * and with a read followed by one command per line.
+ * @return 0 on success, 1 on failure.
+*/
+static int	bench_file_load(void)
+{
+	t_Manager		*manager;
+	t_Command		cmd;
+	t_CmdOpenRoot	open_payload;
+	t_CmdLoadFile	load_payload;
+	t_CmdReadFile	read_payload;
+	t_CmdSaveBuffer	save_payload;
+	char			path[512];
+	char			copy_path[512];
+	char			*text;
+	char			*dir;
+	FILE			*file;
+	size_t			_size;
+	size_t			_written;
+	double			_start;
+	int				status;
+
+	text = bench_read_files(BENCH_SOURCES, &_size);
+	dir = test_tmpdir_create("/tmp/seed_bench");
+	manager = manager_init();
+	if (NULL == text || NULL == dir || NULL == manager)
+		return (free(text), free(dir), manager_clean(manager), print_error("Setup failed"), 1);
+	snprintf(path, sizeof(path), "%s/file.c", dir);
+	snprintf(copy_path, sizeof(copy_path), "%s/concat.c", dir);
+	file = fopen(path, "w");
+	for (_written = 0; file && _written < (size_t)BENCH_FILE_LINES * 24; _written += _size)
+		fwrite(text, 1, _size, file);
+	if (file)
+		fclose(file);
+	status = 1;
+	open_payload.path = dir;
+	cmd.id = CMD_FS_OPEN_ROOT;
+	cmd.payload = &open_payload;
+	if (NULL == file || ERR_SUCCESS != manager_exec(manager, &cmd))
+		print_error("Failed to open root");
+	else
+	{
+		load_payload.path = "file.c";
+		cmd.id = CMD_WRITING_LOAD_FILE;
+		cmd.payload = &load_payload;
+		_start = bench_now();
+		if (ERR_SUCCESS == manager_exec(manager, &cmd))
+		{
+			printf("%10zu lines: %8.1f ms with CMD_WRITING_LOAD_FILE\n",
+				load_payload.out_lines, (bench_now() - _start) / 1e6);
+			save_payload.buffer_id = load_payload.out_buffer_id;
+			save_payload.path = "copy.c";
+			cmd.id = CMD_WRITING_SAVE_BUFFER;
+			cmd.payload = &save_payload;
+			_start = bench_now();
+			if (ERR_SUCCESS == manager_exec(manager, &cmd))
+				printf("%10zu bytes: %8.1f ms with CMD_WRITING_SAVE_BUFFER\n",
+					save_payload.out_size, (bench_now() - _start) / 1e6);
+			_start = bench_now();
+			if (0 == bench_concat_save(manager, load_payload.out_buffer_id,
+					load_payload.out_lines, copy_path))
+				printf("%10zu bytes: %8.1f ms with line copies in one block\n",
+					save_payload.out_size, (bench_now() - _start) / 1e6);
+			bench_snapshot(manager, load_payload.out_buffer_id, load_payload.out_lines);
+			bench_find(manager, load_payload.out_buffer_id, load_payload.out_lines,
+				_written);
+			bench_regex_find(manager, load_payload.out_buffer_id,
+				load_payload.out_lines, _written);
+			bench_offsets(manager, load_payload.out_buffer_id,
+				load_payload.out_lines, _written);
+			bench_wrap(manager, load_payload.out_buffer_id,
+				load_payload.out_lines);
+			read_payload.path = "file.c";
+			read_payload.out_data = NULL;
+			cmd.id = CMD_FS_READ_FILE;
+			cmd.payload = &read_payload;
+			_start = bench_now();
+			if (ERR_SUCCESS == manager_exec(manager, &cmd)
+				&& 0 == bench_replay_file(manager, read_payload.out_data,
+					read_payload.out_len))
+			{
+				printf("%10zu lines: %8.1f ms with read and line commands\n",
+					load_payload.out_lines, (bench_now() - _start) / 1e6);
+				status = 0;
+			}
+			free(read_payload.out_data);
+		}
+		if (status)
+			print_error("Load failed");
+	}
+	manager_clean(manager);
+	test_tmpdir_remove(dir);
+	free(dir);
+	free(text);
+	return (status);
+}
+
+int	main(int argc, char **argv)
+{
+	size_t	max_lines;
+	size_t	lines;
+	int		status;
+
+	max_lines = BENCH_DEFAULT_MAX;
+	if (argc > 1)
+		max_lines = strtoul(argv[1], NULL, 10);
+	status = 0;
+	print_section("EDIT LATENCY");
+	for (lines = 1000; lines <= max_lines && 0 == status; lines *= 10)
+		status |= bench_edit_latency(lines);
+	print_section("LONG LINE TYPING");
+	status |= bench_long_line_typing();
+	print_section("COMMAND TYPING (1 MiB LINE)");
+	status |= bench_command_typing("ASCII", "abc", "x");
+	status |= bench_command_typing("UTF-8", "\xC3\xA9x", "\xC3\xA9");
+	print_section("PASTE");
+	status |= bench_paste();
+	print_section("REPAINT (80 LINES)");
+	status |= bench_repaint(BENCH_FILE_LINES);
+	print_section("MULTI-CURSOR EDIT");
+	status |= bench_multi_edit(BENCH_FILE_LINES, 1);
+	status |= bench_multi_edit(BENCH_FILE_LINES, 200);
+	print_section("CHANGE SYNC");
+	status |= bench_apply_changes(BENCH_FILE_LINES, 2);
+	status |= bench_apply_changes(BENCH_FILE_LINES, 200);
+	print_section("RANGE DELETE");
+	status |= bench_delete(BENCH_FILE_LINES);
+	print_section("UTF-8 KERNELS");
+	status |= bench_utf8_kernels();
+	print_section("FIND IN OPEN BUFFERS");
+	status |= bench_find_all();
+	print_section("REPLACE ALL");
+	status |= bench_replace_all();
+	print_section("UTF-16 POSITIONS");
+	status |= bench_convert_utf16();
+	print_section("DISPLAY COLUMNS");
+	status |= bench_convert_columns();
+	print_section("REGEX WORST CASE (ONE LINE)");
+	status |= bench_regex_worst();
+	print_section("FILE LOAD");
+	status |= bench_file_load();
+	print_section("SNAPSHOT (EVERY LINE TYPED)");
+	status |= bench_snapshot_edited();
+	print_section("FILE MEMORY");
+	status |= bench_file_memory();
+	print_section("MEMORY FOOTPRINT");
+	status |= bench_memory_footprint();
+	return (status);
+}
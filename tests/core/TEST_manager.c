@@ -19,8 +19,8 @@ static int	test_manager_init_state(void)
 	if (NULL == manager->fs_ctx)
 		return (manager_clean(manager), print_error("Filesystem context is NULL"), 1);
 	print_success("Filesystem context initialized");
-	if (manager->dispatcher->count != 19)
-		return (manager_clean(manager), print_error("Expected 19 registered commands"), 1);
+	if (manager->dispatcher->count != 41)
+		return (manager_clean(manager), print_error("Expected 41 registered commands"), 1);
 	print_success("All commands registered");
 	manager_clean(manager);
 	return (0);
@@ -1,5 +1,9 @@
 #include "tools.h"
 #include "seed.h"
+#include <pthread.h>
+#include <sys/mman.h>
+
+#define BIG_EDIT_SIZE (12 << 20)	/* More than half of the history budget */
 
 static int	create_buffer(t_Manager *manager, size_t *buffer_id)
 {
@@ -164,6 +168,11 @@ static int	test_text_commands(void)
 	cmd.payload = &ins_payload;
 	if (assert_error_code(manager_exec(manager, &cmd), ERR_LINE_NOT_FOUND, "Insert text rejected on missing line"))
 		return (manager_clean(manager), 1);
+	ins_payload.line = 0;
+	ins_payload.size = 3;
+	ins_payload.data = "a\xC3(";
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_INVALID_ENCODING, "Insert text rejected on invalid UTF-8"))
+		return (manager_clean(manager), 1);
 	del_payload.line = 0;
 	del_payload.index = 999;
 	del_payload.size = 1;
@@ -236,6 +245,1575 @@ static int	test_split_and_join_commands(void)
 	return (0);
 }
 
+static int	test_insert_range_command(void)
+{
+	t_Manager			*manager;
+	t_Command			cmd;
+	t_CmdInsertRange	range_payload;
+	t_CmdGetLine		get_payload;
+	size_t				buffer_id;
+	size_t				_i;
+	const char			*expected[] = {"ABCDx", "y", "", "z1234"};
+
+	print_section("WRITING INSERT RANGE COMMAND");
+	manager = manager_init();
+	if (NULL == manager)
+		return (print_error("Failed to initialize manager"), 1);
+	if (create_buffer(manager, &buffer_id) || insert_line(manager, buffer_id, 0)
+		|| insert_text(manager, buffer_id, 0, 0, "ABCD1234"))
+		return (manager_clean(manager), 1);
+	range_payload.buffer_id = buffer_id;
+	range_payload.line = 0;
+	range_payload.index = 4;
+	range_payload.data = "x\r\ny\n\nz";
+	range_payload.size = strlen(range_payload.data);
+	cmd.id = CMD_WRITING_INSERT_RANGE;
+	cmd.payload = &range_payload;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_SUCCESS, "Insert range"))
+		return (manager_clean(manager), 1);
+	if (3 != range_payload.out_line || 1 != range_payload.out_index)
+		return (manager_clean(manager), print_error("Range end mismatch"), 1);
+	get_payload.buffer_id = buffer_id;
+	cmd.id = CMD_WRITING_GET_LINE;
+	cmd.payload = &get_payload;
+	for (_i = 0; _i < 4; _i++)
+	{
+		get_payload.line = _i;
+		if (ERR_SUCCESS != manager_exec(manager, &cmd)
+			|| 0 != strcmp(get_payload.out_data, expected[_i]))
+			return (manager_clean(manager), print_error("Range content mismatch"), 1);
+	}
+	print_success("Range is split in lines without CR");
+	range_payload.line = 3;
+	range_payload.index = -1;
+	range_payload.data = "\xC3\xA9!";
+	range_payload.size = 3;
+	cmd.id = CMD_WRITING_INSERT_RANGE;
+	cmd.payload = &range_payload;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_SUCCESS, "Insert range without line ending"))
+		return (manager_clean(manager), 1);
+	if (3 != range_payload.out_line || 7 != range_payload.out_index)
+		return (manager_clean(manager), print_error("Range end mismatch"), 1);
+	print_success("Range end is given in characters");
+	range_payload.data = "\xC3";
+	range_payload.size = 1;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_INVALID_ENCODING, "Range rejected on invalid UTF-8"))
+		return (manager_clean(manager), 1);
+	range_payload.line = 9;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_LINE_NOT_FOUND, "Range rejected on invalid line"))
+		return (manager_clean(manager), 1);
+	manager_clean(manager);
+	return (0);
+}
+
+static int	test_delete_range_command(void)
+{
+	t_Manager			*manager;
+	t_Command			cmd;
+	t_CmdInsertRange	range_payload;
+	t_CmdDeleteRange	delete_payload;
+	t_CmdGetLine		get_payload;
+	size_t				buffer_id;
+
+	print_section("WRITING DELETE RANGE COMMAND");
+	manager = manager_init();
+	if (NULL == manager)
+		return (print_error("Failed to initialize manager"), 1);
+	if (create_buffer(manager, &buffer_id) || insert_line(manager, buffer_id, 0))
+		return (manager_clean(manager), 1);
+	range_payload.buffer_id = buffer_id;
+	range_payload.line = 0;
+	range_payload.index = 0;
+	range_payload.data = "h\xC3\xA9llo\nbig\nw\xC3\xB6rld";
+	range_payload.size = strlen(range_payload.data);
+	cmd.id = CMD_WRITING_INSERT_RANGE;
+	cmd.payload = &range_payload;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_SUCCESS, "Insert range"))
+		return (manager_clean(manager), 1);
+	delete_payload.buffer_id = buffer_id;
+	delete_payload.line = 2;
+	delete_payload.index = 0;
+	delete_payload.end_line = 0;
+	delete_payload.end_index = 2;
+	cmd.id = CMD_WRITING_DELETE_RANGE;
+	cmd.payload = &delete_payload;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_INVALID_PAYLOAD, "Delete range rejected on reversed range"))
+		return (manager_clean(manager), 1);
+	delete_payload.line = 0;
+	delete_payload.index = 2;
+	delete_payload.end_line = 2;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_SUCCESS, "Delete range"))
+		return (manager_clean(manager), 1);
+	get_payload.buffer_id = buffer_id;
+	get_payload.line = -1;
+	cmd.id = CMD_WRITING_GET_LINE;
+	cmd.payload = &get_payload;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_SUCCESS, "Get joined line"))
+		return (manager_clean(manager), 1);
+	if (0 != strcmp(get_payload.out_data, "h\xC3\xA9rld"))
+		return (manager_clean(manager), print_error("Delete range content mismatch"), 1);
+	print_success("Range ends are joined in one line");
+	delete_payload.end_line = 5;
+	cmd.id = CMD_WRITING_DELETE_RANGE;
+	cmd.payload = &delete_payload;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_LINE_NOT_FOUND, "Delete range rejected on invalid line"))
+		return (manager_clean(manager), 1);
+	manager_clean(manager);
+	return (0);
+}
+
+static int	test_get_lines_command(void)
+{
+	t_Manager			*manager;
+	t_Command			cmd;
+	t_CmdInsertRange	range_payload;
+	t_CmdGetLines		lines_payload;
+	t_LineView			views[5];
+	size_t				buffer_id;
+
+	print_section("WRITING GET LINES COMMAND");
+	manager = manager_init();
+	if (NULL == manager)
+		return (print_error("Failed to initialize manager"), 1);
+	if (create_buffer(manager, &buffer_id) || insert_line(manager, buffer_id, 0))
+		return (manager_clean(manager), 1);
+	range_payload.buffer_id = buffer_id;
+	range_payload.line = 0;
+	range_payload.index = 0;
+	range_payload.data = "a\nbb\nccc";
+	range_payload.size = strlen(range_payload.data);
+	cmd.id = CMD_WRITING_INSERT_RANGE;
+	cmd.payload = &range_payload;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_SUCCESS, "Insert range"))
+		return (manager_clean(manager), 1);
+	lines_payload.buffer_id = buffer_id;
+	lines_payload.line = 1;
+	lines_payload.count = 5;
+	lines_payload.views = views;
+	cmd.id = CMD_WRITING_GET_LINES;
+	cmd.payload = &lines_payload;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_SUCCESS, "Get lines"))
+		return (manager_clean(manager), 1);
+	if (2 != lines_payload.out_count || 2 != views[0].size || 3 != views[1].size
+		|| 0 != memcmp(views[0].data, "bb", 2) || 0 != memcmp(views[1].data, "ccc", 3))
+		return (manager_clean(manager), print_error("Line views mismatch"), 1);
+	print_success("Views stop at the last line");
+	lines_payload.views = NULL;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_INVALID_PAYLOAD, "Get lines rejected without views"))
+		return (manager_clean(manager), 1);
+	lines_payload.views = views;
+	lines_payload.line = 3;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_LINE_NOT_FOUND, "Get lines rejected on invalid line"))
+		return (manager_clean(manager), 1);
+	manager_clean(manager);
+	return (0);
+}
+
+static int	expect_lines(t_Manager *manager, size_t buffer_id, const char *text)
+{
+	t_Command		cmd;
+	t_CmdGetLines	payload;
+	t_LineView		views[8];
+	size_t			_i;
+	size_t			_size;
+
+	payload.buffer_id = buffer_id;
+	payload.line = 0;
+	payload.count = 8;
+	payload.views = views;
+	payload.out_count = 0;
+	cmd.id = CMD_WRITING_GET_LINES;
+	cmd.payload = &payload;
+	manager_exec(manager, &cmd);
+	for (_i = 0; _i < payload.out_count; _i++)
+	{
+		_size = strcspn(text, "|");
+		if (_size != views[_i].size || 0 != memcmp(views[_i].data, text, _size))
+			return (1);
+		text += _size + ('|' == text[_size]);
+	}
+	return ('\0' != *text);
+}
+
+static int	test_undo_redo_commands(void)
+{
+	t_Manager			*manager;
+	t_Command			cmd;
+	t_CmdHistory		history_payload;
+	t_CmdSplitLine		split_payload;
+	t_CmdDeleteData		delete_payload;
+	t_CmdInsertRange	range_payload;
+	size_t				buffer_id;
+	size_t				_i;
+	int					_undos;
+
+	print_section("WRITING UNDO/REDO COMMANDS");
+	manager = manager_init();
+	if (NULL == manager)
+		return (print_error("Failed to initialize manager"), 1);
+	if (create_buffer(manager, &buffer_id) || insert_line(manager, buffer_id, 0))
+		return (manager_clean(manager), 1);
+	for (_i = 0; _i < 5; _i++)
+	{
+		if (insert_text(manager, buffer_id, 0, _i, (char [2]){"hello"[_i], '\0'}))
+			return (manager_clean(manager), 1);
+	}
+	history_payload.buffer_id = buffer_id;
+	cmd.id = CMD_WRITING_UNDO;
+	cmd.payload = &history_payload;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_SUCCESS, "Undo typing")
+		|| expect_lines(manager, buffer_id, ""))
+		return (manager_clean(manager), print_error("Typing is not undone at once"), 1);
+	cmd.id = CMD_WRITING_REDO;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_SUCCESS, "Redo typing")
+		|| expect_lines(manager, buffer_id, "hello")
+		|| 0 != history_payload.out_line || 5 != history_payload.out_index)
+		return (manager_clean(manager), print_error("Typing is not redone at once"), 1);
+	print_success("Consecutive typing is one record");
+	delete_payload.buffer_id = buffer_id;
+	delete_payload.line = 0;
+	delete_payload.size = 1;
+	cmd.id = CMD_WRITING_DELETE_TEXT;
+	cmd.payload = &delete_payload;
+	for (delete_payload.index = 4; delete_payload.index > 2; delete_payload.index--)
+		manager_exec(manager, &cmd);
+	split_payload.buffer_id = buffer_id;
+	split_payload.line = 0;
+	split_payload.index = 1;
+	cmd.id = CMD_WRITING_SPLIT_LINE;
+	cmd.payload = &split_payload;
+	manager_exec(manager, &cmd);
+	range_payload.buffer_id = buffer_id;
+	range_payload.line = 1;
+	range_payload.index = -1;
+	range_payload.data = "\xC3\xA9\r\nw\nx";
+	range_payload.size = strlen(range_payload.data);
+	cmd.id = CMD_WRITING_INSERT_RANGE;
+	cmd.payload = &range_payload;
+	manager_exec(manager, &cmd);
+	if (expect_lines(manager, buffer_id, "h|el\xC3\xA9|w|x"))
+		return (manager_clean(manager), print_error("Edits mismatch"), 1);
+	cmd.id = CMD_WRITING_UNDO;
+	cmd.payload = &history_payload;
+	_undos = 0;
+	while (ERR_SUCCESS == manager_exec(manager, &cmd))
+		_undos++;
+	if (5 != _undos || assert_error_code(manager_exec(manager, &cmd), ERR_HISTORY_EMPTY, "Undo rejected on empty history")
+		|| expect_lines(manager, buffer_id, ""))
+		return (manager_clean(manager), print_error("Undo all mismatch"), 1);
+	cmd.id = CMD_WRITING_REDO;
+	while (ERR_SUCCESS == manager_exec(manager, &cmd))
+		_undos--;
+	if (0 != _undos || expect_lines(manager, buffer_id, "h|el\xC3\xA9|w|x"))
+		return (manager_clean(manager), print_error("Redo all mismatch"), 1);
+	print_success("Every edit is undone and redone");
+	cmd.id = CMD_WRITING_UNDO;
+	manager_exec(manager, &cmd);
+	if (1 != history_payload.out_line || 2 != history_payload.out_index)
+		return (manager_clean(manager), print_error("Undo position mismatch"), 1);
+	if (insert_text(manager, buffer_id, 0, 0, "!"))
+		return (manager_clean(manager), 1);
+	cmd.id = CMD_WRITING_REDO;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_HISTORY_EMPTY, "Redo dropped by a new edit"))
+		return (manager_clean(manager), 1);
+	manager_clean(manager);
+	return (0);
+}
+
+static int	test_multi_edit_command(void)
+{
+	t_Manager			*manager;
+	t_Command			cmd;
+	t_CmdInsertRange	range_payload;
+	t_CmdMultiEdit		edit_payload;
+	t_CmdHistory		history_payload;
+	t_Edit				edits[5];
+	size_t				buffer_id;
+	char				*big;
+
+	print_section("WRITING MULTI EDIT COMMAND");
+	manager = manager_init();
+	if (NULL == manager)
+		return (print_error("Failed to initialize manager"), 1);
+	if (create_buffer(manager, &buffer_id) || insert_line(manager, buffer_id, 0))
+		return (manager_clean(manager), 1);
+	range_payload.buffer_id = buffer_id;
+	range_payload.line = 0;
+	range_payload.index = 0;
+	range_payload.data = "id,name\n1,bob\n2,\xC3\xA9ve";
+	range_payload.size = strlen(range_payload.data);
+	cmd.id = CMD_WRITING_INSERT_RANGE;
+	cmd.payload = &range_payload;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_SUCCESS, "Insert range"))
+		return (manager_clean(manager), 1);
+	edits[0] = (t_Edit){.line = -1, .index = 2, .delete_size = 3, .size = 3, .data = "EVE"};
+	edits[1] = (t_Edit){.line = 0, .index = 3, .delete_size = 4, .size = 4, .data = "user"};
+	edits[2] = (t_Edit){.line = 1, .index = 5, .delete_size = 0, .size = 1, .data = "]"};
+	edits[3] = (t_Edit){.line = 0, .index = 0, .delete_size = 0, .size = 1, .data = "#"};
+	edits[4] = (t_Edit){.line = 1, .index = 0, .delete_size = 0, .size = 1, .data = "["};
+	edit_payload.buffer_id = buffer_id;
+	edit_payload.count = 5;
+	edit_payload.edits = edits;
+	cmd.id = CMD_WRITING_MULTI_EDIT;
+	cmd.payload = &edit_payload;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_SUCCESS, "Multi edit")
+		|| expect_lines(manager, buffer_id, "#id,user|[1,bob]|2,EVE"))
+		return (manager_clean(manager), print_error("Multi edit content mismatch"), 1);
+	if (5 != edits[0].out_index || 2 != edits[0].out_line || 8 != edits[1].out_index
+		|| 7 != edits[2].out_index || 1 != edits[3].out_index || 1 != edits[4].out_index)
+		return (manager_clean(manager), print_error("Multi edit cursors mismatch"), 1);
+	print_success("Edits are applied with their cursors");
+	history_payload.buffer_id = buffer_id;
+	cmd.id = CMD_WRITING_UNDO;
+	cmd.payload = &history_payload;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_SUCCESS, "Undo multi edit")
+		|| expect_lines(manager, buffer_id, "id,name|1,bob|2,\xC3\xA9ve"))
+		return (manager_clean(manager), print_error("Multi edit is not undone at once"), 1);
+	cmd.id = CMD_WRITING_REDO;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_SUCCESS, "Redo multi edit")
+		|| expect_lines(manager, buffer_id, "#id,user|[1,bob]|2,EVE"))
+		return (manager_clean(manager), print_error("Multi edit is not redone at once"), 1);
+	print_success("A batch is one undo step");
+	edits[0] = (t_Edit){.line = 0, .index = 1, .delete_size = 3, .size = 0, .data = ""};
+	edits[1] = (t_Edit){.line = 0, .index = 2, .delete_size = 0, .size = 1, .data = "x"};
+	edit_payload.count = 2;
+	cmd.id = CMD_WRITING_MULTI_EDIT;
+	cmd.payload = &edit_payload;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_INVALID_PAYLOAD, "Overlapping edits rejected")
+		|| expect_lines(manager, buffer_id, "#id,user|[1,bob]|2,EVE"))
+		return (manager_clean(manager), 1);
+	edits[0] = (t_Edit){.line = 0, .index = 0, .delete_size = 1, .size = 0, .data = ""};
+	edits[1] = (t_Edit){.line = 2, .index = 9, .delete_size = 0, .size = 1, .data = "x"};
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_OPERATION_FAILED, "Edit past the line rejected")
+		|| expect_lines(manager, buffer_id, "#id,user|[1,bob]|2,EVE"))
+		return (manager_clean(manager), print_error("Rejected batch is not rolled back"), 1);
+	print_success("A rejected batch leaves the buffer unchanged");
+	big = malloc(BIG_EDIT_SIZE);
+	if (NULL == big)
+		return (manager_clean(manager), print_error("Allocation failed"), 1);
+	memset(big, 'a', BIG_EDIT_SIZE);
+	edits[0] = (t_Edit){.line = 0, .index = 0, .delete_size = 0, .size = BIG_EDIT_SIZE, .data = big};
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_OPERATION_FAILED, "Large edit past the line rejected")
+		|| expect_lines(manager, buffer_id, "#id,user|[1,bob]|2,EVE"))
+		return (free(big), manager_clean(manager), print_error("Large rejected batch is not rolled back"), 1);
+	free(big);
+	cmd.id = CMD_WRITING_UNDO;
+	cmd.payload = &history_payload;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_SUCCESS, "Undo after rejected batch")
+		|| expect_lines(manager, buffer_id, "id,name|1,bob|2,\xC3\xA9ve"))
+		return (manager_clean(manager), print_error("Rejected batch dropped the history"), 1);
+	print_success("A rejected batch over the history budget keeps the history");
+	cmd.id = CMD_WRITING_MULTI_EDIT;
+	cmd.payload = &edit_payload;
+	edits[0] = (t_Edit){.line = 0, .index = 0, .delete_size = 1, .size = 0, .data = ""};
+	edits[1] = (t_Edit){.line = 1, .index = 0, .delete_size = 0, .size = 2, .data = "a\n"};
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_INVALID_PAYLOAD, "Line ending rejected"))
+		return (manager_clean(manager), 1);
+	edits[1] = (t_Edit){.line = 3, .index = 0, .delete_size = 0, .size = 1, .data = "a"};
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_LINE_NOT_FOUND, "Multi edit rejected on invalid line"))
+		return (manager_clean(manager), 1);
+	manager_clean(manager);
+	return (0);
+}
+
+static int	test_apply_changes_command(void)
+{
+	t_Manager			*manager;
+	t_Command			cmd;
+	t_CmdInsertRange	range_payload;
+	t_CmdApplyChanges	payload;
+	t_CmdHistory		history_payload;
+	t_Change			changes[3];
+	size_t				buffer_id;
+	size_t				version;
+	char				*big;
+
+	print_section("WRITING APPLY CHANGES COMMAND");
+	manager = manager_init();
+	if (NULL == manager)
+		return (print_error("Failed to initialize manager"), 1);
+	if (create_buffer(manager, &buffer_id) || insert_line(manager, buffer_id, 0))
+		return (manager_clean(manager), 1);
+	range_payload.buffer_id = buffer_id;
+	range_payload.line = 0;
+	range_payload.index = 0;
+	range_payload.data = "id,name\n1,bob\n2,\xC3\xA9ve";
+	range_payload.size = strlen(range_payload.data);
+	cmd.id = CMD_WRITING_INSERT_RANGE;
+	cmd.payload = &range_payload;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_SUCCESS, "Insert range"))
+		return (manager_clean(manager), 1);
+	changes[0] = (t_Change){0, 3, 0, 7, 4, "user"};
+	changes[1] = (t_Change){1, 2, 2, 2, 8, "alice\n3,"};
+	changes[2] = (t_Change){2, 3, 2, 9, 5, "\xF0\x9F\x98\x80!"};
+	payload = (t_CmdApplyChanges){.buffer_id = buffer_id, .count = 3,
+		.changes = changes};
+	cmd.id = CMD_WRITING_APPLY_CHANGES;
+	cmd.payload = &payload;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_SUCCESS, "Apply changes")
+		|| 3 != payload.out_count
+		|| expect_lines(manager, buffer_id, "id,user|1,alice|3,\xC3\xA9\xF0\x9F\x98\x80!"))
+		return (manager_clean(manager), print_error("Changes content mismatch"), 1);
+	print_success("Changes are applied in order and may span lines");
+	version = payload.out_version;
+	changes[0] = (t_Change){2, 5, 2, 5, 1, "?"};
+	changes[1] = (t_Change){2, 4, 2, 5, 0, NULL};
+	payload.utf16 = true;
+	payload.count = 2;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_SUCCESS, "Apply UTF-16 changes")
+		|| payload.out_version <= version
+		|| expect_lines(manager, buffer_id, "id,user|1,alice|3,\xC3\xA9?!"))
+		return (manager_clean(manager), print_error("UTF-16 changes mismatch"), 1);
+	print_success("UTF-16 columns count surrogate pairs twice, the version grows");
+	history_payload.buffer_id = buffer_id;
+	cmd.id = CMD_WRITING_UNDO;
+	cmd.payload = &history_payload;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_SUCCESS, "Undo changes")
+		|| expect_lines(manager, buffer_id, "id,user|1,alice|3,\xC3\xA9\xF0\x9F\x98\x80!"))
+		return (manager_clean(manager), print_error("Changes are not undone at once"), 1);
+	print_success("A batch is one undo step");
+	changes[0] = (t_Change){0, 0, 0, 1, 0, ""};
+	changes[1] = (t_Change){1, 0, 3, 0, 1, "x"};
+	payload.utf16 = false;
+	cmd.id = CMD_WRITING_APPLY_CHANGES;
+	cmd.payload = &payload;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_LINE_NOT_FOUND, "Change past the buffer rejected")
+		|| 1 != payload.out_count
+		|| expect_lines(manager, buffer_id, "id,user|1,alice|3,\xC3\xA9\xF0\x9F\x98\x80!"))
+		return (manager_clean(manager), print_error("Rejected batch is not rolled back"), 1);
+	print_success("A rejected batch leaves the buffer unchanged");
+	big = malloc(BIG_EDIT_SIZE);
+	if (NULL == big)
+		return (manager_clean(manager), print_error("Allocation failed"), 1);
+	memset(big, 'a', BIG_EDIT_SIZE);
+	changes[0] = (t_Change){0, 0, 0, 0, BIG_EDIT_SIZE, big};
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_LINE_NOT_FOUND, "Large change past the buffer rejected")
+		|| expect_lines(manager, buffer_id, "id,user|1,alice|3,\xC3\xA9\xF0\x9F\x98\x80!"))
+		return (free(big), manager_clean(manager), print_error("Large rejected batch is not rolled back"), 1);
+	free(big);
+	cmd.id = CMD_WRITING_UNDO;
+	cmd.payload = &history_payload;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_SUCCESS, "Undo after rejected batch")
+		|| expect_lines(manager, buffer_id, "id,name|1,bob|2,\xC3\xA9ve"))
+		return (manager_clean(manager), print_error("Rejected batch dropped the history"), 1);
+	print_success("A rejected batch over the history budget keeps the history");
+	cmd.id = CMD_WRITING_APPLY_CHANGES;
+	cmd.payload = &payload;
+	changes[0] = (t_Change){0, 0, 0, 1, 0, ""};
+	changes[1] = (t_Change){1, 3, 1, 1, 0, ""};
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_INVALID_PAYLOAD, "Reversed range rejected"))
+		return (manager_clean(manager), 1);
+	changes[1] = (t_Change){1, 9, 1, 9, 1, "x"};
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_OPERATION_FAILED, "Start past the line rejected"))
+		return (manager_clean(manager), 1);
+	changes[1] = (t_Change){1, 0, 1, 0, 1, "\xFF"};
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_INVALID_ENCODING, "Invalid data rejected"))
+		return (manager_clean(manager), 1);
+	payload.changes = NULL;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_INVALID_PAYLOAD, "Missing changes rejected"))
+		return (manager_clean(manager), 1);
+	manager_clean(manager);
+	return (0);
+}
+
+static int	test_load_file_command(void)
+{
+	t_Manager		*manager;
+	t_Command		cmd;
+	t_CmdOpenRoot	open_payload;
+	t_CmdLoadFile	load_payload;
+	t_CmdGetLine	get_payload;
+	char			path[512];
+	char			*dir;
+	FILE			*file;
+	int				status;
+
+	print_section("WRITING LOAD FILE COMMAND");
+	manager = manager_init();
+	if (NULL == manager)
+		return (print_error("Failed to initialize manager"), 1);
+	load_payload.path = "file.txt";
+	cmd.id = CMD_WRITING_LOAD_FILE;
+	cmd.payload = &load_payload;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_FS_CONTEXT_NOT_INITIALIZED, "Load rejected without root"))
+		return (manager_clean(manager), 1);
+	dir = test_tmpdir_create("/tmp/seed_writing_load");
+	if (NULL == dir)
+		return (manager_clean(manager), print_error("Failed to create temp dir"), 1);
+	snprintf(path, sizeof(path), "%s/file.txt", dir);
+	file = fopen(path, "w");
+	if (NULL != file)
+	{
+		fputs("int\tmain(void)\r\n{\r\n\treturn (0);\n}", file);
+		fclose(file);
+	}
+	status = 1;
+	open_payload.path = dir;
+	cmd.id = CMD_FS_OPEN_ROOT;
+	cmd.payload = &open_payload;
+	if (NULL == file || assert_error_code(manager_exec(manager, &cmd), ERR_SUCCESS, "Open root"))
+		goto end;
+	cmd.id = CMD_WRITING_LOAD_FILE;
+	cmd.payload = &load_payload;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_SUCCESS, "Load file"))
+		goto end;
+	if (load_payload.out_lines != 4 || false == load_payload.out_crlf)
+	{
+		print_error("Loaded lines mismatch");
+		goto end;
+	}
+	get_payload.buffer_id = load_payload.out_buffer_id;
+	get_payload.line = 0;
+	cmd.id = CMD_WRITING_GET_LINE;
+	cmd.payload = &get_payload;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_SUCCESS, "Get loaded line"))
+		goto end;
+	if (get_payload.out_size != 14 || 0 != memcmp(get_payload.out_data, "int\tmain(void)", 14))
+	{
+		print_error("Loaded line content mismatch");
+		goto end;
+	}
+	print_success("Loaded lines are split without CR");
+	load_payload.path = "missing.txt";
+	cmd.id = CMD_WRITING_LOAD_FILE;
+	cmd.payload = &load_payload;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_FILE_NOT_FOUND, "Load rejected on missing file"))
+		goto end;
+	status = 0;
+end:
+	manager_clean(manager);
+	test_tmpdir_remove(dir);
+	free(dir);
+	return (status);
+}
+
+static int	expect_matches(t_CmdFind *payload, const size_t *expected, size_t count)
+{
+	size_t	_i;
+
+	if (payload->out_count != count)
+		return (1);
+	for (_i = 0; _i < count; _i++)
+	{
+		if (payload->matches[_i].line != expected[_i * 2]
+			|| payload->matches[_i].index != expected[_i * 2 + 1])
+			return (1);
+	}
+	return (0);
+}
+
+static int	test_find_command(void)
+{
+	t_Manager			*manager;
+	t_Command			cmd;
+	t_CmdOpenRoot		open_payload;
+	t_CmdLoadFile		load_payload;
+	t_CmdInsertData		insert_payload;
+	t_CmdFind			find_payload;
+	t_Match				matches[8];
+	char				path[512];
+	char				*dir;
+	FILE				*file;
+	int					status;
+
+	print_section("WRITING FIND COMMAND");
+	manager = manager_init();
+	if (NULL == manager)
+		return (print_error("Failed to initialize manager"), 1);
+	dir = test_tmpdir_create("/tmp/seed_writing_find");
+	if (NULL == dir)
+		return (manager_clean(manager), print_error("Failed to create temp dir"), 1);
+	snprintf(path, sizeof(path), "%s/find.c", dir);
+	file = fopen(path, "w");
+	if (NULL != file)
+	{
+		fputs("let foo = 1;\nfoo(foo);\r\nnone\nété foo\nFOO", file);
+		fclose(file);
+	}
+	status = 1;
+	open_payload.path = dir;
+	cmd.id = CMD_FS_OPEN_ROOT;
+	cmd.payload = &open_payload;
+	if (NULL == file || assert_error_code(manager_exec(manager, &cmd), ERR_SUCCESS, "Open root"))
+		goto end;
+	load_payload.path = "find.c";
+	cmd.id = CMD_WRITING_LOAD_FILE;
+	cmd.payload = &load_payload;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_SUCCESS, "Load file"))
+		goto end;
+	memset(&find_payload, 0, sizeof(find_payload));
+	find_payload.buffer_id = load_payload.out_buffer_id;
+	find_payload.data = "foo";
+	find_payload.size = 3;
+	find_payload.count = 8;
+	find_payload.matches = matches;
+	cmd.id = CMD_WRITING_FIND;
+	cmd.payload = &find_payload;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_SUCCESS, "Find forward"))
+		goto end;
+	if (expect_matches(&find_payload, (size_t []){0, 4, 1, 0, 1, 4, 3, 4}, 4))
+	{
+		print_error("Forward matches mismatch");
+		goto end;
+	}
+	print_success("Matches are found across unedited lines");
+	find_payload.ignore_case = true;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_SUCCESS, "Find ignoring case")
+		|| expect_matches(&find_payload, (size_t []){0, 4, 1, 0, 1, 4, 3, 4, 4, 0}, 5))
+	{
+		print_error("Case folded matches mismatch");
+		goto end;
+	}
+	print_success("Case of ASCII letters is ignored");
+	find_payload.ignore_case = false;
+	find_payload.line = 1;
+	find_payload.index = 1;
+	find_payload.count = 1;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_SUCCESS, "Find from a position")
+		|| expect_matches(&find_payload, (size_t []){1, 4}, 1))
+	{
+		print_error("Matches from a position mismatch");
+		goto end;
+	}
+	print_success("Search starts at the position and stops at the count");
+	find_payload.backward = true;
+	find_payload.line = 3;
+	find_payload.index = -1;
+	find_payload.count = 8;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_SUCCESS, "Find backward")
+		|| expect_matches(&find_payload, (size_t []){3, 4, 1, 4, 1, 0, 0, 4}, 4))
+	{
+		print_error("Backward matches mismatch");
+		goto end;
+	}
+	find_payload.line = 1;
+	find_payload.index = 4;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_SUCCESS, "Find backward from a position")
+		|| expect_matches(&find_payload, (size_t []){1, 0, 0, 4}, 2))
+	{
+		print_error("Backward matches from a position mismatch");
+		goto end;
+	}
+	print_success("Backward matches start before the position");
+	insert_payload.buffer_id = load_payload.out_buffer_id;
+	insert_payload.line = 2;
+	insert_payload.index = 0;
+	insert_payload.size = 3;
+	insert_payload.data = "foo";
+	cmd.id = CMD_WRITING_INSERT_TEXT;
+	cmd.payload = &insert_payload;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_SUCCESS, "Insert text"))
+		goto end;
+	find_payload.backward = false;
+	find_payload.line = 0;
+	find_payload.index = 0;
+	cmd.id = CMD_WRITING_FIND;
+	cmd.payload = &find_payload;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_SUCCESS, "Find after an edit")
+		|| expect_matches(&find_payload, (size_t []){0, 4, 1, 0, 1, 4, 2, 0, 3, 4}, 5))
+	{
+		print_error("Matches after an edit mismatch");
+		goto end;
+	}
+	print_success("Edited lines are searched between unedited ones");
+	find_payload.data = "foo\nbar";
+	find_payload.size = 7;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_INVALID_PAYLOAD, "Find rejected with a line ending"))
+		goto end;
+	find_payload.size = 3;
+	find_payload.line = 9;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_LINE_NOT_FOUND, "Find rejected on invalid line"))
+		goto end;
+	status = 0;
+end:
+	manager_clean(manager);
+	test_tmpdir_remove(dir);
+	free(dir);
+	return (status);
+}
+
+static int	test_regex_find_command(void)
+{
+	t_Manager			*manager;
+	t_Command			cmd;
+	t_CmdInsertRange	range_payload;
+	t_CmdRegexFind		find_payload;
+	t_Match				matches[4];
+	t_Command			change_cmd;
+	t_CmdApplyChanges	change_payload;
+	t_Change			change;
+	size_t				buffer_id;
+
+	print_section("WRITING REGEX FIND COMMAND");
+	manager = manager_init();
+	if (NULL == manager)
+		return (print_error("Failed to initialize manager"), 1);
+	if (create_buffer(manager, &buffer_id) || insert_line(manager, buffer_id, 0))
+		return (manager_clean(manager), 1);
+	range_payload.buffer_id = buffer_id;
+	range_payload.line = 0;
+	range_payload.index = 0;
+	range_payload.data = "error: a\nok\n\xC3\xA9t\xC3\xA9 error: bb\nError: c";
+	range_payload.size = strlen(range_payload.data);
+	cmd.id = CMD_WRITING_INSERT_RANGE;
+	cmd.payload = &range_payload;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_SUCCESS, "Insert range"))
+		return (manager_clean(manager), 1);
+	memset(&find_payload, 0, sizeof(find_payload));
+	find_payload.buffer_id = buffer_id;
+	find_payload.pattern = "error: \\w+$";
+	find_payload.size = strlen(find_payload.pattern);
+	find_payload.ignore_case = true;
+	find_payload.count = 2;
+	find_payload.matches = matches;
+	cmd.id = CMD_WRITING_REGEX_FIND;
+	cmd.payload = &find_payload;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_SUCCESS, "Find the first chunk"))
+		return (manager_clean(manager), 1);
+	if (2 != find_payload.out_count || find_payload.out_done || NULL == find_payload.regex
+		|| 0 != matches[0].line || 0 != matches[0].index || 8 != matches[0].size
+		|| 2 != matches[1].line || 4 != matches[1].index || 9 != matches[1].size
+		|| 3 != find_payload.out_line || 0 != find_payload.out_index)
+		return (regex_destroy(find_payload.regex), manager_clean(manager), print_error("First chunk mismatch"), 1);
+	print_success("Chunk stops at the count with the next position");
+	find_payload.line = find_payload.out_line;
+	find_payload.index = find_payload.out_index;
+	find_payload.pattern = NULL;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_SUCCESS, "Find the next chunk"))
+		return (regex_destroy(find_payload.regex), manager_clean(manager), 1);
+	if (1 != find_payload.out_count || false == find_payload.out_done
+		|| 3 != matches[0].line || 0 != matches[0].index || 8 != matches[0].size)
+		return (regex_destroy(find_payload.regex), manager_clean(manager), print_error("Next chunk mismatch"), 1);
+	print_success("Next chunk reuses the compiled expression");
+	regex_destroy(find_payload.regex);
+	find_payload.regex = NULL;
+	if (insert_line(manager, buffer_id, -1) || insert_text(manager, buffer_id, 4, 0, "ab ab ab"))
+		return (manager_clean(manager), 1);
+	find_payload.pattern = "ab";
+	find_payload.size = 2;
+	find_payload.line = 4;
+	find_payload.index = 0;
+	find_payload.count = 1;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_SUCCESS, "Find in the line")
+		|| 1 != find_payload.out_count || 4 != find_payload.out_line || 3 != find_payload.out_index)
+		return (regex_destroy(find_payload.regex), manager_clean(manager), print_error("Line chunk mismatch"), 1);
+	change = (t_Change){4, 3, 4, 4, 1, "x"};
+	change_payload = (t_CmdApplyChanges){.buffer_id = buffer_id, .count = 1, .changes = &change};
+	change_cmd = (t_Command){.id = CMD_WRITING_APPLY_CHANGES, .payload = &change_payload};
+	if (assert_error_code(manager_exec(manager, &change_cmd), ERR_SUCCESS, "Edit between chunks"))
+		return (regex_destroy(find_payload.regex), manager_clean(manager), 1);
+	find_payload.line = find_payload.out_line;
+	find_payload.index = find_payload.out_index;
+	find_payload.pattern = NULL;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_SUCCESS, "Find after the edit")
+		|| 1 != find_payload.out_count || 4 != matches[0].line || 6 != matches[0].index)
+		return (regex_destroy(find_payload.regex), manager_clean(manager), print_error("Edited line chunk mismatch"), 1);
+	print_success("Next chunk reads an edited line again");
+	regex_destroy(find_payload.regex);
+	find_payload.regex = NULL;
+	find_payload.pattern = "(error";
+	find_payload.size = strlen(find_payload.pattern);
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_INVALID_PATTERN, "Find rejected on invalid pattern"))
+		return (manager_clean(manager), 1);
+	find_payload.pattern = NULL;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_INVALID_PAYLOAD, "Find rejected without pattern"))
+		return (manager_clean(manager), 1);
+	manager_clean(manager);
+	return (0);
+}
+
+static int	test_find_all_command(void)
+{
+	t_Manager			*manager;
+	t_Command			cmd;
+	t_Command			index_cmd;
+	t_CmdFindAll		find_payload;
+	t_CmdSetIndex		index_payload;
+	t_CmdDestroyBuffer	destroy_payload;
+	t_BufferMatch		matches[2];
+	size_t				ids[3];
+
+	print_section("WRITING FIND ALL COMMAND");
+	manager = manager_init();
+	if (NULL == manager)
+		return (print_error("Failed to initialize manager"), 1);
+	if (create_buffer(manager, &ids[0]) || create_buffer(manager, &ids[1])
+		|| create_buffer(manager, &ids[2]) || insert_line(manager, ids[0], 0)
+		|| insert_line(manager, ids[0], 1) || insert_line(manager, ids[2], 0)
+		|| insert_text(manager, ids[0], 0, 0, "foo bar foo")
+		|| insert_text(manager, ids[0], 1, 0, "nothing")
+		|| insert_text(manager, ids[2], 0, 0, "\xC3\xA9 FOO"))
+		return (manager_clean(manager), 1);
+	destroy_payload.buffer_id = ids[1];
+	cmd.id = CMD_WRITING_DELETE_BUFFER;
+	cmd.payload = &destroy_payload;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_SUCCESS, "Delete the middle buffer"))
+		return (manager_clean(manager), 1);
+	index_payload.buffer_id = ids[0];
+	index_payload.enable = true;
+	index_cmd.id = CMD_WRITING_SET_INDEX;
+	index_cmd.payload = &index_payload;
+	if (assert_error_code(manager_exec(manager, &index_cmd), ERR_SUCCESS, "Index the first buffer"))
+		return (manager_clean(manager), 1);
+	memset(&find_payload, 0, sizeof(find_payload));
+	find_payload.data = "foo";
+	find_payload.size = 3;
+	find_payload.ignore_case = true;
+	find_payload.buffer_id = ids[0];
+	find_payload.count = 2;
+	find_payload.matches = matches;
+	cmd.id = CMD_WRITING_FIND_ALL;
+	cmd.payload = &find_payload;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_SUCCESS, "Find the first chunk"))
+		return (manager_clean(manager), 1);
+	if (2 != find_payload.out_count || find_payload.out_done
+		|| ids[0] != matches[0].buffer_id || 0 != matches[0].match.index
+		|| ids[0] != matches[1].buffer_id || 8 != matches[1].match.index
+		|| ids[2] != find_payload.out_buffer_id || 0 != find_payload.out_line
+		|| 2 != find_payload.out_index)
+		return (manager_clean(manager), print_error("First chunk mismatch"), 1);
+	print_success("Chunk stops at the count with the next buffer");
+	find_payload.buffer_id = find_payload.out_buffer_id;
+	find_payload.line = find_payload.out_line;
+	find_payload.index = find_payload.out_index;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_SUCCESS, "Find the next chunk"))
+		return (manager_clean(manager), 1);
+	if (1 != find_payload.out_count || false == find_payload.out_done
+		|| ids[2] != matches[0].buffer_id || 0 != matches[0].match.line
+		|| 2 != matches[0].match.index || 3 != matches[0].match.size)
+		return (manager_clean(manager), print_error("Next chunk mismatch"), 1);
+	print_success("Next chunk skips the deleted buffer and counts characters");
+	if (insert_text(manager, ids[0], 1, 0, "foo "))
+		return (manager_clean(manager), 1);
+	find_payload.buffer_id = ids[0];
+	find_payload.line = 1;
+	find_payload.index = 0;
+	find_payload.ignore_case = false;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_SUCCESS, "Find after an edit"))
+		return (manager_clean(manager), 1);
+	if (1 != find_payload.out_count || false == find_payload.out_done
+		|| 1 != matches[0].match.line || 0 != matches[0].match.index)
+		return (manager_clean(manager), print_error("Edited line mismatch"), 1);
+	print_success("Edited line is indexed again");
+	index_payload.enable = false;
+	if (assert_error_code(manager_exec(manager, &index_cmd), ERR_SUCCESS, "Release the index"))
+		return (manager_clean(manager), 1);
+	find_payload.line = 0;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_SUCCESS, "Find without index")
+		|| 2 != find_payload.out_count || 0 != matches[0].match.index
+		|| 8 != matches[1].match.index)
+		return (manager_clean(manager), print_error("Unindexed find mismatch"), 1);
+	print_success("Buffer without index is scanned");
+	index_payload.buffer_id = ids[1];
+	if (assert_error_code(manager_exec(manager, &index_cmd), ERR_BUFFER_NOT_FOUND, "Index rejected on missing buffer"))
+		return (manager_clean(manager), 1);
+	find_payload.data = "foo\n";
+	find_payload.size = 4;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_INVALID_PAYLOAD, "Find rejected with line ending"))
+		return (manager_clean(manager), 1);
+	manager_clean(manager);
+	return (0);
+}
+
+static int	test_replace_all_command(void)
+{
+	t_Manager		*manager;
+	t_Command		cmd;
+	t_Command		history_cmd;
+	t_CmdReplaceAll	payload;
+	t_CmdSetIndex	index_payload;
+	t_CmdHistory	history_payload;
+	size_t			buffer_id;
+
+	print_section("WRITING REPLACE ALL COMMAND");
+	manager = manager_init();
+	if (NULL == manager)
+		return (print_error("Failed to initialize manager"), 1);
+	if (create_buffer(manager, &buffer_id) || insert_line(manager, buffer_id, 0)
+		|| insert_line(manager, buffer_id, 1) || insert_line(manager, buffer_id, 2)
+		|| insert_text(manager, buffer_id, 0, 0, "foo bar foo")
+		|| insert_text(manager, buffer_id, 1, 0, "none")
+		|| insert_text(manager, buffer_id, 2, 0, "FOO \xC3\xA9" "foo"))
+		return (manager_clean(manager), 1);
+	index_payload.buffer_id = buffer_id;
+	index_payload.enable = true;
+	cmd.id = CMD_WRITING_SET_INDEX;
+	cmd.payload = &index_payload;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_SUCCESS, "Index the buffer"))
+		return (manager_clean(manager), 1);
+	memset(&payload, 0, sizeof(payload));
+	payload.buffer_id = buffer_id;
+	payload.data = "foo";
+	payload.size = 3;
+	payload.replacement = "quux";
+	payload.replacement_size = 4;
+	cmd.id = CMD_WRITING_REPLACE_ALL;
+	cmd.payload = &payload;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_SUCCESS, "Replace a text")
+		|| expect_lines(manager, buffer_id, "quux bar quux|none|FOO \xC3\xA9" "quux"))
+		return (manager_clean(manager), print_error("Replace content mismatch"), 1);
+	if (3 != payload.out_count || 2 != payload.out_lines)
+		return (manager_clean(manager), print_error("Replace counts mismatch"), 1);
+	print_success("Every match is replaced with its counts");
+	history_payload.buffer_id = buffer_id;
+	history_cmd.id = CMD_WRITING_UNDO;
+	history_cmd.payload = &history_payload;
+	if (assert_error_code(manager_exec(manager, &history_cmd), ERR_SUCCESS, "Undo replace")
+		|| expect_lines(manager, buffer_id, "foo bar foo|none|FOO \xC3\xA9" "foo"))
+		return (manager_clean(manager), print_error("Replace is not undone at once"), 1);
+	history_cmd.id = CMD_WRITING_REDO;
+	if (assert_error_code(manager_exec(manager, &history_cmd), ERR_SUCCESS, "Redo replace")
+		|| expect_lines(manager, buffer_id, "quux bar quux|none|FOO \xC3\xA9" "quux"))
+		return (manager_clean(manager), print_error("Replace is not redone at once"), 1);
+	print_success("A replace is one undo step");
+	payload.data = "QUUX";
+	payload.size = 4;
+	payload.ignore_case = true;
+	payload.replacement = "";
+	payload.replacement_size = 0;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_SUCCESS, "Replace ignoring the case")
+		|| expect_lines(manager, buffer_id, " bar |none|FOO \xC3\xA9")
+		|| 3 != payload.out_count)
+		return (manager_clean(manager), print_error("Folded replace mismatch"), 1);
+	payload.data = "\\s+|^";
+	payload.size = 5;
+	payload.is_regex = true;
+	payload.ignore_case = false;
+	payload.replacement = ">";
+	payload.replacement_size = 1;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_SUCCESS, "Replace a regex")
+		|| expect_lines(manager, buffer_id, ">bar>|>none|>FOO>\xC3\xA9")
+		|| 5 != payload.out_count || 3 != payload.out_lines)
+		return (manager_clean(manager), print_error("Regex replace mismatch"), 1);
+	print_success("Regex matches are replaced, empty ones included");
+	payload.data = "zzz";
+	payload.size = 3;
+	payload.is_regex = false;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_SUCCESS, "Replace without match")
+		|| 0 != payload.out_count || 0 != payload.out_lines)
+		return (manager_clean(manager), 1);
+	payload.replacement = "a\n";
+	payload.replacement_size = 2;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_INVALID_PAYLOAD, "Replacement with line ending rejected"))
+		return (manager_clean(manager), 1);
+	payload.replacement = "\xFF";
+	payload.replacement_size = 1;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_INVALID_ENCODING, "Invalid replacement rejected"))
+		return (manager_clean(manager), 1);
+	payload.replacement = "a";
+	payload.data = "(";
+	payload.size = 1;
+	payload.is_regex = true;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_INVALID_PATTERN, "Invalid pattern rejected"))
+		return (manager_clean(manager), 1);
+	payload.size = 0;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_INVALID_PAYLOAD, "Empty text rejected"))
+		return (manager_clean(manager), 1);
+	payload.buffer_id = buffer_id + 1;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_BUFFER_NOT_FOUND, "Replace rejected on missing buffer")
+		|| expect_lines(manager, buffer_id, ">bar>|>none|>FOO>\xC3\xA9"))
+		return (manager_clean(manager), 1);
+	manager_clean(manager);
+	return (0);
+}
+
+static int	test_offset_commands(void)
+{
+	t_Manager			*manager;
+	t_Command			cmd;
+	t_Command			pos_cmd;
+	t_Command			offset_cmd;
+	t_CmdInsertRange	range_payload;
+	t_CmdPosToOffset	pos_payload;
+	t_CmdOffsetToPos	offset_payload;
+	size_t				buffer_id;
+
+	print_section("WRITING OFFSET COMMANDS");
+	manager = manager_init();
+	if (NULL == manager)
+		return (print_error("Failed to initialize manager"), 1);
+	if (create_buffer(manager, &buffer_id) || insert_line(manager, buffer_id, 0))
+		return (manager_clean(manager), 1);
+	range_payload.buffer_id = buffer_id;
+	range_payload.line = 0;
+	range_payload.index = 0;
+	range_payload.data = "ab\r\n\xC3\xA9x\nlast";
+	range_payload.size = strlen(range_payload.data);
+	cmd.id = CMD_WRITING_INSERT_RANGE;
+	cmd.payload = &range_payload;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_SUCCESS, "Insert range"))
+		return (manager_clean(manager), 1);
+	pos_payload.buffer_id = buffer_id;
+	pos_cmd.id = CMD_WRITING_POS_TO_OFFSET;
+	pos_cmd.payload = &pos_payload;
+	offset_payload.buffer_id = buffer_id;
+	offset_cmd.id = CMD_WRITING_OFFSET_TO_POS;
+	offset_cmd.payload = &offset_payload;
+	pos_payload.line = 1;
+	pos_payload.index = 1;
+	if (assert_error_code(manager_exec(manager, &pos_cmd), ERR_SUCCESS, "Offset of a position")
+		|| 6 != pos_payload.out_offset)
+		return (manager_clean(manager), print_error("Offset mismatch"), 1);
+	pos_payload.line = -1;
+	pos_payload.index = -1;
+	if (assert_error_code(manager_exec(manager, &pos_cmd), ERR_SUCCESS, "Offset of the end")
+		|| 12 != pos_payload.out_offset)
+		return (manager_clean(manager), print_error("End offset mismatch"), 1);
+	print_success("Offsets count the characters and the line endings");
+	offset_payload.offset = 6;
+	if (assert_error_code(manager_exec(manager, &offset_cmd), ERR_SUCCESS, "Position of an offset")
+		|| 1 != offset_payload.out_line || 1 != offset_payload.out_index)
+		return (manager_clean(manager), print_error("Position mismatch"), 1);
+	offset_payload.offset = 5;
+	if (assert_error_code(manager_exec(manager, &offset_cmd), ERR_SUCCESS, "Position inside a character")
+		|| 1 != offset_payload.out_line || 0 != offset_payload.out_index)
+		return (manager_clean(manager), print_error("Inner offset mismatch"), 1);
+	offset_payload.offset = 3;
+	if (assert_error_code(manager_exec(manager, &offset_cmd), ERR_SUCCESS, "Position inside a line ending")
+		|| 0 != offset_payload.out_line || 2 != offset_payload.out_index)
+		return (manager_clean(manager), print_error("Line ending offset mismatch"), 1);
+	offset_payload.offset = 12;
+	if (assert_error_code(manager_exec(manager, &offset_cmd), ERR_SUCCESS, "Position of the end")
+		|| 2 != offset_payload.out_line || 4 != offset_payload.out_index)
+		return (manager_clean(manager), print_error("End position mismatch"), 1);
+	print_success("Positions round down to a character and to the line end");
+	if (insert_text(manager, buffer_id, 0, 0, "zz"))
+		return (manager_clean(manager), 1);
+	offset_payload.offset = 8;
+	if (assert_error_code(manager_exec(manager, &offset_cmd), ERR_SUCCESS, "Position after an edit")
+		|| 1 != offset_payload.out_line || 1 != offset_payload.out_index)
+		return (manager_clean(manager), print_error("Edited position mismatch"), 1);
+	print_success("Edits move the offsets of the next lines");
+	offset_payload.offset = 15;
+	if (assert_error_code(manager_exec(manager, &offset_cmd), ERR_LINE_NOT_FOUND, "Offset past the end rejected"))
+		return (manager_clean(manager), 1);
+	pos_payload.line = 0;
+	pos_payload.index = 5;
+	if (assert_error_code(manager_exec(manager, &pos_cmd), ERR_OPERATION_FAILED, "Index past the line rejected"))
+		return (manager_clean(manager), 1);
+	pos_payload.line = 3;
+	if (assert_error_code(manager_exec(manager, &pos_cmd), ERR_LINE_NOT_FOUND, "Missing line rejected"))
+		return (manager_clean(manager), 1);
+	manager_clean(manager);
+	return (0);
+}
+
+static int	test_convert_utf16_command(void)
+{
+	t_Manager			*manager;
+	t_Command			cmd;
+	t_CmdInsertRange	range_payload;
+	t_CmdConvertUtf16	payload;
+	t_Utf16Position		positions[8];
+	size_t				buffer_id;
+
+	print_section("WRITING CONVERT UTF-16 COMMAND");
+	manager = manager_init();
+	if (NULL == manager)
+		return (print_error("Failed to initialize manager"), 1);
+	if (create_buffer(manager, &buffer_id) || insert_line(manager, buffer_id, 0))
+		return (manager_clean(manager), 1);
+	range_payload.buffer_id = buffer_id;
+	range_payload.line = 0;
+	range_payload.index = 0;
+	range_payload.data = "a\xF0\x9F\x98\x80" "b\nplain\n\xC3\xA9\xF0\x9F\x98\x80";
+	range_payload.size = strlen(range_payload.data);
+	cmd.id = CMD_WRITING_INSERT_RANGE;
+	cmd.payload = &range_payload;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_SUCCESS, "Insert range"))
+		return (manager_clean(manager), 1);
+	positions[0] = (t_Utf16Position){.line = 0, .column = 0};
+	positions[1] = (t_Utf16Position){.line = 0, .column = 1};
+	positions[2] = (t_Utf16Position){.line = 0, .column = 3};
+	positions[3] = (t_Utf16Position){.line = 0, .column = 2};
+	positions[4] = (t_Utf16Position){.line = 1, .column = 4};
+	positions[5] = (t_Utf16Position){.line = 2, .column = 1};
+	positions[6] = (t_Utf16Position){.line = 2, .column = 3};
+	positions[7] = (t_Utf16Position){.line = -1, .column = 3};
+	payload.buffer_id = buffer_id;
+	payload.to_utf16 = false;
+	payload.count = 8;
+	payload.positions = positions;
+	cmd.id = CMD_WRITING_CONVERT_UTF16;
+	cmd.payload = &payload;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_SUCCESS, "Convert columns")
+		|| 8 != payload.out_count)
+		return (manager_clean(manager), 1);
+	if (0 != positions[0].byte || 1 != positions[1].byte || 5 != positions[2].byte
+		|| 1 != positions[3].byte || 1 != positions[3].column || 4 != positions[4].byte
+		|| 2 != positions[5].byte || 6 != positions[6].byte || 6 != positions[7].byte)
+		return (manager_clean(manager), print_error("Column conversion mismatch"), 1);
+	print_success("Columns give bytes, surrogate pairs count twice");
+	positions[0] = (t_Utf16Position){.line = 0, .byte = 5};
+	positions[1] = (t_Utf16Position){.line = 0, .byte = 3};
+	positions[2] = (t_Utf16Position){.line = 2, .byte = 6};
+	positions[3] = (t_Utf16Position){.line = 1, .byte = 5};
+	payload.to_utf16 = true;
+	payload.count = 4;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_SUCCESS, "Convert bytes"))
+		return (manager_clean(manager), 1);
+	if (3 != positions[0].column || 1 != positions[1].column || 1 != positions[1].byte
+		|| 3 != positions[2].column || 5 != positions[3].column)
+		return (manager_clean(manager), print_error("Byte conversion mismatch"), 1);
+	print_success("Bytes give columns, inner bytes round down");
+	positions[0] = (t_Utf16Position){.line = 0, .column = 4};
+	positions[1] = (t_Utf16Position){.line = 0, .column = 5};
+	payload.to_utf16 = false;
+	payload.count = 2;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_OPERATION_FAILED, "Column past the line rejected")
+		|| 1 != payload.out_count || 6 != positions[0].byte)
+		return (manager_clean(manager), print_error("Partial conversion mismatch"), 1);
+	positions[0].line = 3;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_LINE_NOT_FOUND, "Missing line rejected"))
+		return (manager_clean(manager), 1);
+	payload.positions = NULL;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_INVALID_PAYLOAD, "Missing positions rejected"))
+		return (manager_clean(manager), 1);
+	manager_clean(manager);
+	return (0);
+}
+
+static int	test_convert_columns_command(void)
+{
+	t_Manager			*manager;
+	t_Command			cmd;
+	t_CmdInsertRange	range_payload;
+	t_CmdConvertColumns	payload;
+	t_ColumnPosition	positions[8];
+	size_t				buffer_id;
+
+	print_section("WRITING CONVERT COLUMNS COMMAND");
+	manager = manager_init();
+	if (NULL == manager)
+		return (print_error("Failed to initialize manager"), 1);
+	if (create_buffer(manager, &buffer_id) || insert_line(manager, buffer_id, 0))
+		return (manager_clean(manager), 1);
+	range_payload.buffer_id = buffer_id;
+	range_payload.line = 0;
+	range_payload.index = 0;
+	range_payload.data = "a\tb\n\xE4\xB8\xAD\xE6\x96\x87x\ne\xCC\x81z "
+		"\xF0\x9F\x91\xA8\xE2\x80\x8D\xF0\x9F\x91\xA9!";
+	range_payload.size = strlen(range_payload.data);
+	cmd.id = CMD_WRITING_INSERT_RANGE;
+	cmd.payload = &range_payload;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_SUCCESS, "Insert range"))
+		return (manager_clean(manager), 1);
+	positions[0] = (t_ColumnPosition){.line = 0, .index = 1};
+	positions[1] = (t_ColumnPosition){.line = 0, .index = 2};
+	positions[2] = (t_ColumnPosition){.line = 1, .index = 2};
+	positions[3] = (t_ColumnPosition){.line = 1, .index = 3};
+	positions[4] = (t_ColumnPosition){.line = 2, .index = 1};
+	positions[5] = (t_ColumnPosition){.line = 2, .index = 2};
+	positions[6] = (t_ColumnPosition){.line = 2, .index = 6};
+	positions[7] = (t_ColumnPosition){.line = 2, .index = 7};
+	payload = (t_CmdConvertColumns){.buffer_id = buffer_id, .to_columns = true,
+		.tab_size = 4, .count = 8, .positions = positions};
+	cmd.id = CMD_WRITING_CONVERT_COLUMNS;
+	cmd.payload = &payload;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_SUCCESS, "Convert indexes")
+		|| 8 != payload.out_count)
+		return (manager_clean(manager), 1);
+	if (1 != positions[0].column || 4 != positions[1].column || 4 != positions[2].column
+		|| 5 != positions[3].column || 0 != positions[4].column || 0 != positions[4].index
+		|| 1 != positions[5].column || 3 != positions[6].column || 4 != positions[6].index
+		|| 5 != positions[7].column)
+		return (manager_clean(manager), print_error("Index conversion mismatch"), 1);
+	print_success("Indexes give columns, inner characters round down");
+	positions[0] = (t_ColumnPosition){.line = 1, .column = 3};
+	positions[1] = (t_ColumnPosition){.line = 1, .column = 99};
+	positions[2] = (t_ColumnPosition){.line = 2, .column = 4};
+	positions[3] = (t_ColumnPosition){.line = 0, .column = 2};
+	payload.to_columns = false;
+	payload.count = 4;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_SUCCESS, "Convert columns"))
+		return (manager_clean(manager), 1);
+	if (1 != positions[0].index || 2 != positions[0].column || 3 != positions[1].index
+		|| 5 != positions[1].column || 4 != positions[2].index || 3 != positions[2].column
+		|| 1 != positions[3].index || 1 != positions[3].column)
+		return (manager_clean(manager), print_error("Column conversion mismatch"), 1);
+	print_success("Columns give indexes, past the line is its end");
+	positions[0] = (t_ColumnPosition){.line = 2, .index = 9};
+	payload.to_columns = true;
+	payload.count = 1;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_OPERATION_FAILED, "Index past the line rejected"))
+		return (manager_clean(manager), 1);
+	positions[0].line = 3;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_LINE_NOT_FOUND, "Missing line rejected"))
+		return (manager_clean(manager), 1);
+	payload.tab_size = 0;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_INVALID_PAYLOAD, "Empty tab size rejected"))
+		return (manager_clean(manager), 1);
+	manager_clean(manager);
+	return (0);
+}
+
+static int	test_wrap_commands(void)
+{
+	t_Manager			*manager;
+	t_Command			cmd;
+	t_CmdInsertRange	range_payload;
+	t_CmdHistory		history_payload;
+	t_CmdSetWrap		wrap_payload;
+	t_CmdRowToPos		row_payload;
+	t_CmdPosToRow		pos_payload;
+	size_t				buffer_id;
+
+	print_section("WRITING WRAP COMMANDS");
+	manager = manager_init();
+	if (NULL == manager)
+		return (print_error("Failed to initialize manager"), 1);
+	if (create_buffer(manager, &buffer_id) || insert_line(manager, buffer_id, 0))
+		return (manager_clean(manager), 1);
+	range_payload.buffer_id = buffer_id;
+	range_payload.line = 0;
+	range_payload.index = 0;
+	range_payload.data = "abcdefghij\n\nx\t\xE4\xB8\xADyz";
+	range_payload.size = strlen(range_payload.data);
+	cmd.id = CMD_WRITING_INSERT_RANGE;
+	cmd.payload = &range_payload;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_SUCCESS, "Insert range"))
+		return (manager_clean(manager), 1);
+	wrap_payload = (t_CmdSetWrap){.buffer_id = buffer_id, .width = 4, .tab_size = 4};
+	cmd.id = CMD_WRITING_SET_WRAP;
+	cmd.payload = &wrap_payload;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_SUCCESS, "Set wrap")
+		|| 6 != wrap_payload.out_rows)
+		return (manager_clean(manager), print_error("Row count mismatch"), 1);
+	row_payload = (t_CmdRowToPos){.buffer_id = buffer_id, .row = 5};
+	cmd.id = CMD_WRITING_ROW_TO_POS;
+	cmd.payload = &row_payload;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_SUCCESS, "Row to position")
+		|| 2 != row_payload.out_line || 2 != row_payload.out_index)
+		return (manager_clean(manager), print_error("Row position mismatch"), 1);
+	row_payload.row = 1;
+	manager_exec(manager, &cmd);
+	if (0 != row_payload.out_line || 4 != row_payload.out_index)
+		return (manager_clean(manager), print_error("Row position mismatch"), 1);
+	row_payload.row = 6;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_LINE_NOT_FOUND, "Row past the end rejected"))
+		return (manager_clean(manager), 1);
+	pos_payload = (t_CmdPosToRow){.buffer_id = buffer_id, .line = 2, .index = 3};
+	cmd.id = CMD_WRITING_POS_TO_ROW;
+	cmd.payload = &pos_payload;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_SUCCESS, "Position to row")
+		|| 5 != pos_payload.out_row)
+		return (manager_clean(manager), print_error("Position row mismatch"), 1);
+	pos_payload = (t_CmdPosToRow){.buffer_id = buffer_id, .line = 0, .index = -1};
+	manager_exec(manager, &cmd);
+	if (2 != pos_payload.out_row)
+		return (manager_clean(manager), print_error("End row mismatch"), 1);
+	pos_payload.index = 11;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_OPERATION_FAILED, "Index past the line rejected"))
+		return (manager_clean(manager), 1);
+	print_success("Rows and positions convert both ways");
+	if (insert_text(manager, buffer_id, 1, 0, "12345"))
+		return (manager_clean(manager), 1);
+	pos_payload = (t_CmdPosToRow){.buffer_id = buffer_id, .line = 2, .index = 0};
+	manager_exec(manager, &cmd);
+	if (5 != pos_payload.out_row)
+		return (manager_clean(manager), print_error("Edit row mismatch"), 1);
+	history_payload.buffer_id = buffer_id;
+	cmd.id = CMD_WRITING_UNDO;
+	cmd.payload = &history_payload;
+	manager_exec(manager, &cmd);
+	cmd.id = CMD_WRITING_POS_TO_ROW;
+	cmd.payload = &pos_payload;
+	manager_exec(manager, &cmd);
+	if (4 != pos_payload.out_row)
+		return (manager_clean(manager), print_error("Undo row mismatch"), 1);
+	print_success("Edits and undo move the rows below");
+	wrap_payload.width = 0;
+	cmd.id = CMD_WRITING_SET_WRAP;
+	cmd.payload = &wrap_payload;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_SUCCESS, "Unwrap")
+		|| 3 != wrap_payload.out_rows)
+		return (manager_clean(manager), print_error("Unwrapped row count mismatch"), 1);
+	wrap_payload.width = 4;
+	wrap_payload.tab_size = 0;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_INVALID_PAYLOAD, "Empty tab size rejected"))
+		return (manager_clean(manager), 1);
+	manager_clean(manager);
+	return (0);
+}
+
+static int	test_save_buffer_command(void)
+{
+	t_Manager		*manager;
+	t_Command		cmd;
+	t_CmdOpenRoot	open_payload;
+	t_CmdLoadFile	load_payload;
+	t_CmdInsertData	insert_payload;
+	t_CmdSaveBuffer	save_payload;
+	char			path[512];
+	char			content[64];
+	char			*dir;
+	FILE			*file;
+	size_t			size;
+	int				status;
+
+	print_section("WRITING SAVE BUFFER COMMAND");
+	manager = manager_init();
+	if (NULL == manager)
+		return (print_error("Failed to initialize manager"), 1);
+	dir = test_tmpdir_create("/tmp/seed_writing_save");
+	if (NULL == dir)
+		return (manager_clean(manager), print_error("Failed to create temp dir"), 1);
+	snprintf(path, sizeof(path), "%s/file.txt", dir);
+	file = fopen(path, "w");
+	if (NULL != file)
+	{
+		fputs("{\r\n\treturn (0);\r\n}", file);
+		fclose(file);
+	}
+	status = 1;
+	open_payload.path = dir;
+	cmd.id = CMD_FS_OPEN_ROOT;
+	cmd.payload = &open_payload;
+	if (NULL == file || assert_error_code(manager_exec(manager, &cmd), ERR_SUCCESS, "Open root"))
+		goto end;
+	load_payload.path = "file.txt";
+	cmd.id = CMD_WRITING_LOAD_FILE;
+	cmd.payload = &load_payload;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_SUCCESS, "Load file"))
+		goto end;
+	insert_payload.buffer_id = load_payload.out_buffer_id;
+	insert_payload.line = 1;
+	insert_payload.index = 9;
+	insert_payload.size = 1;
+	insert_payload.data = "1";
+	cmd.id = CMD_WRITING_INSERT_TEXT;
+	cmd.payload = &insert_payload;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_SUCCESS, "Edit loaded line"))
+		goto end;
+	save_payload.buffer_id = load_payload.out_buffer_id;
+	save_payload.path = "file.txt";
+	cmd.id = CMD_WRITING_SAVE_BUFFER;
+	cmd.payload = &save_payload;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_SUCCESS, "Save over the loaded file"))
+		goto end;
+	file = fopen(path, "r");
+	size = 0;
+	if (NULL != file)
+	{
+		size = fread(content, 1, sizeof(content), file);
+		fclose(file);
+	}
+	if (save_payload.out_size != 19 || size != 19
+		|| 0 != memcmp(content, "{\r\n\treturn (10);\r\n}", 19))
+	{
+		print_error("Saved file content mismatch");
+		goto end;
+	}
+	print_success("Saved file keeps CRLF line endings");
+	save_payload.buffer_id = 999;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_BUFFER_NOT_FOUND, "Save rejected on invalid buffer"))
+		goto end;
+	status = 0;
+end:
+	manager_clean(manager);
+	test_tmpdir_remove(dir);
+	free(dir);
+	return (status);
+}
+
+static int	test_mapped_last_line(void)
+{
+	t_Manager			*manager;
+	t_Command			cmd;
+	t_CmdOpenRoot		open_payload;
+	t_CmdLoadFile		load_payload;
+	t_CmdOffsetToPos	offset_payload;
+	t_CmdConvertUtf16	convert_payload;
+	t_Utf16Position		position;
+	char				path[512];
+	char				*dir;
+	FILE				*file;
+	void				*guard;
+	size_t				_i;
+	int					status;
+
+	print_section("WRITING MAPPED LAST LINE");
+	guard = MAP_FAILED;
+	manager = manager_init();
+	if (NULL == manager)
+		return (print_error("Failed to initialize manager"), 1);
+	dir = test_tmpdir_create("/tmp/seed_writing_mapped");
+	if (NULL == dir)
+		return (manager_clean(manager), print_error("Failed to create temp dir"), 1);
+	snprintf(path, sizeof(path), "%s/page.txt", dir);
+	file = fopen(path, "w");
+	if (NULL != file)
+	{
+		for (_i = 0; _i < 4096 - 11; _i++)
+			fputc('a', file);
+		fputs("\n\xC3\xA9\xC3\xA9\xC3\xA9\xC3\xA9\xC3\xA9", file);
+		fclose(file);
+	}
+	status = 1;
+	open_payload.path = dir;
+	cmd.id = CMD_FS_OPEN_ROOT;
+	cmd.payload = &open_payload;
+	if (NULL == file || assert_error_code(manager_exec(manager, &cmd), ERR_SUCCESS, "Open root"))
+		goto end;
+	// The file is likely mapped in the freed page, below a page that faults
+	guard = mmap(NULL, 8192, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (MAP_FAILED != guard)
+		munmap(guard, 4096);
+	load_payload.path = "page.txt";
+	cmd.id = CMD_WRITING_LOAD_FILE;
+	cmd.payload = &load_payload;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_SUCCESS, "Load a page-sized file"))
+		goto end;
+	offset_payload = (t_CmdOffsetToPos){.buffer_id = load_payload.out_buffer_id,
+		.offset = 4096};
+	cmd.id = CMD_WRITING_OFFSET_TO_POS;
+	cmd.payload = &offset_payload;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_SUCCESS, "Offset at the end of the file")
+		|| 1 != offset_payload.out_line || 5 != offset_payload.out_index)
+	{
+		print_error("End of file position mismatch");
+		goto end;
+	}
+	position = (t_Utf16Position){.line = 1, .byte = 10};
+	convert_payload = (t_CmdConvertUtf16){.buffer_id = load_payload.out_buffer_id,
+		.to_utf16 = true, .count = 1, .positions = &position};
+	cmd.id = CMD_WRITING_CONVERT_UTF16;
+	cmd.payload = &convert_payload;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_SUCCESS, "Byte at the end of the file")
+		|| 1 != convert_payload.out_count || 5 != position.column || 10 != position.byte)
+	{
+		print_error("End of file column mismatch");
+		goto end;
+	}
+	print_success("The end of a mapped last line is never read past");
+	status = 0;
+end:
+	if (MAP_FAILED != guard)
+		munmap((char *)guard + 4096, 4096);
+	manager_clean(manager);
+	test_tmpdir_remove(dir);
+	free(dir);
+	return (status);
+}
+
+/**
+ * @brief Reads every line of a snapshot again and again.
+ * @param arg The snapshot.
+ * @return NULL if the lines never changed, or the snapshot otherwise.
+*/
+static void	*read_snapshot(void *arg)
+{
+	t_Snapshot	*snapshot;
+	t_LineView	view;
+	size_t		_round;
+
+	snapshot = arg;
+	for (_round = 0; _round < 200; _round++)
+	{
+		if (4 != snapshot_size(snapshot)
+			|| 1 != snapshot_get_lines(snapshot, 1, 1, &view)
+			|| 13 != view.size || 0 != memcmp(view.data, "\treturn (10);", 13)
+			|| 1 != snapshot_get_lines(snapshot, 3, 8, &view)
+			|| 1 != view.size || '}' != view.data[0])
+			return (snapshot);
+	}
+	return (NULL);
+}
+
+static int	test_snapshot_command(void)
+{
+	t_Manager		*manager;
+	t_Command		cmd;
+	t_CmdOpenRoot	open_payload;
+	t_CmdLoadFile	load_payload;
+	t_CmdSnapshot	snapshot_payload;
+	t_CmdDestroyBuffer	delete_payload;
+	t_LineView		view;
+	pthread_t		reader;
+	void			*result;
+	char			path[512];
+	char			*dir;
+	FILE			*file;
+	size_t			_i;
+	int				status;
+
+	print_section("WRITING SNAPSHOT COMMAND");
+	manager = manager_init();
+	if (NULL == manager)
+		return (print_error("Failed to initialize manager"), 1);
+	dir = test_tmpdir_create("/tmp/seed_writing_snapshot");
+	if (NULL == dir)
+		return (manager_clean(manager), print_error("Failed to create temp dir"), 1);
+	snprintf(path, sizeof(path), "%s/file.txt", dir);
+	file = fopen(path, "w");
+	if (NULL != file)
+	{
+		fputs("{\r\n\treturn (0);\r\n\r\n}", file);
+		fclose(file);
+	}
+	status = 1;
+	open_payload.path = dir;
+	cmd.id = CMD_FS_OPEN_ROOT;
+	cmd.payload = &open_payload;
+	if (NULL == file || assert_error_code(manager_exec(manager, &cmd), ERR_SUCCESS, "Open root"))
+		goto end;
+	load_payload.path = "file.txt";
+	cmd.id = CMD_WRITING_LOAD_FILE;
+	cmd.payload = &load_payload;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_SUCCESS, "Load file")
+		|| insert_text(manager, load_payload.out_buffer_id, 1, 9, "1"))
+		goto end;
+	snapshot_payload.buffer_id = load_payload.out_buffer_id;
+	cmd.id = CMD_WRITING_SNAPSHOT;
+	cmd.payload = &snapshot_payload;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_SUCCESS, "Take snapshot"))
+		goto end;
+	if (0 != pthread_create(&reader, NULL, read_snapshot, snapshot_payload.out_snapshot))
+	{
+		snapshot_release(snapshot_payload.out_snapshot);
+		goto end;
+	}
+	for (_i = 0; _i < 200; _i++)
+	{
+		insert_text(manager, load_payload.out_buffer_id, 1, 0, "x");
+		insert_text(manager, load_payload.out_buffer_id, 3, 0, "y");
+	}
+	pthread_join(reader, &result);
+	if (NULL != result)
+	{
+		snapshot_release(snapshot_payload.out_snapshot);
+		print_error("Snapshot changed with the buffer");
+		goto end;
+	}
+	print_success("Snapshot is stable while the buffer is edited");
+	delete_payload.buffer_id = load_payload.out_buffer_id;
+	cmd.id = CMD_WRITING_DELETE_BUFFER;
+	cmd.payload = &delete_payload;
+	manager_exec(manager, &cmd);
+	if (1 != snapshot_get_lines(snapshot_payload.out_snapshot, 0, 1, &view)
+		|| 1 != view.size || '{' != view.data[0]
+		|| false == snapshot_is_crlf(snapshot_payload.out_snapshot, 0)
+		|| true == snapshot_is_crlf(snapshot_payload.out_snapshot, 3))
+	{
+		snapshot_release(snapshot_payload.out_snapshot);
+		print_error("Snapshot mismatch after the buffer is deleted");
+		goto end;
+	}
+	snapshot_release(snapshot_payload.out_snapshot);
+	print_success("Snapshot outlives its buffer");
+	snapshot_payload.buffer_id = 999;
+	cmd.id = CMD_WRITING_SNAPSHOT;
+	cmd.payload = &snapshot_payload;
+	if (assert_error_code(manager_exec(manager, &cmd), ERR_BUFFER_NOT_FOUND, "Snapshot rejected on invalid buffer"))
+		goto end;
+	status = 0;
+end:
+	manager_clean(manager);
+	test_tmpdir_remove(dir);
+	free(dir);
+	return (status);
+}
+
 int	test_commands_main(void)
 {
 	int	status;
@@ -248,6 +1826,24 @@ int	test_commands_main(void)
 	status |= test_line_commands();
 	status |= test_text_commands();
 	status |= test_split_and_join_commands();
+	status |= test_insert_range_command();
+	status |= test_delete_range_command();
+	status |= test_get_lines_command();
+	status |= test_undo_redo_commands();
+	status |= test_multi_edit_command();
+	status |= test_apply_changes_command();
+	status |= test_load_file_command();
+	status |= test_find_command();
+	status |= test_regex_find_command();
+	status |= test_find_all_command();
+	status |= test_replace_all_command();
+	status |= test_offset_commands();
+	status |= test_convert_utf16_command();
+	status |= test_convert_columns_command();
+	status |= test_wrap_commands();
+	status |= test_save_buffer_command();
+	status |= test_mapped_last_line();
+	status |= test_snapshot_command();
 	print_status(status);
 	return (status);
 }
@@ -1,32 +1,39 @@
 #include "tools.h"
 #include "systems/writing/_internal.h"
+#include "systems/writing/_tree.h"
+#include "systems/regex/_regex.h"
+#include "tools/search.h"
+#include "tools/utf8.h"
+#include "tools/width.h"
 
 static int	test_line_core(void)
 {
-	t_Line	*line;
-	char	msg[] = "Hello";
+	t_Buffer	*buffer;
+	t_Line		*line;
+	char		msg[] = "Hello";
 
 	print_section("INTERNAL LINE CORE");
-	line = line_create();
+	buffer = buffer_create();
+	line = line_create(buffer);
 	if (NULL == line)
-		return (print_error("line_create failed"), 1);
-	if (false == line_insert_data(line, 0, 5, msg))
-		return (free(line), print_error("line_insert_data failed"), 1);
-	if (line->len != 5 || 0 != strcmp(line->data, "Hello"))
-		return (free(line->data), free(line), print_error("Unexpected line content"), 1);
+		return (buffer_destroy(buffer), print_error("line_create failed"), 1);
+	if (false == line_insert_data(buffer, line, 0, 5, msg))
+		return (buffer_destroy(buffer), print_error("line_insert_data failed"), 1);
+	if (line->size != 5 || 0 != strcmp(line->data, "Hello"))
+		return (buffer_destroy(buffer), print_error("Unexpected line content"), 1);
 	print_success("Insert data in empty line");
-	if (false == line_insert_data(line, 2, 1, "_"))
-		return (free(line->data), free(line), print_error("Insert in middle failed"), 1);
+	if (false == line_insert_data(buffer, line, 2, 1, "_"))
+		return (buffer_destroy(buffer), print_error("Insert in middle failed"), 1);
 	if (0 != strcmp(line->data, "He_llo"))
-		return (free(line->data), free(line), print_error("Middle insert mismatch"), 1);
+		return (buffer_destroy(buffer), print_error("Middle insert mismatch"), 1);
 	print_success("Insert in middle");
-	if (false == line_delete_data(line, 2, 1))
-		return (free(line->data), free(line), print_error("Delete in middle failed"), 1);
+	if (false == line_delete_data(buffer, line, 2, 1))
+		return (buffer_destroy(buffer), print_error("Delete in middle failed"), 1);
 	if (0 != strcmp(line->data, "Hello"))
-		return (free(line->data), free(line), print_error("Delete result mismatch"), 1);
+		return (buffer_destroy(buffer), print_error("Delete result mismatch"), 1);
 	print_success("Delete in line");
-	free(line->data);
-	free(line);
+	line_destroy(buffer, line);
+	buffer_destroy(buffer);
 	return (0);
 }
 
@@ -43,9 +50,9 @@ static int	test_buffer_core(void)
 	buffer = buffer_create();
 	if (NULL == buffer)
 		return (print_error("buffer_create failed"), 1);
-	l0 = line_create();
-	l1 = line_create();
-	l2 = line_create();
+	l0 = line_create(buffer);
+	l1 = line_create(buffer);
+	l2 = line_create(buffer);
 	if (NULL == l0 || NULL == l1 || NULL == l2)
 		return (buffer_destroy(buffer), print_error("line allocation failed"), 1);
 	if (false == buffer_line_insert(buffer, l0, 0)
@@ -60,7 +67,7 @@ static int	test_buffer_core(void)
 		|| NULL == buffer_get_line(buffer, -1))
 		return (buffer_destroy(buffer), print_error("buffer_get_line failed"), 1);
 	print_success("Get lines by index");
-	if (false == line_insert_data(buffer_get_line(buffer, 0), 0, 8, "ABCD1234"))
+	if (false == line_insert_data(buffer, buffer_get_line(buffer, 0), 0, 8, "ABCD1234"))
 		return (buffer_destroy(buffer), print_error("line insert for split failed"), 1);
 	split = buffer_line_split(buffer, buffer_get_line(buffer, 0), 4);
 	if (NULL == split)
@@ -79,26 +86,1324 @@ static int	test_buffer_core(void)
 	return (0);
 }
 
+static int	test_line_tree(void)
+{
+	t_Buffer	*buffer;
+	t_Line		*lines[512];
+	t_Line		*line;
+	size_t		count;
+	size_t		pos;
+	size_t		_i;
+
+	print_section("INTERNAL LINE TREE");
+	buffer = buffer_create();
+	if (NULL == buffer)
+		return (print_error("buffer_create failed"), 1);
+	count = 0;
+	srand(42);
+	while (count < 512)
+	{
+		line = line_create(buffer);
+		if (NULL == line)
+			return (buffer_destroy(buffer), print_error("line allocation failed"), 1);
+		pos = rand() % (count + 1);
+		memmove(lines + pos + 1, lines + pos, (count - pos) * sizeof(t_Line *));
+		lines[pos] = line;
+		if (false == buffer_line_insert(buffer, line, pos))
+			return (buffer_destroy(buffer), print_error("Random insert failed"), 1);
+		count++;
+	}
+	while (count > 256)
+	{
+		pos = rand() % count;
+		buffer_line_destroy(buffer, lines[pos]);
+		memmove(lines + pos, lines + pos + 1, (count - pos - 1) * sizeof(t_Line *));
+		count--;
+	}
+	if (buffer->size != count)
+		return (buffer_destroy(buffer), print_error("Invalid buffer size after random edits"), 1);
+	line = buffer->line;
+	for (_i = 0; _i < count; _i++)
+	{
+		if (buffer_get_line(buffer, _i) != lines[_i] || line != lines[_i])
+			return (buffer_destroy(buffer), print_error("Line order mismatch"), 1);
+		line = line->next;
+	}
+	if (buffer->last != lines[count - 1] || NULL != line)
+		return (buffer_destroy(buffer), print_error("Line links mismatch"), 1);
+	print_success("Random inserts and deletes keep the line order");
+	buffer_destroy(buffer);
+	return (0);
+}
+
+static int	offsets_check(t_Buffer *buffer)
+{
+	t_Line	*line;
+	size_t	offset;
+	size_t	pos;
+
+	offset = 0;
+	for (line = buffer->line; line; line = line->next)
+	{
+		pos = offset + line->size;
+		if (tree_offset(line) != offset || tree_at_offset(buffer->root, &pos) != line
+			|| pos != line->size)
+			return (1);
+		offset += line->size + (line->flags & LINE_CRLF ? 2 : 1);
+	}
+	pos = offset;
+	return ((buffer->root ? buffer->root->bytes : 0) != offset
+		|| NULL != tree_at_offset(buffer->root, &pos));
+}
+
+static int	test_line_offsets(void)
+{
+	static const char	*texts[] = {"abc", "\xC3\xA9t\xC3\xA9", "x\ny",
+		"one\r\ntwo\r\n", "\n\n", "long line of text"};
+	t_Buffer			*buffer;
+	t_Line				*line;
+	t_Line				*last;
+	size_t				end_line;
+	size_t				pos;
+	size_t				_i;
+
+	print_section("INTERNAL LINE OFFSETS");
+	buffer = buffer_create();
+	line = line_create(buffer);
+	if (NULL == line || false == buffer_line_insert(buffer, line, 0))
+		return (buffer_destroy(buffer), print_error("Setup failed"), 1);
+	srand(11);
+	for (_i = 0; _i < 3000; _i++)
+	{
+		line = buffer_get_line(buffer, rand() % buffer->size);
+		pos = line->size ? rand() % (line->size + 1) : 0;
+		if (rand() % 4 || buffer->size < 4)
+			line = buffer_insert_text(buffer, line, pos,
+				strlen(texts[_i % 6]), texts[_i % 6], &end_line);
+		else if (_i % 3 == 0)
+			line = buffer_line_split(buffer, line, pos);
+		else if (line->next && _i % 3 == 1)
+			line = buffer_line_join(buffer, line, line->next);
+		else
+		{
+			last = line->next ? line->next : line;
+			line = buffer_delete_text(buffer, line, pos, last,
+				last->size / 2) ? line : NULL;
+		}
+		if (NULL == line || offsets_check(buffer))
+			break ;
+	}
+	if (_i != 3000)
+		return (buffer_destroy(buffer), print_error("Line offsets mismatch"), 1);
+	print_success("Random edits keep the byte offsets of the lines");
+	buffer_destroy(buffer);
+	return (0);
+}
+
+static int	test_insert_text(void)
+{
+	t_Buffer	*buffer;
+	t_Line		*line;
+	t_Line		*end;
+	size_t		end_line;
+	size_t		count;
+	size_t		size;
+	size_t		_i;
+	char		newlines[40];
+	const char	*texts[] = {"a", "bc", "d"};
+	const char	*expected[] = {"a", "b1", "2", "3c", "d"};
+	const bool	crlf[] = {false, true, false, true, false};
+
+	print_section("INTERNAL INSERT TEXT");
+	buffer = buffer_create();
+	if (NULL == buffer)
+		return (print_error("buffer_create failed"), 1);
+	for (_i = 0; _i < 3; _i++)
+	{
+		line = line_create(buffer);
+		if (NULL == line || false == buffer_line_insert(buffer, line, -1)
+			|| false == line_insert_data(buffer, line, 0, strlen(texts[_i]),
+				texts[_i]))
+			return (buffer_destroy(buffer), print_error("Setup failed"), 1);
+	}
+	line = buffer_get_line(buffer, 1);
+	line->flags |= LINE_CRLF;
+	end = buffer_insert_text(buffer, line, 1, 6, "1\r\n2\n3", &end_line);
+	if (NULL == end || 3 != end_line || buffer_get_line(buffer, 3) != end)
+		return (buffer_destroy(buffer), print_error("Invalid end of inserted text"), 1);
+	if (5 != buffer->size || buffer->last != buffer_get_line(buffer, 4))
+		return (buffer_destroy(buffer), print_error("Invalid line count after insert"), 1);
+	line = buffer->line;
+	for (_i = 0; _i < 5; _i++, line = line->next)
+	{
+		if (line != buffer_get_line(buffer, _i)
+			|| 0 != strcmp(line_get_data(line), expected[_i])
+			|| crlf[_i] != (0 != (line->flags & LINE_CRLF)))
+			return (buffer_destroy(buffer), print_error("Inserted lines mismatch"), 1);
+	}
+	print_success("Text with line endings is spliced in place");
+	end = buffer_insert_text(buffer, buffer->line, 0, 2, "xy", &end_line);
+	if (end != buffer->line || 0 != end_line || 0 != strcmp(line_get_data(end), "xya"))
+		return (buffer_destroy(buffer), print_error("Single line insert mismatch"), 1);
+	print_success("Text without line ending stays in the line");
+	memset(newlines, '\n', sizeof(newlines));
+	count = buffer->size;
+	srand(42);
+	for (_i = 0; _i < 200; _i++)
+	{
+		size = 1 + rand() % sizeof(newlines);
+		line = buffer_get_line(buffer, rand() % buffer->size);
+		if (NULL == buffer_insert_text(buffer, line, 0, size, newlines, &end_line))
+			return (buffer_destroy(buffer), print_error("Random insert failed"), 1);
+		count += size;
+	}
+	line = buffer->line;
+	for (_i = 0; _i < count && line == buffer_get_line(buffer, _i); _i++)
+		line = line->next;
+	if (buffer->size != count || _i != count || NULL != line)
+		return (buffer_destroy(buffer), print_error("Line order mismatch"), 1);
+	print_success("Random pastes keep the line order");
+	buffer_destroy(buffer);
+	return (0);
+}
+
+static int	test_delete_text(void)
+{
+	t_Buffer	*buffer;
+	t_Line		*line;
+	size_t		end_line;
+	size_t		first;
+	size_t		last;
+	size_t		_i;
+	char		newlines[1000];
+
+	print_section("INTERNAL DELETE TEXT");
+	buffer = buffer_create();
+	line = line_create(buffer);
+	if (NULL == line || false == buffer_line_insert(buffer, line, 0)
+		|| NULL == buffer_insert_text(buffer, line, 0, 12, "ab\ncd\nef\r\ngh", &end_line))
+		return (buffer_destroy(buffer), print_error("Setup failed"), 1);
+	if (false == buffer_delete_text(buffer, buffer->line, 1, buffer_get_line(buffer, 2), 1))
+		return (buffer_destroy(buffer), print_error("buffer_delete_text failed"), 1);
+	if (2 != buffer->size || 0 != strcmp(line_get_data(buffer->line), "af")
+		|| 0 == (buffer->line->flags & LINE_CRLF) || buffer->line->next != buffer->last
+		|| 0 != strcmp(line_get_data(buffer->last), "gh"))
+		return (buffer_destroy(buffer), print_error("Deleted range mismatch"), 1);
+	print_success("Range is deleted and its ends are joined");
+	memset(newlines, '\n', sizeof(newlines));
+	if (NULL == buffer_insert_text(buffer, buffer->line, 1, sizeof(newlines), newlines, &end_line))
+		return (buffer_destroy(buffer), print_error("Setup failed"), 1);
+	srand(42);
+	while (buffer->size > 1)
+	{
+		first = rand() % buffer->size;
+		last = first + rand() % (buffer->size - first);
+		if (false == buffer_delete_text(buffer, buffer_get_line(buffer, first), 0,
+			buffer_get_line(buffer, last), 0))
+			return (buffer_destroy(buffer), print_error("Random delete failed"), 1);
+		line = buffer->line;
+		for (_i = 0; _i < buffer->size && line == buffer_get_line(buffer, _i); _i++)
+			line = line->next;
+		if (_i != buffer->size || NULL != line || buffer->last != buffer_get_line(buffer, -1))
+			return (buffer_destroy(buffer), print_error("Line order mismatch"), 1);
+	}
+	if (NULL == strstr(line_get_data(buffer->line), "gh"))
+		return (buffer_destroy(buffer), print_error("Remaining line mismatch"), 1);
+	print_success("Random deletes keep the line order");
+	buffer_destroy(buffer);
+	return (0);
+}
+
+static int	test_history(void)
+{
+	t_Buffer	*buffer;
+	t_Line		*line;
+	char		*data;
+	size_t		end_line;
+	size_t		byte;
+	size_t		_i;
+
+	print_section("INTERNAL HISTORY");
+	buffer = buffer_create();
+	line = line_create(buffer);
+	if (NULL == line || false == buffer_line_insert(buffer, line, 0)
+		|| NULL == buffer_insert_text(buffer, line, 0, 7, "a\r\nb\nc", &end_line))
+		return (buffer_destroy(buffer), print_error("Setup failed"), 1);
+	history_delete(buffer, line, 1, line->next, 0);
+	buffer_line_join(buffer, line, line->next);
+	history_delete(buffer, line, 0, buffer->last, 1);
+	buffer_delete_text(buffer, line, 0, buffer->last, 1);
+	if (1 != buffer->size || false == history_undo(buffer, &end_line, &byte)
+		|| false == history_undo(buffer, &end_line, &byte) || 3 != buffer->size
+		|| 0 == (buffer->line->flags & LINE_CRLF) || (buffer->line->next->flags & LINE_CRLF)
+		|| 0 != strcmp(line_get_data(buffer->line->next), "b"))
+		return (buffer_destroy(buffer), print_error("Undo line endings mismatch"), 1);
+	print_success("Undo restores the line endings");
+	history_clean(&buffer->history);
+	data = malloc(1 << 20);
+	if (NULL == data)
+		return (buffer_destroy(buffer), print_error("Allocation failed"), 1);
+	memset(data, 'x', 1 << 20);
+	for (_i = 0; _i < 40; _i++)
+	{
+		line_insert_data(buffer, buffer->line, 0, 1 << 20, data);
+		history_insert(buffer, buffer->line, 0, 1 << 20, data);
+	}
+	free(data);
+	for (_i = 0; buffer->history.cursor > 0; _i++)
+		history_undo(buffer, &end_line, &byte);
+	if (buffer->history.size > HISTORY_BUDGET || 0 == _i || _i >= 40
+		|| buffer->line->size != (40 - _i) * (1 << 20) + 1)
+		return (buffer_destroy(buffer), print_error("History budget mismatch"), 1);
+	print_success("Old records are dropped past the budget");
+	buffer_destroy(buffer);
+	return (0);
+}
+
+static int	test_inline_line(void)
+{
+	t_Buffer	*buffer;
+	t_Line		*line;
+	char		text[LINE_INLINE * 2];
+
+	print_section("INTERNAL INLINE LINE");
+	buffer = buffer_create();
+	line = line_create(buffer);
+	if (NULL == line)
+		return (buffer_destroy(buffer), print_error("line_create failed"), 1);
+	memset(text, 'x', sizeof(text));
+	if (false == line_insert_data(buffer, line, 0, LINE_INLINE - 1, text)
+		|| line->data != line->inline_data
+		|| line->size != LINE_INLINE - 1 || '\0' != line->data[line->size])
+		return (buffer_destroy(buffer), print_error("Short line should be inline"), 1);
+	print_success("Short line stored in the line");
+	if (false == line_insert_data(buffer, line, 0, 1, "y")
+		|| line->data == line->inline_data
+		|| line->size != LINE_INLINE || 'y' != line->data[0]
+		|| 0 != memcmp(line->data + 1, text, LINE_INLINE - 1))
+		return (buffer_destroy(buffer), print_error("Long line should spill"), 1);
+	if (line->capacity >= LINE_INLINE * 2)
+		return (buffer_destroy(buffer), print_error("Spilled capacity too large"), 1);
+	print_success("Growing line spills to the pool");
+	line_destroy(buffer, line);
+	buffer_destroy(buffer);
+	return (0);
+}
+
+static int	test_ascii_line(void)
+{
+	t_Buffer	*buffer;
+	t_Line		*line;
+
+	print_section("INTERNAL ASCII LINE");
+	buffer = buffer_create();
+	line = line_create(buffer);
+	if (NULL == line)
+		return (buffer_destroy(buffer), print_error("line_create failed"), 1);
+	if (0 == (line->flags & LINE_ASCII)
+		|| false == line_insert_data(buffer, line, 0, 5, "Hello")
+		|| 0 == (line->flags & LINE_ASCII)
+		|| line_char_to_byte(line, 5) != 5 || line_char_to_byte(line, 6) != UTF_NPOS
+		|| line_char_skip(line, 2, 3) != 5 || line_char_skip(line, 2, 4) != UTF_NPOS)
+		return (buffer_destroy(buffer), print_error("ASCII line lookup mismatch"), 1);
+	print_success("ASCII line resolves columns directly");
+	if (false == line_insert_data(buffer, line, 1, 2, "\xC3\xA9")
+		|| (line->flags & LINE_ASCII)
+		|| line_char_to_byte(line, 2) != 3 || line_char_to_byte(line, 6) != 7)
+		return (buffer_destroy(buffer), print_error("Non ASCII insert mismatch"), 1);
+	print_success("Non ASCII insert clears the flag");
+	line_destroy(buffer, line);
+	buffer_destroy(buffer);
+	return (0);
+}
+
+static int	test_gap_line(void)
+{
+	t_Buffer	*buffer;
+	t_Line		*line;
+	char		*ref;
+	char		chunk[8000];
+	size_t		ref_size;
+	size_t		pos;
+	size_t		size;
+	size_t		_i;
+
+	print_section("INTERNAL GAP LINE");
+	buffer = buffer_create();
+	line = line_create(buffer);
+	ref = malloc(1 << 20);
+	if (NULL == line || NULL == ref)
+		return (buffer_destroy(buffer), free(ref), print_error("Allocation failed"), 1);
+	memset(chunk, 'a', sizeof(chunk));
+	ref_size = 0;
+	srand(7);
+	for (_i = 0; _i < 2000; _i++)
+	{
+		pos = ref_size ? rand() % (ref_size + 1) : 0;
+		if (rand() % 3 || ref_size < 10)
+		{
+			size = 1 + rand() % (_i % 50 ? 8 : sizeof(chunk));
+			chunk[0] = 'A' + _i % 26;
+			if (false == line_insert_data(buffer, line, pos, size, chunk))
+				break ;
+			memmove(ref + pos + size, ref + pos, ref_size - pos);
+			memcpy(ref + pos, chunk, size);
+			ref_size += size;
+		}
+		else
+		{
+			pos = pos == ref_size ? pos - 1 : pos;
+			size = 1 + rand() % 16;
+			size = pos + size > ref_size ? ref_size - pos : size;
+			if (false == line_delete_data(buffer, line, pos, size))
+				break ;
+			memmove(ref + pos, ref + pos + size, ref_size - pos - size);
+			ref_size -= size;
+		}
+		if (line_char_to_byte(line, pos) != pos)
+			break ;
+		if (_i % 100 == 0 && (line->size != ref_size
+			|| 0 != memcmp(line_get_data(line), ref, ref_size)))
+			break ;
+	}
+	if (_i != 2000 || line->size != ref_size
+		|| 0 != memcmp(line_get_data(line), ref, ref_size)
+		|| '\0' != line->data[line->size])
+		return (buffer_destroy(buffer), free(ref), print_error("Gap line content mismatch"), 1);
+	print_success("Random edits on a long line");
+	buffer_destroy(buffer);
+	free(ref);
+	return (0);
+}
+
+static size_t	test_char_to_byte(const char *str, size_t size, size_t index)
+{
+	size_t	_i;
+	size_t	_count;
+
+	_count = 0;
+	for (_i = 0; _i < size; _i++)
+	{
+		if ((str[_i] & 0xC0) != 0x80 && _count++ == index)
+			return (_i);
+	}
+	return (_count == index ? size : UTF_NPOS);
+}
+
+static int	test_utf_marks(void)
+{
+	t_Buffer	*buffer;
+	t_Line		*line;
+	const char	*chars[] = {"a", "\xC3\xA9", "\xE2\x82\xAC", "\xF0\x9F\x98\x80"};
+	const char	*data;
+	size_t		index;
+	size_t		byte;
+	size_t		_i;
+
+	print_section("INTERNAL UTF CHECKPOINTS");
+	buffer = buffer_create();
+	line = line_create(buffer);
+	if (NULL == line)
+		return (buffer_destroy(buffer), print_error("line_create failed"), 1);
+	srand(11);
+	for (_i = 0; _i < 3000; _i++)
+	{
+		data = chars[rand() % 4];
+		if (false == line_insert_data(buffer, line, -1, strlen(data), data))
+			return (buffer_destroy(buffer), print_error("Insert failed"), 1);
+	}
+	for (_i = 0; _i < 2000; _i++)
+	{
+		index = rand() % 3200;
+		byte = line_char_to_byte(line, index);
+		if (byte != test_char_to_byte(line_get_data(line), line->size, index))
+			break ;
+		if (UTF_NPOS == byte || byte == line->size)
+			continue ;
+		if (_i % 2)
+			line_insert_data(buffer, line, byte, strlen(chars[_i % 4]), chars[_i % 4]);
+		else
+			line_delete_data(buffer, line, byte,
+				line_char_skip(line, byte, 1 + rand() % 3) - byte);
+	}
+	if (_i != 2000 || NULL == line->extra || 0 == line->extra->count)
+		return (buffer_destroy(buffer), print_error("Checkpoint lookup mismatch"), 1);
+	if (line_char_skip(line, 0, 1 << 20) != UTF_NPOS)
+		return (buffer_destroy(buffer), print_error("Skip past the end should fail"), 1);
+	print_success("Character lookups across edits");
+	line_destroy(buffer, line);
+	buffer_destroy(buffer);
+	return (0);
+}
+
+static int	test_utf8_kernels(void)
+{
+	const char	*valid = "x\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80\xEF\xBF\xBF\xF4\x8F\xBF\xBF";
+	const char	*invalid[] = {"\xC0\x80", "\xED\xA0\x80", "\xF4\x90\x80\x80",
+		"\xE2\x82", "\x80", "\xF5\x80\x80\x80", "\xE0\x80\xAF"};
+	char		text[200];
+	size_t		index;
+	size_t		_isa;
+	size_t		_i;
+
+	print_section("INTERNAL UTF-8 KERNELS");
+	for (_isa = UTF8_SCALAR; _isa <= UTF8_AVX2; _isa++)
+	{
+		if (false == utf8_use(_isa))
+			continue ;
+		for (_i = 0; _i + 17 < sizeof(text); _i += 17)
+			memcpy(text + _i, valid, 17);
+		if (false == utf8_validate(text, _i) || utf8_count(text, _i) != _i / 17 * 6)
+			return (utf8_use(UTF8_AVX2), print_error("Valid text rejected"), 1);
+		index = 6 * 5 + 3;
+		if (utf8_offset(text, _i, &index) != 17 * 5 + 6)
+			return (utf8_use(UTF8_AVX2), print_error("Offset mismatch"), 1);
+		index = _i;
+		if (UTF_NPOS != utf8_offset(text, _i, &index) || index != _i - _i / 17 * 6)
+			return (utf8_use(UTF8_AVX2), print_error("Offset past the end mismatch"), 1);
+		for (_i = 0; _i < sizeof(invalid) / sizeof(*invalid); _i++)
+		{
+			memset(text, 'a', sizeof(text));
+			memcpy(text + 150, invalid[_i], strlen(invalid[_i]));
+			if (utf8_validate(text, 150 + strlen(invalid[_i])))
+				return (utf8_use(UTF8_AVX2), print_error("Invalid text accepted"), 1);
+		}
+	}
+	if (false == utf8_use(UTF8_AVX2))
+		utf8_use(UTF8_SSE2);
+	print_success("Kernels agree on count, offset and validation");
+	return (0);
+}
+
+static size_t	naive_find(const char *str, size_t size, const char *needle,
+	size_t needle_size, bool last)
+{
+	size_t	_pos;
+	size_t	_i;
+
+	_pos = SEARCH_NPOS;
+	for (_i = 0; _i + needle_size <= size; _i++)
+	{
+		if (0 == strncasecmp(str + _i, needle, needle_size))
+		{
+			_pos = _i;
+			if (false == last)
+				break ;
+		}
+	}
+	return (_pos);
+}
+
+static int	test_utf16_positions(void)
+{
+	static const char	text[] = "a\xF0\x9F\x98\x80" "b\xC3\xA9";
+	t_Buffer			*buffer;
+	t_Line				*line;
+	char				*long_text;
+	size_t				units;
+	size_t				_i;
+
+	print_section("INTERNAL UTF-16 POSITIONS");
+	units = 2;
+	if (5 != utf8_utf16_count(text, 8) || utf8_is_bmp(text, 8)
+		|| false == utf8_is_bmp(text + 5, 3)
+		|| 1 != utf8_utf16_offset(text, 8, &units) || 1 != units)
+		return (print_error("UTF-16 kernels mismatch"), 1);
+	units = 6;
+	if ((size_t)-1 != utf8_utf16_offset(text, 8, &units) || 1 != units)
+		return (print_error("UTF-16 offset past the end mismatch"), 1);
+	long_text = malloc(8 * 1000);
+	if (NULL == long_text)
+		return (print_error("Allocation failed"), 1);
+	for (_i = 0; _i < 1000; _i++)
+		memcpy(long_text + _i * 8, text, 8);
+	units = 5 * 777 + 3;
+	if (5000 != utf8_utf16_count(long_text, 8000)
+		|| 777 * 8 + 5 != utf8_utf16_offset(long_text, 8000, &units) || 0 != units)
+		return (free(long_text), print_error("Long UTF-16 offset mismatch"), 1);
+	print_success("Count and find UTF-16 code units");
+	buffer = buffer_create();
+	line = line_create(buffer);
+	if (NULL == line || false == line_insert_data(buffer, line, 0, 3, "b\xC3\xA9")
+		|| 0 == (line->flags & LINE_UTF16) || (line->flags & LINE_ASTRAL)
+		|| false == line_insert_data(buffer, line, 0, 5, text)
+		|| 0 == (line->flags & LINE_ASTRAL))
+		return (free(long_text), buffer_destroy(buffer), print_error("Surrogate summary mismatch"), 1);
+	units = 3;
+	if (5 != line_utf16_skip(line, 0, &units) || 0 != units
+		|| 5 != line_utf16_count(line, 0, line->size)
+		|| 4 != line_utf16_count(line, 0, 6))
+		return (free(long_text), buffer_destroy(buffer), print_error("Line UTF-16 mismatch"), 1);
+	if (false == line_delete_data(buffer, line, 1, 4)
+		|| (line->flags & LINE_UTF16) || 3 != line_utf16_count(line, 0, line->size)
+		|| 0 == (line->flags & LINE_UTF16) || (line->flags & LINE_ASTRAL))
+		return (free(long_text), buffer_destroy(buffer), print_error("Summary refresh mismatch"), 1);
+	print_success("Lines keep whether they have surrogate pairs");
+	if (false == line_insert_data(buffer, line, 0, 8000, long_text)
+		|| false == line_insert_data(buffer, line, 4000, 1, "x"))
+		return (free(long_text), buffer_destroy(buffer), print_error("line_insert_data failed"), 1);
+	units = 5 * 600 + 1;
+	if (600 * 8 + 1 != line_utf16_skip(line, 0, &units) || 0 != units
+		|| 5 * 600 + 1 != line_utf16_count(line, 0, 600 * 8 + 1))
+		return (free(long_text), buffer_destroy(buffer), print_error("Gap line UTF-16 mismatch"), 1);
+	print_success("Long lines convert across the gap");
+	free(long_text);
+	buffer_destroy(buffer);
+	return (0);
+}
+
+static int	test_display_columns(void)
+{
+	t_Buffer	*buffer;
+	t_Line		*line;
+	char		*long_text;
+	size_t		cells;
+	size_t		column;
+	size_t		_i;
+
+	print_section("INTERNAL DISPLAY COLUMNS");
+	if (1 != width_char('a') || 2 != width_char(0x4E2D) || 0 != width_char(0x301)
+		|| 2 != width_char(0x1F600) || 0 != width_char(0x200B)
+		|| 1 != width_char(0xE9))
+		return (print_error("Character widths mismatch"), 1);
+	if (3 != width_cluster("e\xCC\x81x", 4, 0, 4, &cells) || 1 != cells
+		|| 1 != width_cluster("\tx", 2, 5, 4, &cells) || 3 != cells
+		|| 11 != width_cluster("\xF0\x9F\x91\xA8\xE2\x80\x8D\xF0\x9F\x91\xA9!", 12, 0, 4, &cells)
+		|| 2 != cells
+		|| 8 != width_cluster("\xF0\x9F\x87\xAB\xF0\x9F\x87\xB7\xF0\x9F\x87\xA9", 12, 0, 4, &cells)
+		|| 2 != cells
+		|| 8 != width_cluster("\xF0\x9F\x91\x8D\xF0\x9F\x8F\xBD", 8, 0, 4, &cells)
+		|| 2 != cells)
+		return (print_error("Grapheme clusters mismatch"), 1);
+	if (false == width_is_narrow("h\xC3\xA9llo", 6) || width_is_narrow("a\tb", 3)
+		|| width_is_narrow("\xE4\xB8\xAD", 3) || width_is_narrow("e\xCC\x81", 3))
+		return (print_error("Narrow check mismatch"), 1);
+	print_success("Widths and grapheme clusters");
+	buffer = buffer_create();
+	line = line_create(buffer);
+	if (NULL == line || false == line_insert_data(buffer, line, 0, 2, "ab")
+		|| 0 == (line->flags & LINE_CELLS) || (line->flags & LINE_WIDE)
+		|| false == line_insert_data(buffer, line, 0, 4, "\t\xE4\xB8\xAD")
+		|| 0 == (line->flags & LINE_WIDE))
+		return (buffer_destroy(buffer), print_error("Width summary mismatch"), 1);
+	column = 0;
+	if (1 != line_column_walk(line, 0, &column, UTF_NPOS, 5, 4) || 4 != column
+		|| 6 != line_column_walk(line, 1, &column, UTF_NPOS, UTF_NPOS, 4)
+		|| 8 != column)
+		return (buffer_destroy(buffer), print_error("Line columns mismatch"), 1);
+	column = 0;
+	if (1 != line_column_walk(line, 0, &column, 3, UTF_NPOS, 8) || 8 != column)
+		return (buffer_destroy(buffer), print_error("Line byte limit mismatch"), 1);
+	if (false == line_delete_data(buffer, line, 0, 4)
+		|| (line->flags & LINE_CELLS))
+		return (buffer_destroy(buffer), print_error("Summary refresh mismatch"), 1);
+	column = 0;
+	if (1 != line_column_walk(line, 0, &column, UTF_NPOS, 1, 4) || 1 != column
+		|| 0 == (line->flags & LINE_CELLS) || (line->flags & LINE_WIDE))
+		return (buffer_destroy(buffer), print_error("Summary refresh mismatch"), 1);
+	print_success("Lines keep whether each character takes one cell");
+	long_text = malloc(2 * 1000);
+	if (NULL == long_text)
+		return (buffer_destroy(buffer), print_error("Allocation failed"), 1);
+	for (_i = 0; _i < 1000; _i++)
+		memcpy(long_text + _i * 2, "\xC3\xA9", 2);
+	column = 0;
+	if (false == line_insert_data(buffer, line, 0, 2000, long_text)
+		|| 1554 != line_column_walk(line, 0, &column, UTF_NPOS, 777, 4)
+		|| 777 != column || 2000 != line_column_walk(line, 1554, &column, 2000, UTF_NPOS, 4)
+		|| 1000 != column)
+		return (free(long_text), buffer_destroy(buffer), print_error("Narrow line columns mismatch"), 1);
+	print_success("Narrow lines use the character checkpoints");
+	free(long_text);
+	buffer_destroy(buffer);
+	return (0);
+}
+
+static int	test_wrap_rows(void)
+{
+	t_Buffer	*buffer;
+	t_Line		*lines[4];
+	const char	*texts[4];
+	size_t		row;
+	size_t		_i;
+
+	print_section("INTERNAL WRAP ROWS");
+	texts[0] = "abcdefghij";
+	texts[1] = "";
+	texts[2] = "x\t\xE4\xB8\xADyz";
+	texts[3] = "\xE4\xB8\xAD\xE4\xB8\xAD\xE4\xB8\xAD";
+	buffer = buffer_create();
+	for (_i = 0; _i < 4; _i++)
+	{
+		lines[_i] = line_create(buffer);
+		if (NULL == lines[_i] || false == buffer_line_insert(buffer, lines[_i], -1)
+			|| (texts[_i][0] && false == line_insert_data(buffer, lines[_i], 0,
+			strlen(texts[_i]), texts[_i])))
+			return (buffer_destroy(buffer), print_error("Line setup failed"), 1);
+	}
+	if (4 != buffer->root->rows)
+		return (buffer_destroy(buffer), print_error("Unwrapped rows mismatch"), 1);
+	buffer_wrap(buffer, 4, 4);
+	if (8 != buffer->root->rows || 3 != tree_height(lines[0]) || 2 != tree_height(lines[2])
+		|| 2 != tree_height(lines[3]) || 6 != tree_row(lines[3]))
+		return (buffer_destroy(buffer), print_error("Wrapped rows mismatch"), 1);
+	row = 3;
+	if (lines[1] != tree_at_row(buffer->root, &row) || 0 != row)
+		return (buffer_destroy(buffer), print_error("Row lookup mismatch"), 1);
+	row = 5;
+	if (lines[2] != tree_at_row(buffer->root, &row) || 1 != row
+		|| 2 != line_wrap(lines[2], &buffer->wrap, &row, UTF_NPOS) || 1 != row)
+		return (buffer_destroy(buffer), print_error("Row lookup mismatch"), 1);
+	row = 8;
+	if (NULL != tree_at_row(buffer->root, &row))
+		return (buffer_destroy(buffer), print_error("Row past the end found"), 1);
+	print_success("Rows are counted by line and found in the tree");
+	row = UTF_NPOS;
+	if (0 != line_wrap(lines[2], &buffer->wrap, &row, 1) || 0 != row)
+		return (buffer_destroy(buffer), print_error("Tab row mismatch"), 1);
+	row = UTF_NPOS;
+	if (8 != line_wrap(lines[0], &buffer->wrap, &row, 10) || 2 != row)
+		return (buffer_destroy(buffer), print_error("End row mismatch"), 1);
+	row = UTF_NPOS;
+	if (4 != line_wrap(lines[0], &buffer->wrap, &row, 4) || 1 != row)
+		return (buffer_destroy(buffer), print_error("Row start mismatch"), 1);
+	print_success("Positions give their row, the end stays on the last row");
+	if (false == line_delete_data(buffer, lines[0], 8, 2) || 2 != tree_height(lines[0])
+		|| 7 != buffer->root->rows || 5 != tree_row(lines[3])
+		|| false == line_insert_data(buffer, lines[1], 0, 5, "12345")
+		|| 2 != tree_height(lines[1]) || 8 != buffer->root->rows)
+		return (buffer_destroy(buffer), print_error("Edit rows mismatch"), 1);
+	print_success("Edits count the rows of their line again");
+	buffer_wrap(buffer, 1, 4);
+	if (3 != tree_height(lines[3]) || 5 != tree_height(lines[2]))
+		return (buffer_destroy(buffer), print_error("Wide cluster rows mismatch"), 1);
+	buffer_wrap(buffer, 0, 0);
+	if (4 != buffer->root->rows
+		|| false == line_insert_data(buffer, lines[0], 0, 9, "123456789")
+		|| 1 != tree_height(lines[0]))
+		return (buffer_destroy(buffer), print_error("Unwrap mismatch"), 1);
+	print_success("Wider clusters take a row, unwrapped lines take one");
+	buffer_destroy(buffer);
+	return (0);
+}
+
+static int	test_search_kernels(void)
+{
+	char	text[160];
+	char	needle[6];
+	size_t	_isa;
+	size_t	_size;
+	size_t	_i;
+
+	print_section("INTERNAL SEARCH KERNELS");
+	for (_i = 0; _i < sizeof(text); _i++)
+		text[_i] = "abAB"[(_i * 7 + _i / 5) % 4];
+	for (_isa = UTF8_SCALAR; _isa <= UTF8_AVX2; _isa++)
+	{
+		if (false == search_use(_isa))
+			continue ;
+		for (_size = 1; _size < sizeof(needle); _size++)
+		{
+			for (_i = 0; _i + _size <= sizeof(text); _i += 3)
+			{
+				memcpy(needle, "BaBbA", _size);
+				if (search_find(text + _i, sizeof(text) - _i, needle, _size, true)
+					!= naive_find(text + _i, sizeof(text) - _i, needle, _size, false)
+					|| search_find_last(text, sizeof(text) - _i, needle, _size, true)
+					!= naive_find(text, sizeof(text) - _i, needle, _size, true))
+					return (search_use(UTF8_AVX2), print_error("Folded match mismatch"), 1);
+				memcpy(needle, text + _i, _size);
+				if (search_find(text, sizeof(text), needle, _size, false) > _i
+					|| search_find_last(text, sizeof(text), needle, _size, false) < _i)
+					return (search_use(UTF8_AVX2), print_error("Exact match mismatch"), 1);
+			}
+		}
+	}
+	if (false == search_use(UTF8_AVX2))
+		search_use(UTF8_SSE2);
+	print_success("Kernels agree on first and last matches");
+	return (0);
+}
+
+static int	regex_expect(const char *pattern, bool fold, const char *text,
+	const char *expected)
+{
+	t_Regex	*regex;
+	char	found[128];
+	size_t	_len;
+	size_t	_byte;
+	size_t	_start;
+	size_t	_end;
+	int		_pass;
+
+	if (ERR_SUCCESS != regex_compile(pattern, strlen(pattern), fold, &regex))
+		return (print_error(pattern), 1);
+	for (_pass = 0; _pass < 2; _pass++)
+	{
+		found[0] = '\0';
+		_len = 0;
+		regex_line(regex, text, strlen(text));
+		if (_pass)
+			regex->scanned = REGEX_NPOS;
+		for (_byte = 0; _byte <= strlen(text) && regex_next(regex, _byte, &_start, &_end);)
+		{
+			_len += snprintf(found + _len, sizeof(found) - _len, "%s%zu-%zu",
+				_len ? " " : "", _start, _end);
+			_byte = (_end > _start) ? _end : _end + 1;
+		}
+		if (strcmp(found, expected))
+			return (regex_destroy(regex), printf("%s (pass %d): got \"%s\"\n", pattern,
+				_pass, found), print_error("Regex matches mismatch"), 1);
+	}
+	regex_destroy(regex);
+	return (0);
+}
+
+static int	test_regex_engine(void)
+{
+	const char	*invalid[] = {"(", "a)", "*a", "[a", "a{2,1}", "\\q", "[\xC3\xA9-\xC3\xBC]",
+		"(?=a)", "[^\xC3\xA9]", "a{1001}"};
+	t_Regex		*regex;
+	static char	text[20000];
+	size_t		_start;
+	size_t		_end;
+	size_t		_i;
+	int			status;
+
+	print_section("INTERNAL REGEX ENGINE");
+	status = 0;
+	status |= regex_expect("foo", false, "a foo foo", "2-5 6-9");
+	status |= regex_expect("a|ab", false, "xab", "1-3");
+	status |= regex_expect("ab|bcde", false, "abcde", "0-2");
+	status |= regex_expect("^a", false, "aaa", "0-1");
+	status |= regex_expect("a$", false, "aaa", "2-3");
+	status |= regex_expect("^$", false, "", "0-0");
+	status |= regex_expect("$^", false, "", "0-0");
+	status |= regex_expect("$^", false, "a", "");
+	status |= regex_expect("(?:$|a)^", false, "", "0-0");
+	status |= regex_expect("a*", false, "baa", "0-0 1-3 3-3");
+	status |= regex_expect("[a-c]+", true, "xABCx", "1-4");
+	status |= regex_expect("\\d{2,3}", false, "1 12 12345", "2-4 5-8 8-10");
+	status |= regex_expect("\xC3\xA9+", false, "a\xC3\xA9\xC3\xA9" "b", "1-5");
+	status |= regex_expect("[^a]", false, "a\xC3\xA9" "b", "1-3 3-4");
+	status |= regex_expect("(?:ab){2}", false, "ababab", "0-4");
+	status |= regex_expect("x(a|b)*y", false, "xababy xy", "0-6 7-9");
+	status |= regex_expect("\\w+", false, "hi_1 there", "0-4 5-10");
+	status |= regex_expect("colou?r", false, "color colour", "0-5 6-12");
+	status |= regex_expect("a\\.b|[.]c", false, "a.b axb .c", "0-3 8-10");
+	status |= regex_expect("\\S+$", false, "int main", "4-8");
+	if (status)
+		return (1);
+	print_success("Matches are leftmost-longest, from both match ends passes");
+	for (_i = 0; _i < sizeof(invalid) / sizeof(*invalid); _i++)
+	{
+		if (ERR_INVALID_PATTERN != regex_compile(invalid[_i], strlen(invalid[_i]), false, &regex))
+			return (print_error(invalid[_i]), print_error("Invalid pattern accepted"), 1);
+	}
+	print_success("Invalid patterns are rejected");
+	for (_i = 0, _start = 1; _i < sizeof(text); _i++)
+	{
+		_start = _start * 6364136223846793005ULL + 1442695040888963407ULL;
+		text[_i] = "ab"[_start >> 63];
+	}
+	if (ERR_SUCCESS != regex_compile("(a|b){14}a", 10, false, &regex))
+		return (print_error("Failed to compile"), 1);
+	regex_line(regex, text, sizeof(text));
+	for (_i = 0, _end = 0; _i + 15 <= sizeof(text); _i++)
+	{
+		if ('a' != text[_i + 14] || _i < _end)
+			continue ;
+		if (false == regex_next(regex, _end, &_start, &_end) || _start != _i
+			|| _end != _i + 15)
+			return (regex_destroy(regex), print_error("Match mismatch after cache resets"), 1);
+	}
+	if (regex_next(regex, _end, &_start, &_end) || 0 == regex->reverse.resets)
+		return (regex_destroy(regex), print_error("Cache was not reset"), 1);
+	regex_destroy(regex);
+	print_success("Cache resets keep the matches");
+	memset(text, 'x', 1000);
+	if (ERR_SUCCESS != regex_compile("x|x.*y", 6, false, &regex))
+		return (print_error("Failed to compile"), 1);
+	regex_line(regex, text, 1000);
+	for (_i = 0; _i < 1000; _i++)
+	{
+		if (false == regex_next(regex, _i, &_start, &_end) || _start != _i
+			|| _end != _i + 1)
+			return (regex_destroy(regex), print_error("Bounded match mismatch"), 1);
+	}
+	if (false == regex->longest || regex->scanned > 3 * 1000 + REGEX_SCAN_MIN)
+		return (regex_destroy(regex), print_error("Forward reads are not bounded"), 1);
+	text[999] = 'y';
+	regex_line(regex, text, 1000);
+	if (false == regex_next(regex, 0, &_start, &_end) || 0 != _start || 1000 != _end)
+		return (regex_destroy(regex), print_error("Longest match mismatch"), 1);
+	regex_destroy(regex);
+	print_success("Forward reads of a line stay linear");
+	return (0);
+}
+
+static int	test_trigram_index(void)
+{
+	t_Buffer	*buffer;
+	t_Line		*line;
+	t_GramMask	mask;
+	char		*long_text;
+	size_t		end_line;
+
+	print_section("INTERNAL TRIGRAM INDEX");
+	buffer = buffer_create();
+	line = line_create(buffer);
+	if (NULL == line || false == buffer_line_insert(buffer, line, 0)
+		|| NULL == buffer_insert_text(buffer, line, 0, 30,
+			"alpha beta\nGamma delta\nepsilon", &end_line)
+		|| NULL == (line = line_create(buffer))
+		|| false == buffer_line_insert(buffer, line, 3))
+		return (buffer_destroy(buffer), print_error("Setup failed"), 1);
+	line = buffer_get_line(buffer, 0);
+	if (false == grams_enable(buffer))
+		return (buffer_destroy(buffer), print_error("grams_enable failed"), 1);
+	grams_mask("zeta", 4, &mask);
+	if (grams_match_buffer(buffer, &mask))
+		return (buffer_destroy(buffer), print_error("Buffer filter should reject"), 1);
+	grams_mask("delta", 5, &mask);
+	if (false == grams_match_buffer(buffer, &mask) || grams_match(buffer, buffer_get_line(buffer, 0), &mask)
+		|| false == grams_match(buffer, buffer_get_line(buffer, 1), &mask)
+		|| grams_match(buffer, buffer_get_line(buffer, 2), &mask))
+		return (buffer_destroy(buffer), print_error("Signature mismatch"), 1);
+	grams_mask("GAMMA", 5, &mask);
+	if (false == grams_match(buffer, buffer_get_line(buffer, 1), &mask))
+		return (buffer_destroy(buffer), print_error("Folded signature mismatch"), 1);
+	grams_mask("ab", 2, &mask);
+	if (false == grams_match(buffer, buffer_get_line(buffer, 0), &mask))
+		return (buffer_destroy(buffer), print_error("Short text should match"), 1);
+	print_success("Only buffers and lines with every trigram are candidates");
+	grams_mask("pha zeta", 8, &mask);
+	if (false == line_insert_data(buffer, line, 5, 5, " zeta")
+		|| false == grams_match_buffer(buffer, &mask)
+		|| false == line_delete_data(buffer, line, 5, 5)
+		|| false == grams_match_buffer(buffer, &mask)
+		|| false == line_delete_data(buffer, line, 0, 8)
+		|| false == line_delete_data(buffer, buffer_get_line(buffer, 2), 0, 7)
+		|| grams_match_buffer(buffer, &mask))
+		return (buffer_destroy(buffer), print_error("Buffer filter update mismatch"), 1);
+	if (false == line_insert_data(buffer, line, 0, 8, "alpha be")
+		|| false == line_insert_data(buffer, buffer_get_line(buffer, 2), 0, 7,
+			"epsilon"))
+		return (buffer_destroy(buffer), print_error("line_insert_data failed"), 1);
+	print_success("Edits update the buffer filter, removals rebuild it");
+	grams_mask("delta", 5, &mask);
+	if (false == line_insert_data(buffer, line, -1, 6, " delta")
+		|| (line->flags & LINE_GRAMS)
+		|| false == grams_match(buffer, line, &mask))
+		return (buffer_destroy(buffer), print_error("Insert should refresh the signature"), 1);
+	line = buffer_line_split(buffer, buffer_get_line(buffer, 1), 6);
+	if (NULL == line || grams_match(buffer, buffer_get_line(buffer, 1), &mask)
+		|| false == grams_match(buffer, line, &mask))
+		return (buffer_destroy(buffer), print_error("Split should refresh the signatures"), 1);
+	print_success("Edits refresh the signature of their lines");
+	long_text = malloc(8192);
+	if (NULL == long_text)
+		return (buffer_destroy(buffer), print_error("Allocation failed"), 1);
+	memset(long_text, 'x', 8192);
+	line = buffer_get_line(buffer, 2);
+	grams_mask("needle", 6, &mask);
+	if (false == line_insert_data(buffer, line, 0, 8192, long_text)
+		|| false == line_insert_data(buffer, line, 4000, 6, "needle")
+		|| false == line_insert_data(buffer, line, 4003, 1, "Z")
+		|| false == line_delete_data(buffer, line, 4003, 1)
+		|| line->gap != 4003 || false == grams_match(buffer, line, &mask))
+		return (free(long_text), buffer_destroy(buffer), print_error("Gap line signature mismatch"), 1);
+	free(long_text);
+	print_success("Trigrams across the gap are kept");
+	buffer_destroy(buffer);
+	return (0);
+}
+
+static int	test_replace_ranges(void)
+{
+	t_Buffer	*buffer;
+	t_Line		*line;
+	t_Range		ranges[3];
+	char		*long_text;
+
+	print_section("INTERNAL REPLACE RANGES");
+	buffer = buffer_create();
+	line = line_create(buffer);
+	if (NULL == line || false == line_insert_data(buffer, line, 0, 11, "a-b-c d-e f"))
+		return (buffer_destroy(buffer), print_error("Setup failed"), 1);
+	ranges[0] = (t_Range){1, 2};
+	ranges[1] = (t_Range){3, 3};
+	ranges[2] = (t_Range){7, 8};
+	if (false == line_replace_ranges(buffer, line, ranges, 3, 3, "\xC3\xA9+")
+		|| 0 != strcmp(line->data, "a\xC3\xA9+b\xC3\xA9+-c d\xC3\xA9+e f")
+		|| line->data != line->inline_data || line->gap != line->size
+		|| (line->flags & LINE_ASCII))
+		return (buffer_destroy(buffer), print_error("Inline replace mismatch"), 1);
+	print_success("Inline line is rebuilt with empty and sized ranges");
+	ranges[0] = (t_Range){0, line->size};
+	long_text = malloc(8192);
+	if (NULL == long_text)
+		return (buffer_destroy(buffer), print_error("Allocation failed"), 1);
+	memset(long_text, 'x', 8192);
+	if (false == line_replace_ranges(buffer, line, ranges, 1, 5000, long_text)
+		|| line->size != 5000 || line->capacity != pool_data_capacity(5001)
+		|| 0 == (line->flags & LINE_ASCII) || '\0' != line->data[5000])
+		return (free(long_text), buffer_destroy(buffer), print_error("Allocated replace mismatch"), 1);
+	if (false == line_insert_data(buffer, line, 100, 4, "abcd")
+		|| line->gap != 104)
+		return (free(long_text), buffer_destroy(buffer), print_error("line_insert_data failed"), 1);
+	ranges[0] = (t_Range){98, 103};
+	ranges[1] = (t_Range){4000, 5004};
+	if (false == line_replace_ranges(buffer, line, ranges, 2, 1, "_")
+		|| line->size != 3997 || line->gap != 3997
+		|| line->capacity != pool_data_capacity(3998)
+		|| 0 != memcmp(line->data + 97, "x_dx", 4) || line->data[3996] != '_')
+		return (free(long_text), buffer_destroy(buffer), print_error("Gap replace mismatch"), 1);
+	free(long_text);
+	print_success("Long lines get one right-sized allocation");
+	ranges[0] = (t_Range){0, 3987};
+	if (false == line_replace_ranges(buffer, line, ranges, 1, 0, NULL)
+		|| line->data != line->inline_data || line->capacity != LINE_INLINE
+		|| 0 != strcmp(line->data, "xxxxxxxxx_")
+		|| line_char_to_byte(line, 5) != 5)
+		return (buffer_destroy(buffer), print_error("Shrinking replace mismatch"), 1);
+	print_success("Shrunk line moves back inline");
+	buffer_destroy(buffer);
+	return (0);
+}
+
+static int	test_mapped_buffer(void)
+{
+	t_Buffer	*buffer;
+	t_Line		*line;
+	char		*dir;
+	char		path[512];
+	FILE		*file;
+	int			status;
+
+	print_section("INTERNAL MAPPED BUFFER");
+	dir = test_tmpdir_create("/tmp/seed_writing");
+	if (NULL == dir)
+		return (print_error("Failed to create temp dir"), 1);
+	snprintf(path, sizeof(path), "%s/file.txt", dir);
+	file = fopen(path, "w");
+	if (NULL == file)
+		return (test_tmpdir_remove(dir), free(dir), print_error("Failed to create file"), 1);
+	fputs("alpha\nbeta\n\ng\xC3\xA0mma", file);
+	fclose(file);
+	status = 1;
+	buffer = buffer_create();
+	if (NULL == buffer || false == buffer_map_file(buffer, path))
+		print_error("buffer_map_file failed");
+	else if (buffer->size != 4
+		|| 0 != memcmp(buffer_get_line(buffer, 1)->data, "beta", 4)
+		|| buffer_get_line(buffer, 2)->size != 0
+		|| buffer_get_line(buffer, 3)->size != 6 || offsets_check(buffer))
+		print_error("Mapped lines mismatch");
+	else if (0 == (buffer_get_line(buffer, 1)->flags & LINE_ASCII)
+		|| (buffer_get_line(buffer, 3)->flags & LINE_ASCII))
+		print_error("Mapped lines ASCII flag mismatch");
+	else if (buffer_get_line(buffer, 0)->data != buffer->origin
+		|| buffer_get_line(buffer, 0)->capacity != 0)
+		print_error("Mapped lines should borrow the origin");
+	else
+	{
+		print_success("Map file without copying lines");
+		line = buffer_get_line(buffer, 0);
+		if (false == line_insert_data(buffer, line, 5, 1, "!")
+			|| 0 != strcmp(line->data, "alpha!")
+			|| 0 != memcmp(buffer->origin, "alpha\n", 6))
+			print_error("Copy on write mismatch");
+		else if (false == line_delete_data(buffer, buffer_get_line(buffer, 3), 0, 3)
+			|| 0 != memcmp(buffer_get_line(buffer, 3)->data, "mma", 3)
+			|| buffer_get_line(buffer, 3)->capacity != 0)
+			print_error("Borrowed delete mismatch");
+		else if (false == line_insert_data(buffer, buffer_get_line(buffer, 1), 0, 1, ">")
+			|| buffer_get_line(buffer, 1)->data != buffer_get_line(buffer, 1)->inline_data
+			|| 0 != strcmp(buffer_get_line(buffer, 1)->data, ">beta"))
+			print_error("Short borrowed line should be copied inline");
+		else if (false == line_replace_ranges(buffer, buffer_get_line(buffer, 3),
+				&(t_Range){0, 1}, 1, 2, "MM")
+			|| 0 != strcmp(buffer_get_line(buffer, 3)->data, "MMma")
+			|| 0 == (buffer_get_line(buffer, 3)->flags & LINE_ASCII)
+			|| 0 != memcmp(buffer->origin + 12, "g\xC3\xA0mma", 6))
+			print_error("Borrowed replace mismatch");
+		else
+		{
+			print_success("Edit mapped lines with copy on write");
+			status = 0;
+		}
+	}
+	buffer_destroy(buffer);
+	test_tmpdir_remove(dir);
+	free(dir);
+	return (status);
+}
+
+/**
+ * @brief Writes the lines of a snapshot in one string, each line ends with
+ * "\r\n" or "\n".
+ * @param snapshot The snapshot.
+ * @return The string, or NULL if an error occured.
+*/
+static char	*snapshot_text(const t_Snapshot *snapshot)
+{
+	t_LineView	views[64];
+	char		*text;
+	size_t		_size;
+	size_t		_count;
+	size_t		_line;
+	size_t		_i;
+
+	_size = 0;
+	for (_line = 0; _line < snapshot_size(snapshot); _line++)
+	{
+		snapshot_get_lines(snapshot, _line, 1, views);
+		_size += views[0].size + (snapshot_is_crlf(snapshot, _line) ? 2 : 1);
+	}
+	text = malloc(_size + 1);
+	if (NULL == text)
+		return (NULL);
+	_size = 0;
+	for (_line = 0; _line < snapshot_size(snapshot); _line += _count)
+	{
+		_count = snapshot_get_lines(snapshot, _line, 64, views);
+		for (_i = 0; _i < _count; _i++)
+		{
+			memcpy(text + _size, views[_i].data, views[_i].size);
+			_size += views[_i].size;
+			if (snapshot_is_crlf(snapshot, _line + _i))
+				text[_size++] = '\r';
+			text[_size++] = '\n';
+		}
+	}
+	text[_size] = '\0';
+	return (text);
+}
+
+/**
+ * @brief Writes the lines of a buffer in one string like snapshot_text,
+ * without closing the gaps of the lines.
+ * @param buffer The buffer.
+ * @return The string, or NULL if an error occured.
+*/
+static char	*buffer_text(const t_Buffer *buffer)
+{
+	const t_Line	*_line;
+	char			*text;
+	size_t			_size;
+
+	_size = 0;
+	for (_line = buffer->line; _line; _line = _line->next)
+		_size += _line->size + (_line->flags & LINE_CRLF ? 2 : 1);
+	text = malloc(_size + 1);
+	if (NULL == text)
+		return (NULL);
+	_size = 0;
+	for (_line = buffer->line; _line; _line = _line->next)
+	{
+		memcpy(text + _size, _line->data, _line->gap);
+		memcpy(text + _size + _line->gap, line_tail(_line),
+			_line->size - _line->gap);
+		_size += _line->size;
+		if (_line->flags & LINE_CRLF)
+			text[_size++] = '\r';
+		text[_size++] = '\n';
+	}
+	text[_size] = '\0';
+	return (text);
+}
+
+/**
+ * @brief Applies a random edit to the buffer: text with or without line
+ * endings, a range over several lines, a split, a join or a replace.
+ * @param buffer The buffer.
+ * @param long_text Text longer than a gap buffer line.
+ * @return TRUE for success or FALSE if an error occured.
+*/
+static bool	snapshot_edit(t_Buffer *buffer, const char *long_text)
+{
+	t_Line	*_line;
+	t_Line	*_last;
+	size_t	_pos;
+	size_t	_end;
+
+	_line = buffer_get_line(buffer, rand() % buffer->size);
+	_pos = _line->size ? rand() % (_line->size + 1) : 0;
+	switch (rand() % 8)
+	{
+		case 0:
+			return (NULL != buffer_insert_text(buffer, _line, _pos, 3, "abc", &_end));
+		case 1:
+			return (NULL != buffer_insert_text(buffer, _line, _pos, 9,
+				"ab\ncd\r\nef", &_end));
+		case 2:
+			return (_pos == _line->size
+				|| line_delete_data(buffer, _line, _pos, 1 + rand() % 8));
+		case 3:
+			_last = buffer_get_line(buffer, tree_index(_line) + rand() % 40);
+			if (NULL == _last)
+				_last = buffer->last;
+			_end = _last->size ? rand() % (_last->size + 1) : 0;
+			return (_last == _line || buffer_delete_text(buffer, _line, _pos,
+				_last, _end));
+		case 4:
+			return (NULL != buffer_line_split(buffer, _line, _pos));
+		case 5:
+			return (NULL == _line->next
+				|| NULL != buffer_line_join(buffer, _line, _line->next));
+		case 6:
+			return (line_insert_data(buffer, _line, _pos, 5000, long_text)
+				&& line_delete_data(buffer, _line, rand() % 100, 4990));
+		default:
+			return (line_replace_ranges(buffer, _line,
+				&(t_Range){0, _line->size < 2 ? _line->size : 2}, 1, 2, "RR"));
+	}
+}
+
+static int	test_snapshot_views(void)
+{
+	t_Buffer	*buffer;
+	t_Snapshot	*snapshots[6];
+	char		*texts[6];
+	char		*text;
+	char		*long_text;
+	char		*dir;
+	char		path[512];
+	FILE		*file;
+	size_t		_count;
+	size_t		_i;
+	size_t		_j;
+	int			status;
+
+	print_section("INTERNAL SNAPSHOT VIEWS");
+	dir = test_tmpdir_create("/tmp/seed_writing");
+	if (NULL == dir)
+		return (print_error("Failed to create temp dir"), 1);
+	snprintf(path, sizeof(path), "%s/file.txt", dir);
+	file = fopen(path, "w");
+	if (NULL == file)
+		return (test_tmpdir_remove(dir), free(dir), print_error("Failed to create file"), 1);
+	for (_i = 0; _i < 3000; _i++)
+		fprintf(file, _i % 7 ? "line %zu\n" : "line %zu\r\n", _i);
+	fclose(file);
+	long_text = malloc(5000);
+	buffer = buffer_create();
+	status = 1;
+	_count = 0;
+	if (NULL == long_text || NULL == buffer || false == buffer_map_file(buffer, path))
+	{
+		print_error("Setup failed");
+		goto end;
+	}
+	memset(long_text, 'x', 5000);
+	srand(7);
+	for (_i = 0; _i < 3000; _i++)
+	{
+		if (false == snapshot_edit(buffer, long_text))
+		{
+			print_error("Random edit failed");
+			goto end;
+		}
+		if (_i % 25)
+			continue ;
+		if (6 == _count)
+		{
+			_j = rand() % _count;
+			snapshot_release(snapshots[_j]);
+			free(texts[_j]);
+			snapshots[_j] = snapshots[--_count];
+			texts[_j] = texts[_count];
+		}
+		snapshots[_count] = snapshot_create(buffer);
+		texts[_count] = buffer_text(buffer);
+		if (NULL == snapshots[_count] || NULL == texts[_count])
+		{
+			snapshot_release(snapshots[_count]);
+			free(texts[_count]);
+			print_error("Snapshot failed");
+			goto end;
+		}
+		_count++;
+		for (_j = 0; _j < _count; _j++)
+		{
+			text = snapshot_text(snapshots[_j]);
+			if (NULL == text || 0 != strcmp(text, texts[_j]))
+			{
+				free(text);
+				print_error("Snapshot changed with the buffer");
+				goto end;
+			}
+			free(text);
+		}
+	}
+	print_success("Snapshots keep their lines through random edits");
+	while (_count > 1)
+	{
+		snapshot_release(snapshots[--_count]);
+		free(texts[_count]);
+	}
+	snapshot_release(snapshots[0]);
+	free(texts[0]);
+	snapshots[0] = snapshot_create(buffer);
+	texts[0] = buffer_text(buffer);
+	_count = 1;
+	if (NULL == snapshots[0] || NULL == texts[0]
+		|| 0 != buffer->views.shared->count)
+	{
+		print_error("Retired memory should be released with the snapshots");
+		goto end;
+	}
+	print_success("Retired memory is released with the snapshots");
+	for (_i = 0; _i < 200; _i++)
+		snapshot_edit(buffer, long_text);
+	buffer_destroy(buffer);
+	buffer = NULL;
+	text = snapshot_text(snapshots[0]);
+	if (NULL == text || 0 != strcmp(text, texts[0]))
+	{
+		free(text);
+		print_error("Snapshot changed after the buffer is destroyed");
+		goto end;
+	}
+	free(text);
+	print_success("Snapshot keeps shared lines after the buffer is destroyed");
+	status = 0;
+end:
+	while (_count > 0)
+	{
+		snapshot_release(snapshots[--_count]);
+		free(texts[_count]);
+	}
+	buffer_destroy(buffer);
+	free(long_text);
+	test_tmpdir_remove(dir);
+	free(dir);
+	return (status);
+}
+
 static int	test_internal_errors(void)
 {
 	t_Buffer	*buffer;
 	t_Line		*line;
 
 	print_section("INTERNAL ERROR CASES");
-	if (false != line_insert_data(NULL, 0, 1, "x"))
-		return (print_error("line_insert_data should reject NULL line"), 1);
+	buffer = buffer_create();
+	if (NULL == buffer)
+		return (print_error("Allocation failed"), 1);
+	if (false != line_insert_data(buffer, NULL, 0, 1, "x"))
+		return (buffer_destroy(buffer), print_error("line_insert_data should reject NULL line"), 1);
 	print_success("Reject NULL line on insert");
-	if (false != line_delete_data(NULL, 0, 1))
-		return (print_error("line_delete_data should reject NULL line"), 1);
+	if (false != line_delete_data(buffer, NULL, 0, 1))
+		return (buffer_destroy(buffer), print_error("line_delete_data should reject NULL line"), 1);
 	print_success("Reject NULL line on delete");
-	buffer = buffer_create();
-	line = line_create();
-	if (NULL == buffer || NULL == line)
-		return (buffer_destroy(buffer), free(line), print_error("Allocation failed"), 1);
+	line = line_create(buffer);
+	if (NULL == line)
+		return (buffer_destroy(buffer), print_error("Allocation failed"), 1);
 	if (false != buffer_line_insert(buffer, line, 2))
 		return (buffer_destroy(buffer), print_error("Insert should fail with out-of-range index"), 1);
 	print_success("Reject out-of-range line index");
-	free(line);
+	line_destroy(buffer, line);
 	if (NULL != buffer_get_line(buffer, 0))
 		return (buffer_destroy(buffer), print_error("Get line should fail on empty buffer"), 1);
 	print_success("Reject get line on empty buffer");
@@ -116,6 +1421,25 @@ int	test_internal_main(void)
 	status = 0;
 	status |= test_line_core();
 	status |= test_buffer_core();
+	status |= test_line_tree();
+	status |= test_line_offsets();
+	status |= test_insert_text();
+	status |= test_delete_text();
+	status |= test_history();
+	status |= test_inline_line();
+	status |= test_ascii_line();
+	status |= test_gap_line();
+	status |= test_utf_marks();
+	status |= test_utf8_kernels();
+	status |= test_utf16_positions();
+	status |= test_display_columns();
+	status |= test_wrap_rows();
+	status |= test_search_kernels();
+	status |= test_regex_engine();
+	status |= test_trigram_index();
+	status |= test_replace_ranges();
+	status |= test_mapped_buffer();
+	status |= test_snapshot_views();
 	status |= test_internal_errors();
 	print_status(status);
 	return (status);